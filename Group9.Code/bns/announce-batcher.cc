@@ -0,0 +1,91 @@
+#include <algorithm>
+#include "ns3/simulator.h"
+#include "announce-batcher.h"
+
+namespace bns
+{
+
+AnnounceBatcher::AnnounceBatcher() : m_nMessages(0), m_nIds(0), m_waitSum(0)
+{
+}
+
+bool AnnounceBatcher::Add(ns3::Ipv4Address addr, uint64_t blockID)
+{
+    Batch &batch = m_batches[addr];
+    if (std::find(std::begin(batch.inventory), std::end(batch.inventory), blockID) != std::end(batch.inventory))
+        return false;
+
+    batch.inventory.push_back(blockID);
+    batch.added.push_back(ns3::Simulator::Now());
+    return batch.inventory.size() == 1;
+}
+
+void AnnounceBatcher::SetFlushEvent(ns3::Ipv4Address addr, ns3::EventId flush)
+{
+    auto it = m_batches.find(addr);
+    if (it != std::end(m_batches))
+        it->second.flush = flush;
+}
+
+uint32_t
+AnnounceBatcher::GetSize(ns3::Ipv4Address addr) const
+{
+    auto it = m_batches.find(addr);
+    if (it == std::end(m_batches))
+        return 0;
+    return it->second.inventory.size();
+}
+
+std::vector<uint64_t>
+AnnounceBatcher::Take(ns3::Ipv4Address addr)
+{
+    std::vector<uint64_t> inventory;
+    auto it = m_batches.find(addr);
+    if (it == std::end(m_batches))
+        return inventory;
+
+    Batch &batch = it->second;
+    batch.flush.Cancel();
+    inventory.swap(batch.inventory);
+    for (auto &t : batch.added)
+        m_waitSum += (ns3::Simulator::Now() - t).GetSeconds();
+    m_batches.erase(it);
+
+    if (!inventory.empty())
+    {
+        m_nMessages++;
+        m_nIds += inventory.size();
+    }
+    return inventory;
+}
+
+void AnnounceBatcher::Clear()
+{
+    for (auto &e : m_batches)
+        e.second.flush.Cancel();
+    m_batches.clear();
+}
+
+uint64_t
+AnnounceBatcher::GetNMessages() const
+{
+    return m_nMessages;
+}
+
+double
+AnnounceBatcher::GetMeanBatchSize() const
+{
+    if (m_nMessages == 0)
+        return 0;
+    return m_nIds / (double)m_nMessages;
+}
+
+ns3::Time
+AnnounceBatcher::GetMeanWait() const
+{
+    if (m_nIds == 0)
+        return ns3::Seconds(0);
+    return ns3::Seconds(m_waitSum / m_nIds);
+}
+
+} // namespace bns
@@ -0,0 +1,79 @@
+/**
+ * This file declares the per-peer batching of block announcements (Mincast
+ * INFORM, Vanilla INV and HEADERS).
+ */
+
+#ifndef ANNOUNCE_BATCHER_H
+#define ANNOUNCE_BATCHER_H
+
+#include <unordered_map>
+#include <vector>
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace bns
+{
+
+/**
+ * \brief Block IDs waiting to be announced, per peer.
+ * The node adds every ID it would announce and sends the whole batch in one
+ * message once the flush delay of the first ID expired or the batch is full.
+ * Counts the messages, the IDs per message and how long the IDs waited.
+ */
+class AnnounceBatcher
+{
+public:
+    AnnounceBatcher();
+
+    /**
+     * \brief Queue blockID for addr.
+     * \return true if it opened a new batch, i.e. a flush needs to be scheduled
+     */
+    bool Add(ns3::Ipv4Address addr, uint64_t blockID);
+
+    /**
+     * \brief Remember the pending flush of the batch of addr, to cancel it on an early flush
+     */
+    void SetFlushEvent(ns3::Ipv4Address addr, ns3::EventId flush);
+
+    uint32_t GetSize(ns3::Ipv4Address addr) const;
+
+    /**
+     * \brief Remove and return the batch of addr, empty if there is none
+     */
+    std::vector<uint64_t> Take(ns3::Ipv4Address addr);
+
+    /**
+     * \brief Drop all batches, e.g. when leaving the network
+     */
+    void Clear();
+
+    uint64_t GetNMessages() const;
+
+    /**
+     * \brief Mean number of block IDs per announcement message
+     */
+    double GetMeanBatchSize() const;
+
+    /**
+     * \brief Mean time a block ID waited for its batch to be sent
+     */
+    ns3::Time GetMeanWait() const;
+
+private:
+    struct Batch
+    {
+        std::vector<uint64_t> inventory;
+        std::vector<ns3::Time> added;
+        ns3::EventId flush;
+    };
+
+    std::unordered_map<ns3::Ipv4Address, Batch, ns3::Ipv4AddressHash> m_batches;
+    uint64_t m_nMessages; //!< Announcement messages sent
+    uint64_t m_nIds;      //!< Block IDs announced
+    double m_waitSum;     //!< Accumulated waiting time of the IDs in seconds
+};
+
+} // namespace bns
+#endif /* ANNOUNCE_BATCHER_H */
@@ -1,4 +1,5 @@
 #include "bitcoin-node.h"
+#include "miner-relay.h"
 
 NS_LOG_COMPONENT_DEFINE("BNSBitcoinNode");
 
@@ -7,7 +8,9 @@ namespace bns
 
 uint32_t BitcoinNode::nBlocks = 0;
 
-BitcoinNode::BitcoinNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : m_socket(0), m_address(address), m_isRunning(false), m_isMiner(isMiner), m_isSelfish(false), m_isByzantine(false), m_miner(nullptr), m_hashRate(hashRate), m_receivedFirstPartBlock(false), m_receivedFirstFullBlock(false), m_nMinedBlocks(0), m_totalMinedBlocksSize(0)
+uint32_t BitcoinNode::nKnownTxs = 0;
+
+BitcoinNode::BitcoinNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : m_socket(0), m_address(address), m_isRunning(false), m_isMiner(isMiner), m_isSelfish(false), m_isByzantine(false), m_miner(nullptr), m_relay(nullptr), m_bridge(nullptr), m_ownsChain(true), m_hashRate(hashRate), m_receivedFirstPartBlock(false), m_receivedFirstFullBlock(false), m_knownTxs(BitcoinNode::nKnownTxs, 0.000001), m_nMinedBlocks(0), m_totalMinedBlocksSize(0), m_nReceivedTxs(0)
 {
     NS_LOG_FUNCTION(this);
     m_blockchain = new Blockchain(this);
@@ -20,7 +23,8 @@ BitcoinNode::BitcoinNode(ns3::Ipv4Address address, bool isMiner, double hashRate
 
 BitcoinNode::~BitcoinNode()
 {
-    delete m_blockchain;
+    if (m_ownsChain)
+        delete m_blockchain;
     delete m_miner;
 }
 
@@ -60,6 +64,10 @@ void BitcoinNode::NotifyNewValidBlock(Block &newBlock)
 
     if (!m_isSelfish && !m_isByzantine)
     {
+        if (m_relay)
+            m_relay->Relay(newBlock);
+        if (m_bridge && m_bridge->IsRunning())
+            m_bridge->InitBroadcast(newBlock);
         InitBroadcast(newBlock);
     }
 }
@@ -144,7 +152,12 @@ void BitcoinNode::SetTTFB(uint64_t blockID, ns3::Time ttfb)
 {
     // NS_LOG_INFO("Setting TTFB");
     if (m_ttfb.find(blockID) == m_ttfb.end())
+    {
         m_ttfb[blockID] = ttfb;
+        // a gateway counts once, whichever stack got the block first
+        if (m_bridge)
+            m_bridge->SetTTFB(blockID, ttfb);
+    }
 }
 
 std::unordered_map<uint64_t, ns3::Time>
@@ -156,7 +169,11 @@ BitcoinNode::GetTTLB()
 void BitcoinNode::SetTTLB(uint64_t blockID, ns3::Time ttlb)
 {
     if (m_ttlb.find(blockID) == m_ttlb.end())
+    {
         m_ttlb[blockID] = ttlb;
+        if (m_bridge)
+            m_bridge->SetTTLB(blockID, ttlb);
+    }
 }
 
 std::unordered_map<uint64_t, ns3::Time>
@@ -203,4 +220,92 @@ void BitcoinNode::SetByzantine(bool byzantine)
 {
     m_isByzantine = byzantine;
 }
+
+void BitcoinNode::Leave()
+{
+    if (!m_isRunning)
+        return;
+    NS_LOG_INFO("Node leaving: " << m_address);
+    StopApplication();
+    if (m_bridge)
+        m_bridge->Leave();
+}
+
+void BitcoinNode::Rejoin()
+{
+    if (m_isRunning)
+        return;
+    NS_LOG_INFO("Node rejoining: " << m_address);
+    StartApplication();
+    if (m_bridge)
+        m_bridge->Rejoin();
+}
+
+bool BitcoinNode::IsRunning()
+{
+    return m_isRunning;
+}
+
+ns3::Ipv4Address
+BitcoinNode::GetAddress()
+{
+    return m_address;
+}
+
+void BitcoinNode::SetRelay(MinerRelay *relay)
+{
+    m_relay = relay;
+}
+
+void BitcoinNode::SetBridge(BitcoinNode *bridge)
+{
+    m_bridge = bridge;
+    bridge->m_bridge = this;
+    if (bridge->m_ownsChain)
+        delete bridge->m_blockchain;
+    bridge->m_blockchain = m_blockchain;
+    bridge->m_ownsChain = false;
+}
+
+void BitcoinNode::NotifyNewTx(Tx &tx)
+{
+    if (!m_isRunning)
+        return;
+    m_knownTxs.Insert(tx.txID);
+    if (!m_isSelfish && !m_isByzantine)
+        InitTxBroadcast(tx);
+    if (m_bridge && m_bridge->IsRunning())
+    {
+        m_bridge->m_knownTxs.Insert(tx.txID);
+        if (!m_isSelfish && !m_isByzantine)
+            m_bridge->InitTxBroadcast(tx);
+    }
+}
+
+bool BitcoinNode::AcceptTx(Tx &tx)
+{
+    if (m_knownTxs.Contains(tx.txID))
+        return false;
+    m_knownTxs.Insert(tx.txID);
+    m_nReceivedTxs++;
+    // hand it to the other overlay of a gateway, it is not new there anymore
+    if (m_bridge && m_bridge->IsRunning())
+    {
+        m_bridge->m_knownTxs.Insert(tx.txID);
+        m_bridge->m_nReceivedTxs++;
+        if (!m_isSelfish && !m_isByzantine)
+            m_bridge->InitTxBroadcast(tx);
+    }
+    return !m_isSelfish && !m_isByzantine;
+}
+
+void BitcoinNode::InitTxBroadcast(Tx &)
+{
+}
+
+uint32_t
+BitcoinNode::GetNReceivedTxs()
+{
+    return m_nReceivedTxs;
+}
 } // namespace bns
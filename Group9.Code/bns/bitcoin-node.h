@@ -10,12 +10,15 @@
 
 #include "bitcoin-miner.h"
 #include "blockchain.h"
+#include "rolling-bloom-filter.h"
 
 namespace bns
 {
 
 class Blockchain;
 class BitcoinMiner;
+struct Tx;
+class MinerRelay;
 
 class BitcoinNode : public ns3::Application
 {
@@ -63,12 +66,65 @@ public:
     void SetByzantine(bool byzantine);
     bool IsByzantine();
 
+    /**
+         * \brief Take the node offline, keeping its blockchain (churn)
+         */
+    void Leave();
+
+    /**
+         * \brief Bring an offline node back online
+         */
+    void Rejoin();
+
+    bool IsRunning();
+
+    ns3::Ipv4Address GetAddress();
+
+    /**
+         * \brief Also relay new valid blocks over the miner relay
+         */
+    void SetRelay(MinerRelay *relay);
+
+    /**
+         * \brief Run the stack of bridge next to ours on the same ns-3 node (gateway).
+         * The bridge uses our blockchain, so every block is validated once and
+         * then broadcast on both overlays, and reports its timings and
+         * transactions as ours.
+         */
+    void SetBridge(BitcoinNode *bridge);
+
+    /**
+         * \brief A transaction of the workload was created at this node
+         */
+    void NotifyNewTx(Tx &tx);
+
+    /**
+         * \brief Transactions of other nodes we received
+         */
+    uint32_t GetNReceivedTxs();
+
+    static uint32_t nKnownTxs; //!< Transactions a node remembers, sized to the workload, 0 without
+
 protected:
+    virtual void StartApplication(void) = 0; // Called at time specified by Start or on Rejoin
+    virtual void StopApplication(void) = 0;  // Called at time specified by Stop or on Leave
+
     /**
          * \brief Pick a hashrate
          */
     double GetHashRate();
 
+    /**
+         * \brief Remember a transaction received from the network
+         * \return true if it is new and the node should relay it
+         */
+    bool AcceptTx(Tx &tx);
+
+    /**
+         * \brief Start relaying our own transaction, stacks without transaction relay keep it
+         */
+    virtual void InitTxBroadcast(Tx &tx);
+
     std::vector<ns3::Ipv4Address> m_knownAddresses; //! A vector with known peer addresses
     ns3::Ptr<ns3::Socket> m_socket;                 //!< Listening socket
     ns3::Ipv4Address m_address;
@@ -78,17 +134,23 @@ protected:
     bool m_isSelfish;
     bool m_isByzantine;
     BitcoinMiner *m_miner;
+    MinerRelay *m_relay; //!< Relay among the miners, owned by the ns-3 node, if any
+    BitcoinNode *m_bridge; //!< The other stack of a gateway, owned by the ns-3 node, if any
+    bool m_ownsChain;      //!< False if the blockchain is the one of our bridge
     double m_hashRate; // hashRate in TH/s
 
     bool m_receivedFirstPartBlock;
     bool m_receivedFirstFullBlock;
 
+    RollingBloomFilter m_knownTxs; //!< Transactions we created or received
+
 private:
     std::unordered_map<uint64_t, ns3::Time> m_ttfb;
     std::unordered_map<uint64_t, ns3::Time> m_ttlb;
     std::unordered_map<uint64_t, ns3::Time> m_miningTime;
     uint32_t m_nMinedBlocks;
     uint32_t m_totalMinedBlocksSize;
+    uint32_t m_nReceivedTxs;
 };
 } // namespace bns
 #endif
@@ -45,6 +45,25 @@ BitcoinTopologyHelper::GetIntracontinentalDevices (Region reg)
     return hubDevMap[reg];
 };
 
+ns3::NetDeviceContainer 
+BitcoinTopologyHelper::GetIntercontinentalDevices (Region reg)
+{
+    return interDevMap[reg];
+};
+
+Region
+BitcoinTopologyHelper::GetTopologyRegion (unsigned int index)
+{
+    // topology leafs are ordered by region, see the constructor
+    std::vector<bns::Region> regs = {{bns::Region::NA, bns::Region::EU, bns::Region::AS, bns::Region::OC, bns::Region::AF, bns::Region::SA, bns::Region::CN}};
+    for (auto r : regs) {
+        if (index < numLeafsMap[r])
+            return r;
+        index -= numLeafsMap[r];
+    }
+    return Region::CN;
+};
+
 unsigned int
 BitcoinTopologyHelper::GetNumberOfLeafs (Region reg)
 {
@@ -326,6 +345,8 @@ BitcoinTopologyHelper::ConnectRegionRouters (Region reg0, Region reg1)
 
     routerDevMap[reg0].Add(temp.Get(0));
     routerDevMap[reg1].Add(temp.Get(1));
+    interDevMap[reg0].Add(temp.Get(0));
+    interDevMap[reg1].Add(temp.Get(1));
 }
 
 void
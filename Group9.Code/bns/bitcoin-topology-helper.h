@@ -114,6 +114,9 @@ class BitcoinTopologyHelper{
 
         // Return all devices on the router side of a region (however, only intracontinental).
         ns3::NetDeviceContainer GetIntracontinentalDevices (Region reg);
+        // Return all devices on the router side of the links to other regions.
+        ns3::NetDeviceContainer GetIntercontinentalDevices (Region reg);
+        Region GetTopologyRegion(unsigned int index);
         unsigned int GetNumberOfLeafs (Region reg);
 
         std::string RegionToString(Region reg);
@@ -135,6 +138,7 @@ class BitcoinTopologyHelper{
         std::unordered_map<Region, ns3::NodeContainer> leafMap;
         std::unordered_map<Region, ns3::NetDeviceContainer> routerDevMap;
         std::unordered_map<Region, ns3::NetDeviceContainer> hubDevMap;
+        std::unordered_map<Region, ns3::NetDeviceContainer> interDevMap;
         std::unordered_map<Region, ns3::NetDeviceContainer> leafDevMap;
         std::unordered_map<Region, ns3::Ipv4InterfaceContainer> routerInterfaceMap;
         std::unordered_map<Region, ns3::Ipv4InterfaceContainer> leafInterfaceMap;
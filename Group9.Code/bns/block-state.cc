@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cassert>
+#include "block-state.h"
+
+namespace bns
+{
+
+bool BlockState::HasChunk(uint16_t chunkID) const
+{
+    uint32_t word = chunkID / 64;
+    if (word >= chunkBits.size())
+        return false;
+    return (chunkBits[word] >> (chunkID % 64)) & 1;
+}
+
+bool BlockState::MarkChunk(uint16_t chunkID)
+{
+    uint32_t word = chunkID / 64;
+    if (word >= chunkBits.size())
+        chunkBits.resize(word + 1, 0);
+
+    uint64_t mask = uint64_t(1) << (chunkID % 64);
+    if (chunkBits[word] & mask)
+        return false;
+
+    chunkBits[word] |= mask;
+    nReceived++;
+    return true;
+}
+
+void BlockState::AddHolder(ns3::Ipv4Address addr, uint32_t max)
+{
+    if (holders.size() >= max)
+        return;
+    if (std::find(std::begin(holders), std::end(holders), addr) != std::end(holders))
+        return;
+    holders.push_back(addr);
+}
+
+void BlockState::ClearChunks()
+{
+    std::vector<uint64_t>().swap(chunkBits);
+    std::vector<ns3::Ipv4Address>().swap(holders);
+}
+
+BlockStateTable::BlockStateTable(uint32_t capacity) : m_size(0)
+{
+    uint32_t c = 1;
+    while (c < capacity)
+        c <<= 1;
+    m_slots.resize(c, Slot{false, BlockState()});
+}
+
+uint32_t
+BlockStateTable::IndexOf(uint64_t blockID) const
+{
+    // block IDs are random, but mix them anyway (splitmix64 finalizer)
+    uint64_t h = blockID;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h = h ^ (h >> 31);
+    return h & (m_slots.size() - 1);
+}
+
+BlockState *
+BlockStateTable::Find(uint64_t blockID)
+{
+    uint32_t mask = m_slots.size() - 1;
+    for (uint32_t i = IndexOf(blockID); m_slots[i].used; i = (i + 1) & mask)
+    {
+        if (m_slots[i].state.blockID == blockID)
+            return &m_slots[i].state;
+    }
+    return nullptr;
+}
+
+BlockState &
+BlockStateTable::Get(uint64_t blockID)
+{
+    BlockState *s = Find(blockID);
+    if (s)
+        return *s;
+
+    // keep the load factor below 3/4
+    if (4 * (m_size + 1) > 3 * m_slots.size())
+        Grow();
+
+    uint32_t mask = m_slots.size() - 1;
+    uint32_t i = IndexOf(blockID);
+    while (m_slots[i].used)
+        i = (i + 1) & mask;
+
+    BlockState fresh = BlockState();
+    fresh.blockID = blockID;
+    m_slots[i].used = true;
+    m_slots[i].state = fresh;
+    m_size++;
+    return m_slots[i].state;
+}
+
+void BlockStateTable::Erase(uint64_t blockID)
+{
+    uint32_t mask = m_slots.size() - 1;
+    uint32_t i = IndexOf(blockID);
+    while (m_slots[i].used && m_slots[i].state.blockID != blockID)
+        i = (i + 1) & mask;
+
+    if (!m_slots[i].used)
+        return;
+
+    // backward shift: move up following entries that would otherwise become
+    // unreachable from their home slot
+    uint32_t hole = i;
+    for (uint32_t j = (i + 1) & mask; m_slots[j].used; j = (j + 1) & mask)
+    {
+        uint32_t home = IndexOf(m_slots[j].state.blockID);
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            m_slots[hole] = std::move(m_slots[j]);
+            hole = j;
+        }
+    }
+    m_slots[hole].used = false;
+    m_slots[hole].state = BlockState();
+    m_size--;
+    assert(m_size < m_slots.size());
+}
+
+uint32_t
+BlockStateTable::Size() const
+{
+    return m_size;
+}
+
+void BlockStateTable::Grow()
+{
+    std::vector<Slot> old;
+    old.swap(m_slots);
+    m_slots.resize(old.size() * 2, Slot{false, BlockState()});
+
+    uint32_t mask = m_slots.size() - 1;
+    for (auto &s : old)
+    {
+        if (!s.used)
+            continue;
+        uint32_t i = IndexOf(s.state.blockID);
+        while (m_slots[i].used)
+            i = (i + 1) & mask;
+        m_slots[i] = std::move(s);
+    }
+}
+
+} // namespace bns
@@ -0,0 +1,120 @@
+/**
+ * This file declares the per-block reception state shared by the Kadcast
+ * and Mincast nodes.
+ */
+
+#ifndef BLOCK_STATE_H
+#define BLOCK_STATE_H
+
+#include <cstdint>
+#include <vector>
+#include "ns3/ipv4-address.h"
+
+namespace bns
+{
+
+/**
+ * \brief Reception state of a single block.
+ * Chunks are tracked in a bitmap instead of a map of chunk copies, since all
+ * chunks of a block carry the same block metadata.
+ */
+struct BlockState
+{
+    uint64_t blockID;
+    uint64_t prevID;
+    uint32_t blockSize;
+    uint16_t nChunks;       //!< Number of chunks needed to rebuild the block (0 if no chunk seen yet)
+    uint16_t nReceived;     //!< Popcount of the chunk bitmap
+    uint16_t maxSeenHeight; //!< Largest broadcast height the block was received with
+    bool heightSet;         //!< Whether maxSeenHeight carries a value
+    bool done;              //!< Block is complete (received or created locally)
+    bool requested;         //!< Block is being repaired (requested because it was missing or stalled)
+    uint16_t nRepairs;      //!< Repair rounds without completing the block
+    std::vector<uint64_t> chunkBits;
+    std::vector<ns3::Ipv4Address> holders; //!< Peers known to have the block
+
+    /**
+     * \brief Check if a chunk was already seen.
+     */
+    bool HasChunk(uint16_t chunkID) const;
+
+    /**
+     * \brief Mark a chunk as seen. Returns false if it was seen before.
+     */
+    bool MarkChunk(uint16_t chunkID);
+
+    /**
+     * \brief Remember a peer having the block, keeping at most max peers.
+     */
+    void AddHolder(ns3::Ipv4Address addr, uint32_t max);
+
+    /**
+     * \brief Drop the chunk bitmap and holders, keeping only the block flags.
+     */
+    void ClearChunks();
+};
+
+/**
+ * \brief Small open-addressing hash table (linear probing) of BlockStates
+ * keyed by block ID. Deletion uses backward shifting, so no tombstones are
+ * left behind and the table stays compact when entries are evicted.
+ */
+class BlockStateTable
+{
+public:
+    BlockStateTable(uint32_t capacity = 16);
+
+    /**
+     * \brief Returns the state of a block or nullptr if there is none.
+     */
+    BlockState *Find(uint64_t blockID);
+
+    /**
+     * \brief Returns the state of a block, creating a fresh one if needed.
+     * References are invalidated by subsequent Get and Erase calls.
+     */
+    BlockState &Get(uint64_t blockID);
+
+    /**
+     * \brief Remove the state of a block.
+     */
+    void Erase(uint64_t blockID);
+
+    /**
+     * \brief Remove all states the predicate returns true for.
+     * \return number of removed states
+     */
+    template <typename Pred>
+    uint32_t EraseIf(Pred pred)
+    {
+        std::vector<uint64_t> toErase;
+        for (auto &s : m_slots)
+        {
+            if (s.used && pred(s.state))
+                toErase.push_back(s.state.blockID);
+        }
+        for (auto blockID : toErase)
+        {
+            Erase(blockID);
+        }
+        return toErase.size();
+    }
+
+    uint32_t Size() const;
+
+private:
+    struct Slot
+    {
+        bool used;
+        BlockState state;
+    };
+
+    uint32_t IndexOf(uint64_t blockID) const;
+    void Grow();
+
+    std::vector<Slot> m_slots; //!< Capacity is always a power of two
+    uint32_t m_size;
+};
+
+} // namespace bns
+#endif /* BLOCK_STATE_H */
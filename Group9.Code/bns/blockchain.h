@@ -29,6 +29,16 @@ struct Block
     uint32_t blockSize;
 };
 
+/**
+ * \brief Represents a transaction of the background workload.
+ * Only relayed, never validated or put into blocks.
+ */
+struct Tx
+{
+    uint64_t txID;
+    uint32_t txSize;
+};
+
 class Blockchain
 {
 public:
@@ -18,22 +18,38 @@
 #include "bitcoin-data.h"
 #include "bitcoin-topology-helper.h"
 #include "mincast-node.h"
+#include "hiercast-node.h"
+#include "gossip-node.h"
+#include "miner-relay.h"
+#include "node-id-bench.h"
+#include "frame-reassembler-bench.h"
 
 NS_LOG_COMPONENT_DEFINE("BNS");
 
 static double totalTraffic = 0;
+static double intercontinentalTraffic = 0;
 static void ReceivedPacket(ns3::Ptr<const ns3::Packet> packet);
+static void ReceivedIntercontinentalPacket(ns3::Ptr<const ns3::Packet> packet);
 void SetReceivedCallback(bns::BitcoinTopologyHelper &topology);
 
 ns3::ApplicationContainer buildStarTopology(struct bnsParams &params);
 ns3::ApplicationContainer buildGeoTopology(struct bnsParams &params);
+void setupHierarchy(struct bnsParams &params, bns::BitcoinTopologyHelper &topology, ns3::ApplicationContainer apps);
+void assignStacks(struct bnsParams &params, bns::BitcoinTopologyHelper &topology);
 
 void evaluate(struct bnsParams &params, ns3::ApplicationContainer apps);
 void collectPropagationData(struct bnsParams &params, struct bnsResults &res, ns3::ApplicationContainer apps);
 void collectTrafficData(struct bnsParams &params, struct bnsResults &res, ns3::ApplicationContainer apps);
+void collectOverlayData(struct bnsParams &params, struct bnsResults &res, ns3::ApplicationContainer apps);
+void collectMixData(struct bnsParams &params, struct bnsResults &res, ns3::ApplicationContainer apps);
+void setupChurn(struct bnsParams &params, ns3::ApplicationContainer apps);
+void setupIbd(struct bnsParams &params, ns3::ApplicationContainer apps);
+void setupMinerRelay(struct bnsParams &params, ns3::ApplicationContainer apps);
+void setupTxWorkload(struct bnsParams &params, ns3::ApplicationContainer apps);
 void writeResults(struct bnsParams &params, struct bnsResults &res);
 
 double median(std::vector<double> scores);
+double percentile(std::vector<double> scores, double p);
 
 struct bnsParams
 {
@@ -52,16 +68,71 @@ struct bnsParams
 
     // vanilla specific
     bool unsolicited = false;
+    bool compact = false;
+    double mempoolOverlap = 0.95;
+    uint16_t perigeeRound = 0;
+    double trickleOutbound = 0.0;
+    double trickleInbound = 0.0;
+
+    // vanilla and mincast announcements
+    double announceDelay = 0.0;
+    uint16_t announceBatch = 16;
 
     // kadcast specific
     uint16_t kadK = 100;
     uint16_t kadAlpha = 3;
     uint16_t kadBeta = 3;
     double kadFecOverhead = 0.1;
+    bool kadFecAdaptive = false;
+    double kadFecMin = 0.05;
+    double kadFecMax = 0.5;
+    std::string kadChunkOrder = "serial";
+    double kadCoverageTarget = 0.0;
+    bool benchIds = false;
+    bool benchRecv = false;
+    uint32_t kadStateDepth = 6;
+    bool kadProximity = false;
+    bool kadGeoIds = false;
+    double kadRefreshInterval = 3600.0;
 
     // mincast specific
     bool mincastUseScores = false;
 
+    // hiercast specific
+    uint16_t hierReps = 1;
+    uint16_t hierFanout = 4;
+
+    // gossip specific
+    uint16_t gossipD = 6;
+    uint16_t gossipDLazy = 6;
+    double gossipHeartbeat = 1000.0;
+
+    // churn
+    double churnFraction = 0.0;
+    double churnSession = 60.0;
+    double churnOffline = 30.0;
+    std::string churnDist = "exp";
+    double churnShape = 0.0;
+
+    // relay network among the miners
+    bool minerRelay = false;
+    double relayFecOverhead = 0.2;
+
+    // initial block download benchmark
+    uint32_t ibdNodes = 0;
+    double ibdStart = 60.0;
+
+    // background transaction workload
+    double txRate = 0.0;
+    uint32_t txSize = 500;
+    std::string txSizeDist = "exp";
+    bool txLowPriority = false;
+
+    // mixed deployment of vanilla and kadcast
+    double mixKadcast = 0.3;
+    std::string mixRegions = "none";
+    double mixGateways = 0.05;
+
     // star topo specific
     std::string starLeafDataRate = "50Mbps";
     std::string starHubDataRate = "100Gbps";
@@ -75,13 +146,120 @@ struct bnsResults
     double avgTTLB = 0.0;
     double medianTTFB = 0.0;
     double medianTTLB = 0.0;
+    double p90TTFB = 0.0;
+    double p90TTLB = 0.0;
+    double earlyTTLB = 0.0; // avg. TTLB of the first half of the blocks mined
+    double lateTTLB = 0.0;  // avg. TTLB of the second half
+    double minerDelay = 0.0; // avg. TTLB of the miners for blocks of other miners
     double staleRate = 0.0;
     double coverage = 0.0;
     double overheadRatio = 0.0;
     double totalTraffic = 0;
     double necessaryTraffic = 0;
+    double repairTraffic = 0;
+    double repairOverheadRatio = 0.0;
+    double avgFecOverhead = 0.0;
+    double intercontinentalTraffic = 0;
+    double pushShare = 0.0;
+
+    // batched INFORM, INV and HEADERS messages
+    double announceMessages = 0;
+    double avgAnnounceBatch = 0.0;
+    double avgAnnounceWait = 0.0;
+    double avgUplinkBacklog = 0.0; // bytes queued on the uplink when a vanilla announcement is sent
+
+    // vanilla compact blocks
+    double compactBlocks = 0;
+    double blockTxnShare = 0.0;
+
+    // kadcast/mincast node lookups and routing tables
+    std::vector<bns::LookupStats> lookupValues;
+    double avgLookupHops = 0.0;
+    double avgLookupMessages = 0.0;
+    double avgLookupTime = 0.0;
+    double lookupTimeoutRate = 0.0;
+    double avgBucketRtt = 0.0;
+    double avgFanout = 0.0;
+
+    // kadcast send scheduler, time packets waited per traffic class
+    double avgControlDelay = 0.0;
+    double avgBlockDelay = 0.0;
+    double avgRepairDelay = 0.0;
+
+    // churn
+    double churnRate = 0.0;
+
+    // initial block download
+    double ibdBlocks = 0;
+    double avgSyncTime = 0.0;
+    double ibdSyncedShare = 0.0;
+
+    // background transactions
+    double nTxs = 0;
+    double txCoverage = 0.0;
+
+    // mixed deployment, per sub-population
+    double mixVanillaTTLB = 0.0;
+    double mixKadcastTTLB = 0.0;
+    double mixGatewayTTLB = 0.0;
+    double mixVanillaCoverage = 0.0;
+    double mixKadcastCoverage = 0.0;
+    double mixGatewayCoverage = 0.0;
+
+    // gossip mesh
+    double gossipLazyShare = 0.0; // share of the received blocks fetched with IWANT
+    double avgMeshSize = 0.0;
+};
+
+struct churnModel
+{
+    std::string dist;
+    double shape;
+    double session; // mean online time in seconds
+    double offline; // mean offline time in seconds
+    uint32_t nLeaves = 0;
+};
+
+static struct churnModel churn;
+static ns3::Time churnTime(double mean);
+static void churnLeave(ns3::Ptr<bns::BitcoinNode> app);
+static void churnRejoin(ns3::Ptr<bns::BitcoinNode> app);
+
+struct ibdModel
+{
+    std::vector<ns3::Ptr<bns::BitcoinNode>> joiners;
+    std::vector<ns3::Ptr<bns::BitcoinNode>> others;
+    uint32_t target = 0; // height the joiners need to reach
+    ns3::Time start;
+    std::vector<double> syncTimes;
+    std::set<uint32_t> synced;
+};
+
+static struct ibdModel ibd;
+static void ibdJoin();
+static void ibdCheck();
+
+struct txModel
+{
+    std::vector<ns3::Ptr<bns::BitcoinNode>> nodes;
+    double rate; // transactions per second in the whole network
+    double size; // mean bytes per transaction
+    std::string dist;
+    uint64_t nTxs = 0;
 };
 
+static struct txModel workload;
+static void txArrival();
+static uint32_t txSize();
+
+struct mixModel
+{
+    std::vector<std::string> stacks; // vanilla, kadcast or gateway, per node of the geo topology
+};
+
+static struct mixModel mix;
+static std::vector<ns3::Ipv4Address> mixBootstrap(struct bnsParams &params, bns::BitcoinTopologyHelper &topology, const std::string &overlay);
+
 int main(int argc, char *argv[])
 {
     ns3::LogComponentEnableAll(ns3::LOG_PREFIX_ALL);
@@ -96,6 +274,12 @@ int main(int argc, char *argv[])
     ns3::LogComponentEnable("BNSKadcastMessages", ns3::LOG_LEVEL_INFO);
     ns3::LogComponentEnable("BNSMincastNode", ns3::LOG_LEVEL_INFO);
     ns3::LogComponentEnable("BNSMincastMessages", ns3::LOG_LEVEL_INFO);
+    ns3::LogComponentEnable("BNSNodeIdBench", ns3::LOG_LEVEL_INFO);
+    ns3::LogComponentEnable("BNSFrameReassemblerBench", ns3::LOG_LEVEL_INFO);
+    ns3::LogComponentEnable("BNSHiercastNode", ns3::LOG_LEVEL_INFO);
+    ns3::LogComponentEnable("BNSHiercastMessages", ns3::LOG_LEVEL_INFO);
+    ns3::LogComponentEnable("BNSGossipNode", ns3::LOG_LEVEL_INFO);
+    ns3::LogComponentEnable("BNSGossipMessages", ns3::LOG_LEVEL_INFO);
 
     struct bnsParams params;
     ns3::CommandLine cmd;
@@ -108,49 +292,246 @@ int main(int argc, char *argv[])
     cmd.AddValue("blockSizeFactor", "Set how big blocks are (as a factor of 1 MB)", params.blockSizeFactor);
     cmd.AddValue("blockIntervalFactor", "Set how fast blocks are produced are (as a factor of 10 minutes)", params.blockIntervalFactor);
     cmd.AddValue("byzantineFactor", "Set what part of nodes are byzantine", params.byzantineFactor);
-    cmd.AddValue("net", "Set the network stack (vanilla or kadcast or mincast)", params.netStack);
+    cmd.AddValue("net", "Set the network stack (vanilla or kadcast or mincast or hiercast or gossip, or mixed for vanilla and kadcast nodes side by side)", params.netStack);
     cmd.AddValue("topo", "Set the network topology (star or geo)", params.topo);
 
     cmd.AddValue("unsolicited", "Vanilla: Enable unsolicited block transmission.", params.unsolicited);
+    cmd.AddValue("compact", "Vanilla: Enable compact block relay (BIP152), pushed to three high-bandwidth peers.", params.compact);
+    cmd.AddValue("perigeeRound", "Vanilla: Replace the outgoing peer announcing the blocks of a round latest after this many blocks (Perigee), 0 keeps the peers.", params.perigeeRound);
+    cmd.AddValue("mempoolOverlap", "Vanilla: Mean share of the transactions of a compact block a node already has, the rest is fetched with GETBLOCKTXN. Nodes of the geo topology are spread uniformly around it.", params.mempoolOverlap);
+    cmd.AddValue("announceDelay", "Vanilla or Mincast: Milliseconds block announcements (INV, HEADERS, INFORM) to a peer are held to be sent together, 0 sends each at once.", params.announceDelay);
+    cmd.AddValue("trickleOutbound", "Vanilla: Mean milliseconds of the Poisson timer flushing the announcements to each outgoing peer, 0 uses announceDelay.", params.trickleOutbound);
+    cmd.AddValue("trickleInbound", "Vanilla: Mean milliseconds of the Poisson timer, shared by all incoming peers, flushing the announcements to them, 0 uses announceDelay.", params.trickleInbound);
+    cmd.AddValue("announceBatch", "Vanilla or Mincast: Send the held announcements to a peer as soon as this many block IDs are waiting.", params.announceBatch);
 
     cmd.AddValue("kadK", "Kadcast or Mincast: Set the bucket size k.", params.kadK);
     cmd.AddValue("kadAlpha", "Kadcast or Mincast: Set the alpha factor determining the number of parallel lookup requests.", params.kadAlpha);
     cmd.AddValue("kadBeta", "Kadcast or Mincast: Set the beta factor determining the number of parallel broadcast operations.", params.kadBeta);
     cmd.AddValue("kadFecOverhead", "Kadcast or Mincast: Set the FEC overhead factor.", params.kadFecOverhead);
-    cmd.AddValue("mincastUseScores", "Mincast: Use scores to determine sending BLOCK or INFORM message, instead of percentages.", params.mincastUseScores);
+    cmd.AddValue("kadFecAdaptive", "Kadcast or Mincast: Choose the FEC overhead per destination from the losses it reports (kadFecOverhead until the first report).", params.kadFecAdaptive);
+    cmd.AddValue("kadFecMin", "Kadcast or Mincast: Lower bound of the adaptive FEC overhead factor.", params.kadFecMin);
+    cmd.AddValue("kadFecMax", "Kadcast or Mincast: Upper bound of the adaptive FEC overhead factor.", params.kadFecMax);
+    cmd.AddValue("kadChunkOrder", "Kadcast or Mincast: Order of the chunks sent to the destinations of a broadcast (serial, rr or weighted by bucket height).", params.kadChunkOrder);
+    cmd.AddValue("kadCoverageTarget", "Kadcast: Adapt the fanout of every bucket within [1, kadBeta] to reach this share of blocks delivered without repair (0: fixed kadBeta).", params.kadCoverageTarget);
+    cmd.AddValue("benchIds", "Only run the node ID microbenchmark (64, 160 and 256 bit IDs) and exit.", params.benchIds);
+    cmd.AddValue("benchRecv", "Only run the Vanilla receive path microbenchmark (1, 8 and 32 MB blocks) and exit.", params.benchRecv);
+    cmd.AddValue("kadProximity", "Kadcast: Fill buckets with the lowest-RTT nodes and weight broadcast peers by RTT.", params.kadProximity);
+    cmd.AddValue("kadGeoIds", "Kadcast: Prefix node IDs with their region (geo topology), so the low buckets hold nearby nodes.", params.kadGeoIds);
+    cmd.AddValue("kadStateDepth", "Kadcast or Mincast: Number of confirmations after which per-block reception state is dropped, 0 keeps it forever.", params.kadStateDepth);
+    cmd.AddValue("kadRefreshInterval", "Kadcast or Mincast: Mean interval of bucket refreshes and liveness checks in seconds.", params.kadRefreshInterval);
+    cmd.AddValue("mincastUseScores", "Mincast: Push the BLOCK or send an INFORM depending on the measured RTT, goodput and block need of every peer, instead of a fixed share.", params.mincastUseScores);
+    cmd.AddValue("hierReps", "Hiercast: Number of representatives per region the origin pushes a block to, each roots a tree in its region.", params.hierReps);
+    cmd.AddValue("hierFanout", "Hiercast: Fanout of the trees inside a region.", params.hierFanout);
+    cmd.AddValue("gossipD", "Gossip: Target number of mesh peers blocks are pushed to, kept within [5/6, 2] times this.", params.gossipD);
+    cmd.AddValue("gossipDLazy", "Gossip: Number of peers outside the mesh that get IHAVEs every heartbeat.", params.gossipDLazy);
+    cmd.AddValue("gossipHeartbeat", "Gossip: Milliseconds between mesh maintenance and gossip rounds.", params.gossipHeartbeat);
+
+    cmd.AddValue("churnFraction", "Share of the nodes that leave and rejoin the network (miners never leave), 0 disables churn.", params.churnFraction);
+    cmd.AddValue("churnSession", "Mean online session length of churning nodes in minutes.", params.churnSession);
+    cmd.AddValue("churnOffline", "Mean offline time of churning nodes in minutes.", params.churnOffline);
+    cmd.AddValue("churnDist", "Session length distribution (exp, pareto or weibull).", params.churnDist);
+    cmd.AddValue("churnShape", "Shape of the pareto (default 2) or weibull (default 0.5) distribution, 0 uses the default.", params.churnShape);
+
+    cmd.AddValue("minerRelay", "Relay blocks among the miners over UDP with FEC (FIBRE), next to the selected network stack.", params.minerRelay);
+    cmd.AddValue("relayFecOverhead", "Share of redundant chunks the miner relay sends.", params.relayFecOverhead);
+
+    cmd.AddValue("ibdNodes", "Number of nodes (no miners) that join late and download the whole chain, 0 disables the sync benchmark.", params.ibdNodes);
+    cmd.AddValue("ibdStart", "Minutes after which the ibdNodes join.", params.ibdStart);
+
+    cmd.AddValue("txRate", "Transactions per second created at random nodes and relayed next to the blocks, 0 disables the workload.", params.txRate);
+    cmd.AddValue("txSize", "Mean transaction size in bytes.", params.txSize);
+    cmd.AddValue("txSizeDist", "Transaction size distribution (fixed, exp or pareto).", params.txSizeDist);
+    cmd.AddValue("txLowPriority", "Kadcast: Send transactions only while no block chunk is waiting, instead of in arrival order with them.", params.txLowPriority);
+
+    cmd.AddValue("mixKadcast", "Mixed: Share of the nodes running Kadcast, the others run Vanilla.", params.mixKadcast);
+    cmd.AddValue("mixRegions", "Mixed: Regions whose nodes run Kadcast instead of mixKadcast, joined by + (e.g. EU+AS), none uses the share.", params.mixRegions);
+    cmd.AddValue("mixGateways", "Mixed: Share of the nodes running both stacks on one blockchain, relaying blocks between the overlays.", params.mixGateways);
 
     cmd.AddValue("starLeafDataRate", "Set the data rate for each link", params.starLeafDataRate);
     cmd.AddValue("starHubRate", "Set the data rate for the star network hub", params.starHubDataRate);
 
     cmd.Parse(argc, argv);
 
+    if (params.benchIds)
+    {
+        bns::BenchmarkNodeIds(1000, 20, 2000);
+        return 0;
+    }
+
+    if (params.benchRecv)
+    {
+        bns::BenchmarkReassembly(1448, 5);
+        return 0;
+    }
+
     if (params.nMiners != 1 && params.nMiners % bns::btcNumPools != 0)
     {
         NS_LOG_INFO("Please pick either a single miner, or a multiple of 16 (as there are 16 major bitcoin pools).");
         return -1;
     }
 
+    if (params.churnDist != "exp" && params.churnDist != "pareto" && params.churnDist != "weibull")
+    {
+        NS_LOG_INFO("Please pick exp, pareto or weibull as churn distribution.");
+        return -1;
+    }
+
+    bns::ChunkOrder chunkOrder;
+    if (!bns::ParseChunkOrder(params.kadChunkOrder, chunkOrder))
+    {
+        NS_LOG_INFO("Please pick serial, rr or weighted as chunk order.");
+        return -1;
+    }
+
+    if (params.netStack == "hiercast" && (params.topo != "geo" || params.hierReps == 0 || params.hierFanout == 0))
+    {
+        NS_LOG_INFO("Hiercast needs the geo topology, at least one representative per region and a fanout of at least 1.");
+        return -1;
+    }
+
+    if (params.netStack == "gossip" && (params.gossipD == 0 || params.gossipHeartbeat <= 0))
+    {
+        NS_LOG_INFO("Gossip needs a mesh degree of at least 1 and a positive heartbeat.");
+        return -1;
+    }
+
+    if (params.announceDelay < 0 || params.announceBatch == 0)
+    {
+        NS_LOG_INFO("Please pick a non-negative announce delay and an announce batch of at least 1.");
+        return -1;
+    }
+
+    if (params.trickleOutbound < 0 || params.trickleInbound < 0)
+    {
+        NS_LOG_INFO("Please pick non-negative trickle delays.");
+        return -1;
+    }
+
+    if (params.unsolicited && params.compact)
+    {
+        NS_LOG_INFO("Please pick either unsolicited or compact block relay.");
+        return -1;
+    }
+
+    if (params.mempoolOverlap < 0 || params.mempoolOverlap > 1)
+    {
+        NS_LOG_INFO("Please pick a mempool overlap in [0, 1].");
+        return -1;
+    }
+
+    if (params.relayFecOverhead < 0)
+    {
+        NS_LOG_INFO("Please pick a non-negative relay FEC overhead.");
+        return -1;
+    }
+
+    if (params.ibdNodes > 0 && (params.churnFraction > 0 || params.ibdStart <= 0 || params.ibdStart >= params.nMinutes))
+    {
+        NS_LOG_INFO("Please run the sync benchmark without churn and let the ibdNodes join within the simulated time.");
+        return -1;
+    }
+
+    if (params.txRate < 0 || params.txSize == 0 || (params.txSizeDist != "fixed" && params.txSizeDist != "exp" && params.txSizeDist != "pareto"))
+    {
+        NS_LOG_INFO("Please pick a non-negative transaction rate, a positive transaction size and fixed, exp or pareto as its distribution.");
+        return -1;
+    }
+
+    if (params.txRate > 0 && params.netStack == "hiercast")
+    {
+        NS_LOG_INFO("Hiercast does not relay transactions, please run the workload with vanilla, kadcast or mincast.");
+        return -1;
+    }
+
+    if (params.netStack == "mixed")
+    {
+        bool validRegions = true;
+        if (params.mixRegions != "none")
+        {
+            std::stringstream ss(params.mixRegions);
+            std::string region;
+            std::vector<std::string> regions = {"NA", "EU", "AS", "OC", "AF", "SA", "CN"};
+            while (std::getline(ss, region, '+'))
+                validRegions = validRegions && std::find(regions.begin(), regions.end(), region) != regions.end();
+        }
+        if (params.topo != "geo" || !validRegions || params.mixKadcast < 0 || params.mixGateways < 0 || params.mixKadcast + params.mixGateways > 1)
+        {
+            NS_LOG_INFO("A mixed deployment needs the geo topology, kadcast and gateway shares adding up to at most 1 and regions out of NA, EU, AS, OC, AF, SA and CN.");
+            return -1;
+        }
+    }
+
+    if (params.kadCoverageTarget < 0 || params.kadCoverageTarget >= 1)
+    {
+        NS_LOG_INFO("Please pick a coverage target in [0, 1).");
+        return -1;
+    }
+
     bns::BitcoinMiner::blockSizeFactor = params.blockSizeFactor;
     bns::BitcoinMiner::blockIntervalFactor = params.blockIntervalFactor;
 
     bns::BitcoinNode::nBlocks = params.nBlocks;
+    // a node remembers the transactions of the last two minutes, relaying one takes seconds
+    if (params.txRate > 0)
+        bns::BitcoinNode::nKnownTxs = std::max(1000.0, params.txRate * 120);
 
     if (params.unsolicited)
     {
         NS_LOG_INFO("Enabled unsolicited block relay.");
         bns::VanillaNode::vanBroadcastType = bns::BroadcastType::UNSOLICITED;
     }
+    if (params.compact)
+    {
+        NS_LOG_INFO("Enabled compact block relay.");
+        bns::VanillaNode::vanBroadcastType = bns::BroadcastType::COMPACT;
+    }
+    bns::VanillaNode::mempoolOverlap = params.mempoolOverlap;
+    bns::VanillaNode::perigeeRound = params.perigeeRound;
+    bns::VanillaNode::announceDelay = params.announceDelay / 1000;
+    bns::VanillaNode::announceBatch = params.announceBatch;
+    bns::VanillaNode::trickleOutbound = params.trickleOutbound / 1000;
+    bns::VanillaNode::trickleInbound = params.trickleInbound / 1000;
 
     bns::KadcastNode::kadK = params.kadK;
     bns::KadcastNode::kadAlpha = params.kadAlpha;
     bns::KadcastNode::kadBeta = params.kadBeta;
     bns::KadcastNode::kadFecOverhead = params.kadFecOverhead;
+    bns::KadcastNode::kadFecAdaptive = params.kadFecAdaptive;
+    bns::KadcastNode::kadFecMin = params.kadFecMin;
+    bns::KadcastNode::kadFecMax = params.kadFecMax;
+    bns::KadcastNode::kadChunkOrder = chunkOrder;
+    bns::KadcastNode::kadCoverageTarget = params.kadCoverageTarget;
+    bns::KadcastNode::kadStateDepth = params.kadStateDepth;
+    bns::KadcastNode::kadProximity = params.kadProximity;
+    bns::KadcastNode::kadGeoIds = params.kadGeoIds;
+    bns::KadcastNode::kadTxLowPriority = params.txLowPriority;
+    bns::KadcastNode::kadRefreshInterval = params.kadRefreshInterval;
 
     bns::MincastNode::kadK = params.kadK;
     bns::MincastNode::kadAlpha = params.kadAlpha;
     bns::MincastNode::kadBeta = params.kadBeta;
     bns::MincastNode::kadFecOverhead = params.kadFecOverhead;
+    bns::MincastNode::kadFecAdaptive = params.kadFecAdaptive;
+    bns::MincastNode::kadFecMin = params.kadFecMin;
+    bns::MincastNode::kadFecMax = params.kadFecMax;
+    bns::MincastNode::kadChunkOrder = chunkOrder;
+    bns::MincastNode::kadStateDepth = params.kadStateDepth;
+    bns::MincastNode::kadRefreshInterval = params.kadRefreshInterval;
     bns::MincastNode::mincastUseScores = params.mincastUseScores;
+    bns::MincastNode::announceDelay = params.announceDelay / 1000;
+    bns::MincastNode::announceBatch = params.announceBatch;
+
+    bns::MinerRelay::relayFecOverhead = params.relayFecOverhead;
+
+    bns::HiercastNode::hierReps = params.hierReps;
+    bns::HiercastNode::hierFanout = params.hierFanout;
+
+    // bounds around the target degree as in gossipsub (5 and 12 for 6)
+    bns::GossipNode::gossipD = params.gossipD;
+    bns::GossipNode::gossipDLow = std::max(1, params.gossipD * 5 / 6);
+    bns::GossipNode::gossipDHigh = 2 * params.gossipD;
+    bns::GossipNode::gossipDLazy = params.gossipDLazy;
+    bns::GossipNode::gossipHeartbeat = params.gossipHeartbeat / 1000;
 
     ns3::RngSeedManager::SetSeed(time(0));
 
@@ -189,6 +570,11 @@ int main(int argc, char *argv[])
 
     NS_LOG_INFO("Marked " << byzApps.size() << " nodes as byzantine.");
 
+    setupChurn(params, apps);
+    setupIbd(params, apps);
+    setupMinerRelay(params, apps);
+    setupTxWorkload(params, apps);
+
     //pointToPoint.EnablePcapAll ("KadcastTest");
     //ns3::Ipv4GlobalRoutingHelper g;
     //ns3::Ptr<ns3::OutputStreamWrapper> routingStream = ns3::Create<ns3::OutputStreamWrapper>
@@ -211,9 +597,289 @@ void evaluate(struct bnsParams &params, ns3::ApplicationContainer apps)
     struct bnsResults res;
     collectPropagationData(params, res, apps);
     collectTrafficData(params, res, apps);
+    collectOverlayData(params, res, apps);
+    if (params.netStack == "mixed")
+        collectMixData(params, res, apps);
+
+    if (params.churnFraction > 0)
+    {
+        res.churnRate = churn.nLeaves / (params.nPeers * params.nMinutes / 60.0);
+        NS_LOG_INFO("Churn rate: " << res.churnRate << " leaves per node and hour (" << params.churnDist << "), coverage: " << res.coverage << ", avg. TTLB: " << res.avgTTLB);
+    }
+
+    if (params.ibdNodes > 0)
+    {
+        res.ibdBlocks = ibd.target;
+        res.ibdSyncedShare = ibd.syncTimes.size() / (double)ibd.joiners.size();
+        if (!ibd.syncTimes.empty())
+            res.avgSyncTime = std::accumulate(ibd.syncTimes.begin(), ibd.syncTimes.end(), 0.0) / ibd.syncTimes.size();
+
+        uint32_t nStalls = 0;
+        for (auto &app : ibd.joiners)
+        {
+            if (ns3::Ptr<bns::VanillaNode> v = ns3::DynamicCast<bns::VanillaNode>(app))
+                nStalls += v->GetNStalls();
+        }
+        NS_LOG_INFO("Sync (" << params.netStack << "): " << res.ibdBlocks << " blocks, avg. sync time: " << res.avgSyncTime << " s, synced: " << res.ibdSyncedShare << " of " << ibd.joiners.size() << " nodes, stalls: " << nStalls);
+    }
+
+    // block propagation against runs with a lower txRate
+    if (params.txRate > 0)
+    {
+        double nReceived = 0;
+        double txDelay = 0;
+        uint32_t nKadcast = 0;
+        for (uint32_t i = 0; i < apps.GetN(); ++i)
+        {
+            ns3::Ptr<bns::BitcoinNode> app = apps.Get(i)->GetObject<bns::BitcoinNode>();
+            nReceived += app->GetNReceivedTxs();
+            if (ns3::Ptr<bns::KadcastNode> k = ns3::DynamicCast<bns::KadcastNode>(app))
+            {
+                txDelay += k->GetMeanSendDelay(bns::TrafficClass::TX).GetSeconds() * 1000;
+                nKadcast++;
+            }
+        }
+        res.nTxs = workload.nTxs;
+        if (workload.nTxs > 0)
+            res.txCoverage = nReceived / (workload.nTxs * (params.nPeers - 1));
+        NS_LOG_INFO("Transactions: " << res.nTxs << " at " << params.txRate << " tx/s (" << params.txSizeDist << ", mean " << params.txSize << " bytes), coverage: " << res.txCoverage << ", avg. TTFB: " << res.avgTTFB << ", avg. TTLB: " << res.avgTTLB << ", p90 TTLB: " << res.p90TTLB);
+        if (nKadcast > 0)
+            NS_LOG_INFO("Avg. transaction send delay: " << txDelay / nKadcast << " ms");
+    }
     writeResults(params, res);
 }
 
+void setupTxWorkload(struct bnsParams &params, ns3::ApplicationContainer apps)
+{
+    if (params.txRate <= 0)
+        return;
+
+    workload.rate = params.txRate;
+    workload.size = params.txSize;
+    workload.dist = params.txSizeDist;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+        workload.nodes.push_back(apps.Get(i)->GetObject<bns::BitcoinNode>());
+
+    // the nodes connect first, like the miners
+    ns3::Simulator::Schedule(ns3::Seconds(200), &txArrival);
+    NS_LOG_INFO("Transaction workload: " << params.txRate << " tx/s, mean size: " << params.txSize << " bytes (" << params.txSizeDist << ")");
+}
+
+static void txArrival()
+{
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    ns3::Ptr<bns::BitcoinNode> app = workload.nodes[x->GetInteger(0, workload.nodes.size() - 1)];
+
+    // transactions created while their node is offline are lost
+    if (app->IsRunning())
+    {
+        bns::Tx tx;
+        tx.txID = ++workload.nTxs;
+        tx.txSize = txSize();
+        app->NotifyNewTx(tx);
+    }
+
+    // poisson arrivals
+    double next = -std::log(x->GetValue(1e-9, 1.0)) / workload.rate;
+    ns3::Simulator::Schedule(ns3::Seconds(next), &txArrival);
+}
+
+static uint32_t txSize()
+{
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    double u = x->GetValue(1e-9, 1.0);
+
+    // sample by inverse transform, scaled to the given mean
+    double s = workload.size;
+    if (workload.dist == "pareto")
+    {
+        double a = 2.0;
+        s = workload.size * (a - 1) / a / std::pow(u, 1 / a);
+    }
+    else if (workload.dist == "exp")
+    {
+        s = -workload.size * std::log(u);
+    }
+    // from a bare input and output to the standard size limit
+    return std::max(60.0, std::min(s, 100000.0));
+}
+
+void setupChurn(struct bnsParams &params, ns3::ApplicationContainer apps)
+{
+    if (params.churnFraction <= 0)
+        return;
+
+    churn.dist = params.churnDist;
+    churn.shape = params.churnShape;
+    churn.session = params.churnSession * 60;
+    churn.offline = params.churnOffline * 60;
+
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+    {
+        if (!apps.Get(i)->GetObject<bns::BitcoinNode>()->IsMiner())
+            candidates.push_back(i);
+    }
+    uint32_t nChurn = std::min((uint32_t)candidates.size(), (uint32_t)(params.nPeers * params.churnFraction));
+
+    // start in the steady state: a churning node is online with probability session / (session + offline)
+    double pOnline = churn.session / (churn.session + churn.offline);
+    uint32_t nOffline = 0;
+
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    for (uint32_t j = 0; j < nChurn; j++)
+    {
+        // pick a random node among the remaining candidates
+        uint32_t k = x->GetInteger(j, candidates.size() - 1);
+        std::swap(candidates[j], candidates[k]);
+        ns3::Ptr<bns::BitcoinNode> app = apps.Get(candidates[j])->GetObject<bns::BitcoinNode>();
+
+        ns3::Time joinTime = ns3::Seconds(2.0);
+        if (x->GetValue() >= pOnline)
+        {
+            joinTime += churnTime(churn.offline);
+            app->SetStartTime(joinTime);
+            nOffline++;
+        }
+        ns3::Simulator::Schedule(joinTime + churnTime(churn.session), &churnLeave, app);
+    }
+
+    NS_LOG_INFO("Churning " << nChurn << " nodes (" << nOffline << " join late), mean session: " << params.churnSession << " min, mean offline: " << params.churnOffline << " min, distribution: " << params.churnDist);
+}
+
+static ns3::Time churnTime(double mean)
+{
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    double u = x->GetValue(1e-9, 1.0);
+
+    // sample by inverse transform, scaled to the given mean
+    double t;
+    if (churn.dist == "pareto")
+    {
+        double a = churn.shape > 1.0 ? churn.shape : 2.0; // needs a > 1 for a finite mean
+        double xm = mean * (a - 1) / a;
+        t = xm / std::pow(u, 1 / a);
+    }
+    else if (churn.dist == "weibull")
+    {
+        double k = churn.shape > 0.0 ? churn.shape : 0.5;
+        double lambda = mean / std::tgamma(1 + 1 / k);
+        t = lambda * std::pow(-std::log(u), 1 / k);
+    }
+    else
+    {
+        t = -mean * std::log(u);
+    }
+    return ns3::Seconds(t);
+}
+
+static void churnLeave(ns3::Ptr<bns::BitcoinNode> app)
+{
+    app->Leave();
+    churn.nLeaves++;
+    ns3::Simulator::Schedule(churnTime(churn.offline), &churnRejoin, app);
+}
+
+static void churnRejoin(ns3::Ptr<bns::BitcoinNode> app)
+{
+    app->Rejoin();
+    ns3::Simulator::Schedule(churnTime(churn.session), &churnLeave, app);
+}
+
+void setupMinerRelay(struct bnsParams &params, ns3::ApplicationContainer apps)
+{
+    if (!params.minerRelay)
+        return;
+
+    std::vector<ns3::Ptr<bns::BitcoinNode>> miners;
+    std::vector<ns3::Ipv4Address> addresses;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+    {
+        ns3::Ptr<bns::BitcoinNode> app = apps.Get(i)->GetObject<bns::BitcoinNode>();
+        if (app->IsMiner())
+        {
+            miners.push_back(app);
+            addresses.push_back(app->GetAddress());
+        }
+    }
+
+    for (auto &app : miners)
+    {
+        ns3::Ptr<bns::MinerRelay> relay = ns3::CreateObject<bns::MinerRelay>(ns3::PeekPointer(app), app->GetAddress());
+        relay->SetMiners(addresses);
+        app->GetNode()->AddApplication(relay);
+        relay->SetStartTime(ns3::Seconds(2.0));
+        app->SetRelay(ns3::PeekPointer(relay));
+    }
+    NS_LOG_INFO("Miner relay among " << miners.size() << " miners, FEC overhead: " << params.relayFecOverhead);
+}
+
+void setupIbd(struct bnsParams &params, ns3::ApplicationContainer apps)
+{
+    if (params.ibdNodes == 0)
+        return;
+
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+    {
+        ns3::Ptr<bns::BitcoinNode> app = apps.Get(i)->GetObject<bns::BitcoinNode>();
+        if (app->IsMiner())
+            ibd.others.push_back(app);
+        else
+            candidates.push_back(i);
+    }
+    uint32_t nJoiners = std::min((uint32_t)candidates.size(), params.ibdNodes);
+
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    for (uint32_t j = 0; j < candidates.size(); j++)
+    {
+        // pick a random node among the remaining candidates
+        if (j < nJoiners)
+        {
+            uint32_t k = x->GetInteger(j, candidates.size() - 1);
+            std::swap(candidates[j], candidates[k]);
+        }
+        ns3::Ptr<bns::BitcoinNode> app = apps.Get(candidates[j])->GetObject<bns::BitcoinNode>();
+        if (j < nJoiners)
+        {
+            app->SetStartTime(ns3::Minutes(params.ibdStart));
+            ibd.joiners.push_back(app);
+        }
+        else
+        {
+            ibd.others.push_back(app);
+        }
+    }
+
+    ns3::Simulator::Schedule(ns3::Minutes(params.ibdStart), &ibdJoin);
+    NS_LOG_INFO("Sync benchmark: " << nJoiners << " nodes join after " << params.ibdStart << " min");
+}
+
+static void ibdJoin()
+{
+    // the joiners need to catch up on the best chain any running node has
+    for (auto &app : ibd.others)
+        ibd.target = std::max(ibd.target, app->GetBlockchain()->GetTopBlockHeight());
+    ibd.start = ns3::Simulator::Now();
+    if (ibd.target == 0)
+        NS_LOG_WARN("Sync benchmark: no blocks mined before the nodes joined");
+    ibdCheck();
+}
+
+static void ibdCheck()
+{
+    for (uint32_t i = 0; i < ibd.joiners.size(); i++)
+    {
+        if (ibd.synced.count(i) == 0 && ibd.joiners[i]->GetBlockchain()->GetTopBlockHeight() >= ibd.target)
+        {
+            ibd.synced.insert(i);
+            ibd.syncTimes.push_back((ns3::Simulator::Now() - ibd.start).GetSeconds());
+        }
+    }
+    if (ibd.synced.size() < ibd.joiners.size())
+        ns3::Simulator::Schedule(ns3::MilliSeconds(100), &ibdCheck);
+}
+
 ns3::ApplicationContainer
 buildGeoTopology(struct bnsParams &params)
 {
@@ -221,11 +887,19 @@ buildGeoTopology(struct bnsParams &params)
     bns::BitcoinTopologyHelper topology(params.nPeers, params.seed);
 
     SetReceivedCallback(topology);
+    if (params.netStack == "mixed")
+        assignStacks(params, topology);
 
     ns3::Ptr<ns3::UniformRandomVariable> leafIndexVar = ns3::CreateObject<ns3::UniformRandomVariable>();
     leafIndexVar->SetAttribute("Min", ns3::DoubleValue(0));
     leafIndexVar->SetAttribute("Max", ns3::DoubleValue(params.nPeers - 1));
 
+    // nodes see different parts of the transaction flow, spread their mempool overlap evenly around the mean
+    ns3::Ptr<ns3::UniformRandomVariable> overlapVar = ns3::CreateObject<ns3::UniformRandomVariable>();
+    double overlapSpread = std::min(params.mempoolOverlap, 1 - params.mempoolOverlap);
+    overlapVar->SetAttribute("Min", ns3::DoubleValue(params.mempoolOverlap - overlapSpread));
+    overlapVar->SetAttribute("Max", ns3::DoubleValue(params.mempoolOverlap + overlapSpread));
+
     std::vector<uint32_t> miners;
     uint32_t toAdd = params.nMiners;
     while (toAdd > 0)
@@ -244,7 +918,10 @@ buildGeoTopology(struct bnsParams &params)
         ns3::Ipv4Address nodeAddr = topology.GetTopologyAddress(i);
         //NS_LOG_INFO("Setting up node " << topology.GetTopologyLeaf(i)->GetId() << ": " << nodeAddr);
         ns3::Ptr<bns::BitcoinNode> app;
-        if (params.netStack == "kadcast")
+        std::string netStack = params.netStack;
+        if (netStack == "mixed")
+            netStack = mix.stacks[i] == "kadcast" ? "kadcast" : "vanilla";
+        if (netStack == "kadcast")
         {
             auto it = std::find(std::begin(miners), std::end(miners), i);
             if (it != std::end(miners))
@@ -268,8 +945,9 @@ buildGeoTopology(struct bnsParams &params)
                 app = ns3::CreateObject<bns::KadcastNode>(nodeAddr, false, 0);
                 apps.Add(app);
             }
+            ns3::DynamicCast<bns::KadcastNode>(app)->SetRegion(static_cast<uint16_t>(topology.GetTopologyRegion(i)));
         }
-        else if (params.netStack == "mincast")
+        else if (netStack == "mincast")
         {
             auto it = std::find(std::begin(miners), std::end(miners), i);
             if (it != std::end(miners))
@@ -294,6 +972,56 @@ buildGeoTopology(struct bnsParams &params)
                 apps.Add(app);
             }
         }
+        else if (netStack == "gossip")
+        {
+            auto it = std::find(std::begin(miners), std::end(miners), i);
+            if (it != std::end(miners))
+            {                                                       // if the current index is a miner
+                auto index = std::distance(std::begin(miners), it); // get its index in miner list
+                double poolShare;
+                if (params.nMiners == 1)
+                {
+                    poolShare = 1.0;
+                }
+                else
+                {
+                    poolShare = bns::btcHashRateDistribution[index % bns::btcNumPools] / (params.nMiners / bns::btcNumPools);
+                }
+                double hashRate = poolShare * bns::btcTotalHashRate;
+                app = ns3::CreateObject<bns::GossipNode>(nodeAddr, true, hashRate);
+                apps.Add(app);
+            }
+            else
+            {
+                app = ns3::CreateObject<bns::GossipNode>(nodeAddr, false, 0);
+                apps.Add(app);
+            }
+        }
+        else if (netStack == "hiercast")
+        {
+            auto it = std::find(std::begin(miners), std::end(miners), i);
+            if (it != std::end(miners))
+            {                                                       // if the current index is a miner
+                auto index = std::distance(std::begin(miners), it); // get its index in miner list
+                double poolShare;
+                if (params.nMiners == 1)
+                {
+                    poolShare = 1.0;
+                }
+                else
+                {
+                    poolShare = bns::btcHashRateDistribution[index % bns::btcNumPools] / (params.nMiners / bns::btcNumPools);
+                }
+                double hashRate = poolShare * bns::btcTotalHashRate;
+                app = ns3::CreateObject<bns::HiercastNode>(nodeAddr, true, hashRate);
+                apps.Add(app);
+            }
+            else
+            {
+                app = ns3::CreateObject<bns::HiercastNode>(nodeAddr, false, 0);
+                apps.Add(app);
+            }
+        }
         else
         {
             auto it = std::find(std::begin(miners), std::end(miners), i);
@@ -322,6 +1050,24 @@ buildGeoTopology(struct bnsParams &params)
         topology.GetTopologyLeaf(i)->AddApplication(app);
         app->SetStartTime(ns3::Seconds(2.0));
         //app->SetStopTime(ns3::Minutes (10.0));
+        if (ns3::Ptr<bns::VanillaNode> v = ns3::DynamicCast<bns::VanillaNode>(app))
+            v->SetMempoolOverlap(std::min(1.0, std::max(0.0, overlapVar->GetValue())));
+
+        if (params.netStack == "mixed")
+        {
+            // a gateway runs a kadcast stack next to its vanilla one
+            if (mix.stacks[i] == "gateway")
+            {
+                ns3::Ptr<bns::KadcastNode> bridge = ns3::CreateObject<bns::KadcastNode>(nodeAddr, false, 0);
+                bridge->SetRegion(static_cast<uint16_t>(topology.GetTopologyRegion(i)));
+                topology.GetTopologyLeaf(i)->AddApplication(bridge);
+                bridge->SetStartTime(ns3::Seconds(2.0));
+                bridge->SetKnownAddresses(mixBootstrap(params, topology, "kadcast"));
+                app->SetBridge(ns3::PeekPointer(bridge));
+            }
+            app->SetKnownAddresses(mixBootstrap(params, topology, netStack));
+            continue;
+        }
 
         // Bootstrap
         std::vector<ns3::Ipv4Address> peerAddresses;
@@ -339,9 +1085,86 @@ buildGeoTopology(struct bnsParams &params)
         }
         app->SetKnownAddresses(peerAddresses);
     }
+
+    if (params.netStack == "hiercast")
+        setupHierarchy(params, topology, apps);
     return apps;
 }
 
+void assignStacks(struct bnsParams &params, bns::BitcoinTopologyHelper &topology)
+{
+    // random order, the first nodes become gateways, the next ones run kadcast unless regions decide
+    std::vector<uint32_t> order(params.nPeers);
+    std::iota(order.begin(), order.end(), 0);
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    for (uint32_t j = 0; j + 1 < order.size(); j++)
+        std::swap(order[j], order[x->GetInteger(j, order.size() - 1)]);
+
+    uint32_t nGateways = params.nPeers * params.mixGateways;
+    uint32_t nKadcast = params.nPeers * params.mixKadcast;
+    std::string regions = "+" + params.mixRegions + "+";
+    std::map<std::string, uint32_t> counts;
+    mix.stacks.assign(params.nPeers, "vanilla");
+    for (uint32_t j = 0; j < order.size(); j++)
+    {
+        uint32_t i = order[j];
+        std::string region = "+" + topology.RegionToString(topology.GetTopologyRegion(i)) + "+";
+        if (j < nGateways)
+            mix.stacks[i] = "gateway";
+        else if (params.mixRegions != "none" ? regions.find(region) != std::string::npos : j < nGateways + nKadcast)
+            mix.stacks[i] = "kadcast";
+        counts[mix.stacks[i]]++;
+    }
+    NS_LOG_INFO("Mixed deployment: " << counts["vanilla"] << " vanilla, " << counts["kadcast"] << " kadcast and " << counts["gateway"] << " gateway nodes.");
+}
+
+static std::vector<ns3::Ipv4Address> mixBootstrap(struct bnsParams &params, bns::BitcoinTopologyHelper &topology, const std::string &overlay)
+{
+    // only nodes that speak the protocol of the overlay
+    std::vector<ns3::Ipv4Address> peerAddresses;
+    for (uint32_t j = 0; j < params.nPeers; j++)
+    {
+        if (mix.stacks[j] == overlay || mix.stacks[j] == "gateway")
+            peerAddresses.push_back(topology.GetTopologyAddress(j));
+    }
+    uint32_t toBootstrap = std::min(params.nBootstrap, (uint32_t)peerAddresses.size());
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    for (uint32_t j = 0; j < toBootstrap; j++)
+        std::swap(peerAddresses[j], peerAddresses[x->GetInteger(j, peerAddresses.size() - 1)]);
+    peerAddresses.resize(toBootstrap);
+    return peerAddresses;
+}
+
+void setupHierarchy(struct bnsParams &params, bns::BitcoinTopologyHelper &topology, ns3::ApplicationContainer apps)
+{
+    std::map<uint16_t, std::vector<ns3::Ipv4Address>> members;
+    for (uint32_t i = 0; i < params.nPeers; i++)
+        members[static_cast<uint16_t>(topology.GetTopologyRegion(i))].push_back(topology.GetTopologyAddress(i));
+
+    // random representatives per region, a miner may be one of them
+    std::map<uint16_t, std::vector<ns3::Ipv4Address>> representatives;
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    for (auto &m : members)
+    {
+        std::vector<ns3::Ipv4Address> candidates = m.second;
+        uint32_t nReps = std::min((uint32_t)candidates.size(), (uint32_t)params.hierReps);
+        for (uint32_t j = 0; j < nReps; j++)
+        {
+            uint32_t k = x->GetInteger(j, candidates.size() - 1);
+            std::swap(candidates[j], candidates[k]);
+            representatives[m.first].push_back(candidates[j]);
+        }
+        NS_LOG_INFO("Region " << m.first << ": " << m.second.size() << " nodes, " << nReps << " representatives.");
+    }
+
+    for (uint32_t i = 0; i < params.nPeers; i++)
+    {
+        uint16_t region = static_cast<uint16_t>(topology.GetTopologyRegion(i));
+        ns3::Ptr<bns::HiercastNode> app = ns3::DynamicCast<bns::HiercastNode>(apps.Get(i));
+        app->SetHierarchy(region, members[region], representatives);
+    }
+}
+
 ns3::ApplicationContainer buildStarTopology(struct bnsParams &params)
 {
     ns3::ApplicationContainer apps;
@@ -519,6 +1342,7 @@ void collectPropagationData(struct bnsParams &params, struct bnsResults &res, ns
     int64_t total_ttfb = 0, total_ttlb = 0;
     double avg_ttfb = 0.0, median_ttfb = 0.0, avg_ttlb = 0.0, median_ttlb = 0.0, coverage = 0.0;
     double acc_avg_ttfb = 0.0, acc_median_ttfb = 0.0, acc_avg_ttlb = 0.0, acc_median_ttlb = 0.0, acc_coverage = 0.0;
+    double acc_p90_ttfb = 0.0, acc_p90_ttlb = 0.0;
     NS_LOG_INFO("-----------------------BLOCKWISE STATS-------------------------------");
     for (itr1 = ttfbs.begin(); itr1 != ttfbs.end(); itr1++)
     {
@@ -527,6 +1351,7 @@ void collectPropagationData(struct bnsParams &params, struct bnsResults &res, ns
         median_ttfb = median(itr1->second);
         acc_avg_ttfb += avg_ttfb;
         acc_median_ttfb += median_ttfb;
+        acc_p90_ttfb += percentile(itr1->second, 0.9);
         NS_LOG_DEBUG("BlockID: " << itr1->first);
         NS_LOG_DEBUG("total_ttfb: " << total_ttfb);
         NS_LOG_DEBUG("TTFBs size: " << itr1->second.size());
@@ -542,6 +1367,7 @@ void collectPropagationData(struct bnsParams &params, struct bnsResults &res, ns
         coverage = (double)itr1->second.size() / (double)params.nPeers;
         acc_avg_ttlb += avg_ttlb;
         acc_median_ttlb += median_ttlb;
+        acc_p90_ttlb += percentile(itr1->second, 0.9);
         acc_coverage += coverage;
         NS_LOG_DEBUG("BlockID: " << itr1->first);
         NS_LOG_DEBUG("total_ttlb: " << total_ttlb);
@@ -555,14 +1381,120 @@ void collectPropagationData(struct bnsParams &params, struct bnsResults &res, ns
     res.avgTTLB = acc_avg_ttlb / ttlbs.size();
     res.medianTTFB = acc_median_ttfb / ttfbs.size();
     res.medianTTLB = acc_median_ttlb / ttlbs.size();
+    res.p90TTFB = acc_p90_ttfb / ttfbs.size();
+    res.p90TTLB = acc_p90_ttlb / ttlbs.size();
     res.coverage = acc_coverage / ttlbs.size();
+
+    // how fast the miners learn about each other's blocks, the delay that makes blocks stale
+    double minerDelaySum = 0;
+    uint32_t nMinerDelays = 0;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+    {
+        a = apps.Get(i)->GetObject<bns::BitcoinNode>();
+        if (!a->IsMiner())
+            continue;
+        std::unordered_map<uint64_t, ns3::Time> mined = a->GetMiningTime();
+        time_var = a->GetTTLB();
+        for (itr = time_var.begin(); itr != time_var.end(); itr++)
+        {
+            if (mined.count(itr->first) == 1 || firstMiningTime.count(itr->first) == 0)
+                continue;
+            minerDelaySum += itr->second.GetMilliSeconds() - firstMiningTime[itr->first];
+            nMinerDelays++;
+        }
+    }
+    if (nMinerDelays > 0)
+        res.minerDelay = minerDelaySum / nMinerDelays;
+
+    // TTLB of the early against the late blocks, shows how much an adapting overlay gained during the run
+    std::vector<std::pair<double, uint64_t>> byMiningTime;
+    for (itr2 = firstMiningTime.begin(); itr2 != firstMiningTime.end(); itr2++)
+    {
+        if (ttlbs.count(itr2->first) == 1)
+            byMiningTime.push_back({itr2->second, itr2->first});
+    }
+    std::sort(byMiningTime.begin(), byMiningTime.end());
+    uint32_t half = byMiningTime.size() / 2;
+    if (half > 0)
+    {
+        double early = 0, late = 0;
+        for (uint32_t i = 0; i < byMiningTime.size(); i++)
+        {
+            std::vector<double> &v = ttlbs[byMiningTime[i].second];
+            double avg = std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+            if (i < half)
+                early += avg;
+            else
+                late += avg;
+        }
+        res.earlyTTLB = early / half;
+        res.lateTTLB = late / (byMiningTime.size() - half);
+        NS_LOG_INFO("Avg. TTLB first half: " << res.earlyTTLB << ", second half: " << res.lateTTLB << " (perigee round: " << params.perigeeRound << " blocks)");
+    }
     NS_LOG_DEBUG("Avg. TTFB: " << res.avgTTFB);
     NS_LOG_DEBUG("Avg. TTLB: " << res.avgTTLB);
     NS_LOG_DEBUG("Median TTFB: " << res.medianTTFB);
     NS_LOG_DEBUG("Median TTLB: " << res.medianTTLB);
+    NS_LOG_DEBUG("90th perc. TTFB: " << res.p90TTFB);
+    NS_LOG_DEBUG("90th perc. TTLB: " << res.p90TTLB);
     NS_LOG_DEBUG("Coverage: " << res.coverage);
 }
 
+void collectMixData(struct bnsParams &params, struct bnsResults &res, ns3::ApplicationContainer apps)
+{
+    std::unordered_map<uint64_t, double> firstMiningTime;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+    {
+        ns3::Ptr<bns::BitcoinNode> a = apps.Get(i)->GetObject<bns::BitcoinNode>();
+        for (auto &t : a->GetMiningTime())
+        {
+            if (firstMiningTime.count(t.first) == 0)
+                firstMiningTime[t.first] = t.second.GetMilliSeconds();
+            else
+                firstMiningTime[t.first] = std::min(firstMiningTime[t.first], (double)t.second.GetMilliSeconds());
+        }
+    }
+
+    // a gateway reports the TTLB of whichever of its stacks got the block first
+    std::map<std::string, std::unordered_map<uint64_t, std::vector<double>>> ttlbs;
+    std::map<std::string, uint32_t> nNodes;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+    {
+        ns3::Ptr<bns::BitcoinNode> a = apps.Get(i)->GetObject<bns::BitcoinNode>();
+        nNodes[mix.stacks[i]]++;
+        for (auto &t : a->GetTTLB())
+        {
+            if (firstMiningTime.count(t.first) == 1)
+                ttlbs[mix.stacks[i]][t.first].push_back(t.second.GetMilliSeconds() - firstMiningTime[t.first]);
+        }
+    }
+
+    std::map<std::string, double> avgTTLB;
+    std::map<std::string, double> coverage;
+    for (auto &n : nNodes)
+    {
+        std::unordered_map<uint64_t, std::vector<double>> &blocks = ttlbs[n.first];
+        double accTTLB = 0, accCoverage = 0;
+        for (auto &b : blocks)
+        {
+            accTTLB += std::accumulate(b.second.begin(), b.second.end(), 0.0) / b.second.size();
+            accCoverage += (double)b.second.size() / n.second;
+        }
+        // blocks that reached no node of the population count with coverage 0
+        if (!blocks.empty())
+            avgTTLB[n.first] = accTTLB / blocks.size();
+        if (!firstMiningTime.empty())
+            coverage[n.first] = accCoverage / firstMiningTime.size();
+    }
+    res.mixVanillaTTLB = avgTTLB["vanilla"];
+    res.mixKadcastTTLB = avgTTLB["kadcast"];
+    res.mixGatewayTTLB = avgTTLB["gateway"];
+    res.mixVanillaCoverage = coverage["vanilla"];
+    res.mixKadcastCoverage = coverage["kadcast"];
+    res.mixGatewayCoverage = coverage["gateway"];
+    NS_LOG_INFO("Mixed deployment, avg. TTLB (coverage): vanilla " << res.mixVanillaTTLB << " ms (" << res.mixVanillaCoverage << ", " << nNodes["vanilla"] << " nodes), kadcast " << res.mixKadcastTTLB << " ms (" << res.mixKadcastCoverage << ", " << nNodes["kadcast"] << " nodes), gateways " << res.mixGatewayTTLB << " ms (" << res.mixGatewayCoverage << ", " << nNodes["gateway"] << " nodes)");
+}
+
 void collectTrafficData(struct bnsParams &params, struct bnsResults &res, ns3::ApplicationContainer apps)
 {
     //
@@ -571,12 +1503,76 @@ void collectTrafficData(struct bnsParams &params, struct bnsResults &res, ns3::A
     uint32_t topBlockHeight = 0;
     double nMinedBlocks = 0;
     double totalMinedBlocksSize = 0;
+    double repairTraffic = 0;
+    double fecOverheadSum = 0;
+    uint32_t nFecSenders = 0;
+    double pushShareSum = 0;
+    uint32_t nMincast = 0;
+    double announceMessages = 0, announceIds = 0, announceWait = 0;
+    uint32_t nInterPushes = 0;
+    double gossipBlocks = 0, gossipLazyBlocks = 0, meshSizeSum = 0;
+    uint32_t nGossip = 0, nPrunes = 0;
+    double compactBlocks = 0, blockTxnRoundTrips = 0;
+    uint32_t nRotations = 0;
+    double uplinkBacklogSum = 0;
+    uint32_t nVanilla = 0;
     for (uint32_t i = 0; i < params.nPeers; ++i)
     {
         ns3::Ptr<bns::BitcoinNode> app = apps.Get(i)->GetObject<bns::BitcoinNode>();
         topBlockHeight = std::max(topBlockHeight, app->GetBlockchain()->GetTopBlockHeight());
         nMinedBlocks += app->GetNMinedBlocks();
         totalMinedBlocksSize += app->GetTotalMinedBlocksSize();
+        if (ns3::Ptr<bns::KadcastNode> k = ns3::DynamicCast<bns::KadcastNode>(app))
+        {
+            repairTraffic += k->GetRepairTraffic();
+            if (k->GetMeanFecOverhead() > 0)
+            {
+                fecOverheadSum += k->GetMeanFecOverhead();
+                nFecSenders++;
+            }
+        }
+        if (ns3::Ptr<bns::MincastNode> m = ns3::DynamicCast<bns::MincastNode>(app))
+        {
+            if (m->GetMeanFecOverhead() > 0)
+            {
+                fecOverheadSum += m->GetMeanFecOverhead();
+                nFecSenders++;
+            }
+            pushShareSum += m->GetPushShare();
+            nMincast++;
+        }
+
+        if (ns3::Ptr<bns::HiercastNode> h = ns3::DynamicCast<bns::HiercastNode>(app))
+            nInterPushes += h->GetNInterPushes();
+
+        if (ns3::Ptr<bns::GossipNode> g = ns3::DynamicCast<bns::GossipNode>(app))
+        {
+            gossipBlocks += g->GetNReceivedBlocks();
+            gossipLazyBlocks += g->GetNLazyBlocks();
+            meshSizeSum += g->GetMeanMeshSize();
+            nPrunes += g->GetNPrunes();
+            nGossip++;
+        }
+
+        const bns::AnnounceBatcher *announces = 0;
+        if (ns3::Ptr<bns::MincastNode> m = ns3::DynamicCast<bns::MincastNode>(app))
+            announces = &m->GetAnnounces();
+        else if (ns3::Ptr<bns::VanillaNode> v = ns3::DynamicCast<bns::VanillaNode>(app))
+        {
+            announces = &v->GetAnnounces();
+            compactBlocks += v->GetNCompactBlocks();
+            blockTxnRoundTrips += v->GetNBlockTxnRoundTrips();
+            nRotations += v->GetNRotations();
+            uplinkBacklogSum += v->GetMeanUplinkBacklog();
+            nVanilla++;
+        }
+        if (announces)
+        {
+            double nIds = announces->GetNMessages() * announces->GetMeanBatchSize();
+            announceMessages += announces->GetNMessages();
+            announceIds += nIds;
+            announceWait += nIds * announces->GetMeanWait().GetSeconds() * 1000;
+        }
     }
     double staleRate = (nMinedBlocks - topBlockHeight) / nMinedBlocks;
     double necessaryTraffic = totalMinedBlocksSize * (params.nPeers - 1);
@@ -585,12 +1581,141 @@ void collectTrafficData(struct bnsParams &params, struct bnsResults &res, ns3::A
     NS_LOG_INFO("Total number of mined blocks: " << nMinedBlocks << ", top block Height: " << topBlockHeight);
     NS_LOG_INFO("Stale rate: " << staleRate << ", totalTraffic: " << totalTraffic << ", overheadRatio: " << overheadRatio);
     res.staleRate = staleRate;
+
+    // miner relay against the public network alone, compare runs with and without minerRelay
+    uint32_t nRelayedBlocks = 0;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+    {
+        ns3::Ptr<ns3::Node> node = apps.Get(i)->GetNode();
+        for (uint32_t j = 0; j < node->GetNApplications(); ++j)
+        {
+            if (ns3::Ptr<bns::MinerRelay> relay = ns3::DynamicCast<bns::MinerRelay>(node->GetApplication(j)))
+                nRelayedBlocks += relay->GetNRelayedBlocks();
+        }
+    }
+    NS_LOG_INFO("Miner-to-miner delay: " << res.minerDelay << " ms, stale rate: " << staleRate << " (miner relay: " << params.minerRelay << ", " << nRelayedBlocks << " blocks first rebuilt from relayed chunks)");
     res.totalTraffic = totalTraffic;
     res.necessaryTraffic = necessaryTraffic;
     res.overheadRatio = overheadRatio;
+
+    // share of the overhead spent on repairing blocks (chunks on request and the requests themselves)
+    res.repairTraffic = repairTraffic;
+    res.repairOverheadRatio = repairTraffic / necessaryTraffic;
+    res.intercontinentalTraffic = intercontinentalTraffic;
+    NS_LOG_INFO("Intercontinental traffic: " << intercontinentalTraffic << " (region ID prefix: " << params.kadGeoIds << "), avg. TTLB: " << res.avgTTLB);
+    if (params.netStack == "hiercast")
+        NS_LOG_INFO("Hiercast: " << nInterPushes << " inter-region pushes (" << params.hierReps << " per region), intercontinental traffic: " << intercontinentalTraffic << ", avg. TTLB: " << res.avgTTLB);
+    NS_LOG_INFO("Repair traffic: " << repairTraffic << ", repairOverheadRatio: " << res.repairOverheadRatio);
+
+    // blocks the mesh missed and gossip made up for
+    if (nGossip > 0)
+    {
+        res.avgMeshSize = meshSizeSum / nGossip;
+        if (gossipBlocks > 0)
+            res.gossipLazyShare = gossipLazyBlocks / gossipBlocks;
+        NS_LOG_INFO("Gossip: avg. mesh size: " << res.avgMeshSize << " (D: " << params.gossipD << "), blocks fetched with IWANT: " << res.gossipLazyShare << ", prunes: " << nPrunes << ", avg. TTLB: " << res.avgTTLB << ", overheadRatio: " << res.overheadRatio);
+    }
+
+    // redundancy the senders chose, fixed to kadFecOverhead unless kadFecAdaptive is set
+    if (nFecSenders > 0)
+        res.avgFecOverhead = fecOverheadSum / nFecSenders;
+    NS_LOG_INFO("Avg. FEC overhead: " << res.avgFecOverhead << " (adaptive: " << params.kadFecAdaptive << ")");
+
+    // blocks pushed rather than informed, fixed share unless mincastUseScores is set
+    if (nMincast > 0)
+    {
+        res.pushShare = pushShareSum / nMincast;
+        NS_LOG_INFO("Mincast push share: " << res.pushShare << " (scores: " << params.mincastUseScores << ")");
+    }
+
+    // fewer, larger announcements against the time block IDs wait for their batch
+    res.announceMessages = announceMessages;
+    if (announceMessages > 0)
+    {
+        res.avgAnnounceBatch = announceIds / announceMessages;
+        res.avgAnnounceWait = announceWait / announceIds;
+        NS_LOG_INFO("Announcements: " << announceMessages << " messages, avg. batch: " << res.avgAnnounceBatch << " IDs, avg. wait: " << res.avgAnnounceWait << " ms (window: " << params.announceDelay << " ms), avg. TTFB: " << res.avgTTFB << ", overheadRatio: " << res.overheadRatio);
+    }
+
+    // bursts of announcements queue behind each other and behind blocks on the uplink
+    if (nVanilla > 0)
+    {
+        res.avgUplinkBacklog = uplinkBacklogSum / nVanilla;
+        NS_LOG_INFO("Trickle: avg. uplink backlog at announcement: " << res.avgUplinkBacklog << " bytes (outbound: " << params.trickleOutbound << " ms, inbound: " << params.trickleInbound << " ms), avg. TTFB: " << res.avgTTFB << ", median TTFB: " << res.medianTTFB);
+    }
+
+    if (params.perigeeRound > 0)
+        NS_LOG_INFO("Perigee: " << nRotations << " outgoing peers replaced, avg. TTLB first half: " << res.earlyTTLB << ", second half: " << res.lateTTLB);
+
+    // compact blocks rebuilt from the mempool against those needing a GETBLOCKTXN round trip
+    res.compactBlocks = compactBlocks;
+    if (compactBlocks > 0)
+    {
+        res.blockTxnShare = blockTxnRoundTrips / compactBlocks;
+        NS_LOG_INFO("Compact blocks: " << compactBlocks << ", GETBLOCKTXN share: " << res.blockTxnShare << " (mempool overlap: " << params.mempoolOverlap << "), avg. TTLB: " << res.avgTTLB << ", totalTraffic: " << res.totalTraffic);
+    }
     return;
 }
 
+void collectOverlayData(struct bnsParams &params, struct bnsResults &res, ns3::ApplicationContainer apps)
+{
+    //
+    // Here we evaluate hop count, messages and time to convergence of the node lookups,
+    // and the latency to the peers kept in the routing tables
+    //
+    double bucketRtt = 0, controlDelay = 0, blockDelay = 0, repairDelay = 0, fanout = 0;
+    uint32_t nKadcast = 0;
+    for (uint32_t i = 0; i < apps.GetN(); ++i)
+    {
+        std::vector<bns::LookupStats> stats;
+        if (ns3::Ptr<bns::KadcastNode> k = ns3::DynamicCast<bns::KadcastNode>(apps.Get(i)))
+        {
+            stats = k->GetLookupStats();
+            bucketRtt += k->GetMeanBucketRtt().GetMilliSeconds();
+            controlDelay += k->GetMeanSendDelay(bns::TrafficClass::CONTROL).GetSeconds() * 1000;
+            blockDelay += k->GetMeanSendDelay(bns::TrafficClass::BLOCK).GetSeconds() * 1000;
+            repairDelay += k->GetMeanSendDelay(bns::TrafficClass::REPAIR).GetSeconds() * 1000;
+            fanout += k->GetMeanFanout();
+            nKadcast++;
+        }
+        else if (ns3::Ptr<bns::MincastNode> m = ns3::DynamicCast<bns::MincastNode>(apps.Get(i)))
+            stats = m->GetLookupStats();
+        res.lookupValues.insert(std::end(res.lookupValues), std::begin(stats), std::end(stats));
+    }
+
+    if (nKadcast > 0)
+    {
+        res.avgBucketRtt = bucketRtt / nKadcast;
+        NS_LOG_INFO("Avg. bucket RTT: " << res.avgBucketRtt << " ms (proximity selection: " << params.kadProximity << "), avg. TTFB: " << res.avgTTFB << ", avg. TTLB: " << res.avgTTLB);
+
+        res.avgControlDelay = controlDelay / nKadcast;
+        res.avgBlockDelay = blockDelay / nKadcast;
+        res.avgRepairDelay = repairDelay / nKadcast;
+        NS_LOG_INFO("Avg. send delay: control " << res.avgControlDelay << " ms, block " << res.avgBlockDelay << " ms, repair " << res.avgRepairDelay << " ms");
+
+        res.avgFanout = fanout / nKadcast;
+        NS_LOG_INFO("Avg. fanout: " << res.avgFanout << " (coverage target: " << params.kadCoverageTarget << "), coverage: " << res.coverage << ", total traffic: " << res.totalTraffic);
+    }
+
+    if (res.lookupValues.empty())
+        return;
+
+    double hops = 0, messages = 0, time = 0, timeouts = 0;
+    for (auto &e : res.lookupValues)
+    {
+        hops += e.hops;
+        messages += e.nMessages;
+        time += e.duration.GetMilliSeconds();
+        timeouts += e.nTimeouts;
+    }
+    res.avgLookupHops = hops / res.lookupValues.size();
+    res.avgLookupMessages = messages / res.lookupValues.size();
+    res.avgLookupTime = time / res.lookupValues.size();
+    res.lookupTimeoutRate = messages > 0 ? timeouts / messages : 0.0;
+
+    NS_LOG_INFO("Lookups: " << res.lookupValues.size() << ", avg. hops: " << res.avgLookupHops << ", avg. messages: " << res.avgLookupMessages << ", avg. time: " << res.avgLookupTime << " ms, timeout rate: " << res.lookupTimeoutRate);
+}
+
 void writeResults(struct bnsParams &params, struct bnsResults &res)
 {
     std::stringstream fileNameStringStream;
@@ -620,6 +1745,38 @@ void writeResults(struct bnsParams &params, struct bnsResults &res)
     csv << params.kadAlpha << del;
     csv << params.kadBeta << del;
     csv << params.kadFecOverhead << del;
+    csv << params.kadFecAdaptive << del;
+    csv << params.kadChunkOrder << del;
+    csv << params.kadCoverageTarget << del;
+    csv << params.kadProximity << del;
+    csv << params.kadGeoIds << del;
+    csv << params.announceDelay << del;
+    csv << params.announceBatch << del;
+    csv << params.hierReps << del;
+    csv << params.hierFanout << del;
+    csv << params.gossipD << del;
+    csv << params.gossipDLazy << del;
+    csv << params.gossipHeartbeat << del;
+    csv << params.compact << del;
+    csv << params.mempoolOverlap << del;
+    csv << params.perigeeRound << del;
+    csv << params.trickleOutbound << del;
+    csv << params.trickleInbound << del;
+    csv << params.minerRelay << del;
+    csv << params.relayFecOverhead << del;
+    csv << params.churnFraction << del;
+    csv << params.churnDist << del;
+    csv << params.churnSession << del;
+    csv << params.churnOffline << del;
+    csv << params.ibdNodes << del;
+    csv << params.ibdStart << del;
+    csv << params.txRate << del;
+    csv << params.txSize << del;
+    csv << params.txSizeDist << del;
+    csv << params.txLowPriority << del;
+    csv << params.mixKadcast << del;
+    csv << params.mixRegions << del;
+    csv << params.mixGateways << del;
     csv << res.avgTTFB << del;
     csv << res.avgTTLB << del;
     csv << res.medianTTFB << del;
@@ -628,7 +1785,46 @@ void writeResults(struct bnsParams &params, struct bnsResults &res)
     csv << res.coverage << del;
     csv << res.overheadRatio << del;
     csv << res.totalTraffic << del;
-    csv << res.necessaryTraffic;
+    csv << res.necessaryTraffic << del;
+    csv << res.avgLookupHops << del;
+    csv << res.avgLookupMessages << del;
+    csv << res.avgLookupTime << del;
+    csv << res.lookupTimeoutRate << del;
+    csv << res.avgBucketRtt << del;
+    csv << res.churnRate << del;
+    csv << res.avgControlDelay << del;
+    csv << res.avgBlockDelay << del;
+    csv << res.avgRepairDelay << del;
+    csv << res.repairTraffic << del;
+    csv << res.repairOverheadRatio << del;
+    csv << res.avgFecOverhead << del;
+    csv << res.p90TTFB << del;
+    csv << res.p90TTLB << del;
+    csv << res.avgFanout << del;
+    csv << res.intercontinentalTraffic << del;
+    csv << res.pushShare << del;
+    csv << res.announceMessages << del;
+    csv << res.avgAnnounceBatch << del;
+    csv << res.avgAnnounceWait << del;
+    csv << res.compactBlocks << del;
+    csv << res.blockTxnShare << del;
+    csv << res.ibdBlocks << del;
+    csv << res.avgSyncTime << del;
+    csv << res.ibdSyncedShare << del;
+    csv << res.earlyTTLB << del;
+    csv << res.lateTTLB << del;
+    csv << res.minerDelay << del;
+    csv << res.avgUplinkBacklog << del;
+    csv << res.nTxs << del;
+    csv << res.txCoverage << del;
+    csv << res.mixVanillaTTLB << del;
+    csv << res.mixKadcastTTLB << del;
+    csv << res.mixGatewayTTLB << del;
+    csv << res.mixVanillaCoverage << del;
+    csv << res.mixKadcastCoverage << del;
+    csv << res.mixGatewayCoverage << del;
+    csv << res.gossipLazyShare << del;
+    csv << res.avgMeshSize;
     csv << std::endl;
     csv.close();
 
@@ -657,6 +1853,38 @@ void writeResults(struct bnsParams &params, struct bnsResults &res)
         csv << params.kadAlpha << del;
         csv << params.kadBeta << del;
         csv << params.kadFecOverhead << del;
+        csv << params.kadFecAdaptive << del;
+        csv << params.kadChunkOrder << del;
+        csv << params.kadCoverageTarget << del;
+        csv << params.kadProximity << del;
+        csv << params.kadGeoIds << del;
+        csv << params.announceDelay << del;
+        csv << params.announceBatch << del;
+        csv << params.hierReps << del;
+        csv << params.hierFanout << del;
+        csv << params.gossipD << del;
+        csv << params.gossipDLazy << del;
+        csv << params.gossipHeartbeat << del;
+        csv << params.compact << del;
+        csv << params.mempoolOverlap << del;
+        csv << params.perigeeRound << del;
+        csv << params.trickleOutbound << del;
+        csv << params.trickleInbound << del;
+        csv << params.minerRelay << del;
+        csv << params.relayFecOverhead << del;
+        csv << params.churnFraction << del;
+        csv << params.churnDist << del;
+        csv << params.churnSession << del;
+        csv << params.churnOffline << del;
+        csv << params.ibdNodes << del;
+        csv << params.ibdStart << del;
+        csv << params.txRate << del;
+        csv << params.txSize << del;
+        csv << params.txSizeDist << del;
+        csv << params.txLowPriority << del;
+        csv << params.mixKadcast << del;
+        csv << params.mixRegions << del;
+        csv << params.mixGateways << del;
         csv << e;
         csv << std::endl;
     }
@@ -687,10 +1915,72 @@ void writeResults(struct bnsParams &params, struct bnsResults &res)
         csv << params.kadAlpha << del;
         csv << params.kadBeta << del;
         csv << params.kadFecOverhead << del;
+        csv << params.kadFecAdaptive << del;
+        csv << params.kadChunkOrder << del;
+        csv << params.kadCoverageTarget << del;
+        csv << params.kadProximity << del;
+        csv << params.kadGeoIds << del;
+        csv << params.announceDelay << del;
+        csv << params.announceBatch << del;
+        csv << params.hierReps << del;
+        csv << params.hierFanout << del;
+        csv << params.gossipD << del;
+        csv << params.gossipDLazy << del;
+        csv << params.gossipHeartbeat << del;
+        csv << params.compact << del;
+        csv << params.mempoolOverlap << del;
+        csv << params.perigeeRound << del;
+        csv << params.trickleOutbound << del;
+        csv << params.trickleInbound << del;
+        csv << params.minerRelay << del;
+        csv << params.relayFecOverhead << del;
+        csv << params.churnFraction << del;
+        csv << params.churnDist << del;
+        csv << params.churnSession << del;
+        csv << params.churnOffline << del;
+        csv << params.ibdNodes << del;
+        csv << params.ibdStart << del;
+        csv << params.txRate << del;
+        csv << params.txSize << del;
+        csv << params.txSizeDist << del;
+        csv << params.txLowPriority << del;
+        csv << params.mixKadcast << del;
+        csv << params.mixRegions << del;
+        csv << params.mixGateways << del;
         csv << e;
         csv << std::endl;
     }
     csv.close();
+
+    if (res.lookupValues.empty())
+        return;
+
+    ext = "lookupValues";
+    std::stringstream lookupFileNameStringStream;
+    lookupFileNameStringStream << baseStr << fndel;
+    lookupFileNameStringStream << ext << fndel;
+    lookupFileNameStringStream << params.topo << fndel;
+    lookupFileNameStringStream << params.netStack << end;
+
+    csv.open(lookupFileNameStringStream.str(), std::ios::app);
+
+    for (auto &e : res.lookupValues)
+    {
+        csv << params.seed << del;
+        csv << params.nPeers << del;
+        csv << params.netStack << del;
+        csv << params.topo << del;
+        csv << params.kadK << del;
+        csv << params.kadAlpha << del;
+        csv << e.hops << del;
+        csv << e.nMessages << del;
+        csv << e.nReplies << del;
+        csv << e.nTimeouts << del;
+        csv << e.duration.GetMilliSeconds() << del;
+        csv << e.found;
+        csv << std::endl;
+    }
+    csv.close();
 }
 
 static void ReceivedPacket(ns3::Ptr<const ns3::Packet> packet)
@@ -698,6 +1988,11 @@ static void ReceivedPacket(ns3::Ptr<const ns3::Packet> packet)
     totalTraffic += packet->GetSize();
 }
 
+static void ReceivedIntercontinentalPacket(ns3::Ptr<const ns3::Packet> packet)
+{
+    intercontinentalTraffic += packet->GetSize();
+}
+
 double median(std::vector<double> scores)
 {
     size_t size = scores.size();
@@ -724,6 +2019,17 @@ double median(std::vector<double> scores)
     }
 }
 
+double percentile(std::vector<double> scores, double p)
+{
+    if (scores.empty())
+        return 0;
+
+    // nearest rank
+    sort(scores.begin(), scores.end());
+    size_t rank = std::ceil(p * scores.size());
+    return scores[std::max(rank, (size_t)1) - 1];
+}
+
 void SetReceivedCallback(bns::BitcoinTopologyHelper &topology)
 {
     std::vector<bns::Region> regs = {{bns::Region::NA, bns::Region::EU, bns::Region::AS, bns::Region::OC, bns::Region::AF, bns::Region::SA, bns::Region::CN}};
@@ -735,5 +2041,12 @@ void SetReceivedCallback(bns::BitcoinTopologyHelper &topology)
             ns3::Ptr<ns3::PointToPointNetDevice> dev = ns3::DynamicCast<ns3::PointToPointNetDevice>(devs.Get(i));
             dev->TraceConnectWithoutContext("MacRx", ns3::MakeCallback(&ReceivedPacket));
         }
+
+        devs = topology.GetIntercontinentalDevices(r);
+        for (uint32_t i = 0; i < devs.GetN(); i++)
+        {
+            ns3::Ptr<ns3::PointToPointNetDevice> dev = ns3::DynamicCast<ns3::PointToPointNetDevice>(devs.Get(i));
+            dev->TraceConnectWithoutContext("MacRx", ns3::MakeCallback(&ReceivedIntercontinentalPacket));
+        }
     }
 }
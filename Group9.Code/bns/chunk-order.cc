@@ -0,0 +1,55 @@
+#include <assert.h>
+#include "chunk-order.h"
+
+namespace bns
+{
+
+bool ParseChunkOrder(const std::string &name, ChunkOrder &order)
+{
+    if (name == "serial")
+        order = ChunkOrder::SERIAL;
+    else if (name == "rr")
+        order = ChunkOrder::ROUND_ROBIN;
+    else if (name == "weighted")
+        order = ChunkOrder::WEIGHTED;
+    else
+        return false;
+    return true;
+}
+
+std::vector<uint16_t> InterleaveChunks(const std::vector<uint16_t> &counts, const std::vector<uint32_t> &weights)
+{
+    assert(counts.size() == weights.size());
+
+    std::vector<uint16_t> left = counts;
+    std::vector<int64_t> credit(counts.size(), 0);
+    std::vector<uint16_t> order;
+
+    uint32_t total = 0;
+    for (auto n : counts)
+        total += n;
+    order.reserve(total);
+
+    // every round, all pending destinations earn their weight and the richest one
+    // sends a chunk, paying the sum of the weights of the pending destinations
+    while (order.size() < total)
+    {
+        int64_t sum = 0;
+        int best = -1;
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            if (left[i] == 0)
+                continue;
+            credit[i] += weights[i];
+            sum += weights[i];
+            if (best < 0 || credit[i] > credit[best])
+                best = i;
+        }
+        credit[best] -= sum;
+        left[best]--;
+        order.push_back(best);
+    }
+    return order;
+}
+
+} // namespace bns
@@ -0,0 +1,41 @@
+/**
+ * This file declares how the Kadcast and Mincast nodes order the chunks of
+ * one broadcast over its destinations.
+ */
+
+#ifndef CHUNK_ORDER_H
+#define CHUNK_ORDER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace bns
+{
+
+/**
+ * \brief Transmission order of the chunks of a broadcast.
+ */
+enum class ChunkOrder
+{
+    SERIAL,      //0: all chunks for one destination, then the next
+    ROUND_ROBIN, //1: one chunk per destination in turn
+    WEIGHTED,    //2: in turn, destinations of higher buckets more often
+};
+
+/**
+ * \brief Parse serial, rr or weighted.
+ * \return false if the name is unknown
+ */
+bool ParseChunkOrder(const std::string &name, ChunkOrder &order);
+
+/**
+ * \brief Interleave the chunks of several destinations (smooth weighted round-robin).
+ * \param counts number of chunks per destination
+ * \param weights share of the upload per destination, all 1 for plain round-robin
+ * \return destination index of every chunk in transmission order
+ */
+std::vector<uint16_t> InterleaveChunks(const std::vector<uint16_t> &counts, const std::vector<uint32_t> &weights);
+
+} // namespace bns
+#endif /* CHUNK_ORDER_H */
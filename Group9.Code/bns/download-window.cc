@@ -0,0 +1,108 @@
+#include <algorithm>
+#include "ns3/simulator.h"
+#include "download-window.h"
+
+namespace bns
+{
+
+DownloadWindow::DownloadWindow(uint32_t nWindow, uint32_t nPerPeer) : m_nWindow(nWindow), m_nPerPeer(nPerPeer)
+{
+}
+
+void DownloadWindow::Add(const std::vector<uint64_t> &blockIDs, ns3::Ipv4Address from)
+{
+    for (uint64_t id : blockIDs)
+    {
+        if (m_known.insert(id).second)
+            m_queue.push_back(id);
+        m_holders[id].insert(from);
+    }
+}
+
+std::vector<uint64_t>
+DownloadWindow::Assign(ns3::Ipv4Address addr)
+{
+    std::vector<uint64_t> assigned;
+    uint32_t &nInFlight = m_nPeerInFlight[addr];
+    uint32_t end = std::min((uint32_t)m_queue.size(), m_nWindow);
+    for (uint32_t i = 0; i < end && nInFlight < m_nPerPeer; i++)
+    {
+        uint64_t id = m_queue[i];
+        if (m_inFlight.count(id) == 1 || m_holders[id].count(addr) == 0)
+            continue;
+        m_inFlight[id] = {addr, ns3::Simulator::Now()};
+        nInFlight++;
+        assigned.push_back(id);
+    }
+    return assigned;
+}
+
+bool DownloadWindow::Received(uint64_t blockID)
+{
+    if (m_known.erase(blockID) == 0)
+        return false;
+    m_holders.erase(blockID);
+
+    auto it = m_inFlight.find(blockID);
+    if (it != std::end(m_inFlight))
+    {
+        m_nPeerInFlight[it->second.addr]--;
+        m_inFlight.erase(it);
+    }
+    // blocks mostly arrive in order, the search rarely goes past the front
+    m_queue.erase(std::find(std::begin(m_queue), std::end(m_queue), blockID));
+    return true;
+}
+
+bool DownloadWindow::FindStaller(ns3::Time timeout, ns3::Ipv4Address &staller) const
+{
+    if (m_queue.empty())
+        return false;
+
+    auto it = m_inFlight.find(m_queue.front());
+    if (it == std::end(m_inFlight) || ns3::Simulator::Now() - it->second.since <= timeout)
+        return false;
+
+    staller = it->second.addr;
+    return true;
+}
+
+void DownloadWindow::Release(ns3::Ipv4Address addr)
+{
+    for (auto it = std::begin(m_inFlight); it != std::end(m_inFlight);)
+    {
+        if (it->second.addr == addr)
+            it = m_inFlight.erase(it);
+        else
+            ++it;
+    }
+    m_nPeerInFlight.erase(addr);
+    for (auto &h : m_holders)
+        h.second.erase(addr);
+}
+
+uint32_t
+DownloadWindow::GetSize() const
+{
+    return m_queue.size();
+}
+
+uint32_t
+DownloadWindow::GetNInFlight(ns3::Ipv4Address addr) const
+{
+    auto it = m_nPeerInFlight.find(addr);
+    if (it == std::end(m_nPeerInFlight))
+        return 0;
+    return it->second;
+}
+
+void DownloadWindow::Clear()
+{
+    m_queue.clear();
+    m_known.clear();
+    m_inFlight.clear();
+    m_holders.clear();
+    m_nPeerInFlight.clear();
+}
+
+} // namespace bns
@@ -0,0 +1,82 @@
+/**
+ * This file declares the sliding block download window the Vanilla nodes
+ * use to catch up on the chain from several peers at once.
+ */
+
+#ifndef DOWNLOAD_WINDOW_H
+#define DOWNLOAD_WINDOW_H
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace bns
+{
+
+/**
+ * \brief Blocks to download in chain order, and which peer each one is requested from.
+ * Only the first nWindow blocks are requested, each peer has at most
+ * nPerPeer of them in flight, and only blocks its headers covered. A block holding back the window for too long
+ * marks the peer it was requested from as a staller, whose requests are
+ * then released to the others.
+ */
+class DownloadWindow
+{
+public:
+    DownloadWindow(uint32_t nWindow, uint32_t nPerPeer);
+
+    /**
+     * \brief Append block IDs to download, oldest first, skipping known ones
+     * \param from peer whose headers announced the blocks, it may be asked for them
+     */
+    void Add(const std::vector<uint64_t> &blockIDs, ns3::Ipv4Address from);
+
+    /**
+     * \brief Pick the next unrequested blocks of the window that addr has, up to its free slots
+     */
+    std::vector<uint64_t> Assign(ns3::Ipv4Address addr);
+
+    /**
+     * \brief Remove a downloaded block.
+     * \return true if it was part of the window
+     */
+    bool Received(uint64_t blockID);
+
+    /**
+     * \brief Find the peer the first block of the window is requested from for longer than timeout
+     * \return true if there is one
+     */
+    bool FindStaller(ns3::Time timeout, ns3::Ipv4Address &staller) const;
+
+    /**
+     * \brief Forget the requests and blocks of addr, so they can be assigned to other peers
+     */
+    void Release(ns3::Ipv4Address addr);
+
+    uint32_t GetSize() const;
+    uint32_t GetNInFlight(ns3::Ipv4Address addr) const;
+
+    void Clear();
+
+private:
+    struct Request
+    {
+        ns3::Ipv4Address addr;
+        ns3::Time since;
+    };
+
+    uint32_t m_nWindow;
+    uint32_t m_nPerPeer;
+    std::deque<uint64_t> m_queue;                                                //!< Blocks to download, oldest first
+    std::unordered_set<uint64_t> m_known;                                        //!< Blocks in m_queue
+    std::unordered_map<uint64_t, Request> m_inFlight;                            //!< Requested blocks
+    std::unordered_map<uint64_t, std::set<ns3::Ipv4Address>> m_holders;          //!< Peers whose headers covered a block in m_queue
+    std::unordered_map<ns3::Ipv4Address, uint32_t, ns3::Ipv4AddressHash> m_nPeerInFlight;
+};
+
+} // namespace bns
+#endif /* DOWNLOAD_WINDOW_H */
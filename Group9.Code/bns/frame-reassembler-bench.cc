@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "frame-reassembler.h"
+#include "frame-reassembler-bench.h"
+#include "vanilla-messages.h"
+
+NS_LOG_COMPONENT_DEFINE("BNSFrameReassemblerBench");
+
+namespace bns
+{
+
+static double
+ElapsedMs(std::chrono::steady_clock::time_point start, uint32_t nOps)
+{
+    std::chrono::duration<double, std::milli> d = std::chrono::steady_clock::now() - start;
+    return d.count() / nOps;
+}
+
+/**
+ * \brief A framed BLOCK message of blockSize bytes, cut into segments
+ */
+static std::vector<ns3::Ptr<ns3::Packet>>
+Segments(uint32_t blockSize, uint32_t segmentSize)
+{
+    VanBlockHeader bh;
+    bh.SetBlockId(1);
+    bh.SetPrevId(0);
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(blockSize);
+    packet->AddHeader(bh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(VanMsgType::BLOCK));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    std::vector<ns3::Ptr<ns3::Packet>> segments;
+    for (uint32_t offset = 0; offset < packet->GetSize(); offset += segmentSize)
+        segments.push_back(packet->CreateFragment(offset, std::min(segmentSize, packet->GetSize() - offset)));
+    return segments;
+}
+
+/**
+ * \brief The receive path before the FrameReassembler, one call per segment
+ */
+static uint32_t
+LegacyProcess(ns3::Ptr<ns3::Packet> curPacket)
+{
+    VanLengthHeader lh;
+    if (curPacket->GetSize() < lh.GetSerializedSize())
+        return 0;
+
+    curPacket->PeekHeader(lh);
+    uint32_t length = lh.GetLength();
+    VanTypeHeader th;
+    if (curPacket->GetSize() >= lh.GetSerializedSize() + th.GetSerializedSize())
+    {
+        ns3::Ptr<ns3::Packet> p = curPacket->CreateFragment(lh.GetSerializedSize(), th.GetSerializedSize());
+        p->RemoveHeader(th);
+    }
+    if (curPacket->GetSize() < lh.GetSerializedSize() + length)
+        return 0;
+
+    curPacket->RemoveHeader(lh);
+    ns3::Ptr<ns3::Packet> p = curPacket->CreateFragment(0, length);
+    curPacket->RemoveAtStart(length);
+    return p->GetSize();
+}
+
+void BenchmarkReassembly(uint32_t segmentSize, uint32_t nRounds)
+{
+    NS_LOG_INFO("Receive path benchmark: " << segmentSize << " byte segments, " << nRounds << " messages per size");
+    NS_LOG_INFO("blockMB,segments,legacyMs,reassemblerMs,speedup");
+
+    for (uint32_t mb : {1, 8, 32})
+    {
+        std::vector<ns3::Ptr<ns3::Packet>> segments = Segments(mb * 1024 * 1024, segmentSize);
+        uint64_t sink = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t r = 0; r < nRounds; r++)
+        {
+            ns3::Ptr<ns3::Packet> queue = ns3::Create<ns3::Packet>();
+            for (auto &s : segments)
+            {
+                queue->AddAtEnd(s);
+                sink += LegacyProcess(queue);
+            }
+        }
+        double legacyMs = ElapsedMs(start, nRounds);
+
+        start = std::chrono::steady_clock::now();
+        for (uint32_t r = 0; r < nRounds; r++)
+        {
+            FrameReassembler recvQueue;
+            for (auto &s : segments)
+            {
+                recvQueue.Push(s);
+                ns3::Ptr<ns3::Packet> msg = recvQueue.Pop();
+                if (msg != 0)
+                    sink += msg->GetSize();
+            }
+        }
+        double reassemblerMs = ElapsedMs(start, nRounds);
+
+        NS_LOG_INFO(mb << "," << segments.size() << "," << legacyMs << "," << reassemblerMs << "," << legacyMs / reassemblerMs << " (checksum " << sink << ")");
+    }
+}
+
+} // namespace bns
@@ -0,0 +1,24 @@
+/**
+ * This file declares the microbenchmark of the Vanilla TCP receive path.
+ */
+
+#ifndef FRAME_REASSEMBLER_BENCH_H
+#define FRAME_REASSEMBLER_BENCH_H
+
+#include <stdint.h>
+
+namespace bns
+{
+
+/**
+ * \brief Time the reassembly of 1, 8 and 32 MB BLOCK messages from TCP segments.
+ * Compares the FrameReassembler against the former receive path (AddAtEnd
+ * into one growing packet, fragment and RemoveAtStart on every segment) and
+ * logs the time per message and the speedup.
+ * \param segmentSize bytes per received segment, e.g. the TCP MSS
+ * \param nRounds messages reassembled per size and path
+ */
+void BenchmarkReassembly(uint32_t segmentSize, uint32_t nRounds);
+
+} // namespace bns
+#endif /* FRAME_REASSEMBLER_BENCH_H */
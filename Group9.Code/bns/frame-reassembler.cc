@@ -0,0 +1,81 @@
+#include "frame-reassembler.h"
+#include "vanilla-messages.h"
+
+namespace bns
+{
+
+FrameReassembler::FrameReassembler() : m_size(0), m_hasLength(false), m_frameLength(0)
+{
+}
+
+void FrameReassembler::Push(ns3::Ptr<ns3::Packet> segment)
+{
+    if (segment->GetSize() == 0)
+        return;
+    m_segments.push_back(segment);
+    m_size += segment->GetSize();
+}
+
+ns3::Ptr<ns3::Packet>
+FrameReassembler::Pop()
+{
+    if (!m_hasLength)
+    {
+        VanLengthHeader lh;
+        if (m_size < lh.GetSerializedSize())
+            return 0;
+        ns3::Ptr<ns3::Packet> header = Take(lh.GetSerializedSize());
+        header->RemoveHeader(lh);
+        m_frameLength = lh.GetLength();
+        m_hasLength = true;
+    }
+
+    if (m_size < m_frameLength)
+        return 0;
+
+    m_hasLength = false;
+    return Take(m_frameLength);
+}
+
+ns3::Ptr<ns3::Packet>
+FrameReassembler::Take(uint32_t nBytes)
+{
+    ns3::Ptr<ns3::Packet> p = ns3::Create<ns3::Packet>();
+    while (nBytes > 0 && !m_segments.empty())
+    {
+        ns3::Ptr<ns3::Packet> front = m_segments.front();
+        uint32_t size = front->GetSize();
+        if (size <= nBytes)
+        {
+            p->AddAtEnd(front);
+            m_segments.pop_front();
+            m_size -= size;
+            nBytes -= size;
+        }
+        else
+        {
+            // split the segment holding the end of the message
+            p->AddAtEnd(front->CreateFragment(0, nBytes));
+            m_segments.front() = front->CreateFragment(nBytes, size - nBytes);
+            m_size -= nBytes;
+            nBytes = 0;
+        }
+    }
+    return p;
+}
+
+uint32_t
+FrameReassembler::GetSize() const
+{
+    return m_size;
+}
+
+void FrameReassembler::Clear()
+{
+    m_segments.clear();
+    m_size = 0;
+    m_hasLength = false;
+    m_frameLength = 0;
+}
+
+} // namespace bns
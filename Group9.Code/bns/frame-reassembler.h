@@ -0,0 +1,59 @@
+/**
+ * This file declares the reassembly of length-framed messages from a TCP
+ * byte stream, used by the Vanilla node.
+ */
+
+#ifndef FRAME_REASSEMBLER_H
+#define FRAME_REASSEMBLER_H
+
+#include <deque>
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+namespace bns
+{
+
+/**
+ * \brief Receive buffer of one connection, split into VanLengthHeader frames.
+ * Received segments are only queued and counted. The length header is
+ * parsed once enough bytes arrived, and a message is assembled from the
+ * segments once it is complete, so every byte is copied once no matter in
+ * how many segments a large BLOCK message arrives.
+ */
+class FrameReassembler
+{
+public:
+    FrameReassembler();
+
+    /**
+     * \brief Append a received segment
+     */
+    void Push(ns3::Ptr<ns3::Packet> segment);
+
+    /**
+     * \brief Remove the next complete message, without its length header
+     * \return 0 if no message is complete yet
+     */
+    ns3::Ptr<ns3::Packet> Pop();
+
+    /**
+     * \brief Buffered bytes of messages not returned yet
+     */
+    uint32_t GetSize() const;
+
+    void Clear();
+
+private:
+    /**
+     * \brief Remove the first nBytes (at most GetSize()) as one packet
+     */
+    ns3::Ptr<ns3::Packet> Take(uint32_t nBytes);
+
+    std::deque<ns3::Ptr<ns3::Packet>> m_segments;
+    uint32_t m_size;        //!< Bytes in m_segments
+    bool m_hasLength;       //!< The length header of the next message was parsed
+    uint32_t m_frameLength; //!< Length of the next message, if parsed
+};
+
+} // namespace bns
+#endif /* FRAME_REASSEMBLER_H */
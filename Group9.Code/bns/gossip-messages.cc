@@ -0,0 +1,87 @@
+#include "gossip-messages.h"
+NS_LOG_COMPONENT_DEFINE ("BNSGossipMessages");
+
+namespace bns {
+
+ns3::TypeId
+GossipBlockHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("GossipBlockHeader")
+	.SetParent<Header> ()
+	.AddConstructor<GossipBlockHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+GossipBlockHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+GossipBlockHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GOSSIP_BLOCK_SIZE;
+}
+
+
+void 
+GossipBlockHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU64 (m_prevID);
+}
+
+
+uint32_t 
+GossipBlockHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = start.ReadNtohU64 ();
+    m_prevID = start.ReadNtohU64 ();
+    return GOSSIP_BLOCK_SIZE;
+}
+
+
+void 
+GossipBlockHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "blockID=" << m_blockID << " prevID=" << m_prevID;
+}
+
+void 
+GossipBlockHeader::SetBlockId (uint64_t blockID)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = blockID;
+}
+
+uint64_t 
+GossipBlockHeader::GetBlockId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockID;
+}
+
+void 
+GossipBlockHeader::SetPrevId (uint64_t prevID)
+{
+    NS_LOG_FUNCTION(this);
+    m_prevID = prevID;
+}
+
+uint64_t 
+GossipBlockHeader::GetPrevId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_prevID;
+}
+
+}
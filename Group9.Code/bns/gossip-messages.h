@@ -0,0 +1,44 @@
+#ifndef GOSSIP_MESSAGES_H
+#define GOSSIP_MESSAGES_H
+
+#include "ns3/header.h"
+#include "ns3/log.h"
+#include "vanilla-messages.h"
+
+// define field sizes for the headers, framing reuses VanLengthHeader and VanTypeHeader
+#define GOSSIP_BLOCK_SIZE 8 + 8 // blockID + prevID
+
+namespace bns {
+
+enum class GossipMsgType
+{
+	GRAFT, //0: no payload
+	PRUNE, //1: no payload
+	IHAVE, //2: same layout as VanInvHeader
+	IWANT, //3: same layout as VanGetDataHeader
+	BLOCK, //4
+	TX,	   //5: same layout as VanTxHeader
+};
+
+class GossipBlockHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetBlockId (uint64_t blockID);
+		uint64_t GetBlockId (void) const;
+
+		void SetPrevId (uint64_t prevID);
+		uint64_t GetPrevId (void) const;
+
+	private:
+		uint64_t m_blockID;
+		uint64_t m_prevID;
+};
+}
+#endif
@@ -0,0 +1,740 @@
+#include <algorithm>
+#include "ns3/address.h"
+#include "ns3/address-utils.h"
+#include "ns3/log.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-socket.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include "bitcoin-node.h"
+#include "bitcoin-miner.h"
+#include "gossip-node.h"
+#include "vanilla-node.h"
+#include "util.h"
+
+NS_LOG_COMPONENT_DEFINE("BNSGossipNode");
+
+namespace bns
+{
+
+uint16_t GossipNode::gossipD = 6;
+
+uint16_t GossipNode::gossipDLow = 5;
+
+uint16_t GossipNode::gossipDHigh = 12;
+
+uint16_t GossipNode::gossipDLazy = 6;
+
+double GossipNode::gossipHeartbeat = 1.0;
+
+GossipNode::GossipNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : BitcoinNode(address, isMiner, hashRate), m_scorer(GOSSIP_SCORE_BLOCKS, ns3::Seconds(GOSSIP_SCORE_WINDOW)), m_nReceivedBlocks(0), m_nLazyBlocks(0), m_nPrunes(0), m_meshSizeSum(0), m_nHeartbeats(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+GossipNode::~GossipNode(void)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void GossipNode::DoDispose(void)
+{
+    NS_LOG_FUNCTION(this);
+
+    m_socket = 0;
+
+    // chain up
+    Application::DoDispose();
+}
+
+// Application Methods
+void GossipNode::StartApplication() // Called at time specified by Start
+{
+    NS_LOG_FUNCTION(this);
+    NS_LOG_INFO("Starting node " << GetNode()->GetId() << ": " << m_address);
+    m_isRunning = true;
+
+    if (!m_socket)
+    {
+        m_socket = ns3::Socket::CreateSocket(GetNode(), ns3::TcpSocketFactory::GetTypeId());
+        m_socket->Bind(ns3::InetSocketAddress(ns3::Ipv4Address::GetAny(), GOSSIP_PORT));
+        m_socket->Listen();
+        m_socket->SetAcceptCallback(
+            ns3::MakeNullCallback<bool, ns3::Ptr<ns3::Socket>, const ns3::Address &>(),
+            ns3::MakeCallback(&GossipNode::HandleAccept, this));
+    }
+
+    m_history.assign(1, {});
+    ConnectPeers();
+
+    // nodes start together, spread their heartbeats
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    m_heartbeat = ns3::Simulator::Schedule(ns3::Seconds(x->GetValue(0, gossipHeartbeat)), &GossipNode::Heartbeat, this);
+
+    if (m_isMiner)
+    {
+        ns3::Simulator::Schedule(ns3::Seconds(200), &BitcoinMiner::StartMining, m_miner);
+    }
+}
+
+void GossipNode::StopApplication() // Called at time specified by Stop
+{
+    NS_LOG_FUNCTION(this);
+
+    m_isRunning = false;
+    ns3::Simulator::Cancel(m_heartbeat);
+
+    // accept no incoming connections anymore
+    m_socket->Close();
+    m_socket = 0;
+
+    for (auto &e : m_sockets)
+        e.second->Close();
+    m_sockets.clear();
+    m_sendQueues.clear();
+    m_connecting.clear();
+    m_recvBuffers.clear();
+
+    m_mesh.clear();
+    m_backoff.clear();
+    m_scorer.Clear();
+    m_history.clear();
+    m_requested.clear();
+}
+
+void GossipNode::InitBroadcast(Block &b)
+{
+    NS_LOG_FUNCTION(this);
+    m_seen.insert(b.blockID);
+    if (!m_history.empty())
+        m_history.front().push_back(b.blockID);
+
+    std::set<ns3::Ipv4Address> &known = m_knownBy[b.blockID];
+    for (auto &addr : m_mesh)
+    {
+        if (known.count(addr) == 1)
+            continue;
+        SendBlockMessage(addr, b);
+    }
+    CollectBlockStates();
+}
+
+void GossipNode::InitTxBroadcast(Tx &tx)
+{
+    RelayTx(tx, m_address);
+}
+
+void GossipNode::RelayTx(Tx &tx, ns3::Ipv4Address from)
+{
+    for (auto &addr : m_mesh)
+    {
+        if (addr != from)
+            SendTxMessage(addr, tx);
+    }
+}
+
+void GossipNode::Heartbeat(void)
+{
+    // replace peers that left
+    ConnectPeers();
+    ExpirePromises();
+    MaintainMesh();
+    EmitGossip();
+
+    m_history.push_front({});
+    if (m_history.size() > GOSSIP_HISTORY)
+        m_history.pop_back();
+
+    m_meshSizeSum += m_mesh.size();
+    m_nHeartbeats++;
+    m_heartbeat = ns3::Simulator::Schedule(ns3::Seconds(gossipHeartbeat), &GossipNode::Heartbeat, this);
+}
+
+void GossipNode::ConnectPeers(void)
+{
+    std::vector<ns3::Ipv4Address> candidates;
+    for (auto &addr : m_knownAddresses)
+    {
+        if (addr != m_address && m_sockets.count(addr) == 0 && m_connecting.count(addr) == 0)
+            candidates.push_back(addr);
+    }
+
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    for (uint32_t j = 0; j < candidates.size() && m_sockets.size() + m_connecting.size() < gossipDHigh; j++)
+    {
+        uint32_t k = x->GetInteger(j, candidates.size() - 1);
+        std::swap(candidates[j], candidates[k]);
+        Connect(candidates[j]);
+    }
+}
+
+std::vector<ns3::Ipv4Address>
+GossipNode::GetCandidates(bool byScore)
+{
+    std::vector<ns3::Ipv4Address> candidates;
+    for (auto &s : m_sockets)
+    {
+        if (m_mesh.count(s.first) == 0 && m_scorer.GetScore(s.first) >= 0)
+            candidates.push_back(s.first);
+    }
+
+    // random order, so equal scores are picked at random
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    for (uint32_t j = 0; j + 1 < candidates.size(); j++)
+        std::swap(candidates[j], candidates[x->GetInteger(j, candidates.size() - 1)]);
+    if (byScore)
+        std::stable_sort(std::begin(candidates), std::end(candidates), [this](ns3::Ipv4Address a, ns3::Ipv4Address b) { return m_scorer.GetScore(a) > m_scorer.GetScore(b); });
+    return candidates;
+}
+
+void GossipNode::MaintainMesh(void)
+{
+    std::vector<ns3::Ipv4Address> mesh(std::begin(m_mesh), std::end(m_mesh));
+    for (auto &addr : mesh)
+    {
+        if (m_scorer.GetScore(addr) < 0)
+            Prune(addr);
+    }
+
+    ns3::Time now = ns3::Simulator::Now();
+    if (m_mesh.size() < gossipDLow)
+    {
+        for (auto &addr : GetCandidates(true))
+        {
+            if (m_mesh.size() >= gossipD)
+                break;
+            auto bit = m_backoff.find(addr);
+            if (bit == std::end(m_backoff) || bit->second <= now)
+                Graft(addr);
+        }
+    }
+
+    if (m_mesh.size() > gossipDHigh)
+    {
+        // keep the best gossipD
+        mesh.assign(std::begin(m_mesh), std::end(m_mesh));
+        std::sort(std::begin(mesh), std::end(mesh), [this](ns3::Ipv4Address a, ns3::Ipv4Address b) { return m_scorer.GetScore(a) > m_scorer.GetScore(b); });
+        for (uint32_t j = gossipD; j < mesh.size(); j++)
+            Prune(mesh[j]);
+    }
+}
+
+void GossipNode::EmitGossip(void)
+{
+    if (m_isByzantine)
+        return;
+
+    std::vector<uint64_t> recent;
+    for (auto &h : m_history)
+        recent.insert(std::end(recent), std::begin(h), std::end(h));
+    if (recent.empty())
+        return;
+
+    std::vector<ns3::Ipv4Address> candidates = GetCandidates(false);
+    for (uint32_t j = 0; j < candidates.size() && j < gossipDLazy; j++)
+    {
+        std::vector<uint64_t> blockIDs;
+        for (uint64_t id : recent)
+        {
+            if (m_knownBy[id].count(candidates[j]) == 0)
+                blockIDs.push_back(id);
+        }
+        if (!blockIDs.empty())
+            SendIHaveMessage(candidates[j], blockIDs);
+    }
+}
+
+void GossipNode::ExpirePromises(void)
+{
+    ns3::Time now = ns3::Simulator::Now();
+    for (auto it = std::begin(m_requested); it != std::end(m_requested);)
+    {
+        if (now - it->second.second <= ns3::Seconds(GOSSIP_IWANT_TIMEOUT))
+        {
+            ++it;
+            continue;
+        }
+        if (m_seen.count(it->first) == 0)
+        {
+            NS_LOG_INFO("Peer " << it->second.first << " did not answer IWANT " << it->first);
+            m_scorer.BrokenPromise(it->second.first);
+        }
+        it = m_requested.erase(it);
+    }
+}
+
+void GossipNode::CollectBlockStates(void)
+{
+    uint32_t topHeight = m_blockchain->GetTopBlockHeight();
+    if (topHeight <= GOSSIP_STATE_DEPTH)
+        return;
+    uint32_t maxHeight = topHeight - GOSSIP_STATE_DEPTH;
+
+    // blocks not in the chain yet wait for their parent, keep them
+    auto isBuried = [this, maxHeight](uint64_t blockID) {
+        return m_blockchain->HasBlock(blockID) && m_blockchain->GetBlockById(blockID).blockHeight <= maxHeight;
+    };
+    for (auto it = std::begin(m_seen); it != std::end(m_seen);)
+    {
+        if (isBuried(*it))
+            it = m_seen.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = std::begin(m_knownBy); it != std::end(m_knownBy);)
+    {
+        bool announcedOnly = m_seen.count(it->first) == 0 && m_requested.count(it->first) == 0;
+        if (announcedOnly || isBuried(it->first))
+            it = m_knownBy.erase(it);
+        else
+            ++it;
+    }
+}
+
+void GossipNode::Graft(ns3::Ipv4Address addr)
+{
+    m_mesh.insert(addr);
+    m_scorer.SetInMesh(addr, true);
+    SendControlMessage(addr, GossipMsgType::GRAFT);
+}
+
+void GossipNode::Prune(ns3::Ipv4Address addr)
+{
+    m_mesh.erase(addr);
+    m_scorer.SetInMesh(addr, false);
+    m_backoff[addr] = ns3::Simulator::Now() + ns3::Seconds(GOSSIP_PRUNE_BACKOFF);
+    m_nPrunes++;
+    SendControlMessage(addr, GossipMsgType::PRUNE);
+}
+
+void GossipNode::SendControlMessage(ns3::Ipv4Address addr, GossipMsgType type)
+{
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(type));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(addr, packet);
+}
+
+void GossipNode::SendIHaveMessage(ns3::Ipv4Address addr, std::vector<uint64_t> blockIDs)
+{
+    VanInvHeader ih;
+    ih.SetInventory(blockIDs);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+    packet->AddHeader(ih);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(GossipMsgType::IHAVE));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(addr, packet);
+}
+
+void GossipNode::SendIWantMessage(ns3::Ipv4Address addr, std::vector<uint64_t> blockIDs)
+{
+    ns3::Time now = ns3::Simulator::Now();
+    for (uint64_t id : blockIDs)
+        m_requested[id] = {addr, now};
+
+    VanGetDataHeader gh;
+    gh.SetInventory(blockIDs);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+    packet->AddHeader(gh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(GossipMsgType::IWANT));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(addr, packet);
+}
+
+void GossipNode::SendBlockMessage(ns3::Ipv4Address addr, Block &b)
+{
+    if (addr == m_address)
+        return; // do not send to self
+    m_knownBy[b.blockID].insert(addr);
+
+    GossipBlockHeader bh;
+    bh.SetBlockId(b.blockID);
+    bh.SetPrevId(b.prevID);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(b.blockSize);
+    packet->AddHeader(bh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(GossipMsgType::BLOCK));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(addr, packet);
+}
+
+void GossipNode::SendTxMessage(ns3::Ipv4Address addr, Tx &tx)
+{
+    VanTxHeader txh;
+    txh.SetTxId(tx.txID);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(tx.txSize);
+    packet->AddHeader(txh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(GossipMsgType::TX));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(addr, packet);
+}
+
+void GossipNode::SendPacket(ns3::Ipv4Address addr, ns3::Ptr<ns3::Packet> packet)
+{
+    NS_LOG_FUNCTION(this << packet);
+    if (!m_isRunning)
+        return;
+
+    m_sendQueues[addr].push_back(packet);
+    if (m_sockets.count(addr) == 1)
+        SendAvailable(addr);
+    else if (m_connecting.count(addr) == 0)
+        Connect(addr);
+}
+
+void GossipNode::SendAvailable(ns3::Ipv4Address addr)
+{
+    auto sit = m_sockets.find(addr);
+    auto qit = m_sendQueues.find(addr);
+    if (sit == std::end(m_sockets) || qit == std::end(m_sendQueues))
+        return;
+
+    std::deque<ns3::Ptr<ns3::Packet>> &queue = qit->second;
+    while (!queue.empty() && sit->second->GetTxAvailable() >= queue.front()->GetSize())
+    {
+        sit->second->Send(queue.front());
+        queue.pop_front();
+    }
+}
+
+void GossipNode::Connect(ns3::Ipv4Address addr)
+{
+    NS_LOG_INFO("Connecting to address " << addr);
+    m_connecting.insert(addr);
+
+    ns3::Ptr<ns3::Socket> socketPtr = ns3::Socket::CreateSocket(GetNode(), ns3::TcpSocketFactory::GetTypeId());
+    socketPtr->Bind();
+    socketPtr->SetConnectCallback(
+        ns3::MakeCallback(&GossipNode::HandleConnect, this),
+        ns3::MakeCallback(&GossipNode::HandleConnectFailed, this));
+    socketPtr->Connect(ns3::InetSocketAddress(addr, GOSSIP_PORT));
+}
+
+void GossipNode::AddConnection(ns3::Ipv4Address addr, ns3::Ptr<ns3::Socket> socketPtr)
+{
+    ns3::Ptr<ns3::TcpSocket> sock = ns3::DynamicCast<ns3::TcpSocket>(socketPtr);
+    uint32_t bufSize = 1.5 * 1024 * 1024 * BitcoinMiner::blockSizeFactor;
+    sock->SetAttribute("SndBufSize", ns3::UintegerValue(bufSize));
+    socketPtr->SetCloseCallbacks(
+        ns3::MakeCallback(&GossipNode::HandlePeerClose, this),
+        ns3::MakeCallback(&GossipNode::HandlePeerError, this));
+    socketPtr->SetRecvCallback(ns3::MakeCallback(&GossipNode::HandleRead, this));
+    socketPtr->SetDataSentCallback(ns3::MakeCallback(&GossipNode::HandleSent, this));
+
+    // on a simultaneous open both sockets receive, we send on the first one
+    if (m_sockets.count(addr) == 0)
+    {
+        m_sockets[addr] = socketPtr;
+        m_scorer.AddPeer(addr);
+    }
+    SendAvailable(addr);
+}
+
+void GossipNode::DropConnection(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    ns3::Ipv4Address addr = GetSocketAddress(socketPtr);
+    m_recvBuffers.erase(socketPtr);
+
+    auto sit = m_sockets.find(addr);
+    if (sit != std::end(m_sockets) && sit->second == socketPtr)
+    {
+        // the peer left, its queued packets are lost
+        m_sockets.erase(sit);
+        m_sendQueues.erase(addr);
+        m_mesh.erase(addr);
+        m_scorer.RemovePeer(addr);
+    }
+}
+
+void GossipNode::HandleAccept(ns3::Ptr<ns3::Socket> socketPtr, const ns3::Address &from)
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_isRunning)
+        return;
+
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    AddConnection(peerAddr, socketPtr);
+}
+
+void GossipNode::HandleConnect(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this);
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    m_connecting.erase(peerAddr);
+    if (!m_isRunning)
+    {
+        socketPtr->Close();
+        return;
+    }
+
+    AddConnection(peerAddr, socketPtr);
+}
+
+void GossipNode::HandleConnectFailed(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this);
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    NS_LOG_WARN("Outgoing connection FAILED: " << peerAddr);
+    m_connecting.erase(peerAddr);
+    if (m_sockets.count(peerAddr) == 0)
+        m_sendQueues.erase(peerAddr);
+}
+
+void GossipNode::HandleSent(ns3::Ptr<ns3::Socket> socketPtr, uint32_t availBytes)
+{
+    NS_LOG_FUNCTION(this << socketPtr << availBytes);
+    if (!m_isRunning)
+        return;
+    SendAvailable(GetSocketAddress(socketPtr));
+}
+
+void GossipNode::HandleRead(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this << socketPtr);
+    if (!m_isRunning)
+        return;
+
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    FrameReassembler &recvQueue = m_recvBuffers[socketPtr];
+
+    ns3::Ptr<ns3::Packet> p = socketPtr->Recv();
+    while (p != 0)
+    {
+        recvQueue.Push(p);
+
+        ns3::Ptr<ns3::Packet> msg = recvQueue.Pop();
+        while (msg != 0)
+        {
+            HandlePacket(peerAddr, msg);
+            msg = recvQueue.Pop();
+        }
+        p = socketPtr->Recv();
+    }
+}
+
+void GossipNode::HandlePeerClose(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this << socketPtr);
+    if (!m_isRunning)
+        return;
+    DropConnection(socketPtr);
+}
+
+void GossipNode::HandlePeerError(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this << socketPtr);
+    if (!m_isRunning)
+        return;
+    NS_LOG_WARN("Connection ERROR: " << GetSocketAddress(socketPtr));
+    NS_LOG_WARN("Error: " << show_errno(socketPtr->GetErrno()));
+    DropConnection(socketPtr);
+}
+
+void GossipNode::HandlePacket(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet)
+{
+    NS_LOG_FUNCTION(this);
+
+    VanTypeHeader th;
+    packet->RemoveHeader(th);
+    switch (static_cast<GossipMsgType>(th.GetType()))
+    {
+    case GossipMsgType::GRAFT:
+        HandleGraftMessage(senderAddr);
+        break;
+    case GossipMsgType::PRUNE:
+        HandlePruneMessage(senderAddr);
+        break;
+    case GossipMsgType::IHAVE:
+        HandleIHaveMessage(senderAddr, packet);
+        break;
+    case GossipMsgType::IWANT:
+        HandleIWantMessage(senderAddr, packet);
+        break;
+    case GossipMsgType::BLOCK:
+        HandleBlockMessage(senderAddr, packet);
+        break;
+    case GossipMsgType::TX:
+        HandleTxMessage(senderAddr, packet);
+        break;
+    default:
+        NS_LOG_DEBUG("Got unknown message: " << packet);
+    }
+}
+
+void GossipNode::HandleGraftMessage(ns3::Ipv4Address senderAddr)
+{
+    // refuse peers with a negative score or in backoff, the mesh is trimmed at the next heartbeat
+    auto bit = m_backoff.find(senderAddr);
+    if (m_scorer.GetScore(senderAddr) < 0 || (bit != std::end(m_backoff) && bit->second > ns3::Simulator::Now()))
+    {
+        SendControlMessage(senderAddr, GossipMsgType::PRUNE);
+        return;
+    }
+    m_mesh.insert(senderAddr);
+    m_scorer.SetInMesh(senderAddr, true);
+}
+
+void GossipNode::HandlePruneMessage(ns3::Ipv4Address senderAddr)
+{
+    m_mesh.erase(senderAddr);
+    m_scorer.SetInMesh(senderAddr, false);
+    m_backoff[senderAddr] = ns3::Simulator::Now() + ns3::Seconds(GOSSIP_PRUNE_BACKOFF);
+}
+
+void GossipNode::HandleIHaveMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet)
+{
+    VanInvHeader ih;
+    packet->RemoveHeader(ih);
+    if (m_scorer.GetScore(senderAddr) < 0)
+        return;
+
+    std::vector<uint64_t> wanted;
+    for (uint64_t id : ih.GetInventory())
+    {
+        if (m_seen.count(id) == 0 && m_blockchain->HasBlock(id))
+            continue; // buried, its state is gone
+        m_knownBy[id].insert(senderAddr);
+        if (m_seen.count(id) == 0 && m_requested.count(id) == 0)
+            wanted.push_back(id);
+    }
+    if (!wanted.empty())
+        SendIWantMessage(senderAddr, wanted);
+}
+
+void GossipNode::HandleIWantMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet)
+{
+    VanGetDataHeader gh;
+    packet->RemoveHeader(gh);
+
+    for (uint64_t id : gh.GetInventory())
+    {
+        if (!m_blockchain->HasBlock(id))
+        {
+            NS_LOG_INFO("Could not find requested BLOCK!!");
+            continue;
+        }
+        Block b = m_blockchain->GetBlockById(id);
+        SendBlockMessage(senderAddr, b);
+    }
+}
+
+void GossipNode::HandleBlockMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet)
+{
+    GossipBlockHeader bh;
+    packet->RemoveHeader(bh);
+
+    Block b = Blockchain::GetNewBlock(bh.GetBlockId(), bh.GetPrevId(), packet->GetSize());
+    if (m_seen.count(b.blockID) == 0 && m_blockchain->HasBlock(b.blockID))
+        return; // a late copy of a block whose state we dropped
+    m_knownBy[b.blockID].insert(senderAddr);
+    bool first = m_seen.count(b.blockID) == 0;
+    m_scorer.Observe(b.blockID, senderAddr, first);
+    if (!first)
+        return;
+
+    m_seen.insert(b.blockID);
+    m_nReceivedBlocks++;
+    auto rit = m_requested.find(b.blockID);
+    if (rit != std::end(m_requested))
+    {
+        if (rit->second.first == senderAddr)
+            m_nLazyBlocks++;
+        m_requested.erase(rit);
+    }
+
+    SetTTFB(b.blockID, ns3::Simulator::Now());
+    SetTTLB(b.blockID, ns3::Simulator::Now());
+
+    if (b.prevID != 0 && !m_blockchain->HasBlock(b.prevID) && m_seen.count(b.prevID) == 0 && m_requested.count(b.prevID) == 0)
+    {
+        NS_LOG_INFO("Requesting missing parent " << b.prevID << " from " << senderAddr);
+        SendIWantMessage(senderAddr, {b.prevID});
+    }
+
+    ns3::Time delay = GetValidationDelay(b);
+    ns3::Simulator::Schedule(delay, &GossipNode::NotifyNewBlock, this, b, false);
+}
+
+void GossipNode::HandleTxMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet)
+{
+    VanTxHeader txh;
+    packet->RemoveHeader(txh);
+
+    Tx tx;
+    tx.txID = txh.GetTxId();
+    tx.txSize = packet->GetSize();
+    if (AcceptTx(tx))
+        RelayTx(tx, senderAddr);
+}
+
+uint32_t
+GossipNode::GetNReceivedBlocks()
+{
+    return m_nReceivedBlocks;
+}
+
+uint32_t
+GossipNode::GetNLazyBlocks()
+{
+    return m_nLazyBlocks;
+}
+
+uint32_t
+GossipNode::GetNPrunes()
+{
+    return m_nPrunes;
+}
+
+double
+GossipNode::GetMeanMeshSize()
+{
+    if (m_nHeartbeats == 0)
+        return 0;
+    return m_meshSizeSum / m_nHeartbeats;
+}
+} // namespace bns
@@ -0,0 +1,192 @@
+/**
+ * This file declares the GossipNode class, a gossipsub-style mesh broadcast.
+ */
+
+#ifndef GOSSIP_NODE_H
+#define GOSSIP_NODE_H
+
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/socket.h"
+
+#include "bitcoin-node.h"
+#include "frame-reassembler.h"
+#include "gossip-messages.h"
+#include "mesh-scorer.h"
+
+#define GOSSIP_PORT 8337
+#define GOSSIP_HISTORY 3         // Heartbeats a valid block is announced in IHAVEs
+#define GOSSIP_IWANT_TIMEOUT 30  // Seconds a peer has to answer our IWANT
+#define GOSSIP_PRUNE_BACKOFF 60  // Seconds a pruned peer is not grafted again
+#define GOSSIP_SCORE_BLOCKS 8    // Recent blocks the mesh delivery deficit is measured over
+#define GOSSIP_SCORE_WINDOW 30   // Seconds after we first saw a block in which a mesh peer's copy counts as delivered
+#define GOSSIP_STATE_DEPTH 6     // Blocks below the top whose seen flags and recipients are still remembered
+
+namespace bns
+{
+
+class Address;
+class Socket;
+class Packet;
+
+/**
+ * \brief Eager push over a bounded-degree mesh plus lazy IHAVE/IWANT gossip, as in gossipsub.
+ * Every node keeps TCP connections to about gossipDHigh peers and a mesh of
+ * gossipD of them, joined with GRAFT and left with PRUNE. A valid block is
+ * pushed to all mesh peers not known to have it. Every gossipHeartbeat the
+ * node keeps its mesh between gossipDLow and gossipDHigh peers, preferring
+ * high scores, and sends IHAVEs with the blocks of the last GOSSIP_HISTORY
+ * heartbeats to gossipDLazy random peers outside the mesh, which fetch the
+ * ones they miss with IWANT. Peers are scored by a MeshScorer, negative
+ * peers are pruned and get no gossip. Transactions are only pushed over the
+ * mesh. Blocks whose parent is unknown are completed with an IWANT to the
+ * sender.
+ */
+class GossipNode : public BitcoinNode
+{
+public:
+    GossipNode(ns3::Ipv4Address address, bool isMiner, double hashRate);
+
+    virtual ~GossipNode(void);
+
+    static uint16_t gossipD;
+    static uint16_t gossipDLow;
+    static uint16_t gossipDHigh;
+    static uint16_t gossipDLazy;
+    static double gossipHeartbeat; //!< Seconds between mesh maintenance and gossip rounds
+
+    /**
+     * \brief Blocks we got from other nodes
+     */
+    uint32_t GetNReceivedBlocks();
+
+    /**
+     * \brief Blocks we got first as the answer to an IWANT, not pushed over the mesh
+     */
+    uint32_t GetNLazyBlocks();
+
+    uint32_t GetNPrunes();
+
+    /**
+     * \brief Mean number of mesh peers at the heartbeats
+     */
+    double GetMeanMeshSize();
+
+protected:
+    virtual void DoDispose(void); // inherited from Application base class.
+
+    virtual void StartApplication(void); // Called at time specified by Start
+    virtual void StopApplication(void);  // Called at time specified by Stop
+
+    /**
+     * \brief Push a valid block to the mesh and remember it for the IHAVEs
+     */
+    void InitBroadcast(Block &b);
+
+    void InitTxBroadcast(Tx &tx);
+
+    /**
+     * \brief Push a transaction to the mesh peers other than from
+     */
+    void RelayTx(Tx &tx, ns3::Ipv4Address from);
+
+    /**
+     * \brief Mesh maintenance, gossip and expiry of IWANT promises
+     */
+    void Heartbeat(void);
+
+    /**
+     * \brief Open connections until we have gossipDHigh peers
+     */
+    void ConnectPeers(void);
+
+    void MaintainMesh(void);
+    void EmitGossip(void);
+    void ExpirePromises(void);
+
+    /**
+     * \brief Drop the state of blocks buried GOSSIP_STATE_DEPTH blocks deep, and of announced IDs nobody delivered
+     */
+    void CollectBlockStates(void);
+
+    void Graft(ns3::Ipv4Address addr);
+    void Prune(ns3::Ipv4Address addr);
+
+    /**
+     * \brief Random peers outside the mesh with a non-negative score, best first if byScore
+     */
+    std::vector<ns3::Ipv4Address> GetCandidates(bool byScore);
+
+    void SendControlMessage(ns3::Ipv4Address addr, GossipMsgType type);
+    void SendIHaveMessage(ns3::Ipv4Address addr, std::vector<uint64_t> blockIDs);
+    void SendIWantMessage(ns3::Ipv4Address addr, std::vector<uint64_t> blockIDs);
+    void SendBlockMessage(ns3::Ipv4Address addr, Block &b);
+    void SendTxMessage(ns3::Ipv4Address addr, Tx &tx);
+
+    /**
+     * \brief Queue the packet for addr, connecting first if needed
+     */
+    void SendPacket(ns3::Ipv4Address addr, ns3::Ptr<ns3::Packet> packet);
+
+    /**
+     * \brief Hand the queued packets of addr to its socket as long as they fit
+     */
+    void SendAvailable(ns3::Ipv4Address addr);
+
+    void Connect(ns3::Ipv4Address addr);
+    void AddConnection(ns3::Ipv4Address addr, ns3::Ptr<ns3::Socket> socketPtr);
+    void DropConnection(ns3::Ptr<ns3::Socket> socketPtr);
+
+    void HandleAccept(ns3::Ptr<ns3::Socket> socketPtr, const ns3::Address &from);
+    void HandleConnect(ns3::Ptr<ns3::Socket> socketPtr);
+    void HandleConnectFailed(ns3::Ptr<ns3::Socket> socketPtr);
+    void HandleSent(ns3::Ptr<ns3::Socket> socketPtr, uint32_t availBytes);
+    void HandleRead(ns3::Ptr<ns3::Socket> socketPtr);
+    void HandlePeerClose(ns3::Ptr<ns3::Socket> socketPtr);
+    void HandlePeerError(ns3::Ptr<ns3::Socket> socketPtr);
+
+    /**
+     * \brief Handle a complete message, without its length header
+     */
+    void HandlePacket(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet);
+
+    void HandleGraftMessage(ns3::Ipv4Address senderAddr);
+    void HandlePruneMessage(ns3::Ipv4Address senderAddr);
+    void HandleIHaveMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet);
+    void HandleIWantMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet);
+    void HandleBlockMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet);
+    void HandleTxMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet);
+
+    std::set<ns3::Ipv4Address> m_mesh;
+    std::unordered_map<ns3::Ipv4Address, ns3::Time, ns3::Ipv4AddressHash> m_backoff; //!< No GRAFT with these peers before
+    MeshScorer m_scorer;
+
+    std::unordered_set<uint64_t> m_seen;                                              //!< Blocks we received or mined, valid or not yet
+    std::unordered_map<uint64_t, std::set<ns3::Ipv4Address>> m_knownBy;               //!< Nodes we sent a block to or got it or an IHAVE from
+    std::deque<std::vector<uint64_t>> m_history;                                      //!< Valid blocks per heartbeat, newest first
+    std::unordered_map<uint64_t, std::pair<ns3::Ipv4Address, ns3::Time>> m_requested; //!< IWANTs not answered yet
+
+    std::unordered_map<ns3::Ipv4Address, ns3::Ptr<ns3::Socket>, ns3::Ipv4AddressHash> m_sockets;
+    std::unordered_map<ns3::Ipv4Address, std::deque<ns3::Ptr<ns3::Packet>>, ns3::Ipv4AddressHash> m_sendQueues;
+    std::set<ns3::Ipv4Address> m_connecting;
+    std::map<ns3::Ptr<ns3::Socket>, FrameReassembler> m_recvBuffers;
+
+    ns3::EventId m_heartbeat;
+
+    uint32_t m_nReceivedBlocks;
+    uint32_t m_nLazyBlocks;
+    uint32_t m_nPrunes;
+    double m_meshSizeSum;
+    uint32_t m_nHeartbeats;
+};
+
+} // namespace bns
+#endif
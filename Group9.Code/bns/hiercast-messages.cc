@@ -0,0 +1,183 @@
+#include "hiercast-messages.h"
+NS_LOG_COMPONENT_DEFINE ("BNSHiercastMessages");
+
+namespace bns {
+
+ns3::TypeId
+HierBlockHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("HierBlockHeader")
+	.SetParent<Header> ()
+	.AddConstructor<HierBlockHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+HierBlockHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+HierBlockHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return HIER_BLOCK_SIZE;
+}
+
+
+void 
+HierBlockHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU64 (m_prevID);
+    start.WriteHtonU32 (m_root);
+    start.WriteU8 (m_stage);
+}
+
+
+uint32_t 
+HierBlockHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = start.ReadNtohU64 ();
+    m_prevID = start.ReadNtohU64 ();
+    m_root = start.ReadNtohU32 ();
+    m_stage = start.ReadU8 ();
+    return HIER_BLOCK_SIZE;
+}
+
+
+void 
+HierBlockHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "blockID=" << m_blockID << " root=" << m_root << " stage=" << (uint32_t)m_stage;
+}
+
+void 
+HierBlockHeader::SetBlockId (uint64_t blockID)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = blockID;
+}
+
+uint64_t 
+HierBlockHeader::GetBlockId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockID;
+}
+
+void 
+HierBlockHeader::SetPrevId (uint64_t prevID)
+{
+    NS_LOG_FUNCTION(this);
+    m_prevID = prevID;
+}
+
+uint64_t 
+HierBlockHeader::GetPrevId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_prevID;
+}
+
+void 
+HierBlockHeader::SetRoot (uint32_t root)
+{
+    NS_LOG_FUNCTION(this);
+    m_root = root;
+}
+
+uint32_t 
+HierBlockHeader::GetRoot (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_root;
+}
+
+void 
+HierBlockHeader::SetStage (uint8_t stage)
+{
+    NS_LOG_FUNCTION(this);
+    m_stage = stage;
+}
+
+uint8_t 
+HierBlockHeader::GetStage (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_stage;
+}
+
+ns3::TypeId
+HierGetBlockHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("HierGetBlockHeader")
+	.SetParent<Header> ()
+	.AddConstructor<HierGetBlockHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+HierGetBlockHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+HierGetBlockHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return HIER_GETBLOCK_SIZE;
+}
+
+
+void 
+HierGetBlockHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    start.WriteHtonU64 (m_blockID);
+}
+
+
+uint32_t 
+HierGetBlockHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = start.ReadNtohU64 ();
+    return HIER_GETBLOCK_SIZE;
+}
+
+
+void 
+HierGetBlockHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "blockID=" << m_blockID;
+}
+
+void 
+HierGetBlockHeader::SetBlockId (uint64_t blockID)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = blockID;
+}
+
+uint64_t 
+HierGetBlockHeader::GetBlockId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockID;
+}
+
+}
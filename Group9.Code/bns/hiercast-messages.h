@@ -0,0 +1,76 @@
+#ifndef HIERCAST_MESSAGES_H
+#define HIERCAST_MESSAGES_H
+
+#include "ns3/header.h"
+#include "ns3/log.h"
+#include "vanilla-messages.h"
+
+// define field sizes for the headers, framing reuses VanLengthHeader and VanTypeHeader
+#define HIER_BLOCK_SIZE 8 + 8 + 4 + 1 // blockID + prevID + tree root + stage
+#define HIER_GETBLOCK_SIZE 8		  // blockID
+
+namespace bns {
+
+enum class HierMsgType
+{
+	BLOCK,	  //0
+	GETBLOCK, //1
+};
+
+/**
+ * \brief How a block was sent, i.e. what the receiver does with it
+ */
+enum class HierStage
+{
+	INTER,	//0: pushed to a region representative, which roots a tree in its region
+	INTRA,	//1: pushed down the tree rooted at the given node
+	REPAIR, //2: sent on request, not forwarded
+};
+
+class HierBlockHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetBlockId (uint64_t blockID);
+		uint64_t GetBlockId (void) const;
+
+		void SetPrevId (uint64_t prevID);
+		uint64_t GetPrevId (void) const;
+
+		void SetRoot (uint32_t root);
+		uint32_t GetRoot (void) const;
+
+		void SetStage (uint8_t stage);
+		uint8_t GetStage (void) const;
+
+	private:
+		uint64_t m_blockID;
+		uint64_t m_prevID;
+		uint32_t m_root;
+		uint8_t m_stage;
+};
+
+class HierGetBlockHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetBlockId (uint64_t blockID);
+		uint64_t GetBlockId (void) const;
+
+	private:
+		uint64_t m_blockID;
+};
+}
+#endif
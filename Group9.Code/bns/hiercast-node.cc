@@ -0,0 +1,473 @@
+#include <algorithm>
+#include "ns3/address.h"
+#include "ns3/address-utils.h"
+#include "ns3/log.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/socket.h"
+#include "ns3/tcp-socket.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include "bitcoin-node.h"
+#include "bitcoin-miner.h"
+#include "hiercast-node.h"
+#include "vanilla-node.h"
+#include "util.h"
+
+NS_LOG_COMPONENT_DEFINE("BNSHiercastNode");
+
+namespace bns
+{
+
+uint16_t HiercastNode::hierReps = 1;
+
+uint16_t HiercastNode::hierFanout = 4;
+
+HiercastNode::HiercastNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : BitcoinNode(address, isMiner, hashRate), m_region(0), m_nInterPushes(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+HiercastNode::~HiercastNode(void)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void HiercastNode::DoDispose(void)
+{
+    NS_LOG_FUNCTION(this);
+
+    m_socket = 0;
+
+    // chain up
+    Application::DoDispose();
+}
+
+void HiercastNode::SetHierarchy(uint16_t region, const std::vector<ns3::Ipv4Address> &members, const std::map<uint16_t, std::vector<ns3::Ipv4Address>> &representatives)
+{
+    NS_LOG_FUNCTION(this);
+    m_region = region;
+    m_members = members;
+    std::sort(std::begin(m_members), std::end(m_members));
+    assert(std::find(std::begin(m_members), std::end(m_members), m_address) != std::end(m_members));
+    m_representatives = representatives;
+}
+
+// Application Methods
+void HiercastNode::StartApplication() // Called at time specified by Start
+{
+    NS_LOG_FUNCTION(this);
+    NS_LOG_INFO("Starting node " << GetNode()->GetId() << ": " << m_address << " (region " << m_region << ", " << m_members.size() << " members)");
+    m_isRunning = true;
+
+    if (!m_socket)
+    {
+        m_socket = ns3::Socket::CreateSocket(GetNode(), ns3::TcpSocketFactory::GetTypeId());
+        m_socket->Bind(ns3::InetSocketAddress(ns3::Ipv4Address::GetAny(), HIER_PORT));
+        m_socket->Listen();
+        m_socket->SetAcceptCallback(
+            ns3::MakeNullCallback<bool, ns3::Ptr<ns3::Socket>, const ns3::Address &>(),
+            ns3::MakeCallback(&HiercastNode::HandleAccept, this));
+    }
+
+    if (m_isMiner)
+    {
+        ns3::Simulator::Schedule(ns3::Seconds(200), &BitcoinMiner::StartMining, m_miner);
+    }
+}
+
+void HiercastNode::StopApplication() // Called at time specified by Stop
+{
+    NS_LOG_FUNCTION(this);
+
+    m_isRunning = false;
+
+    // accept no incoming connections anymore
+    m_socket->Close();
+    m_socket = 0;
+
+    for (auto &e : m_sockets)
+        e.second->Close();
+    m_sockets.clear();
+    m_sendQueues.clear();
+    m_connecting.clear();
+    m_recvBuffers.clear();
+}
+
+void HiercastNode::InitBroadcast(Block &b)
+{
+    NS_LOG_FUNCTION(this);
+
+    auto it = m_trees.find(b.blockID);
+    if (it != std::end(m_trees))
+    {
+        for (auto &root : it->second)
+            ForwardInTree(b, root);
+        CollectBlockStates();
+        return;
+    }
+
+    // we mined it: one push per representative of every other region, then our own region
+    NS_LOG_INFO("Broadcasting BLOCK " << b.blockID << " to " << m_representatives.size() << " regions.");
+    for (auto &r : m_representatives)
+    {
+        if (r.first == m_region)
+            continue;
+        for (auto &addr : r.second)
+        {
+            SendBlockMessage(addr, b, HierStage::INTER, addr);
+            m_nInterPushes++;
+        }
+    }
+    m_trees[b.blockID].push_back(m_address);
+    ForwardInTree(b, m_address);
+    CollectBlockStates();
+}
+
+std::vector<ns3::Ipv4Address>
+HiercastNode::GetChildren(ns3::Ipv4Address root)
+{
+    std::vector<ns3::Ipv4Address> children;
+    auto rit = std::find(std::begin(m_members), std::end(m_members), root);
+    auto sit = std::find(std::begin(m_members), std::end(m_members), m_address);
+    if (rit == std::end(m_members) || sit == std::end(m_members))
+        return children;
+
+    // heap layout relative to the root: the children of position p are p * fanout + 1 .. p * fanout + fanout
+    size_t n = m_members.size();
+    size_t rootIndex = rit - std::begin(m_members);
+    size_t pos = (sit - std::begin(m_members) + n - rootIndex) % n;
+    for (size_t c = pos * hierFanout + 1; c <= pos * hierFanout + hierFanout && c < n; c++)
+        children.push_back(m_members[(rootIndex + c) % n]);
+    return children;
+}
+
+void HiercastNode::ForwardInTree(Block &b, ns3::Ipv4Address root)
+{
+    std::set<ns3::Ipv4Address> &known = m_knownBy[b.blockID];
+    for (auto &child : GetChildren(root))
+    {
+        if (known.count(child) == 1)
+            continue;
+        SendBlockMessage(child, b, HierStage::INTRA, root);
+    }
+}
+
+void HiercastNode::CollectBlockStates()
+{
+    uint32_t topHeight = m_blockchain->GetTopBlockHeight();
+    if (topHeight <= HIER_STATE_DEPTH)
+        return;
+    uint32_t maxHeight = topHeight - HIER_STATE_DEPTH;
+
+    // blocks not in the chain yet wait for their parent, keep them
+    auto isBuried = [this, maxHeight](uint64_t blockID) {
+        return m_blockchain->HasBlock(blockID) && m_blockchain->GetBlockById(blockID).blockHeight <= maxHeight;
+    };
+    for (auto it = std::begin(m_trees); it != std::end(m_trees);)
+    {
+        if (isBuried(it->first))
+            it = m_trees.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = std::begin(m_knownBy); it != std::end(m_knownBy);)
+    {
+        if (isBuried(it->first))
+            it = m_knownBy.erase(it);
+        else
+            ++it;
+    }
+}
+
+void HiercastNode::SendBlockMessage(ns3::Ipv4Address addr, Block &b, HierStage stage, ns3::Ipv4Address root)
+{
+    if (addr == m_address)
+        return; // do not send to self
+    m_knownBy[b.blockID].insert(addr);
+
+    HierBlockHeader bh;
+    bh.SetBlockId(b.blockID);
+    bh.SetPrevId(b.prevID);
+    bh.SetRoot(root.Get());
+    bh.SetStage(static_cast<uint8_t>(stage));
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(b.blockSize);
+    packet->AddHeader(bh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(HierMsgType::BLOCK));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(addr, packet);
+}
+
+void HiercastNode::SendGetBlockMessage(ns3::Ipv4Address addr, uint64_t blockID)
+{
+    NS_LOG_INFO("Requesting missing parent " << blockID << " from " << addr);
+
+    HierGetBlockHeader gh;
+    gh.SetBlockId(blockID);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+    packet->AddHeader(gh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(HierMsgType::GETBLOCK));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(addr, packet);
+}
+
+void HiercastNode::SendPacket(ns3::Ipv4Address addr, ns3::Ptr<ns3::Packet> packet)
+{
+    NS_LOG_FUNCTION(this << packet);
+    if (!m_isRunning)
+        return;
+
+    m_sendQueues[addr].push_back(packet);
+    if (m_sockets.count(addr) == 1)
+        SendAvailable(addr);
+    else if (m_connecting.count(addr) == 0)
+        Connect(addr);
+}
+
+void HiercastNode::SendAvailable(ns3::Ipv4Address addr)
+{
+    auto sit = m_sockets.find(addr);
+    auto qit = m_sendQueues.find(addr);
+    if (sit == std::end(m_sockets) || qit == std::end(m_sendQueues))
+        return;
+
+    std::deque<ns3::Ptr<ns3::Packet>> &queue = qit->second;
+    while (!queue.empty() && sit->second->GetTxAvailable() >= queue.front()->GetSize())
+    {
+        sit->second->Send(queue.front());
+        queue.pop_front();
+    }
+}
+
+void HiercastNode::Connect(ns3::Ipv4Address addr)
+{
+    NS_LOG_INFO("Connecting to address " << addr);
+    m_connecting.insert(addr);
+
+    ns3::Ptr<ns3::Socket> socketPtr = ns3::Socket::CreateSocket(GetNode(), ns3::TcpSocketFactory::GetTypeId());
+    socketPtr->Bind();
+    socketPtr->SetConnectCallback(
+        ns3::MakeCallback(&HiercastNode::HandleConnect, this),
+        ns3::MakeCallback(&HiercastNode::HandleConnectFailed, this));
+    socketPtr->Connect(ns3::InetSocketAddress(addr, HIER_PORT));
+}
+
+void HiercastNode::AddConnection(ns3::Ipv4Address addr, ns3::Ptr<ns3::Socket> socketPtr)
+{
+    ns3::Ptr<ns3::TcpSocket> sock = ns3::DynamicCast<ns3::TcpSocket>(socketPtr);
+    uint32_t bufSize = 1.5 * 1024 * 1024 * BitcoinMiner::blockSizeFactor;
+    sock->SetAttribute("SndBufSize", ns3::UintegerValue(bufSize));
+    socketPtr->SetCloseCallbacks(
+        ns3::MakeCallback(&HiercastNode::HandlePeerClose, this),
+        ns3::MakeCallback(&HiercastNode::HandlePeerError, this));
+    socketPtr->SetRecvCallback(ns3::MakeCallback(&HiercastNode::HandleRead, this));
+    socketPtr->SetDataSentCallback(ns3::MakeCallback(&HiercastNode::HandleSent, this));
+
+    // on a simultaneous open both sockets receive, we send on the first one
+    if (m_sockets.count(addr) == 0)
+        m_sockets[addr] = socketPtr;
+    SendAvailable(addr);
+}
+
+void HiercastNode::DropConnection(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    ns3::Ipv4Address addr = GetSocketAddress(socketPtr);
+    m_recvBuffers.erase(socketPtr);
+
+    auto sit = m_sockets.find(addr);
+    if (sit != std::end(m_sockets) && sit->second == socketPtr)
+    {
+        // the peer left, its queued packets are lost
+        m_sockets.erase(sit);
+        m_sendQueues.erase(addr);
+    }
+}
+
+void HiercastNode::HandleAccept(ns3::Ptr<ns3::Socket> socketPtr, const ns3::Address &from)
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_isRunning)
+        return;
+
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    //NS_LOG_INFO("Incoming connection ESTABLISHED: " << peerAddr);
+    AddConnection(peerAddr, socketPtr);
+}
+
+void HiercastNode::HandleConnect(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this);
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    m_connecting.erase(peerAddr);
+    if (!m_isRunning)
+    {
+        socketPtr->Close();
+        return;
+    }
+
+    //NS_LOG_INFO("Outgoing connection ESTABLISHED: " << peerAddr);
+    AddConnection(peerAddr, socketPtr);
+}
+
+void HiercastNode::HandleConnectFailed(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this);
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    NS_LOG_WARN("Outgoing connection FAILED: " << peerAddr);
+    m_connecting.erase(peerAddr);
+    if (m_sockets.count(peerAddr) == 0)
+        m_sendQueues.erase(peerAddr);
+}
+
+void HiercastNode::HandleSent(ns3::Ptr<ns3::Socket> socketPtr, uint32_t availBytes)
+{
+    NS_LOG_FUNCTION(this << socketPtr << availBytes);
+    if (!m_isRunning)
+        return;
+    SendAvailable(GetSocketAddress(socketPtr));
+}
+
+void HiercastNode::HandleRead(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this << socketPtr);
+    if (!m_isRunning)
+        return;
+
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    FrameReassembler &recvQueue = m_recvBuffers[socketPtr];
+
+    ns3::Ptr<ns3::Packet> p = socketPtr->Recv();
+    while (p != 0)
+    {
+        recvQueue.Push(p);
+
+        ns3::Ptr<ns3::Packet> msg = recvQueue.Pop();
+        while (msg != 0)
+        {
+            HandlePacket(peerAddr, msg);
+            msg = recvQueue.Pop();
+        }
+        p = socketPtr->Recv();
+    }
+}
+
+void HiercastNode::HandlePeerClose(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this << socketPtr);
+    if (!m_isRunning)
+        return;
+    DropConnection(socketPtr);
+}
+
+void HiercastNode::HandlePeerError(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this << socketPtr);
+    if (!m_isRunning)
+        return;
+    NS_LOG_WARN("Connection ERROR: " << GetSocketAddress(socketPtr));
+    NS_LOG_WARN("Error: " << show_errno(socketPtr->GetErrno()));
+    DropConnection(socketPtr);
+}
+
+void HiercastNode::HandlePacket(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet)
+{
+    NS_LOG_FUNCTION(this);
+
+    VanTypeHeader th;
+    packet->RemoveHeader(th);
+    switch (static_cast<HierMsgType>(th.GetType()))
+    {
+    case HierMsgType::BLOCK:
+        HandleBlockMessage(senderAddr, packet);
+        break;
+    case HierMsgType::GETBLOCK:
+        HandleGetBlockMessage(senderAddr, packet);
+        break;
+    default:
+        NS_LOG_DEBUG("Got unknown message: " << packet);
+    }
+}
+
+void HiercastNode::HandleBlockMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet)
+{
+    HierBlockHeader bh;
+    packet->RemoveHeader(bh);
+
+    HierStage stage = static_cast<HierStage>(bh.GetStage());
+    Block b = Blockchain::GetNewBlock(bh.GetBlockId(), bh.GetPrevId(), packet->GetSize());
+    if (m_trees.count(b.blockID) == 0 && m_blockchain->HasBlock(b.blockID))
+        return; // a late copy of a block whose state we dropped
+    m_knownBy[b.blockID].insert(senderAddr);
+
+    // representatives root their own tree, repaired blocks are not forwarded
+    ns3::Ipv4Address root = stage == HierStage::INTER ? m_address : ns3::Ipv4Address(bh.GetRoot());
+
+    auto it = m_trees.find(b.blockID);
+    if (it != std::end(m_trees))
+    {
+        std::vector<ns3::Ipv4Address> &roots = it->second;
+        if (stage == HierStage::REPAIR || std::find(std::begin(roots), std::end(roots), root) != std::end(roots))
+            return;
+
+        // another tree reached us, forward along it as well once the block is valid
+        roots.push_back(root);
+        if (m_blockchain->HasBlock(b.blockID))
+            ForwardInTree(b, root);
+        return;
+    }
+
+    std::vector<ns3::Ipv4Address> &roots = m_trees[b.blockID];
+    if (stage != HierStage::REPAIR)
+        roots.push_back(root);
+
+    SetTTFB(b.blockID, ns3::Simulator::Now());
+    SetTTLB(b.blockID, ns3::Simulator::Now());
+
+    if (b.prevID != 0 && !m_blockchain->HasBlock(b.prevID) && m_trees.count(b.prevID) == 0)
+        SendGetBlockMessage(senderAddr, b.prevID);
+
+    ns3::Time delay = GetValidationDelay(b);
+    ns3::Simulator::Schedule(delay, &HiercastNode::NotifyNewBlock, this, b, false);
+}
+
+void HiercastNode::HandleGetBlockMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet)
+{
+    HierGetBlockHeader gh;
+    packet->RemoveHeader(gh);
+
+    uint64_t blockID = gh.GetBlockId();
+    if (!m_blockchain->HasBlock(blockID))
+    {
+        NS_LOG_INFO("Could not find requested BLOCK!!");
+        return;
+    }
+    Block b = m_blockchain->GetBlockById(blockID);
+    SendBlockMessage(senderAddr, b, HierStage::REPAIR, m_address);
+}
+
+uint32_t
+HiercastNode::GetNInterPushes()
+{
+    return m_nInterPushes;
+}
+} // namespace bns
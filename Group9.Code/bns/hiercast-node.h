@@ -0,0 +1,138 @@
+/**
+ * This file declares the HiercastNode class, a region-aware broadcast.
+ */
+
+#ifndef HIERCAST_NODE_H
+#define HIERCAST_NODE_H
+
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include "ns3/application.h"
+#include "ns3/ptr.h"
+#include "ns3/address.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/socket.h"
+
+#include "bitcoin-node.h"
+#include "frame-reassembler.h"
+#include "hiercast-messages.h"
+
+#define HIER_PORT 8335
+#define HIER_STATE_DEPTH 6 // Blocks below the top whose trees and recipients are still remembered
+
+namespace bns
+{
+
+class Address;
+class Socket;
+class Packet;
+
+/**
+ * \brief Two-level block broadcast along the regions of the geo topology.
+ * The origin pushes a block to hierReps representatives of every other
+ * region and roots a tree in its own region. Every representative roots a
+ * tree with fanout hierFanout over the members of its region, so a block
+ * crosses the intercontinental links hierReps times per region instead of
+ * once per random peer. The trees are implicit: the members of a region are
+ * sorted, the position of a node is its offset from the root. Blocks whose
+ * parent is unknown are completed by asking the sender for the parent.
+ * Connections are TCP, opened on first use.
+ */
+class HiercastNode : public BitcoinNode
+{
+public:
+    HiercastNode(ns3::Ipv4Address address, bool isMiner, double hashRate);
+
+    virtual ~HiercastNode(void);
+
+    static uint16_t hierReps;
+    static uint16_t hierFanout;
+
+    /**
+     * \brief Set the members of our region (including us) and the representatives of every region
+     */
+    void SetHierarchy(uint16_t region, const std::vector<ns3::Ipv4Address> &members, const std::map<uint16_t, std::vector<ns3::Ipv4Address>> &representatives);
+
+    /**
+     * \brief Number of blocks we pushed to other regions as origin
+     */
+    uint32_t GetNInterPushes();
+
+protected:
+    virtual void DoDispose(void); // inherited from Application base class.
+
+    virtual void StartApplication(void); // Called at time specified by Start
+    virtual void StopApplication(void);  // Called at time specified by Stop
+
+    /**
+     * \brief Push a block we mined to the other regions and our own, or forward one we received down its trees
+     */
+    void InitBroadcast(Block &b);
+
+    /**
+     * \brief Our children in the tree rooted at root
+     */
+    std::vector<ns3::Ipv4Address> GetChildren(ns3::Ipv4Address root);
+
+    /**
+     * \brief Push the block to our children in the tree rooted at root, skipping nodes known to have it
+     */
+    void ForwardInTree(Block &b, ns3::Ipv4Address root);
+
+    /**
+     * \brief Drop the trees and recipients of blocks buried HIER_STATE_DEPTH blocks deep
+     */
+    void CollectBlockStates();
+
+    void SendBlockMessage(ns3::Ipv4Address addr, Block &b, HierStage stage, ns3::Ipv4Address root);
+    void SendGetBlockMessage(ns3::Ipv4Address addr, uint64_t blockID);
+
+    /**
+     * \brief Queue the packet for addr, connecting first if needed
+     */
+    void SendPacket(ns3::Ipv4Address addr, ns3::Ptr<ns3::Packet> packet);
+
+    /**
+     * \brief Hand the queued packets of addr to its socket as long as they fit
+     */
+    void SendAvailable(ns3::Ipv4Address addr);
+
+    void Connect(ns3::Ipv4Address addr);
+    void AddConnection(ns3::Ipv4Address addr, ns3::Ptr<ns3::Socket> socketPtr);
+    void DropConnection(ns3::Ptr<ns3::Socket> socketPtr);
+
+    void HandleAccept(ns3::Ptr<ns3::Socket> socketPtr, const ns3::Address &from);
+    void HandleConnect(ns3::Ptr<ns3::Socket> socketPtr);
+    void HandleConnectFailed(ns3::Ptr<ns3::Socket> socketPtr);
+    void HandleSent(ns3::Ptr<ns3::Socket> socketPtr, uint32_t availBytes);
+    void HandleRead(ns3::Ptr<ns3::Socket> socketPtr);
+    void HandlePeerClose(ns3::Ptr<ns3::Socket> socketPtr);
+    void HandlePeerError(ns3::Ptr<ns3::Socket> socketPtr);
+
+    /**
+     * \brief Handle a complete message, without its length header
+     */
+    void HandlePacket(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet);
+
+    void HandleBlockMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet);
+    void HandleGetBlockMessage(ns3::Ipv4Address senderAddr, ns3::Ptr<ns3::Packet> packet);
+
+    uint16_t m_region;
+    std::vector<ns3::Ipv4Address> m_members;                             //!< Sorted members of our region
+    std::map<uint16_t, std::vector<ns3::Ipv4Address>> m_representatives; //!< Representatives by region
+
+    std::unordered_map<uint64_t, std::vector<ns3::Ipv4Address>> m_trees; //!< Roots of the trees a block reached us through
+    std::unordered_map<uint64_t, std::set<ns3::Ipv4Address>> m_knownBy;  //!< Nodes we sent a block to or got it from
+
+    std::unordered_map<ns3::Ipv4Address, ns3::Ptr<ns3::Socket>, ns3::Ipv4AddressHash> m_sockets;
+    std::unordered_map<ns3::Ipv4Address, std::deque<ns3::Ptr<ns3::Packet>>, ns3::Ipv4AddressHash> m_sendQueues;
+    std::set<ns3::Ipv4Address> m_connecting;
+    std::map<ns3::Ptr<ns3::Socket>, FrameReassembler> m_recvBuffers;
+
+    uint32_t m_nInterPushes;
+};
+
+} // namespace bns
+#endif
@@ -102,7 +102,7 @@ KadPingHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
+    m_senderID.Serialize(start);
 }
 
 
@@ -110,7 +110,7 @@ uint32_t
 KadPingHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
     return KAD_PING_SIZE; // the number of bytes consumed.
 }
 
@@ -123,14 +123,14 @@ KadPingHeader::Print (std::ostream &os) const
 }
 
 void 
-KadPingHeader::SetSenderId (uint64_t senderID)
+KadPingHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
 
-uint64_t 
+nodeid_t 
 KadPingHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -168,8 +168,8 @@ KadFindNodeHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
-    start.WriteHtonU64 (m_targetID);
+    m_senderID.Serialize(start);
+    m_targetID.Serialize(start);
 }
 
 
@@ -177,8 +177,8 @@ uint32_t
 KadFindNodeHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
-    m_targetID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
+    m_targetID.Deserialize(start);
     return KAD_FINDNODE_SIZE; // the number of bytes consumed.
 }
 
@@ -191,13 +191,13 @@ KadFindNodeHeader::Print (std::ostream &os) const
 }
 
 void 
-KadFindNodeHeader::SetSenderId (uint64_t senderID)
+KadFindNodeHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 KadFindNodeHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -205,14 +205,14 @@ KadFindNodeHeader::GetSenderId (void) const
 }
 
 void 
-KadFindNodeHeader::SetTargetId (uint64_t targetID)
+KadFindNodeHeader::SetTargetId (const nodeid_t &targetID)
 {
     NS_LOG_FUNCTION(this);
     m_targetID = targetID;
 }
 
 
-uint64_t 
+nodeid_t 
 KadFindNodeHeader::GetTargetId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -250,14 +250,14 @@ KadNodesHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
-    start.WriteHtonU64 (m_targetID);
+    m_senderID.Serialize(start);
+    m_targetID.Serialize(start);
     start.WriteHtonU16 (m_nodeCount);
 
     uint8_t tmp_addrBuf[4];
     for (auto it : m_nodes) {
         // write node id
-        start.WriteHtonU64(it.first);
+        it.first.Serialize(start);
         
         // serialize and write ip address
         ns3::Ipv4Address& addr = it.second;
@@ -271,15 +271,15 @@ uint32_t
 KadNodesHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
-    m_targetID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
+    m_targetID.Deserialize(start);
     m_nodeCount = start.ReadNtohU16 ();
     uint8_t tmp_addrBuf[4];
     ns3::Ipv4Address tmp_addr;
-    uint64_t tmp_nodeID;
+    nodeid_t tmp_nodeID;
     for (int i = 0; i < m_nodeCount; ++i) {
         // read node id
-        tmp_nodeID = start.ReadNtohU64();
+        tmp_nodeID.Deserialize(start);
 
         // read serialized ip address
         for (int j = 0; j < 4; ++j) tmp_addrBuf[j] = start.ReadU8(); 
@@ -300,13 +300,13 @@ KadNodesHeader::Print (std::ostream &os) const
 }
 
 void 
-KadNodesHeader::SetSenderId (uint64_t senderID)
+KadNodesHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 KadNodesHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -314,14 +314,14 @@ KadNodesHeader::GetSenderId (void) const
 }
 
 void 
-KadNodesHeader::SetTargetId (uint64_t targetID)
+KadNodesHeader::SetTargetId (const nodeid_t &targetID)
 {
     NS_LOG_FUNCTION(this);
     m_targetID = targetID;
 }
 
 
-uint64_t 
+nodeid_t 
 KadNodesHeader::GetTargetId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -329,7 +329,7 @@ KadNodesHeader::GetTargetId (void) const
 }
 
 void 
-KadNodesHeader::SetNodes (std::unordered_map<uint64_t, ns3::Ipv4Address> nodes)
+KadNodesHeader::SetNodes (std::unordered_map<nodeid_t, ns3::Ipv4Address> nodes)
 {
     NS_LOG_FUNCTION(this);
     m_nodes = nodes;
@@ -337,7 +337,7 @@ KadNodesHeader::SetNodes (std::unordered_map<uint64_t, ns3::Ipv4Address> nodes)
 }
 
 
-std::unordered_map<uint64_t, ns3::Ipv4Address> 
+std::unordered_map<nodeid_t, ns3::Ipv4Address> 
 KadNodesHeader::GetNodes (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -375,13 +375,14 @@ KadChunkHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
+    m_senderID.Serialize(start);
 
     start.WriteHtonU64 (m_blockID);
     start.WriteHtonU16 (m_chunkID);
     start.WriteHtonU64 (m_prevID);
     start.WriteHtonU32 (m_blockSize);
     start.WriteHtonU16 (m_nChunks);
+    start.WriteHtonU16 (m_nSent);
 
     start.WriteHtonU16 (m_height);
 }
@@ -391,13 +392,14 @@ uint32_t
 KadChunkHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
 
     m_blockID = start.ReadNtohU64 ();
     m_chunkID = start.ReadNtohU16 ();
     m_prevID = start.ReadNtohU64 ();
     m_blockSize = start.ReadNtohU32 ();
     m_nChunks = start.ReadNtohU16 ();
+    m_nSent = start.ReadNtohU16 ();
 
     m_height = start.ReadNtohU16 ();
     return KAD_BROADCAST_SIZE; // the number of bytes consumed.
@@ -411,13 +413,13 @@ KadChunkHeader::Print (std::ostream &os) const
 }
 
 void 
-KadChunkHeader::SetSenderId (uint64_t senderID)
+KadChunkHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 KadChunkHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -487,6 +489,20 @@ KadChunkHeader::SetNChunks (uint16_t nChunks)
     m_nChunks = nChunks;
 }
 
+void 
+KadChunkHeader::SetNSent (uint16_t nSent)
+{
+    NS_LOG_FUNCTION(this);
+    m_nSent = nSent;
+}
+
+uint16_t 
+KadChunkHeader::GetNSent (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nSent;
+}
+
 
 uint64_t 
 KadChunkHeader::GetPrevId (void) const
@@ -540,8 +556,14 @@ KadReqHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
+    m_senderID.Serialize(start);
     start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU16 (m_share);
+    start.WriteHtonU16 (m_nShares);
+    start.WriteHtonU16 (m_wordCount);
+    for (auto w : m_chunkBits) {
+        start.WriteHtonU64(w);
+    }
 }
 
 
@@ -549,8 +571,15 @@ uint32_t
 KadReqHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
     m_blockID = start.ReadNtohU64 ();
+    m_share = start.ReadNtohU16 ();
+    m_nShares = start.ReadNtohU16 ();
+    m_wordCount = start.ReadNtohU16 ();
+    m_chunkBits.clear();
+    for (int i = 0; i < m_wordCount; ++i) {
+        m_chunkBits.push_back(start.ReadNtohU64());
+    }
 
     return KAD_REQUEST_SIZE; // the number of bytes consumed.
 }
@@ -559,17 +588,17 @@ KadReqHeader::Deserialize (ns3::Buffer::Iterator start)
 void 
 KadReqHeader::Print (std::ostream &os) const
 {
-    os << "senderID=" << m_senderID << " blockID=" << m_blockID;
+    os << "senderID=" << m_senderID << " blockID=" << m_blockID << " share=" << m_share << "/" << m_nShares;
 }
 
 void 
-KadReqHeader::SetSenderId (uint64_t senderID)
+KadReqHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 KadReqHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -590,4 +619,248 @@ KadReqHeader::GetBlockId (void) const
     return m_blockID;
 }
 
+void 
+KadReqHeader::SetShare (uint16_t share, uint16_t nShares)
+{
+    NS_LOG_FUNCTION(this);
+    m_share = share;
+    m_nShares = nShares;
+}
+
+uint16_t 
+KadReqHeader::GetShare (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_share;
+}
+
+uint16_t 
+KadReqHeader::GetNShares (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nShares;
+}
+
+void 
+KadReqHeader::SetChunkBits (const std::vector<uint64_t> &chunkBits)
+{
+    NS_LOG_FUNCTION(this);
+    m_chunkBits = chunkBits;
+    m_wordCount = chunkBits.size();
+}
+
+std::vector<uint64_t> 
+KadReqHeader::GetChunkBits (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_chunkBits;
+}
+
+
+ns3::TypeId
+KadReportHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("KadReportHeader")
+	.SetParent<Header> ()
+	.AddConstructor<KadReportHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+KadReportHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+KadReportHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return KAD_REPORT_SIZE;
+}
+
+
+void 
+KadReportHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    m_senderID.Serialize(start);
+
+    start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU16 (m_nReceived);
+    start.WriteHtonU16 (m_nSent);
+}
+
+
+uint32_t 
+KadReportHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_senderID.Deserialize(start);
+
+    m_blockID = start.ReadNtohU64 ();
+    m_nReceived = start.ReadNtohU16 ();
+    m_nSent = start.ReadNtohU16 ();
+    return KAD_REPORT_SIZE; // the number of bytes consumed.
+}
+
+
+void 
+KadReportHeader::Print (std::ostream &os) const
+{
+    os << "senderID=" << m_senderID << " blockID=" << m_blockID << " nReceived=" << m_nReceived << " nSent=" << m_nSent;
+}
+
+void 
+KadReportHeader::SetSenderId (const nodeid_t &senderID)
+{
+    NS_LOG_FUNCTION(this);
+    m_senderID = senderID;
+}
+
+nodeid_t 
+KadReportHeader::GetSenderId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_senderID;
+}
+
+void 
+KadReportHeader::SetBlockId (uint64_t blockID)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = blockID;
+}
+
+uint64_t 
+KadReportHeader::GetBlockId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockID;
+}
+
+void 
+KadReportHeader::SetReceived (uint16_t nReceived, uint16_t nSent)
+{
+    NS_LOG_FUNCTION(this);
+    m_nReceived = nReceived;
+    m_nSent = nSent;
+}
+
+uint16_t 
+KadReportHeader::GetNReceived (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nReceived;
+}
+
+uint16_t 
+KadReportHeader::GetNSent (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nSent;
+}
+
+ns3::TypeId
+KadTxHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("KadTxHeader")
+	.SetParent<Header> ()
+	.AddConstructor<KadTxHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+KadTxHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+KadTxHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return KAD_TX_SIZE;
+}
+
+
+void 
+KadTxHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    m_senderID.Serialize(start);
+
+    start.WriteHtonU64 (m_txID);
+    start.WriteHtonU16 (m_height);
+}
+
+
+uint32_t 
+KadTxHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_senderID.Deserialize(start);
+
+    m_txID = start.ReadNtohU64 ();
+    m_height = start.ReadNtohU16 ();
+    return KAD_TX_SIZE; // the number of bytes consumed.
+}
+
+
+void 
+KadTxHeader::Print (std::ostream &os) const
+{
+    os << "senderID=" << m_senderID << " txID=" << m_txID << " height=" << m_height;
+}
+
+void 
+KadTxHeader::SetSenderId (const nodeid_t &senderID)
+{
+    NS_LOG_FUNCTION(this);
+    m_senderID = senderID;
+}
+
+nodeid_t 
+KadTxHeader::GetSenderId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_senderID;
+}
+
+void 
+KadTxHeader::SetTxId (uint64_t txID)
+{
+    NS_LOG_FUNCTION(this);
+    m_txID = txID;
+}
+
+uint64_t 
+KadTxHeader::GetTxId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_txID;
+}
+
+void 
+KadTxHeader::SetHeight (uint16_t height)
+{
+    NS_LOG_FUNCTION(this);
+    m_height = height;
+}
+
+uint16_t 
+KadTxHeader::GetHeight (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_height;
+}
+
 }
@@ -10,15 +10,19 @@
 #include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/random-variable-stream.h"
+#include "node-id.h"
 
 // define field sizes for the headers
 #define LEN_SIZE 4 // length
 #define TYPE_SIZE 1 // type
-#define KAD_PING_SIZE 8 // senderID
-#define KAD_FINDNODE_SIZE 8+8 // senderID + targetID
-#define KAD_NODES_SIZE 8+8+2+(m_nodeCount * (8+4)) // senderID + targetID + nodeCount + 12 byte per node
-#define KAD_BROADCAST_SIZE 8+8+2+8+4+2+2 // senderID+blockID+chunkID+prevID+blockSize+nChunks+height
-#define KAD_REQUEST_SIZE 8+8 // senderID+blockID
+#define KAD_ID_SIZE (BNS_ID_LEN / 8) // node ID
+#define KAD_PING_SIZE KAD_ID_SIZE // senderID
+#define KAD_FINDNODE_SIZE KAD_ID_SIZE+KAD_ID_SIZE // senderID + targetID
+#define KAD_NODES_SIZE KAD_ID_SIZE+KAD_ID_SIZE+2+(m_nodeCount * (KAD_ID_SIZE+4)) // senderID + targetID + nodeCount + ID and address per node
+#define KAD_BROADCAST_SIZE KAD_ID_SIZE+8+2+8+4+2+2+2 // senderID+blockID+chunkID+prevID+blockSize+nChunks+nSent+height
+#define KAD_REQUEST_SIZE KAD_ID_SIZE+8+2+2+2+(m_wordCount * 8) // senderID+blockID+share+nShares+wordCount+8 byte per bitmap word
+#define KAD_REPORT_SIZE KAD_ID_SIZE+8+2+2 // senderID+blockID+nReceived+nSent
+#define KAD_TX_SIZE KAD_ID_SIZE+8+2 // senderID+txID+height, the transaction follows as payload
 
 namespace bns {
 
@@ -30,6 +34,8 @@ enum class KadMsgType
   NODES,        //3
   BROADCAST,    //4
   REQUEST,    //5
+  REPORT,     //6
+  TX,         //7
 };
 
 class KadTypeHeader : public ns3::Header
@@ -58,10 +64,10 @@ class KadPingHeader : public ns3::Header
 		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
 		virtual void Print (std::ostream &os) const;
 
-		void SetSenderId (uint64_t senderID);
-		uint64_t GetSenderId (void) const;
+		void SetSenderId (const nodeid_t &senderID);
+		nodeid_t GetSenderId (void) const;
 	private:
-		uint64_t m_senderID;
+		nodeid_t m_senderID;
 };
 
 class KadFindNodeHeader : public ns3::Header
@@ -74,14 +80,14 @@ class KadFindNodeHeader : public ns3::Header
 		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
 		virtual void Print (std::ostream &os) const;
 
-		void SetSenderId (uint64_t senderID);
-		uint64_t GetSenderId (void) const;
+		void SetSenderId (const nodeid_t &senderID);
+		nodeid_t GetSenderId (void) const;
 
-		void SetTargetId (uint64_t targetID);
-		uint64_t GetTargetId (void) const;
+		void SetTargetId (const nodeid_t &targetID);
+		nodeid_t GetTargetId (void) const;
 	private:
-		uint64_t m_senderID;
-		uint64_t m_targetID;
+		nodeid_t m_senderID;
+		nodeid_t m_targetID;
 };
 
 class KadNodesHeader : public ns3::Header
@@ -94,19 +100,19 @@ class KadNodesHeader : public ns3::Header
 		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
 		virtual void Print (std::ostream &os) const;
 
-		void SetSenderId (uint64_t senderID);
-		uint64_t GetSenderId (void) const;
+		void SetSenderId (const nodeid_t &senderID);
+		nodeid_t GetSenderId (void) const;
 
-		void SetTargetId (uint64_t targetID);
-		uint64_t GetTargetId (void) const;
+		void SetTargetId (const nodeid_t &targetID);
+		nodeid_t GetTargetId (void) const;
 
-		void SetNodes (std::unordered_map<uint64_t, ns3::Ipv4Address> nodes);
-        std::unordered_map<uint64_t, ns3::Ipv4Address> GetNodes (void) const;
+		void SetNodes (std::unordered_map<nodeid_t, ns3::Ipv4Address> nodes);
+        std::unordered_map<nodeid_t, ns3::Ipv4Address> GetNodes (void) const;
 	private:
-		uint64_t m_senderID;
-		uint64_t m_targetID;
+		nodeid_t m_senderID;
+		nodeid_t m_targetID;
         uint16_t m_nodeCount;
-        std::unordered_map<uint64_t, ns3::Ipv4Address> m_nodes;
+        std::unordered_map<nodeid_t, ns3::Ipv4Address> m_nodes;
 
 };
 
@@ -120,8 +126,8 @@ class KadChunkHeader : public ns3::Header
 		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
 		virtual void Print (std::ostream &os) const;
 
-		void SetSenderId (uint64_t senderID);
-		uint64_t GetSenderId (void) const;
+		void SetSenderId (const nodeid_t &senderID);
+		nodeid_t GetSenderId (void) const;
 
 		void SetBlockId (uint64_t blockID);
 		uint64_t GetBlockId (void) const;
@@ -138,16 +144,23 @@ class KadChunkHeader : public ns3::Header
 		void SetNChunks (uint16_t nChunks);
 		uint16_t GetNChunks (void) const;
 
+		/**
+		 * \brief Chunks of the block the sender transmits to this receiver, 0 for repair chunks
+		 */
+		void SetNSent (uint16_t nSent);
+		uint16_t GetNSent (void) const;
+
 		void SetHeight(uint16_t nonce);
 		uint16_t GetHeight (void) const;
 	private:
-		uint64_t m_senderID;
+		nodeid_t m_senderID;
 
 		uint64_t m_blockID;
 		uint16_t m_chunkID;
         uint64_t m_prevID;
         uint32_t m_blockSize;
         uint16_t m_nChunks;
+        uint16_t m_nSent;
 
         uint16_t m_height;
 };
@@ -162,16 +175,90 @@ class KadReqHeader : public ns3::Header
 		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
 		virtual void Print (std::ostream &os) const;
 
-		void SetSenderId (uint64_t senderID);
-		uint64_t GetSenderId (void) const;
+		void SetSenderId (const nodeid_t &senderID);
+		nodeid_t GetSenderId (void) const;
 
 		void SetBlockId (uint64_t blockID);
 		uint64_t GetBlockId (void) const;
 
+		/**
+		 * \brief Which of nShares disjoint parts of the missing chunks the receiver should send
+		 */
+		void SetShare (uint16_t share, uint16_t nShares);
+		uint16_t GetShare (void) const;
+		uint16_t GetNShares (void) const;
+
+		/**
+		 * \brief Bitmap of the chunks the requester already has
+		 */
+		void SetChunkBits (const std::vector<uint64_t> &chunkBits);
+		std::vector<uint64_t> GetChunkBits (void) const;
+
 	private:
-		uint64_t m_senderID;
+		nodeid_t m_senderID;
 
 		uint64_t m_blockID;
+		uint16_t m_share;
+		uint16_t m_nShares;
+		uint16_t m_wordCount;
+		std::vector<uint64_t> m_chunkBits;
+};
+
+class KadReportHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetSenderId (const nodeid_t &senderID);
+		nodeid_t GetSenderId (void) const;
+
+		void SetBlockId (uint64_t blockID);
+		uint64_t GetBlockId (void) const;
+
+		/**
+		 * \brief How many of the nSent chunks the addressed node sent us have arrived
+		 */
+		void SetReceived (uint16_t nReceived, uint16_t nSent);
+		uint16_t GetNReceived (void) const;
+		uint16_t GetNSent (void) const;
+
+	private:
+		nodeid_t m_senderID;
+
+		uint64_t m_blockID;
+		uint16_t m_nReceived;
+		uint16_t m_nSent;
+};
+
+class KadTxHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetSenderId (const nodeid_t &senderID);
+		nodeid_t GetSenderId (void) const;
+
+		void SetTxId (uint64_t txID);
+		uint64_t GetTxId (void) const;
+
+		void SetHeight (uint16_t height);
+		uint16_t GetHeight (void) const;
+
+	private:
+		nodeid_t m_senderID;
+
+		uint64_t m_txID;
+		uint16_t m_height;
 };
 }
 #endif
@@ -15,6 +15,7 @@
 #include "ns3/tcp-socket-factory.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/point-to-point-net-device.h"
+#include "ns3/data-rate.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
 #include "kadcast-node.h"
@@ -32,11 +33,32 @@ uint16_t KadcastNode::kadBeta = 5;
 
 double KadcastNode::kadFecOverhead = 0.25;
 
-KadcastNode::KadcastNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : BitcoinNode(address, isMiner, hashRate), m_sending(false)
+uint32_t KadcastNode::kadStateDepth = 6;
+
+bool KadcastNode::kadProximity = false;
+
+double KadcastNode::kadRefreshInterval = KAD_BUCKET_REFRESH_TIMEOUT;
+
+bool KadcastNode::kadFecAdaptive = false;
+
+ChunkOrder KadcastNode::kadChunkOrder = ChunkOrder::SERIAL;
+
+double KadcastNode::kadCoverageTarget = 0.0;
+
+double KadcastNode::kadFecMin = 0.05;
+
+double KadcastNode::kadFecMax = 0.5;
+
+bool KadcastNode::kadGeoIds = false;
+
+bool KadcastNode::kadTxLowPriority = false;
+
+KadcastNode::KadcastNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : BitcoinNode(address, isMiner, hashRate), m_repairRequestBytes(0), m_fecOverheadSum(0), m_nFecChoices(0), m_fanout(KAD_ID_LEN, KadcastNode::kadBeta), m_usefulChunks(KAD_ID_LEN, 0), m_dupChunks(KAD_ID_LEN, 0), m_missRate(0), m_nSinceAdapt(0), m_sending(false)
 {
     NS_LOG_FUNCTION(this);
     m_nodeID = GenerateNodeID();
-    m_doneBlocks[0] = true;
+    m_blockStates.Get(0).done = true;
+    m_sendQueue.SetTxLowPriority(KadcastNode::kadTxLowPriority);
 }
 
 KadcastNode::~KadcastNode(void)
@@ -57,7 +79,7 @@ void KadcastNode::DoDispose(void)
 // Application Methods
 void KadcastNode::StartApplication() // Called at time specified by Start
 {
-    NS_LOG_INFO("Starting node " << GetNode()->GetId() << ": " << m_address << " / " << EncodeID(m_nodeID));
+    NS_LOG_INFO("Starting node " << GetNode()->GetId() << ": " << m_address << " / " << m_nodeID);
     m_isRunning = true;
     if (!m_socket)
     {
@@ -102,7 +124,7 @@ void KadcastNode::StartApplication() // Called at time specified by Start
     x->SetAttribute("Mean", ns3::DoubleValue(100));
     x->SetAttribute("Variance", ns3::DoubleValue(30));
     ns3::Time refreshTime = ns3::Seconds(x->GetValue());
-    // ns3::Simulator::Schedule (refreshTime, &KadcastNode::PeriodicRefresh, this);
+    m_nextRefresh = ns3::Simulator::Schedule(refreshTime, &KadcastNode::PeriodicRefresh, this);
 
     if (m_isMiner)
     {
@@ -123,29 +145,52 @@ void KadcastNode::StopApplication() // Called at time specified by Stop
         ns3::Simulator::Remove(event);
     }
     m_pendingRefreshes.clear();
+    ns3::Simulator::Cancel(m_nextRefresh);
+
+    // running lookups are lost, they are not recorded
+    for (auto &l : m_nodeLookups)
+    {
+        l.second.Finish(false);
+    }
+    m_nodeLookups.clear();
+
+    ns3::Simulator::Cancel(m_nextSend);
+    m_sendQueue.Clear();
+    m_pendingPings.clear();
+    m_chunkReports.clear();
+
     m_socket->Close();
+    m_socket = 0;
 }
 
 nodeid_t
 KadcastNode::GenerateNodeID()
 {
     NS_LOG_FUNCTION(this);
-    return RandomIDInInterval(pow2(0), pow2(KAD_ID_LEN));
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    return nodeid_t::Random(x);
 }
 
 nodeid_t
-KadcastNode::RandomIDInInterval(uint64_t min, uint64_t max)
+KadcastNode::RandomIDInBucket(uint16_t i)
 {
     NS_LOG_FUNCTION(this);
-    double dmin = static_cast<double>(min);
-    double dmax = static_cast<double>(max);
-
     ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
 
-    // GetValue returns a value in [min, max)
-    uint64_t encoded_id = x->GetValue(dmin, dmax);
+    // the distance to our own ID falls in [2^i, 2^(i+1))
+    return m_nodeID ^ nodeid_t::RandomWithTopBit(x, i);
+}
+
+void KadcastNode::SetRegion(uint16_t region)
+{
+    NS_LOG_FUNCTION(this);
+    assert(region < (1 << KAD_REGION_BITS));
+    if (!KadcastNode::kadGeoIds)
+        return;
 
-    return DecodeID(encoded_id);
+    // nodes of one region share the top bits and fill each other's low buckets,
+    // the high buckets hold the other regions
+    m_nodeID.SetPrefix(region, KAD_REGION_BITS);
 }
 
 ns3::Ipv4Address
@@ -153,6 +198,44 @@ KadcastNode::RandomAddressFromBucket(short i)
 {
     std::vector<bentry_t> &cur_bucket = m_buckets[i];
 
+    if (KadcastNode::kadProximity)
+    {
+        // weight by inverse RTT, unmeasured nodes get the average weight
+        std::vector<double> weights;
+        double known = 0;
+        uint32_t nKnown = 0;
+        for (auto &e : cur_bucket)
+        {
+            auto rit = m_rtts.find(e.second);
+            double w = 0;
+            if (rit != std::end(m_rtts))
+            {
+                w = 1.0 / std::max(rit->second.GetSeconds(), 0.001);
+                known += w;
+                nKnown++;
+            }
+            weights.push_back(w);
+        }
+        double avg = nKnown > 0 ? known / nKnown : 1.0;
+        double total = 0;
+        for (auto &w : weights)
+        {
+            if (w == 0)
+                w = avg;
+            total += w;
+        }
+
+        ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+        double r = x->GetValue(0, total);
+        for (uint32_t j = 0; j < cur_bucket.size(); j++)
+        {
+            if (r < weights[j])
+                return cur_bucket[j].first;
+            r -= weights[j];
+        }
+        return cur_bucket.back().first;
+    }
+
     ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
     x->SetAttribute("Min", ns3::DoubleValue(0));
     x->SetAttribute("Max", ns3::DoubleValue(cur_bucket.size() - 1));
@@ -166,30 +249,18 @@ KadcastNode::RandomAddressFromBucket(short i)
     return it->first;
 }
 
-uint64_t
-KadcastNode::Distance(nodeid_t node1, nodeid_t node2)
+nodeid_t
+KadcastNode::Distance(const nodeid_t &node1, const nodeid_t &node2)
 {
-    NS_LOG_FUNCTION(this);
-    std::bitset<KAD_ID_LEN> bs = node1 ^= node2;
-    return bs.to_ulong();
+    return node1 ^ node2;
 }
 
 uint16_t
 KadcastNode::BucketIndexFromID(nodeid_t node)
 {
     NS_LOG_FUNCTION(this);
-    // take distance from local node
-    uint64_t d = Distance(m_nodeID, node);
-
-    // iterate all possible intervals
-    for (short i = 0; i < KAD_ID_LEN; ++i)
-    {
-        if (d >= pow2(i) && d < pow2(i + 1))
-        {
-            return i;
-        }
-    }
-    return 0;
+    // highest set bit of the distance from the local node
+    return nodeid_t::BucketIndex(m_nodeID, node);
 }
 
 void KadcastNode::UpdateBucket(ns3::Ipv4Address addr, nodeid_t nodeID)
@@ -198,10 +269,13 @@ void KadcastNode::UpdateBucket(ns3::Ipv4Address addr, nodeid_t nodeID)
     if (nodeID == m_nodeID)
         return;
 
-    // delete pending refreshes.
+    m_lastSeen[nodeID] = ns3::Simulator::Now();
+
+    // the node is alive, delete pending refreshes.
     auto rit = FindInRefreshes(nodeID);
     if (rit != std::end(m_pendingRefreshes))
     {
+        ns3::Simulator::Cancel(std::get<0>(rit->second));
         m_pendingRefreshes.erase(rit);
     }
 
@@ -228,15 +302,50 @@ void KadcastNode::UpdateBucket(ns3::Ipv4Address addr, nodeid_t nodeID)
             // 2.1. if fewer than k entries, add it to the end
             //    if (GetNode()->GetId() == 52) NS_LOG_INFO("Just add it to bucket " << i);
             bucket.push_back(std::make_pair(addr, nodeID));
+            if (KadcastNode::kadProximity && m_rtts.count(nodeID) == 0)
+                ProbeNode(addr);
+        }
+        else if (KadcastNode::kadProximity)
+        {
+            // 2.2. proximity neighbor selection: replace the slowest measured node, if the new one is faster
+            auto nrit = m_rtts.find(nodeID);
+            if (nrit == std::end(m_rtts))
+            {
+                // measure first, we'll be back here on PONG
+                ProbeNode(addr);
+                return;
+            }
+
+            auto slowest = std::end(bucket);
+            ns3::Time slowestRtt = nrit->second;
+            for (auto eit = std::begin(bucket); eit != std::end(bucket); ++eit)
+            {
+                auto rit = m_rtts.find(eit->second);
+                if (rit == std::end(m_rtts))
+                {
+                    ProbeNode(eit->first);
+                    continue;
+                }
+                if (rit->second > slowestRtt)
+                {
+                    slowestRtt = rit->second;
+                    slowest = eit;
+                }
+            }
+
+            if (slowest != std::end(bucket))
+            {
+                //NS_LOG_INFO("Replacing " << slowest->first << " (" << slowestRtt << ") by " << addr << " (" << nrit->second << ")");
+                bucket.erase(slowest);
+                bucket.push_back(std::make_pair(addr, nodeID));
+            }
         }
         else
         {
-            // 2.2. else ping least recently seen node
-            //auto old = bucket.front();
-            bucket.erase(bucket.begin());
-            bucket.push_back(std::make_pair(addr, nodeID));
+            // 2.2. else ping least recently seen node, it is replaced if it does not answer
+            auto old = bucket.front();
             //     if (GetNode()->GetId() == 52) NS_LOG_INFO("Checking least recently seen " << i);
-            //RefreshNode(old.first, old.second, addr, nodeID);
+            RefreshNode(old.first, old.second, addr, nodeID);
         }
     }
 
@@ -253,14 +362,18 @@ void KadcastNode::InitBroadcast(Block &b)
 {
     uint16_t startHeight = KAD_ID_LEN;
 
-    m_doneBlocks[b.blockID] = true;
+    BlockState &state = m_blockStates.Get(b.blockID);
+    state.done = true;
 
     //NS_LOG_INFO ("Initializing Broadcast " << b.blockID);
-    if (m_maxSeenHeight.find(b.blockID) == std::end(m_maxSeenHeight))
+    if (!state.heightSet)
     {
-        m_maxSeenHeight[b.blockID] = startHeight;
+        state.maxSeenHeight = startHeight;
+        state.heightSet = true;
     }
     BroadcastBlock(b);
+
+    CollectBlockStates();
 }
 
 void KadcastNode::BroadcastBlock(Block &b)
@@ -274,13 +387,24 @@ void KadcastNode::BroadcastBlock(Block &b)
     //}
     //NS_LOG_INFO ("nNodes total: " << nNodes);
     //}
-    uint16_t height = m_maxSeenHeight[b.blockID];
-    m_maxSeenHeight.erase(b.blockID);
+    BlockState &state = m_blockStates.Get(b.blockID);
+    uint16_t height = state.maxSeenHeight;
+    state.maxSeenHeight = 0;
+    state.heightSet = false;
 
     if (height == 0)
         return;
     //NS_LOG_INFO ("Initializing Broadcast for block " << b.blockID << ". Height: " << height);
 
+    std::vector<std::pair<ns3::Ipv4Address, uint16_t>> dests = PickBroadcastDests(height);
+    SendBlock(dests, b);
+    return;
+}
+
+std::vector<std::pair<ns3::Ipv4Address, uint16_t>>
+KadcastNode::PickBroadcastDests(uint16_t height)
+{
+    std::vector<std::pair<ns3::Ipv4Address, uint16_t>> dests;
     for (uint16_t bIndex = height - 1; bIndex >= 0 && bIndex < KAD_ID_LEN; --bIndex)
     {
         //if (m_buckets[i].size() == 0) NS_LOG_INFO("Bucket " << i << ": empty! (height: " << height << ")");
@@ -288,8 +412,9 @@ void KadcastNode::BroadcastBlock(Block &b)
             continue;
 
         std::vector<ns3::Ipv4Address> nodeAddresses;
-        // Pick KadcastNode::kadBeta nodes
-        uint16_t toQuery = KadcastNode::kadBeta < m_buckets[bIndex].size() ? KadcastNode::kadBeta : m_buckets[bIndex].size();
+        // Pick the fanout of the bucket (KadcastNode::kadBeta or less) nodes
+        uint16_t fanout = GetFanout(bIndex);
+        uint16_t toQuery = fanout < m_buckets[bIndex].size() ? fanout : m_buckets[bIndex].size();
         //if (GetNode()->GetId() == 52) NS_LOG_INFO("Bucket " << i << ": Will query " << toQuery << "/" << m_buckets[i].size() << " nodes.");
         while (toQuery > 0)
         {
@@ -307,17 +432,83 @@ void KadcastNode::BroadcastBlock(Block &b)
 
         for (auto nAddr : nodeAddresses)
         {
-            SendBlock(nAddr, b, bIndex);
+            dests.push_back(std::make_pair(nAddr, bIndex));
         }
     }
 
-    return;
+    return dests;
+}
+
+void KadcastNode::InitTxBroadcast(Tx &tx)
+{
+    BroadcastTx(tx, KAD_ID_LEN);
 }
 
-void KadcastNode::SendBlock(ns3::Ipv4Address &outgoingAddress, Block &b, uint16_t height)
+void KadcastNode::BroadcastTx(Tx &tx, uint16_t height)
+{
+    // a transaction fits into one packet, so it is passed on like a single chunk without FEC
+    for (auto &d : PickBroadcastDests(height))
+    {
+        SendTxMessage(d.first, tx, d.second);
+    }
+}
+
+void KadcastNode::SendBlock(ns3::Ipv4Address &outgoingAddress, Block &b, uint16_t height, TrafficClass cls)
 {
     NS_LOG_INFO("Sending block: " << b.blockID << " to: " << outgoingAddress);
-    std::map<uint16_t, Chunk> chunkMap = Chunkify(b);
+    for (auto &c : PrepareChunks(outgoingAddress, b))
+    {
+        SendChunkMessage(outgoingAddress, c, height, cls);
+    }
+}
+
+void KadcastNode::SendBlock(std::vector<std::pair<ns3::Ipv4Address, uint16_t>> &dests, Block &b)
+{
+    if (KadcastNode::kadChunkOrder == ChunkOrder::SERIAL)
+    {
+        for (auto &d : dests)
+        {
+            SendBlock(d.first, b, d.second);
+        }
+        return;
+    }
+
+    // interleave, so every subtree gets its first chunks early.
+    // Weighted: destinations in higher buckets cover larger subtrees and get a larger share.
+    std::vector<std::vector<Chunk>> chunkLists;
+    std::vector<uint16_t> counts;
+    std::vector<uint32_t> weights;
+    for (auto &d : dests)
+    {
+        chunkLists.push_back(PrepareChunks(d.first, b));
+        counts.push_back(chunkLists.back().size());
+        weights.push_back(KadcastNode::kadChunkOrder == ChunkOrder::WEIGHTED ? d.second + 1 : 1);
+    }
+
+    std::vector<uint16_t> next(dests.size(), 0);
+    for (uint16_t i : InterleaveChunks(counts, weights))
+    {
+        if (next[i] == 0)
+            NS_LOG_INFO("Sending block: " << b.blockID << " to: " << dests[i].first);
+        SendChunkMessage(dests[i].first, chunkLists[i][next[i]++], dests[i].second, TrafficClass::BLOCK);
+    }
+}
+
+std::vector<Chunk>
+KadcastNode::PrepareChunks(ns3::Ipv4Address &outgoingAddress, Block &b)
+{
+    // choose the redundancy by the losses the destination reported
+    double fecOverhead = KadcastNode::kadFecOverhead;
+    if (KadcastNode::kadFecAdaptive)
+        fecOverhead = m_lossEstimates.GetFecOverhead(outgoingAddress, KadcastNode::kadFecOverhead, KadcastNode::kadFecMin, KadcastNode::kadFecMax);
+    m_fecOverheadSum += fecOverhead;
+    m_nFecChoices++;
+
+    std::map<uint16_t, Chunk> chunkMap = Chunkify(b, fecOverhead);
+    for (auto &e : chunkMap)
+    {
+        e.second.nSent = chunkMap.size();
+    }
 
     std::vector<uint16_t> chunksToSend;
     for (uint16_t chunkID = 0; chunkID < chunkMap.size(); chunkID++)
@@ -325,6 +516,7 @@ void KadcastNode::SendBlock(ns3::Ipv4Address &outgoingAddress, Block &b, uint16_
         chunksToSend.push_back(chunkID);
     }
 
+    std::vector<Chunk> chunks;
     while (!chunksToSend.empty())
     {
         ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
@@ -334,11 +526,11 @@ void KadcastNode::SendBlock(ns3::Ipv4Address &outgoingAddress, Block &b, uint16_
         auto it = std::begin(chunksToSend);
         std::advance(it, steps);
 
-        SendChunkMessage(outgoingAddress, chunkMap[*it], height);
+        chunks.push_back(chunkMap[*it]);
 
-        m_seenBroadcasts[b.blockID][*it] = true;
         chunksToSend.erase(it);
     }
+    return chunks;
 }
 
 std::unordered_map<uint16_t, std::vector<bentry_t>>::iterator
@@ -402,14 +594,13 @@ void KadcastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             KadPingHeader ph;
             packet->RemoveHeader(ph);
 
-            uint64_t eSenderID = ph.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = ph.GetSenderId();
 
             // Do not act on messages from self
             if (senderID == m_nodeID)
                 continue;
 
-            //NS_LOG_INFO("Got PING from node: " << eSenderID << " / " << senderAddr);
+            //NS_LOG_INFO("Got PING from node: " << senderID << " / " << senderAddr);
 
             HandlePingMessage(senderAddr, senderID);
             break;
@@ -419,14 +610,13 @@ void KadcastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             KadPingHeader ph;
             packet->RemoveHeader(ph);
 
-            uint64_t eSenderID = ph.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = ph.GetSenderId();
 
             // Do not act on messages from self
             if (senderID == m_nodeID)
                 continue;
 
-            //if (GetNode()->GetId() == 52) NS_LOG_INFO("Got PONG from node: " << eSenderID << " / " << senderAddr);
+            //if (GetNode()->GetId() == 52) NS_LOG_INFO("Got PONG from node: " << senderID << " / " << senderAddr);
             HandlePongMessage(senderAddr, senderID);
 
             break;
@@ -436,17 +626,15 @@ void KadcastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             KadFindNodeHeader fh;
             packet->RemoveHeader(fh);
 
-            uint64_t eSenderID = fh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = fh.GetSenderId();
 
-            uint64_t eTargetID = fh.GetTargetId();
-            nodeid_t targetID = DecodeID(eTargetID);
+            nodeid_t targetID = fh.GetTargetId();
 
             // Do not act on messages from self
             if (senderID == m_nodeID)
                 continue;
 
-            //NS_LOG_INFO("Got FIND_NODE from node " << eSenderID << " / " << senderAddr << ": " << eTargetID);
+            //NS_LOG_INFO("Got FIND_NODE from node " << senderID << " / " << senderAddr << ": " << targetID);
             HandleFindNodeMessage(senderAddr, senderID, targetID);
             break;
         }
@@ -455,19 +643,17 @@ void KadcastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             KadNodesHeader nh;
             packet->RemoveHeader(nh);
 
-            uint64_t eSenderID = nh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = nh.GetSenderId();
 
-            uint64_t eTargetID = nh.GetTargetId();
-            nodeid_t targetID = DecodeID(eTargetID);
+            nodeid_t targetID = nh.GetTargetId();
 
             // Do not act on messages from self
             if (senderID == m_nodeID)
                 continue;
 
-            //NS_LOG_INFO("Got NODES from node: " << eSenderID << " / " << senderAddr);
+            //NS_LOG_INFO("Got NODES from node: " << senderID << " / " << senderAddr);
 
-            std::unordered_map<uint64_t, ns3::Ipv4Address> nodeMap = nh.GetNodes();
+            std::unordered_map<nodeid_t, ns3::Ipv4Address> nodeMap = nh.GetNodes();
             std::vector<bentry_t> nodes;
 
             nodeid_t nID;
@@ -475,7 +661,7 @@ void KadcastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
 
             for (auto it : nodeMap)
             {
-                nID = DecodeID(it.first);
+                nID = it.first;
                 nAddr = it.second;
                 nodes.push_back(std::make_pair(nAddr, nID));
             }
@@ -489,10 +675,9 @@ void KadcastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             KadChunkHeader bh;
             packet->RemoveHeader(bh);
 
-            uint64_t eSenderID = bh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = bh.GetSenderId();
 
-            //NS_LOG_INFO("Got BROADCAST from node: " << eSenderID << " / " << senderAddr);
+            //NS_LOG_INFO("Got BROADCAST from node: " << senderID << " / " << senderAddr);
 
             Chunk c;
             c.blockID = bh.GetBlockId();
@@ -501,6 +686,7 @@ void KadcastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             c.blockSize = bh.GetBlockSize();
             c.chunkSize = packet->GetSize();
             c.nChunks = bh.GetNChunks();
+            c.nSent = bh.GetNSent();
 
             uint16_t height = bh.GetHeight();
 
@@ -512,14 +698,38 @@ void KadcastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             KadReqHeader rh;
             packet->RemoveHeader(rh);
 
-            uint64_t eSenderID = rh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = rh.GetSenderId();
 
-            NS_LOG_INFO("Got REQUEST from node: " << eSenderID << " / " << senderAddr);
+            NS_LOG_INFO("Got REQUEST from node: " << senderID << " / " << senderAddr);
 
             uint64_t blockID = rh.GetBlockId();
+            std::vector<uint64_t> chunkBits = rh.GetChunkBits();
+
+            HandleRequestMessage(senderAddr, senderID, blockID, rh.GetShare(), rh.GetNShares(), chunkBits);
+            break;
+        }
+        case KadMsgType::REPORT:
+        {
+            KadReportHeader rh;
+            packet->RemoveHeader(rh);
+
+            nodeid_t senderID = rh.GetSenderId();
+
+            HandleReportMessage(senderAddr, senderID, rh.GetBlockId(), rh.GetNReceived(), rh.GetNSent());
+            break;
+        }
+        case KadMsgType::TX:
+        {
+            KadTxHeader txh;
+            packet->RemoveHeader(txh);
+
+            Tx tx;
+            tx.txID = txh.GetTxId();
+            tx.txSize = packet->GetSize();
 
-            HandleRequestMessage(senderAddr, senderID, blockID);
+            // a node passes a transaction on in the subtree it got it for, only the first time
+            if (AcceptTx(tx))
+                BroadcastTx(tx, txh.GetHeight());
             break;
         }
         default:
@@ -539,9 +749,12 @@ void KadcastNode::HandleSent(ns3::Ptr<ns3::Socket> socketPtr, uint32_t availByte
 
 void KadcastNode::SendAvailable()
 {
-    if (!m_socket)
+    if (!m_isRunning || !m_socket)
+    {
+        m_sendQueue.Clear(); // we are offline, drop everything
         return;
-    if (m_sendQueue.empty())
+    }
+    if (m_sendQueue.IsEmpty())
         return;
     if (m_sending)
         return;
@@ -550,15 +763,13 @@ void KadcastNode::SendAvailable()
     ns3::Ptr<ns3::PointToPointNetDevice> dev = ns3::DynamicCast<ns3::PointToPointNetDevice>(GetNode()->GetDevice(0));
     ns3::Ptr<ns3::DropTailQueue<ns3::Packet>> queue = ns3::DynamicCast<ns3::DropTailQueue<ns3::Packet>>(dev->GetQueue());
 
-    uint32_t spaceInDevQueue = queue->GetCurrentSize().GetValue() - queue->GetMaxSize().GetValue();
-    uint32_t queueSize = m_sendQueue.size();
-    uint32_t toSend = std::min(queueSize, spaceInDevQueue);
-
-    //NS_LOG_INFO ("Sending " << toSend << " packets");
-    for (uint32_t i = 0; i < toSend; i++)
+    // only keep a small backlog in the device queue, so the scheduler decides what goes out next
+    uint32_t backlog = queue->GetNBytes();
+    while (backlog < KAD_SEND_BACKLOG && !m_sendQueue.IsEmpty())
     {
-        ns3::Ipv4Address nextAddr = m_sendQueue.front().first;
-        ns3::Ptr<ns3::Packet> nextPacket = m_sendQueue.front().second;
+        ns3::Ipv4Address nextAddr;
+        ns3::Ptr<ns3::Packet> nextPacket;
+        m_sendQueue.Dequeue(nextAddr, nextPacket);
         uint32_t nextSize = nextPacket->GetSize();
 
         int sent = m_socket->SendTo(nextPacket, 0, ns3::InetSocketAddress(nextAddr, KAD_PORT));
@@ -566,15 +777,18 @@ void KadcastNode::SendAvailable()
             NS_LOG_WARN("Error sending packet: " << show_errno(m_socket->GetErrno()));
         if (sent != (int32_t)nextSize)
             NS_LOG_WARN("Couldn't send whole packet! Sent " << sent << " / " << nextSize << " bytes.");
-        m_sendQueue.pop_front();
+        backlog = queue->GetNBytes();
     }
 
+    // come back when half of the backlog is on the wire
     ns3::Simulator::Cancel(m_nextSend);
-    ns3::Ptr<ns3::NormalRandomVariable> x = ns3::CreateObject<ns3::NormalRandomVariable>();
-    x->SetAttribute("Mean", ns3::DoubleValue(100));
-    x->SetAttribute("Variance", ns3::DoubleValue(25));
-    ns3::Time sendTime = ns3::MilliSeconds(x->GetValue());
-    m_nextSend = ns3::Simulator::Schedule(sendTime, &KadcastNode::SendAvailable, this);
+    if (!m_sendQueue.IsEmpty())
+    {
+        ns3::DataRateValue rate;
+        dev->GetAttribute("DataRate", rate);
+        ns3::Time sendTime = std::max(rate.Get().CalculateBytesTxTime(backlog / 2), ns3::MicroSeconds(100));
+        m_nextSend = ns3::Simulator::Schedule(sendTime, &KadcastNode::SendAvailable, this);
+    }
 
     m_sending = false;
 }
@@ -590,6 +804,12 @@ void KadcastNode::HandlePingMessage(ns3::Ipv4Address &senderAddr, nodeid_t &send
 void KadcastNode::HandlePongMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
+    auto pit = m_pendingPings.find(senderAddr);
+    if (pit != std::end(m_pendingPings))
+    {
+        UpdateRtt(senderID, ns3::Simulator::Now() - pit->second);
+        m_pendingPings.erase(pit);
+    }
     UpdateBucket(senderAddr, senderID);
     return;
 }
@@ -599,7 +819,7 @@ void KadcastNode::HandleFindNodeMessage(ns3::Ipv4Address &senderAddr, nodeid_t &
     NS_LOG_FUNCTION(this);
     UpdateBucket(senderAddr, senderID);
 
-    std::map<uint64_t, bentry_t> kClosest = FindKClosestNodes(targetID);
+    std::map<nodeid_t, bentry_t> kClosest = FindKClosestNodes(targetID);
 
     std::vector<bentry_t> nodeList;
     for (auto e : kClosest)
@@ -614,11 +834,14 @@ void KadcastNode::HandleFindNodeMessage(ns3::Ipv4Address &senderAddr, nodeid_t &
 void KadcastNode::HandleNodesMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, nodeid_t &targetID, std::vector<bentry_t> &nodes)
 {
     NS_LOG_FUNCTION(this);
-    if (m_nodeLookups.count(targetID) == 0)
+    auto lit = m_nodeLookups.find(targetID);
+    if (lit == std::end(m_nodeLookups))
         return; // we aren't actually looking for this id
-    std::map<uint64_t, std::tuple<ns3::Ipv4Address, nodeid_t, bool>> queryMap = m_nodeLookups[targetID];
+    NodeLookup &lookup = lit->second;
+
+    uint16_t hop = lookup.HandleReply(Distance(senderID, targetID));
 
-    bool queryAll = true; // query all formerly unqueried nodes, if we do not make progress
+    bool progress = false;
     for (bentry_t e : nodes)
     {
         ns3::Ipv4Address nodeAddr = e.first;
@@ -626,36 +849,24 @@ void KadcastNode::HandleNodesMessage(ns3::Ipv4Address &senderAddr, nodeid_t &sen
 
         UpdateBucket(nodeAddr, nodeID);
 
+        if (nodeID == m_nodeID)
+            continue;
+
         if (nodeID == targetID)
         {
-            NS_LOG_INFO("Found node ID: " << EncodeID(targetID));
-            m_nodeLookups.erase(targetID);
+            NS_LOG_INFO("Found node ID: " << targetID);
+            TerminateLookup(targetID, true, hop + 1);
             return;
         }
 
         // 5. Upon receiving NODES msg: if there are closest nodes, update kClosest nodes structure
-
-        uint64_t dist = Distance(nodeID, targetID);
-        if (queryMap.count(dist) == 1)
-            continue; // we actually already know this node
-
-        std::tuple<ns3::Ipv4Address, nodeid_t, bool> nodeEntry(nodeAddr, nodeID, false);
-        queryMap[dist] = nodeEntry;
-
-        if (queryMap.size() > KadcastNode::kadK)
-        {
-            if (queryMap.find(dist) == std::prev(std::end(queryMap)))
-            {
-                // we didn't add to the end => will not be directly removed => progress happened
-                queryAll = false;
-            }
-            // if there are too many entries, remove entries on the end of the map (aka largest entries)
-            queryMap.erase(std::prev(std::end(queryMap)));
-        }
+        nodeid_t dist = Distance(nodeID, targetID);
+        if (lookup.AddCandidate(e, dist, hop + 1))
+            progress = true;
     }
-    m_nodeLookups[targetID] = queryMap;
+    lookup.SetProgress(progress);
 
-    LookupNode(targetID, queryAll);
+    LookupNode(targetID);
 }
 
 void KadcastNode::HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, Chunk c, uint16_t height)
@@ -666,39 +877,74 @@ void KadcastNode::HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &sen
     m_receivedFirstPartBlock = true;
     SetTTFB(c.blockID, ns3::Simulator::Now());
 
-    if (!m_doneBlocks[c.prevID] && !m_blockchain->HasBlock(c.prevID))
+    if (c.nSent > 0)
+        CountReportedChunk(senderAddr, c);
+
+    BlockState *prevState = m_blockStates.Find(c.prevID);
+    if (!(prevState && prevState->done) && !m_blockchain->HasBlock(c.prevID))
     {
-        if (!m_requestedBlocks[c.prevID])
+        // the sender has the whole chain, so it can repair the parent
+        BlockState &missing = m_blockStates.Get(c.prevID);
+        missing.AddHolder(senderAddr, KAD_REPAIR_MAX_HOLDERS);
+        if (!missing.requested)
         {
-            RequestMissingBlock(senderAddr, c.prevID);
-            m_requestedBlocks[c.prevID] = true;
+            missing.requested = true;
+            RepairBlock(c.prevID, 0);
         }
     }
 
-    if (m_seenBroadcasts[c.blockID][c.chunkID])
+    // chunks sent as broadcast (not repair) tell how redundant the fanout is
+    bool fromBroadcast = c.nSent > 0;
+
+    // late chunks of blocks whose state was already collected
+    if (m_blockchain->HasBlock(c.blockID))
+    {
+        if (fromBroadcast)
+            CountFanoutChunk(senderID, false);
         return;
-    m_seenBroadcasts[c.blockID][c.chunkID] = true;
+    }
 
-    if (m_doneBlocks[c.blockID])
+    BlockState &state = m_blockStates.Get(c.blockID);
+    if (state.done)
+    {
+        if (fromBroadcast)
+            CountFanoutChunk(senderID, false);
         return;
+    }
 
-    m_maxSeenHeight[c.blockID] = std::max(height, m_maxSeenHeight[c.blockID]);
+    state.AddHolder(senderAddr, KAD_REPAIR_MAX_HOLDERS);
 
-    std::map<uint16_t, Chunk> &chunkMap = m_receivedChunks[c.blockID];
-    if (chunkMap.count(c.chunkID) == 0)
+    // only count chunks once
+    if (!state.MarkChunk(c.chunkID))
     {
-        // only insert chunks once
-        chunkMap[c.chunkID] = c;
+        if (fromBroadcast)
+            CountFanoutChunk(senderID, false);
+        return;
     }
+    if (fromBroadcast)
+        CountFanoutChunk(senderID, true);
 
-    if (chunkMap.size() >= c.nChunks && !m_doneBlocks[c.blockID])
+    if (!state.requested)
     {
-        m_doneBlocks[c.blockID] = true;
+        // repair the block if it stalls
+        state.requested = true;
+        ns3::Simulator::Schedule(ns3::Seconds(KAD_REPAIR_TIMEOUT), &KadcastNode::RepairBlock, this, c.blockID, state.nReceived);
+    }
+
+    state.maxSeenHeight = std::max(height, state.maxSeenHeight);
+    state.heightSet = true;
+    state.prevID = c.prevID;
+    state.blockSize = c.blockSize;
+    state.nChunks = c.nChunks;
 
-        m_requestedBlocks.erase(c.blockID);
+    if (state.nReceived >= state.nChunks)
+    {
+        state.done = true;
+        state.requested = false;
+        state.ClearChunks();
 
         // we have all chunks
-        Block b = Dechunkify(chunkMap);
+        Block b = Dechunkify(state);
 
         NS_LOG_INFO("Got all Chunks (ID: " << b.blockID << ", prevID: " << b.prevID << ", size: " << b.blockSize << ").");
 
@@ -706,8 +952,11 @@ void KadcastNode::HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &sen
         SetTTLB(c.blockID, ns3::Simulator::Now());
         ns3::Time delay = GetValidationDelay(b);
         ns3::Simulator::Schedule(delay, &KadcastNode::NotifyNewBlock, this, b, false);
-        chunkMap.clear();
-        m_receivedChunks.erase(c.blockID);
+
+        if (KadcastNode::kadCoverageTarget > 0)
+            AdaptFanout(state.nRepairs > 0);
+
+        CollectBlockStates();
     }
     else
     {
@@ -717,17 +966,63 @@ void KadcastNode::HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &sen
     return;
 }
 
-void KadcastNode::HandleRequestMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID)
+void KadcastNode::HandleRequestMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID, uint16_t share, uint16_t nShares, std::vector<uint64_t> &chunkBits)
 {
     if (!m_blockchain->HasBlock(blockID))
     {
-        NS_LOG_WARN("Requested block I do not have. This should never happen!");
+        NS_LOG_INFO("Requested block " << blockID << " I do not have (yet).");
         return;
     }
+    if (nShares == 0 || share >= nShares)
+        return;
+
+    // answer the same requester at most once per repair round
+    auto key = std::make_pair(blockID, senderAddr.Get());
+    auto sit = m_servedRepairs.find(key);
+    if (sit != std::end(m_servedRepairs) && ns3::Simulator::Now() - sit->second < ns3::Seconds(KAD_REPAIR_TIMEOUT))
+        return;
+    m_servedRepairs[key] = ns3::Simulator::Now();
+
     Block b = m_blockchain->GetBlockById(blockID);
-    SendBlock(senderAddr, b, 0);
+    double fecOverhead = KadcastNode::kadFecOverhead;
+    if (KadcastNode::kadFecAdaptive)
+        fecOverhead = m_lossEstimates.GetFecOverhead(senderAddr, KadcastNode::kadFecOverhead, KadcastNode::kadFecMin, KadcastNode::kadFecMax);
+    std::map<uint16_t, Chunk> chunkMap = Chunkify(b, fecOverhead);
+    if (chunkMap.empty())
+        return;
 
-    return;
+    BlockState held = BlockState();
+    held.chunkBits = chunkBits;
+    uint16_t nHeld = 0;
+    for (auto &e : chunkMap)
+    {
+        if (held.HasChunk(e.first))
+            nHeld++;
+    }
+
+    // every asked holder sends its share of what is still needed, from disjoint chunk sets,
+    // with the redundancy a push would carry, so a lost chunk does not cost another round
+    uint16_t nChunks = chunkMap.begin()->second.nChunks;
+    uint16_t needed = nChunks > nHeld ? nChunks - nHeld : 0;
+    uint16_t toSend = std::ceil(needed * (1 + fecOverhead) / nShares);
+
+    NS_LOG_INFO("Repairing block " << blockID << " for " << senderAddr << ": " << toSend << " of " << needed << " missing chunks (share " << share << "/" << nShares << ").");
+    for (auto &e : chunkMap)
+    {
+        if (toSend == 0)
+            break;
+        if (e.first % nShares != share || held.HasChunk(e.first))
+            continue;
+        SendChunkMessage(senderAddr, e.second, 0, TrafficClass::REPAIR);
+        toSend--;
+    }
+}
+
+void KadcastNode::HandleReportMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID, uint16_t nReceived, uint16_t nSent)
+{
+    NS_LOG_FUNCTION(this);
+    m_lossEstimates.AddSample(senderAddr, nSent, nReceived);
+    NS_LOG_INFO("Got REPORT from " << senderAddr << " on block " << blockID << ": " << nReceived << "/" << nSent << " chunks, loss estimate " << m_lossEstimates.GetLoss(senderAddr));
 }
 
 void KadcastNode::SendPingMessage(ns3::Ipv4Address &outgoingAddress)
@@ -739,22 +1034,45 @@ void KadcastNode::SendPingMessage(ns3::Ipv4Address &outgoingAddress)
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-
     KadPingHeader ph;
-    ph.SetSenderId(eSenderID);
+    ph.SetSenderId(m_nodeID);
     packet->AddHeader(ph);
 
     KadTypeHeader th;
     th.SetType(static_cast<uint8_t>(KadMsgType::PING));
     packet->AddHeader(th);
 
+    // keep the first send time, so a late PONG is not mistaken for a fast one
+    auto pit = m_pendingPings.find(outgoingAddress);
+    if (pit == std::end(m_pendingPings) || ns3::Simulator::Now() - pit->second > ns3::Seconds(KAD_PING_TIMEOUT))
+        m_pendingPings[outgoingAddress] = ns3::Simulator::Now();
+
     //NS_LOG_INFO("Sending PING to " << outgoingAddress);
     //m_socket->SendTo (packet, 0, ns3::InetSocketAddress(outgoingAddress, KAD_PORT));
-    m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
+    m_sendQueue.Enqueue(TrafficClass::CONTROL, outgoingAddress, packet);
     SendAvailable();
 }
 
+void KadcastNode::ProbeNode(ns3::Ipv4Address addr)
+{
+    auto pit = m_pendingPings.find(addr);
+    if (pit != std::end(m_pendingPings) && ns3::Simulator::Now() - pit->second <= ns3::Seconds(KAD_PING_TIMEOUT))
+        return;
+    SendPingMessage(addr);
+}
+
+void KadcastNode::UpdateRtt(nodeid_t node, ns3::Time sample)
+{
+    auto rit = m_rtts.find(node);
+    if (rit == std::end(m_rtts))
+    {
+        m_rtts[node] = sample;
+        return;
+    }
+    // smoothed like TCP's SRTT (RFC 6298, alpha = 1/8)
+    rit->second = ns3::Seconds(0.875 * rit->second.GetSeconds() + 0.125 * sample.GetSeconds());
+}
+
 void KadcastNode::SendPongMessage(ns3::Ipv4Address &outgoingAddress)
 {
     NS_LOG_FUNCTION(this);
@@ -764,10 +1082,8 @@ void KadcastNode::SendPongMessage(ns3::Ipv4Address &outgoingAddress)
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-
     KadPingHeader ph;
-    ph.SetSenderId(eSenderID);
+    ph.SetSenderId(m_nodeID);
     packet->AddHeader(ph);
 
     KadTypeHeader th;
@@ -776,7 +1092,7 @@ void KadcastNode::SendPongMessage(ns3::Ipv4Address &outgoingAddress)
 
     //NS_LOG_INFO("Replying PONG to " << outgoingAddress);
     //m_socket->SendTo (packet, 0, ns3::InetSocketAddress(outgoingAddress, KAD_PORT));
-    m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
+    m_sendQueue.Enqueue(TrafficClass::CONTROL, outgoingAddress, packet);
     SendAvailable();
 }
 
@@ -789,12 +1105,9 @@ void KadcastNode::SendFindNodeMessage(ns3::Ipv4Address &outgoingAddress, nodeid_
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-    uint64_t eTargetID = EncodeID(targetID);
-
     KadFindNodeHeader fn_header;
-    fn_header.SetSenderId(eSenderID);
-    fn_header.SetTargetId(eTargetID);
+    fn_header.SetSenderId(m_nodeID);
+    fn_header.SetTargetId(targetID);
     packet->AddHeader(fn_header);
 
     KadTypeHeader th;
@@ -803,7 +1116,7 @@ void KadcastNode::SendFindNodeMessage(ns3::Ipv4Address &outgoingAddress, nodeid_
 
     //NS_LOG_INFO("Sending FIND_NODE to " << outgoingAddress << ": " << packet);
     //m_socket->SendTo (packet, 0, ns3::InetSocketAddress(outgoingAddress, KAD_PORT));
-    m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
+    m_sendQueue.Enqueue(TrafficClass::CONTROL, outgoingAddress, packet);
     SendAvailable();
 }
 
@@ -816,19 +1129,15 @@ void KadcastNode::SendNodesMessage(ns3::Ipv4Address &outgoingAddress, nodeid_t &
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    std::unordered_map<uint64_t, ns3::Ipv4Address> nodeMap;
+    std::unordered_map<nodeid_t, ns3::Ipv4Address> nodeMap;
     for (auto e : nodes)
     {
-        uint64_t eNodeID = EncodeID(e.second);
-        nodeMap[eNodeID] = e.first;
+        nodeMap[e.second] = e.first;
     }
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-    uint64_t eTargetID = EncodeID(targetID);
-
     KadNodesHeader nh;
-    nh.SetSenderId(eSenderID);
-    nh.SetTargetId(eTargetID);
+    nh.SetSenderId(m_nodeID);
+    nh.SetTargetId(targetID);
     nh.SetNodes(nodeMap);
     packet->AddHeader(nh);
 
@@ -838,11 +1147,11 @@ void KadcastNode::SendNodesMessage(ns3::Ipv4Address &outgoingAddress, nodeid_t &
 
     //NS_LOG_INFO("Sending NODES to " << outgoingAddress << ": " << packet);
     //m_socket->SendTo (packet, 0, ns3::InetSocketAddress(outgoingAddress, KAD_PORT));
-    m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
+    m_sendQueue.Enqueue(TrafficClass::CONTROL, outgoingAddress, packet);
     SendAvailable();
 }
 
-void KadcastNode::SendChunkMessage(ns3::Ipv4Address &outgoingAddress, Chunk c, uint16_t height)
+void KadcastNode::SendChunkMessage(ns3::Ipv4Address &outgoingAddress, Chunk c, uint16_t height, TrafficClass cls)
 {
     NS_LOG_FUNCTION(this);
 
@@ -851,15 +1160,14 @@ void KadcastNode::SendChunkMessage(ns3::Ipv4Address &outgoingAddress, Chunk c, u
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(c.chunkSize);
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-
     KadChunkHeader ch;
-    ch.SetSenderId(eSenderID);
+    ch.SetSenderId(m_nodeID);
     ch.SetBlockId(c.blockID);
     ch.SetChunkId(c.chunkID);
     ch.SetPrevId(c.prevID);
     ch.SetBlockSize(c.blockSize);
     ch.SetNChunks(c.nChunks);
+    ch.SetNSent(c.nSent);
     ch.SetHeight(height);
     packet->AddHeader(ch);
 
@@ -870,11 +1178,11 @@ void KadcastNode::SendChunkMessage(ns3::Ipv4Address &outgoingAddress, Chunk c, u
     //int sent = m_socket->SendTo (packet, 0, ns3::InetSocketAddress(outgoingAddress, KAD_PORT));
     //NS_LOG_INFO("Sending BROADCAST to " << outgoingAddress << " sent: " << sent << "/" << packet->GetSize() << ".");
     //if (sent != packet->GetSize()) NS_LOG_INFO("Could not send a complete chunk!");
-    m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
+    m_sendQueue.Enqueue(cls, outgoingAddress, packet, c.blockID);
     SendAvailable();
 }
 
-void KadcastNode::SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID)
+void KadcastNode::SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID, uint16_t share, uint16_t nShares, const std::vector<uint64_t> &chunkBits)
 {
     NS_LOG_FUNCTION(this);
 
@@ -883,100 +1191,121 @@ void KadcastNode::SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-
     KadReqHeader rh;
-    rh.SetSenderId(eSenderID);
+    rh.SetSenderId(m_nodeID);
     rh.SetBlockId(blockID);
+    rh.SetShare(share, nShares);
+    rh.SetChunkBits(chunkBits);
     packet->AddHeader(rh);
 
     KadTypeHeader th;
     th.SetType(static_cast<uint8_t>(KadMsgType::REQUEST));
     packet->AddHeader(th);
 
-    m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
+    m_repairRequestBytes += packet->GetSize();
+
+    m_sendQueue.Enqueue(TrafficClass::CONTROL, outgoingAddress, packet);
+    SendAvailable();
+}
+
+void KadcastNode::SendReportMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID, uint16_t nReceived, uint16_t nSent)
+{
+    NS_LOG_FUNCTION(this);
+
+    if (outgoingAddress == m_address)
+        return; // do not send to self
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+
+    KadReportHeader rh;
+    rh.SetSenderId(m_nodeID);
+    rh.SetBlockId(blockID);
+    rh.SetReceived(nReceived, nSent);
+    packet->AddHeader(rh);
+
+    KadTypeHeader th;
+    th.SetType(static_cast<uint8_t>(KadMsgType::REPORT));
+    packet->AddHeader(th);
+
+    m_sendQueue.Enqueue(TrafficClass::CONTROL, outgoingAddress, packet);
     SendAvailable();
 }
 
 void KadcastNode::InitLookupNode(nodeid_t &targetID)
 {
     NS_LOG_FUNCTION(this);
-    //NS_LOG_INFO("Initializing node lookup: " << EncodeID(targetID));
+    //NS_LOG_INFO("Initializing node lookup: " << targetID);
 
     // 1. Create LookupNode data structure
-    // if already looking up, skip
-    if (m_nodeLookups.count(targetID) == 1)
+    // if offline or already looking up, skip
+    if (!m_isRunning || m_nodeLookups.count(targetID) == 1)
         return;
 
     // 2. Retrieve kClosest nodes, add to data structure with distance
-    std::map<uint64_t, bentry_t> kClosest = FindKClosestNodes(targetID);
-    std::map<uint64_t, std::tuple<ns3::Ipv4Address, nodeid_t, bool>> queryMap;
+    std::map<nodeid_t, bentry_t> kClosest = FindKClosestNodes(targetID);
+    NodeLookup &lookup = m_nodeLookups.emplace(targetID, NodeLookup(targetID, KadcastNode::kadK, KadcastNode::kadAlpha)).first->second;
     for (auto e : kClosest)
     {
-        ns3::Ipv4Address &nodeAddr = e.second.first;
-        nodeid_t &nodeID = e.second.second;
-        std::tuple<ns3::Ipv4Address, nodeid_t, bool> p(nodeAddr, nodeID, false);
-        queryMap[e.first] = p;
+        lookup.AddCandidate(e.second, e.first, 1);
     }
-    m_nodeLookups[targetID] = queryMap;
 
     LookupNode(targetID);
 }
 
-void KadcastNode::LookupNode(nodeid_t &targetID, bool queryAll)
+void KadcastNode::LookupNode(nodeid_t &targetID)
 {
     NS_LOG_FUNCTION(this);
-    if (targetID == m_nodeID)
-        return;
-    if (m_nodeLookups.count(targetID) == 0)
+    auto lit = m_nodeLookups.find(targetID);
+    if (lit == std::end(m_nodeLookups))
         return; // Make sure we do not acidentally create new entries
+    NodeLookup &lookup = lit->second;
 
     // 3. Check in local buckets
-    auto bucket_index = BucketIndexFromID(targetID);
-    std::vector<bentry_t> &bucket = m_buckets[bucket_index];
-
-    for (auto e : bucket)
+    if (targetID != m_nodeID)
     {
-        if (e.second == targetID)
+        auto bucket_index = BucketIndexFromID(targetID);
+        std::vector<bentry_t> &bucket = m_buckets[bucket_index];
+
+        for (auto e : bucket)
         {
-            NS_LOG_INFO("Found node ID in local bucket: " << EncodeID(targetID));
-            TerminateLookup(targetID);
-            return;
+            if (e.second == targetID)
+            {
+                NS_LOG_INFO("Found node ID in local bucket: " << targetID);
+                TerminateLookup(targetID, true, 0);
+                return;
+            }
         }
     }
 
-    std::map<uint64_t, std::tuple<ns3::Ipv4Address, nodeid_t, bool>> queryMap = m_nodeLookups[targetID];
-
-    // 4. Query alpha not-yet-queried closest nodes
-    unsigned int toQuery = KadcastNode::kadAlpha;
-    unsigned int nQueried = 0;
-
-    for (auto e : queryMap)
+    // 4. Query alpha not-yet-queried closest nodes, each with its own timeout
+    for (const nodeid_t &dist : lookup.NextQueries())
     {
-        if (!queryAll && toQuery == 0)
-            break;
-        ns3::Ipv4Address nodeAddr;
-        nodeid_t nodeID;
-        bool queried;
-        std::tie(nodeAddr, nodeID, queried) = e.second;
-
-        if (queried)
-        {
-            nQueried++;
-            continue;
-        }
+        LookupCandidate *c = lookup.GetCandidate(dist);
+        SendFindNodeMessage(c->addr, targetID);
+        c->timeout = ns3::Simulator::Schedule(ns3::Seconds(KAD_LOOKUP_TIMEOUT), &KadcastNode::LookupTimeoutExpired, this, targetID, dist);
+    }
 
-        SendFindNodeMessage(nodeAddr, targetID);
-        MarkQueried(targetID, nodeID);
-        nQueried++;
-        toQuery--;
+    if (lookup.IsConverged())
+    {
+        //NS_LOG_INFO ("Terminating node lookup!");
+        TerminateLookup(targetID);
     }
+}
 
-    if (nQueried < KadcastNode::kadK)
+void KadcastNode::LookupTimeoutExpired(nodeid_t &targetID, nodeid_t dist)
+{
+    NS_LOG_FUNCTION(this);
+    auto lit = m_nodeLookups.find(targetID);
+    if (lit == std::end(m_nodeLookups))
         return;
-    //NS_LOG_INFO ("Terminating node lookup!");
-    // terminate after timeout
-    ns3::Simulator::Schedule(ns3::Seconds(10), &KadcastNode::TerminateLookup, this, targetID);
+
+    // the node did not answer, check if it is still alive
+    LookupCandidate *c = lit->second.GetCandidate(dist);
+    if (c && c->state == RpcState::INFLIGHT)
+        CheckNode(c->addr, c->nodeID);
+
+    lit->second.HandleTimeout(dist);
+    LookupNode(targetID);
 }
 
 void KadcastNode::PeriodicRefresh()
@@ -986,32 +1315,155 @@ void KadcastNode::PeriodicRefresh()
     NS_LOG_INFO("Conducting periodic refresh!");
 
     RefreshBuckets();
+    CheckBuckets();
 
     ns3::Ptr<ns3::NormalRandomVariable> x = ns3::CreateObject<ns3::NormalRandomVariable>();
-    x->SetAttribute("Mean", ns3::DoubleValue(KAD_BUCKET_REFRESH_TIMEOUT));
+    x->SetAttribute("Mean", ns3::DoubleValue(KadcastNode::kadRefreshInterval));
     x->SetAttribute("Variance", ns3::DoubleValue(100));
     ns3::Time refreshTime = ns3::Seconds(x->GetValue());
-    //ns3::Simulator::Schedule (refreshTime, &KadcastNode::PeriodicRefresh, this);
+    m_nextRefresh = ns3::Simulator::Schedule(refreshTime, &KadcastNode::PeriodicRefresh, this);
 }
 
-void KadcastNode::RequestMissingBlock(ns3::Ipv4Address &senderAddr, uint64_t blockID)
+void KadcastNode::RepairBlock(uint64_t blockID, uint16_t lastReceived)
 {
-    if (m_doneBlocks[blockID] || m_blockchain->HasBlock(blockID))
+    BlockState *state = m_blockStates.Find(blockID);
+    if (!state)
+        return; // collected meanwhile
+    if (state->done || m_blockchain->HasBlock(blockID))
     {
         NS_LOG_INFO("Caught up to block: " << blockID);
+        state->requested = false;
         return;
     }
 
-    SendRequestMessage(senderAddr, blockID);
+    if (!m_isRunning || state->nReceived > lastReceived)
+    {
+        // still making progress, check again later
+        ns3::Simulator::Schedule(ns3::Seconds(KAD_REPAIR_TIMEOUT), &KadcastNode::RepairBlock, this, blockID, state->nReceived);
+        return;
+    }
 
-    ns3::Ptr<ns3::NormalRandomVariable> x = ns3::CreateObject<ns3::NormalRandomVariable>();
-    x->SetAttribute("Mean", ns3::DoubleValue(5000));
-    x->SetAttribute("Variance", ns3::DoubleValue(3000));
+    if (state->holders.empty())
+    {
+        NS_LOG_WARN("No peer to repair block " << blockID << " from.");
+        state->requested = false;
+        return;
+    }
+
+    // NACK to several holders, each one sending a disjoint share of the missing chunks.
+    // Retries rotate through the known holders.
+    std::vector<ns3::Ipv4Address> holders = state->holders;
+    std::vector<uint64_t> chunkBits = state->chunkBits;
+    uint16_t nShares = std::min((uint16_t)holders.size(), (uint16_t)KAD_REPAIR_HOLDERS);
+    uint16_t nRepairs = state->nRepairs++;
+    uint16_t nReceived = state->nReceived;
+    for (uint16_t i = 0; i < nShares; i++)
+    {
+        ns3::Ipv4Address holder = holders[(nRepairs * nShares + i) % holders.size()];
+        SendRequestMessage(holder, blockID, i, nShares, chunkBits);
+    }
+
+    // exponential backoff while nothing arrives
+    double backoff = std::min(KAD_REPAIR_TIMEOUT * std::pow(2, nRepairs), KAD_REPAIR_MAX_BACKOFF);
+    ns3::Time nextRepairTime = ns3::Seconds(backoff);
+    ns3::Simulator::Schedule(nextRepairTime, &KadcastNode::RepairBlock, this, blockID, nReceived);
+
+    NS_LOG_INFO("Requesting missing chunks of block " << blockID << " (have " << nReceived << ") from " << nShares << " peers. Next: " << nextRepairTime);
+}
 
-    ns3::Time nextRequestTime = ns3::MilliSeconds(x->GetValue());
-    ns3::Simulator::Schedule(nextRequestTime, &KadcastNode::RequestMissingBlock, this, senderAddr, blockID);
+void KadcastNode::CountReportedChunk(ns3::Ipv4Address &senderAddr, Chunk &c)
+{
+    auto key = std::make_pair(c.blockID, senderAddr.Get());
+    auto rit = m_chunkReports.find(key);
+    if (rit != std::end(m_chunkReports))
+    {
+        rit->second.first++;
+        return;
+    }
+
+    m_chunkReports[key] = std::make_pair(1, c.nSent);
+    ns3::Simulator::Schedule(ns3::Seconds(KAD_REPORT_DELAY), &KadcastNode::ReportLoss, this, senderAddr, c.blockID, 1);
+}
+
+void KadcastNode::ReportLoss(ns3::Ipv4Address addr, uint64_t blockID, uint16_t lastReceived)
+{
+    auto rit = m_chunkReports.find(std::make_pair(blockID, addr.Get()));
+    if (rit == std::end(m_chunkReports))
+        return; // dropped while offline
+
+    uint16_t nReceived = rit->second.first;
+    if (nReceived > lastReceived)
+    {
+        // the sender is still transmitting
+        ns3::Simulator::Schedule(ns3::Seconds(KAD_REPORT_DELAY), &KadcastNode::ReportLoss, this, addr, blockID, nReceived);
+        return;
+    }
+
+    SendReportMessage(addr, blockID, nReceived, rit->second.second);
+    m_chunkReports.erase(rit);
+}
+
+uint16_t
+KadcastNode::GetFanout(uint16_t bIndex)
+{
+    if (KadcastNode::kadCoverageTarget > 0)
+        return m_fanout[bIndex];
+    return KadcastNode::kadBeta;
+}
+
+void KadcastNode::CountFanoutChunk(nodeid_t &senderID, bool useful)
+{
+    uint16_t i = BucketIndexFromID(senderID);
+    if (useful)
+        m_usefulChunks[i]++;
+    else
+        m_dupChunks[i]++;
+}
+
+void KadcastNode::AdaptFanout(bool missed)
+{
+    m_missRate = (1.0 - KAD_FANOUT_EWMA) * m_missRate + KAD_FANOUT_EWMA * (missed ? 1.0 : 0.0);
+    if (++m_nSinceAdapt < KAD_FANOUT_PERIOD)
+        return;
+    m_nSinceAdapt = 0;
+
+    // All nodes run the same loop, so what we receive reflects the fanout we use ourselves.
+    // Blocks that had to be repaired mean too little redundancy: raise all buckets.
+    // Otherwise lower the bucket sending the most duplicates, with some hysteresis.
+    double maxMiss = 1.0 - KadcastNode::kadCoverageTarget;
+    if (m_missRate > maxMiss)
+    {
+        for (auto &f : m_fanout)
+        {
+            f = std::min((uint16_t)(f + 1), KadcastNode::kadBeta);
+        }
+        NS_LOG_INFO("Miss rate " << m_missRate << " above " << maxMiss << ", raising fanout.");
+    }
+    else if (m_missRate < maxMiss / 2)
+    {
+        int worst = -1;
+        double worstRatio = KAD_FANOUT_DUP_MAX;
+        for (uint16_t i = 0; i < KAD_ID_LEN; i++)
+        {
+            uint32_t n = m_usefulChunks[i] + m_dupChunks[i];
+            if (n < KAD_FANOUT_MIN_SAMPLES || m_fanout[i] <= 1)
+                continue;
+            double ratio = (double)m_dupChunks[i] / n;
+            if (ratio > worstRatio)
+            {
+                worst = i;
+                worstRatio = ratio;
+            }
+        }
+        if (worst >= 0)
+        {
+            m_fanout[worst]--;
+            NS_LOG_INFO("Duplicate share " << worstRatio << " from bucket " << worst << ", fanout lowered to " << m_fanout[worst] << ".");
+        }
+    }
 
-    NS_LOG_INFO("Requesting missing block " << blockID << " from " << senderAddr << ". Next: " << nextRequestTime);
+    std::fill(std::begin(m_usefulChunks), std::end(m_usefulChunks), 0);
+    std::fill(std::begin(m_dupChunks), std::end(m_dupChunks), 0);
 }
 
 void KadcastNode::RefreshBuckets()
@@ -1022,10 +1474,8 @@ void KadcastNode::RefreshBuckets()
         auto it = m_activeBuckets.find(i);
         if (it != std::end(m_activeBuckets))
             continue;
-        uint64_t min = pow2(i);
-        uint64_t max = pow2(i + 1);
-        nodeid_t random_id = RandomIDInInterval(min, max);
-        //NS_LOG_INFO("Looking up random node in [" << min << "," << max << "): " << EncodeID(random_id));
+        nodeid_t random_id = RandomIDInBucket(i);
+        //NS_LOG_INFO("Looking up random node in bucket " << i << ": " << random_id);
         InitLookupNode(random_id);
     }
     m_activeBuckets.clear();
@@ -1043,13 +1493,33 @@ void KadcastNode::RefreshNode(ns3::Ipv4Address &oldAddress, nodeid_t oldID, ns3:
 
     SendPingMessage(oldAddress);
 
-    if (newID == m_nodeID)
-        return;
+    // newID == m_nodeID means there is no replacement, the node is just evicted on timeout
     ns3::EventId event = ns3::Simulator::Schedule(ns3::Seconds(KAD_PING_TIMEOUT), &KadcastNode::RefreshTimeoutExpired, this, oldAddress, oldID);
     std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t> eventTuple = std::make_tuple(event, newAddress, newID);
     m_pendingRefreshes[oldID] = eventTuple;
 }
 
+void KadcastNode::CheckNode(ns3::Ipv4Address addr, nodeid_t nodeID)
+{
+    NS_LOG_FUNCTION(this);
+    RefreshNode(addr, nodeID, m_address, m_nodeID);
+}
+
+void KadcastNode::CheckBuckets()
+{
+    NS_LOG_FUNCTION(this);
+    ns3::Time lastRefresh = ns3::Simulator::Now() - ns3::Seconds(KadcastNode::kadRefreshInterval);
+    for (auto &b : m_buckets)
+    {
+        for (auto e : b.second)
+        {
+            auto sit = m_lastSeen.find(e.second);
+            if (sit == std::end(m_lastSeen) || sit->second < lastRefresh)
+                CheckNode(e.first, e.second);
+        }
+    }
+}
+
 void KadcastNode::RefreshTimeoutExpired(ns3::Ipv4Address &addr, nodeid_t nodeID)
 {
     NS_LOG_FUNCTION(this);
@@ -1062,17 +1532,20 @@ void KadcastNode::RefreshTimeoutExpired(ns3::Ipv4Address &addr, nodeid_t nodeID)
     auto nit = FindInBucket(addr, bucket);
     if (nit != std::end(bucket))
     {
+        //NS_LOG_INFO("Evicting unresponsive node " << addr);
         bucket.erase(nit);
     }
+    m_lastSeen.erase(nodeID);
+    m_rtts.erase(nodeID);
 
-    // Retrieve & push new peer
+    // Retrieve & push new peer, if there is room
     auto rit = FindInRefreshes(nodeID);
     if (rit != std::end(m_pendingRefreshes))
     {
         std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t> t = rit->second;
         ns3::Ipv4Address newAddr = std::get<1>(t);
         nodeid_t newID = std::get<2>(t);
-        if (newID != m_nodeID)
+        if (newID != m_nodeID && bucket.size() < KadcastNode::kadK && FindInBucket(newAddr, bucket) == std::end(bucket))
             bucket.push_back(std::make_pair(newAddr, newID));
         m_pendingRefreshes.erase(rit);
     }
@@ -1080,25 +1553,12 @@ void KadcastNode::RefreshTimeoutExpired(ns3::Ipv4Address &addr, nodeid_t nodeID)
     m_buckets[i] = bucket;
 }
 
-uint64_t
-KadcastNode::EncodeID(std::bitset<KAD_ID_LEN> &bs)
-{
-    return bs.to_ullong();
-}
-
-std::bitset<KAD_ID_LEN>
-KadcastNode::DecodeID(uint64_t encoded)
-{
-    std::bitset<KAD_ID_LEN> bs(encoded);
-    return bs;
-}
-
-std::map<uint64_t, bentry_t>
+std::map<nodeid_t, bentry_t>
 KadcastNode::FindKClosestNodes(nodeid_t targetID)
 {
-    std::map<uint64_t, bentry_t> closestNodes;
+    std::map<nodeid_t, bentry_t> closestNodes;
 
-    uint64_t dist;
+    nodeid_t dist;
 
     // Get nodes from the target's bucket
     uint16_t bucket_index = BucketIndexFromID(targetID);
@@ -1124,7 +1584,7 @@ KadcastNode::FindKClosestNodes(nodeid_t targetID)
                 if (closestNodes.count(dist) == 0)
                 {
                     // if we did not already add the entry, calculate distance and insert to map
-                    uint64_t dist = Distance(targetID, e.second);
+                    nodeid_t dist = Distance(targetID, e.second);
                     closestNodes[dist] = e;
                     if (closestNodes.size() > KadcastNode::kadK)
                     {
@@ -1138,30 +1598,6 @@ KadcastNode::FindKClosestNodes(nodeid_t targetID)
     return closestNodes;
 }
 
-void KadcastNode::MarkQueried(nodeid_t &targetID, nodeid_t &nodeID)
-{
-    if (m_nodeLookups.count(targetID) == 0)
-        return; // Make sure we do not acidentally create new entries
-
-    uint64_t dist = Distance(nodeID, targetID);
-    if (m_nodeLookups[targetID].count(dist) == 0)
-        return; // Make sure we do not acidentally add to the k closest nodes
-
-    std::get<2>(m_nodeLookups[targetID][dist]) = true;
-}
-
-bool KadcastNode::IsQueried(nodeid_t &targetID, nodeid_t &nodeID)
-{
-    if (m_nodeLookups.count(targetID) == 0)
-        return false; // Make sure we do not acidentally create new entries
-
-    uint64_t dist = Distance(nodeID, targetID);
-    if (m_nodeLookups[targetID].count(dist) == 0)
-        return false; // Make sure we do not acidentally add to the k closest nodes
-
-    return std::get<2>(m_nodeLookups[targetID][dist]);
-}
-
 void KadcastNode::PrintBuckets()
 {
     for (uint16_t i = 0; i < KAD_ID_LEN; ++i)
@@ -1175,7 +1611,7 @@ void KadcastNode::PrintBuckets()
 }
 
 std::map<uint16_t, Chunk>
-KadcastNode::Chunkify(Block b)
+KadcastNode::Chunkify(Block b, double fecOverhead)
 {
     KadTypeHeader th;
     KadChunkHeader ch;
@@ -1201,6 +1637,7 @@ KadcastNode::Chunkify(Block b)
         assert(c.chunkSize <= packetSize);
 
         c.nChunks = nChunks;
+        c.nSent = 0;
 
         chunks[i] = c;
         toProcess -= c.chunkSize;
@@ -1217,7 +1654,7 @@ KadcastNode::Chunkify(Block b)
     assert(blockSize == b.blockSize);
 
     // add additional chunks to model FEC
-    uint16_t nAdditional = (nChunks * KadcastNode::kadFecOverhead);
+    uint16_t nAdditional = (nChunks * fecOverhead);
     for (unsigned int i = nChunks; i < nChunks + nAdditional; i++)
     {
         Chunk c;
@@ -1230,33 +1667,144 @@ KadcastNode::Chunkify(Block b)
         assert(c.chunkSize <= packetSize);
 
         c.nChunks = nChunks;
+        c.nSent = 0;
 
         chunks[i] = c;
     }
     return chunks;
 }
 
-Block KadcastNode::Dechunkify(std::map<uint16_t, Chunk> chunks)
+Block KadcastNode::Dechunkify(const BlockState &state)
 {
-    assert(chunks.size() > 0);
+    assert(state.blockID != 0);
+    assert(state.nChunks > 0 && state.nChunks <= state.nReceived);
 
-    Chunk firstChunk = std::begin(chunks)->second;
+    Block newBlock = Blockchain::GetNewBlock(state.blockID, state.prevID, state.blockSize);
 
-    assert(firstChunk.blockID != 0);
-    assert(firstChunk.nChunks <= chunks.size());
+    return newBlock;
+}
 
-    uint64_t newBlockID = firstChunk.blockID;
-    uint64_t newPrevID = firstChunk.prevID;
-    uint32_t newBlockSize = firstChunk.blockSize;
-    Block newBlock = Blockchain::GetNewBlock(newBlockID, newPrevID, newBlockSize);
+void KadcastNode::CollectBlockStates()
+{
+    uint32_t topHeight = m_blockchain->GetTopBlockHeight();
+    if (KadcastNode::kadStateDepth == 0 || topHeight <= KadcastNode::kadStateDepth)
+        return;
+    uint32_t maxHeight = topHeight - KadcastNode::kadStateDepth;
+
+    Blockchain *chain = m_blockchain;
+    auto isBuried = [chain, maxHeight](const BlockState &s) {
+        uint32_t h = 0;
+        if (chain->HasBlock(s.blockID))
+            h = chain->GetBlockById(s.blockID).blockHeight;
+        else if (s.nChunks > 0 && chain->HasBlock(s.prevID))
+            h = chain->GetBlockById(s.prevID).blockHeight + 1; // stale partial download
+        return h > 0 && h <= maxHeight;
+    };
+    uint32_t nDropped = m_blockStates.EraseIf(isBuried);
+
+    for (auto sit = std::begin(m_servedRepairs); sit != std::end(m_servedRepairs);)
+    {
+        if (ns3::Simulator::Now() - sit->second > ns3::Seconds(KAD_REPAIR_MAX_BACKOFF))
+            sit = m_servedRepairs.erase(sit);
+        else
+            ++sit;
+    }
 
-    return newBlock;
+    if (nDropped > 0)
+        NS_LOG_INFO("Dropped state of " << nDropped << " blocks below height " << maxHeight << ", " << m_blockStates.Size() << " left.");
 }
 
-void KadcastNode::TerminateLookup(nodeid_t &targetID)
+void KadcastNode::TerminateLookup(nodeid_t &targetID, bool found, uint16_t foundHop)
 {
-    if (m_nodeLookups.count(targetID) == 0)
+    auto lit = m_nodeLookups.find(targetID);
+    if (lit == std::end(m_nodeLookups))
         return;
-    m_nodeLookups.erase(targetID);
+
+    LookupStats stats = lit->second.Finish(found, foundHop);
+    NS_LOG_INFO("Lookup of " << targetID << " done after " << stats.duration.GetMilliSeconds() << " ms, " << stats.hops << " hops, " << stats.nMessages << " messages, " << stats.nTimeouts << " timeouts (found: " << stats.found << ").");
+
+    m_lookupStats.push_back(stats);
+    m_nodeLookups.erase(lit);
+}
+
+std::vector<LookupStats>
+KadcastNode::GetLookupStats()
+{
+    return m_lookupStats;
+}
+
+ns3::Time
+KadcastNode::GetMeanBucketRtt()
+{
+    double total = 0;
+    uint32_t n = 0;
+    for (auto &b : m_buckets)
+    {
+        for (auto &e : b.second)
+        {
+            auto rit = m_rtts.find(e.second);
+            if (rit == std::end(m_rtts))
+                continue;
+            total += rit->second.GetSeconds();
+            n++;
+        }
+    }
+    return ns3::Seconds(n > 0 ? total / n : 0);
+}
+
+void KadcastNode::SendTxMessage(ns3::Ipv4Address &outgoingAddress, Tx &tx, uint16_t height)
+{
+    if (outgoingAddress == m_address)
+        return; // do not send to self
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(tx.txSize);
+
+    KadTxHeader txh;
+    txh.SetSenderId(m_nodeID);
+    txh.SetTxId(tx.txID);
+    txh.SetHeight(height);
+    packet->AddHeader(txh);
+
+    KadTypeHeader th;
+    th.SetType(static_cast<uint8_t>(KadMsgType::TX));
+    packet->AddHeader(th);
+
+    m_sendQueue.Enqueue(TrafficClass::TX, outgoingAddress, packet);
+    SendAvailable();
+}
+
+ns3::Time
+KadcastNode::GetMeanSendDelay(TrafficClass cls)
+{
+    return m_sendQueue.GetMeanDelay(cls);
+}
+
+uint64_t
+KadcastNode::GetRepairTraffic()
+{
+    return m_sendQueue.GetBytes(TrafficClass::REPAIR) + m_repairRequestBytes;
+}
+
+double
+KadcastNode::GetMeanFanout()
+{
+    double total = 0;
+    uint32_t n = 0;
+    for (auto &b : m_buckets)
+    {
+        if (b.second.empty())
+            continue;
+        total += std::min((size_t)GetFanout(b.first), b.second.size());
+        n++;
+    }
+    return n > 0 ? total / n : 0;
+}
+
+double
+KadcastNode::GetMeanFecOverhead()
+{
+    if (m_nFecChoices == 0)
+        return 0.0;
+    return m_fecOverheadSum / m_nFecChoices;
 }
 } // namespace bns
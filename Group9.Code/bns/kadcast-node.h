@@ -6,7 +6,6 @@
 #define KADCAST_NODE_H
 
 #include <algorithm>
-#include <bitset>
 #include <set>
 #include <unordered_map>
 #include <deque>
@@ -21,14 +20,31 @@
 #include "ns3/socket.h"
 
 #include "bitcoin-node.h"
+#include "block-state.h"
+#include "chunk-order.h"
 #include "kadcast-messages.h"
+#include "loss-estimator.h"
+#include "node-lookup.h"
+#include "send-scheduler.h"
 #include "util.h"
 
-#define KAD_ID_LEN 64 // FIXME: Using node ID length of 64 bits for now, since it fits a uint64_t distance variable.
+#define KAD_ID_LEN BNS_ID_LEN
+#define KAD_REGION_BITS 3 // ID prefix bits holding the region with kadGeoIds
 #define KAD_PING_TIMEOUT 10.0
+#define KAD_LOOKUP_TIMEOUT 2.0
 #define KAD_BUCKET_REFRESH_TIMEOUT 3600.0
 #define KAD_PORT 8334
 #define KAD_PACKET_SIZE 1433
+#define KAD_REPAIR_TIMEOUT 2.0       // Seconds without new chunks before a block is repaired
+#define KAD_REPAIR_MAX_BACKOFF 32.0  // Max. seconds between repair rounds
+#define KAD_REPAIR_HOLDERS 3         // Peers asked in parallel for missing chunks
+#define KAD_REPAIR_MAX_HOLDERS 8     // Peers remembered per block to repair from
+#define KAD_SEND_BACKLOG (32 * KAD_PACKET_SIZE) // Bytes we let pile up in the device queue
+#define KAD_REPORT_DELAY 1.0     // Seconds without new chunks from a sender before we report its losses
+#define KAD_FANOUT_PERIOD 4          // Completed blocks between two fanout updates
+#define KAD_FANOUT_EWMA 0.2          // Weight of a completed block in the miss rate
+#define KAD_FANOUT_DUP_MAX 0.5       // Share of duplicate chunks from a bucket above which its fanout is lowered
+#define KAD_FANOUT_MIN_SAMPLES 64    // Chunks from a bucket needed to judge its duplicates
 
 namespace bns {
 
@@ -36,9 +52,6 @@ class Address;
 class Socket;
 class Packet;
 
-typedef std::bitset<64> nodeid_t;
-typedef std::pair<ns3::Ipv4Address, nodeid_t> bentry_t;
-
 struct Chunk
 {
     uint16_t chunkID;
@@ -48,6 +61,7 @@ struct Chunk
     uint16_t chunkSize;
     uint32_t blockHeight;
     uint16_t nChunks;
+    uint16_t nSent; //!< Chunks of the block sent to the receiver, 0 if not to be reported
 };
 
 
@@ -68,6 +82,51 @@ class KadcastNode : public BitcoinNode
         static uint16_t kadAlpha;
         static uint16_t kadBeta;
         static double kadFecOverhead;
+        static uint32_t kadStateDepth;
+        static bool kadProximity;
+        static double kadRefreshInterval;
+        static bool kadFecAdaptive;
+        static ChunkOrder kadChunkOrder;
+        static double kadCoverageTarget;
+        static double kadFecMin;
+        static double kadFecMax;
+        static bool kadGeoIds;
+        static bool kadTxLowPriority; //!< Transactions only use the link while no block chunk waits
+
+        /**
+         * \brief Put the region into the ID prefix if kadGeoIds is set, before the node starts
+         */
+        void SetRegion(uint16_t region);
+
+        /**
+         * \brief Metrics of all finished node lookups
+         */
+        std::vector<LookupStats> GetLookupStats();
+
+        /**
+         * \brief Mean smoothed RTT of the measured bucket entries
+         */
+        ns3::Time GetMeanBucketRtt();
+
+        /**
+         * \brief Mean time packets of a traffic class waited for transmission
+         */
+        ns3::Time GetMeanSendDelay(TrafficClass cls);
+
+        /**
+         * \brief Bytes sent to repair blocks of other nodes or requested for own repairs
+         */
+        uint64_t GetRepairTraffic();
+
+        /**
+         * \brief Mean FEC overhead chosen for the blocks we sent
+         */
+        double GetMeanFecOverhead();
+
+        /**
+         * \brief Mean broadcast fanout over the non-empty buckets
+         */
+        double GetMeanFanout();
 
     protected:
         virtual void DoDispose (void);           // inherited from Application base class.
@@ -82,19 +141,29 @@ class KadcastNode : public BitcoinNode
         nodeid_t GenerateNodeID ();
 
         /**
-         * \brief Generate a random ID in given interval.
+         * \brief Generate a random ID in the i-th bucket of this node
          */
-        nodeid_t RandomIDInInterval (uint64_t min, uint64_t max);
+        nodeid_t RandomIDInBucket (uint16_t i);
 
         /**
-         * \brief Returns a random address from a bucket.
+         * \brief Returns a random address from a bucket, weighted by inverse RTT if kadProximity is set.
          */
         ns3::Ipv4Address RandomAddressFromBucket (short i);
 
+        /**
+         * \brief Update the smoothed RTT estimate of a node
+         */
+        void UpdateRtt (nodeid_t node, ns3::Time sample);
+
+        /**
+         * \brief Ping a node to measure its RTT, unless a ping is already pending
+         */
+        void ProbeNode (ns3::Ipv4Address addr);
+
         /**
          * \brief Calculate the distance between two IDs
          */
-        uint64_t Distance (nodeid_t node1, nodeid_t node2);
+        nodeid_t Distance (const nodeid_t &node1, const nodeid_t &node2);
 
         /**
          * \brief Calculate the appropriate bucket index for a nodeid_t
@@ -142,7 +211,12 @@ class KadcastNode : public BitcoinNode
         /**
          * \brief Handle a received block request message.
          */
-        void HandleRequestMessage(ns3::Ipv4Address &senderAddr, nodeid_t& senderID, uint64_t blockID);
+        void HandleRequestMessage(ns3::Ipv4Address &senderAddr, nodeid_t& senderID, uint64_t blockID, uint16_t share, uint16_t nShares, std::vector<uint64_t> &chunkBits);
+
+        /**
+         * \brief Handle a received loss report on the chunks we sent.
+         */
+        void HandleReportMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID, uint16_t nReceived, uint16_t nSent);
 
         /** 
          * \brief Send a ping message to a node
@@ -167,12 +241,17 @@ class KadcastNode : public BitcoinNode
         /**
          * \brief Send a broadcast message
          */
-        void SendChunkMessage(ns3::Ipv4Address &outgoingAddress, Chunk c, uint16_t height);
+        void SendChunkMessage(ns3::Ipv4Address &outgoingAddress, Chunk c, uint16_t height, TrafficClass cls);
+
+        /**
+         * \brief Send a block request message, NACKing the chunks not in chunkBits
+         */
+        void SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID, uint16_t share, uint16_t nShares, const std::vector<uint64_t> &chunkBits);
 
         /**
-         * \brief Send a block request message
+         * \brief Send a report on how many of the nSent chunks of a block arrived from a node
          */
-        void SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID);
+        void SendReportMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID, uint16_t nReceived, uint16_t nSent);
 
         /**
          * \brief Initializ a node lookup
@@ -182,7 +261,12 @@ class KadcastNode : public BitcoinNode
         /**
          * \brief Lookup a node based on the current state of m_nodeLookups map
          */
-        void LookupNode (nodeid_t &targetID, bool queryAll = false);
+        void LookupNode (nodeid_t &targetID);
+
+        /**
+         * \brief Is called when a find_node RPC of a lookup is expired.
+         */
+        void LookupTimeoutExpired (nodeid_t &targetID, nodeid_t dist);
 
         /**
          * \brief Initialize a broadcast operation
@@ -194,11 +278,38 @@ class KadcastNode : public BitcoinNode
          */
         void BroadcastBlock (Block& b);
 
+        /**
+         * \brief Pick the fanout of every bucket below height as (address, bucket index) destinations
+         */
+        std::vector<std::pair<ns3::Ipv4Address, uint16_t>> PickBroadcastDests (uint16_t height);
+
+        virtual void InitTxBroadcast (Tx& tx);
 
         /**
-         * \brief Actually chunkify and send a block
+         * \brief Broadcast a transaction in the subtree of height
          */
-        void SendBlock (ns3::Ipv4Address &outgoingAddress, Block& b, uint16_t height);
+        void BroadcastTx (Tx& tx, uint16_t height);
+
+        /**
+         * \brief Send a transaction, below block and repair chunks in the send queue
+         */
+        void SendTxMessage (ns3::Ipv4Address &outgoingAddress, Tx& tx, uint16_t height);
+
+
+        /**
+         * \brief Actually chunkify and send a block, as broadcast or repair traffic
+         */
+        void SendBlock (ns3::Ipv4Address &outgoingAddress, Block& b, uint16_t height, TrafficClass cls = TrafficClass::BLOCK);
+
+        /**
+         * \brief Send a block to several (address, height) destinations, interleaving their chunks by kadChunkOrder
+         */
+        void SendBlock (std::vector<std::pair<ns3::Ipv4Address, uint16_t>> &dests, Block& b);
+
+        /**
+         * \brief Chunkify a block with the FEC overhead of a destination, in random transmission order
+         */
+        std::vector<Chunk> PrepareChunks (ns3::Ipv4Address &outgoingAddress, Block& b);
 
         /**
          * \brief Refresh a known node
@@ -211,92 +322,129 @@ class KadcastNode : public BitcoinNode
         void RefreshTimeoutExpired (ns3::Ipv4Address &addr, nodeid_t node);
 
         /**
-         * \brief Periodically refresh buckets (every KAD_BUCKET_REFRESH_TIMEOUT seconds)
+         * \brief Periodically refresh buckets (every kadRefreshInterval seconds)
          */
         void PeriodicRefresh();
 
-        void RequestMissingBlock(ns3::Ipv4Address& senderAddr, uint64_t blockID);
+        /**
+         * \brief Ping a node and evict it from its bucket if it does not answer
+         */
+        void CheckNode(ns3::Ipv4Address addr, nodeid_t nodeID);
 
         /**
-         * \brief Refresh all buckets
+         * \brief Check the liveness of all nodes not seen since the last refresh
          */
-        void RefreshBuckets();
+        void CheckBuckets();
 
         /**
-         * \brief Creates a fresh bucket or returns the existing one.
+         * \brief Request the missing chunks of a block from its holders, unless it made progress since lastReceived
          */
-        std::unordered_map<uint16_t, std::vector<bentry_t>>::iterator InitBucket (uint16_t i, std::unordered_map<uint16_t, std::vector<bentry_t>> &bm);
+        void RepairBlock(uint64_t blockID, uint16_t lastReceived);
 
         /**
-         * \brief Find a node in a bucket
+         * \brief Count a received chunk towards the loss report for its sender
          */
-        std::vector<bentry_t>::iterator FindInBucket (ns3::Ipv4Address &addr, std::vector<bentry_t> &bucket);
+        void CountReportedChunk(ns3::Ipv4Address &senderAddr, Chunk &c);
 
         /**
-         * \brief Find pending node refresh data
+         * \brief Report the losses of a sender, unless more of its chunks arrived since lastReceived
          */
-        std::unordered_map<nodeid_t, std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t> >::iterator FindInRefreshes (nodeid_t nodeID);
+        void ReportLoss(ns3::Ipv4Address addr, uint64_t blockID, uint16_t lastReceived);
 
         /**
-         * \brief Encode a node id for transmission.
+         * \brief Number of nodes of a bucket to broadcast to, kadBeta unless the fanout is adaptive
          */
-        uint64_t EncodeID (std::bitset<KAD_ID_LEN> &bs);
+        uint16_t GetFanout(uint16_t bIndex);
 
         /**
-         * \brief Decode a trasmitted node ID.
+         * \brief Count a broadcast chunk from a sender as useful or duplicate
          */
-        std::bitset<KAD_ID_LEN> DecodeID (uint64_t encoded);
+        void CountFanoutChunk(nodeid_t &senderID, bool useful);
 
         /**
-         * \brief Find the K closest nodes to a given node id
+         * \brief Adapt the per-bucket fanout after a block completed, with or without repair
          */
-        std::map<uint64_t, bentry_t> FindKClosestNodes (nodeid_t targetID);
+        void AdaptFanout(bool missed);
 
         /**
-         * \brief Mark that a node has already been queried for a specified find_node targetID
+         * \brief Drop the reception state of blocks buried kadStateDepth blocks deep
          */
-        void MarkQueried (nodeid_t& targetID, nodeid_t& nodeID);
+        void CollectBlockStates();
 
         /**
-         * \brief Check if a node has already been queried for a targetID
+         * \brief Refresh all buckets
          */
-        bool IsQueried (nodeid_t& targetID, nodeid_t& nodeID);
+        void RefreshBuckets();
 
         /**
-         * \brief Terminate lookup
+         * \brief Creates a fresh bucket or returns the existing one.
          */
-        void TerminateLookup(nodeid_t& targetID);
+        std::unordered_map<uint16_t, std::vector<bentry_t>>::iterator InitBucket (uint16_t i, std::unordered_map<uint16_t, std::vector<bentry_t>> &bm);
+
+        /**
+         * \brief Find a node in a bucket
+         */
+        std::vector<bentry_t>::iterator FindInBucket (ns3::Ipv4Address &addr, std::vector<bentry_t> &bucket);
+
+        /**
+         * \brief Find pending node refresh data
+         */
+        std::unordered_map<nodeid_t, std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t> >::iterator FindInRefreshes (nodeid_t nodeID);
+
+        /**
+         * \brief Find the K closest nodes to a given node id
+         */
+        std::map<nodeid_t, bentry_t> FindKClosestNodes (nodeid_t targetID);
+
+        /**
+         * \brief Terminate lookup and record its metrics
+         */
+        void TerminateLookup(nodeid_t& targetID, bool found = false, uint16_t foundHop = 0);
 
         void PrintBuckets();
 
         /**
          * \brief Create chunks out of blocks.
          */
-        std::map<uint16_t, Chunk> Chunkify (Block b);
+        std::map<uint16_t, Chunk> Chunkify (Block b, double fecOverhead);
 
         /**
-         * \brief Create blocks from chunks.
+         * \brief Create blocks from the reception state of its chunks.
          */
-        Block Dechunkify (std::map<uint16_t, Chunk> chunks);
+        Block Dechunkify (const BlockState &state);
 
         nodeid_t                                             m_nodeID;                         //!< The Kademlia node id of the Kadcast peer.
         std::unordered_map<uint16_t, std::vector<bentry_t>>                                           m_buckets; //!< The k-buckets (one for every 0 =< i =< KAD_ID_LEN)
         std::unordered_map<nodeid_t, std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t> > m_pendingRefreshes; //!< Pending refreshed nodes.
-        std::unordered_map<nodeid_t, std::map<uint64_t, std::tuple<ns3::Ipv4Address, nodeid_t, bool>>> m_nodeLookups; //!< Lists all running node lookups, currently known k closest nodes by distance, and if they were queried
+        std::unordered_map<nodeid_t, NodeLookup> m_nodeLookups; //!< All running node lookups by target
+        std::vector<LookupStats> m_lookupStats;                  //!< Metrics of finished lookups
 
-        std::unordered_map<uint64_t, std::map<uint32_t, bool>> m_seenBroadcasts;
-        std::unordered_map<uint64_t, std::map<uint16_t, Chunk>> m_receivedChunks;
-        std::unordered_map<uint64_t, uint16_t> m_maxSeenHeight;
-        std::unordered_map<uint64_t, bool> m_doneBlocks;
+        BlockStateTable m_blockStates; //!< Per-block chunk bitmap, seen height and done/requested flags
 
-        std::unordered_map<uint64_t, bool> m_requestedBlocks;
+        SendScheduler m_sendQueue; //!< Outgoing packets by traffic class
+        std::map<std::pair<uint64_t, uint32_t>, ns3::Time> m_servedRepairs; //!< Last repair answer by block and requester
+        uint64_t m_repairRequestBytes;
 
-        std::deque<std::pair<ns3::Ipv4Address, ns3::Ptr<ns3::Packet>>> m_sendQueue;
+        LossEstimator m_lossEstimates; //!< Chunk loss towards the nodes we sent blocks to
+        std::map<std::pair<uint64_t, uint32_t>, std::pair<uint16_t, uint16_t>> m_chunkReports; //!< Chunks received and sent, by block and sender
+        double m_fecOverheadSum;
+        uint32_t m_nFecChoices;
+
+        std::vector<uint16_t> m_fanout;       //!< Broadcast fanout per bucket, within [1, kadBeta]
+        std::vector<uint32_t> m_usefulChunks; //!< New broadcast chunks per sender bucket since the last fanout update
+        std::vector<uint32_t> m_dupChunks;    //!< Duplicate broadcast chunks per sender bucket since the last fanout update
+        double m_missRate;                    //!< Smoothed share of blocks that needed a repair
+        uint16_t m_nSinceAdapt;               //!< Completed blocks since the last fanout update
 
         std::set<uint16_t> m_activeBuckets;
 
+        std::unordered_map<nodeid_t, ns3::Time> m_rtts;                                    //!< Smoothed RTT per node
+        std::unordered_map<ns3::Ipv4Address, ns3::Time, ns3::Ipv4AddressHash> m_pendingPings; //!< Send time of unanswered pings
+        std::unordered_map<nodeid_t, ns3::Time> m_lastSeen;                                //!< Last time we heard of a node
+
         bool m_sending;
         ns3::EventId m_nextSend;
+        ns3::EventId m_nextRefresh;
 };
 
 }
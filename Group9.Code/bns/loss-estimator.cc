@@ -0,0 +1,52 @@
+#include <algorithm>
+#include "loss-estimator.h"
+
+namespace bns
+{
+
+LossEstimator::LossEstimator()
+{
+}
+
+void LossEstimator::AddSample(ns3::Ipv4Address addr, uint16_t nSent, uint16_t nReceived)
+{
+    if (nSent == 0)
+        return;
+
+    double sample = 1.0 - std::min(nReceived, nSent) / (double)nSent;
+    auto it = m_loss.find(addr);
+    if (it == std::end(m_loss))
+        m_loss[addr] = sample;
+    else
+        it->second = (1.0 - LOSS_EWMA_WEIGHT) * it->second + LOSS_EWMA_WEIGHT * sample;
+}
+
+bool LossEstimator::HasEstimate(ns3::Ipv4Address addr) const
+{
+    return m_loss.count(addr) == 1;
+}
+
+double
+LossEstimator::GetLoss(ns3::Ipv4Address addr) const
+{
+    auto it = m_loss.find(addr);
+    if (it == std::end(m_loss))
+        return 0.0;
+    return it->second;
+}
+
+double
+LossEstimator::GetFecOverhead(ns3::Ipv4Address addr, double def, double min, double max) const
+{
+    double overhead = def;
+    auto it = m_loss.find(addr);
+    if (it != std::end(m_loss))
+    {
+        // with loss p, n chunks need n * p / (1 - p) additional ones on average
+        double p = it->second;
+        overhead = p < 1.0 ? LOSS_FEC_SAFETY * p / (1.0 - p) : max;
+    }
+    return std::max(min, std::min(overhead, max));
+}
+
+} // namespace bns
@@ -0,0 +1,51 @@
+/**
+ * This file declares the per-peer loss estimator used by the Kadcast and
+ * Mincast nodes to choose their FEC redundancy.
+ */
+
+#ifndef LOSS_ESTIMATOR_H
+#define LOSS_ESTIMATOR_H
+
+#include <unordered_map>
+#include "ns3/ipv4-address.h"
+
+#define LOSS_EWMA_WEIGHT 0.25 // Weight of a new loss sample
+#define LOSS_FEC_SAFETY 1.5   // Additional chunks sent per expected lost chunk
+
+namespace bns
+{
+
+/**
+ * \brief Smoothed chunk loss rate per destination.
+ * Fed by the receiver reports telling how many of the chunks we sent to a
+ * peer actually arrived. The FEC overhead for a peer covers its expected
+ * loss with some safety margin, bounded by the configured minimum and maximum.
+ */
+class LossEstimator
+{
+public:
+    LossEstimator();
+
+    /**
+     * \brief Add a report of nReceived out of nSent chunks arriving at addr.
+     */
+    void AddSample(ns3::Ipv4Address addr, uint16_t nSent, uint16_t nReceived);
+
+    bool HasEstimate(ns3::Ipv4Address addr) const;
+
+    /**
+     * \brief Smoothed loss rate towards addr, 0 if unknown
+     */
+    double GetLoss(ns3::Ipv4Address addr) const;
+
+    /**
+     * \brief FEC overhead for addr within [min, max], def if there was no report yet
+     */
+    double GetFecOverhead(ns3::Ipv4Address addr, double def, double min, double max) const;
+
+private:
+    std::unordered_map<ns3::Ipv4Address, double, ns3::Ipv4AddressHash> m_loss; //!< Smoothed loss rate per destination
+};
+
+} // namespace bns
+#endif /* LOSS_ESTIMATOR_H */
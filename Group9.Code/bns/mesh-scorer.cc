@@ -0,0 +1,103 @@
+#include <algorithm>
+#include "ns3/simulator.h"
+#include "mesh-scorer.h"
+
+#define MESH_SCORE_DECAY 0.9     // Counters kept per new block
+#define MESH_SCORE_FIRST_CAP 10  // Most points for first deliveries
+#define MESH_SCORE_THRESHOLD 1   // Recent blocks a mesh peer should deliver
+#define MESH_SCORE_ACTIVATION 3  // Recent blocks a mesh peer is judged on at least
+
+namespace bns
+{
+
+MeshScorer::MeshScorer(uint32_t nBlocks, ns3::Time window) : m_nBlocks(nBlocks), m_window(window)
+{
+}
+
+void MeshScorer::AddPeer(ns3::Ipv4Address addr)
+{
+    m_peers[addr];
+}
+
+void MeshScorer::RemovePeer(ns3::Ipv4Address addr)
+{
+    m_peers.erase(addr);
+}
+
+void MeshScorer::SetInMesh(ns3::Ipv4Address addr, bool inMesh)
+{
+    auto it = m_peers.find(addr);
+    if (it == std::end(m_peers) || it->second.inMesh == inMesh)
+        return;
+    it->second.inMesh = inMesh;
+    it->second.meshSince = ns3::Simulator::Now();
+}
+
+void MeshScorer::Observe(uint64_t blockID, ns3::Ipv4Address addr, bool first)
+{
+    auto it = m_blocks.find(blockID);
+    if (it == std::end(m_blocks))
+    {
+        it = m_blocks.insert({blockID, {ns3::Simulator::Now(), {}}}).first;
+        m_order.push_back(blockID);
+        if (m_order.size() > m_nBlocks)
+        {
+            m_blocks.erase(m_order.front());
+            m_order.pop_front();
+        }
+        for (auto &p : m_peers)
+        {
+            p.second.firstDeliveries *= MESH_SCORE_DECAY;
+            p.second.penalty *= MESH_SCORE_DECAY;
+        }
+    }
+    if (ns3::Simulator::Now() - it->second.firstSeen <= m_window)
+        it->second.delivered.insert(addr);
+
+    auto pit = m_peers.find(addr);
+    if (first && pit != std::end(m_peers))
+        pit->second.firstDeliveries = std::min<double>(pit->second.firstDeliveries + 1, MESH_SCORE_FIRST_CAP);
+}
+
+void MeshScorer::BrokenPromise(ns3::Ipv4Address addr)
+{
+    auto it = m_peers.find(addr);
+    if (it != std::end(m_peers))
+        it->second.penalty += 1;
+}
+
+double
+MeshScorer::GetScore(ns3::Ipv4Address addr) const
+{
+    auto it = m_peers.find(addr);
+    if (it == std::end(m_peers))
+        return 0;
+    const PeerStats &s = it->second;
+
+    double deficit = 0;
+    if (s.inMesh)
+    {
+        // only blocks whose window is over, a peer in our mesh since then had its chance
+        ns3::Time now = ns3::Simulator::Now();
+        uint32_t nJudged = 0, nDelivered = 0;
+        for (auto &b : m_blocks)
+        {
+            if (b.second.firstSeen < s.meshSince || now - b.second.firstSeen <= m_window)
+                continue;
+            nJudged++;
+            nDelivered += b.second.delivered.count(addr);
+        }
+        if (nJudged >= MESH_SCORE_ACTIVATION && nDelivered < MESH_SCORE_THRESHOLD)
+            deficit = MESH_SCORE_THRESHOLD - nDelivered;
+    }
+    return s.firstDeliveries - deficit * deficit - s.penalty * s.penalty;
+}
+
+void MeshScorer::Clear()
+{
+    m_order.clear();
+    m_blocks.clear();
+    m_peers.clear();
+}
+
+} // namespace bns
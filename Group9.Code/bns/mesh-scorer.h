@@ -0,0 +1,86 @@
+/**
+ * This file declares the gossipsub-style scoring of the peers of a Gossip
+ * node.
+ */
+
+#ifndef MESH_SCORER_H
+#define MESH_SCORER_H
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace bns
+{
+
+/**
+ * \brief Peer scores from first deliveries, mesh delivery deficits and broken IWANT promises.
+ * Only blocks we received count, first copies and duplicates alike, blocks
+ * we mined or sent are no evidence about a peer. Counters decay with every
+ * new block rather than with time, blocks are too rare for per-second
+ * decay. A peer earns one point per block it delivered first, capped. A
+ * mesh peer that sent us fewer than a threshold of the recent blocks first
+ * seen since it joined the mesh, each within the delivery window, loses the
+ * square of the deficit, once enough such blocks are over. A peer loses
+ * the square of its broken promises, IHAVEs it did not answer in time.
+ * Peers with a negative score are pruned from the mesh and get no gossip.
+ */
+class MeshScorer
+{
+public:
+    /**
+     * \param nBlocks Recent blocks the mesh deficit is measured over
+     * \param window Time after we first saw a block in which a copy from a mesh peer counts
+     */
+    MeshScorer(uint32_t nBlocks, ns3::Time window);
+
+    void AddPeer(ns3::Ipv4Address addr);
+
+    void RemovePeer(ns3::Ipv4Address addr);
+
+    /**
+     * \brief addr joined or left our mesh now
+     */
+    void SetInMesh(ns3::Ipv4Address addr, bool inMesh);
+
+    /**
+     * \brief We received blockID from addr
+     * \param first addr gave us the block first
+     */
+    void Observe(uint64_t blockID, ns3::Ipv4Address addr, bool first);
+
+    /**
+     * \brief addr did not answer our IWANT in time
+     */
+    void BrokenPromise(ns3::Ipv4Address addr);
+
+    double GetScore(ns3::Ipv4Address addr) const;
+
+    void Clear();
+
+private:
+    struct PeerStats
+    {
+        bool inMesh = false;
+        ns3::Time meshSince;
+        double firstDeliveries = 0;
+        double penalty = 0;
+    };
+
+    struct BlockObservation
+    {
+        ns3::Time firstSeen;
+        std::set<ns3::Ipv4Address> delivered; //!< Peers that sent it within the window
+    };
+
+    uint32_t m_nBlocks;
+    ns3::Time m_window;
+    std::deque<uint64_t> m_order; //!< Recent blocks, oldest first
+    std::unordered_map<uint64_t, BlockObservation> m_blocks;
+    std::unordered_map<ns3::Ipv4Address, PeerStats, ns3::Ipv4AddressHash> m_peers;
+};
+
+} // namespace bns
+#endif /* MESH_SCORER_H */
@@ -102,7 +102,7 @@ MincastPingHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
+    m_senderID.Serialize(start);
 }
 
 
@@ -110,7 +110,7 @@ uint32_t
 MincastPingHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
     return MINCAST_PING_SIZE; // the number of bytes consumed.
 }
 
@@ -123,14 +123,14 @@ MincastPingHeader::Print (std::ostream &os) const
 }
 
 void 
-MincastPingHeader::SetSenderId (uint64_t senderID)
+MincastPingHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
 
-uint64_t 
+nodeid_t 
 MincastPingHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -168,8 +168,8 @@ MincastFindNodeHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
-    start.WriteHtonU64 (m_targetID);
+    m_senderID.Serialize(start);
+    m_targetID.Serialize(start);
 }
 
 
@@ -177,8 +177,8 @@ uint32_t
 MincastFindNodeHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
-    m_targetID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
+    m_targetID.Deserialize(start);
     return MINCAST_FINDNODE_SIZE; // the number of bytes consumed.
 }
 
@@ -191,13 +191,13 @@ MincastFindNodeHeader::Print (std::ostream &os) const
 }
 
 void 
-MincastFindNodeHeader::SetSenderId (uint64_t senderID)
+MincastFindNodeHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 MincastFindNodeHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -205,14 +205,14 @@ MincastFindNodeHeader::GetSenderId (void) const
 }
 
 void 
-MincastFindNodeHeader::SetTargetId (uint64_t targetID)
+MincastFindNodeHeader::SetTargetId (const nodeid_t &targetID)
 {
     NS_LOG_FUNCTION(this);
     m_targetID = targetID;
 }
 
 
-uint64_t 
+nodeid_t 
 MincastFindNodeHeader::GetTargetId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -250,14 +250,14 @@ MincastNodesHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
-    start.WriteHtonU64 (m_targetID);
+    m_senderID.Serialize(start);
+    m_targetID.Serialize(start);
     start.WriteHtonU16 (m_nodeCount);
 
     uint8_t tmp_addrBuf[4];
     for (auto it : m_nodes) {
         // write node id
-        start.WriteHtonU64(it.first);
+        it.first.Serialize(start);
         
         // serialize and write ip address
         ns3::Ipv4Address& addr = it.second;
@@ -271,15 +271,15 @@ uint32_t
 MincastNodesHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
-    m_targetID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
+    m_targetID.Deserialize(start);
     m_nodeCount = start.ReadNtohU16 ();
     uint8_t tmp_addrBuf[4];
     ns3::Ipv4Address tmp_addr;
-    uint64_t tmp_nodeID;
+    nodeid_t tmp_nodeID;
     for (int i = 0; i < m_nodeCount; ++i) {
         // read node id
-        tmp_nodeID = start.ReadNtohU64();
+        tmp_nodeID.Deserialize(start);
 
         // read serialized ip address
         for (int j = 0; j < 4; ++j) tmp_addrBuf[j] = start.ReadU8(); 
@@ -300,13 +300,13 @@ MincastNodesHeader::Print (std::ostream &os) const
 }
 
 void 
-MincastNodesHeader::SetSenderId (uint64_t senderID)
+MincastNodesHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 MincastNodesHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -314,14 +314,14 @@ MincastNodesHeader::GetSenderId (void) const
 }
 
 void 
-MincastNodesHeader::SetTargetId (uint64_t targetID)
+MincastNodesHeader::SetTargetId (const nodeid_t &targetID)
 {
     NS_LOG_FUNCTION(this);
     m_targetID = targetID;
 }
 
 
-uint64_t 
+nodeid_t 
 MincastNodesHeader::GetTargetId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -329,7 +329,7 @@ MincastNodesHeader::GetTargetId (void) const
 }
 
 void 
-MincastNodesHeader::SetNodes (std::unordered_map<uint64_t, ns3::Ipv4Address> nodes)
+MincastNodesHeader::SetNodes (std::unordered_map<nodeid_t, ns3::Ipv4Address> nodes)
 {
     NS_LOG_FUNCTION(this);
     m_nodes = nodes;
@@ -337,7 +337,7 @@ MincastNodesHeader::SetNodes (std::unordered_map<uint64_t, ns3::Ipv4Address> nod
 }
 
 
-std::unordered_map<uint64_t, ns3::Ipv4Address> 
+std::unordered_map<nodeid_t, ns3::Ipv4Address> 
 MincastNodesHeader::GetNodes (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -375,13 +375,14 @@ MincastChunkHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
+    m_senderID.Serialize(start);
 
     start.WriteHtonU64 (m_blockID);
     start.WriteHtonU16 (m_chunkID);
     start.WriteHtonU64 (m_prevID);
     start.WriteHtonU32 (m_blockSize);
     start.WriteHtonU16 (m_nChunks);
+    start.WriteHtonU16 (m_nSent);
 
     start.WriteHtonU16 (m_height);
 }
@@ -391,13 +392,14 @@ uint32_t
 MincastChunkHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
 
     m_blockID = start.ReadNtohU64 ();
     m_chunkID = start.ReadNtohU16 ();
     m_prevID = start.ReadNtohU64 ();
     m_blockSize = start.ReadNtohU32 ();
     m_nChunks = start.ReadNtohU16 ();
+    m_nSent = start.ReadNtohU16 ();
 
     m_height = start.ReadNtohU16 ();
     return MINCAST_BROADCAST_SIZE; // the number of bytes consumed.
@@ -411,13 +413,13 @@ MincastChunkHeader::Print (std::ostream &os) const
 }
 
 void 
-MincastChunkHeader::SetSenderId (uint64_t senderID)
+MincastChunkHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 MincastChunkHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -487,6 +489,20 @@ MincastChunkHeader::SetNChunks (uint16_t nChunks)
     m_nChunks = nChunks;
 }
 
+void 
+MincastChunkHeader::SetNSent (uint16_t nSent)
+{
+    NS_LOG_FUNCTION(this);
+    m_nSent = nSent;
+}
+
+uint16_t 
+MincastChunkHeader::GetNSent (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nSent;
+}
+
 
 uint64_t 
 MincastChunkHeader::GetPrevId (void) const
@@ -540,8 +556,14 @@ MincastReqHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
+    m_senderID.Serialize(start);
     start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU16 (m_share);
+    start.WriteHtonU16 (m_nShares);
+    start.WriteHtonU16 (m_wordCount);
+    for (auto w : m_chunkBits) {
+        start.WriteHtonU64(w);
+    }
 }
 
 
@@ -549,8 +571,15 @@ uint32_t
 MincastReqHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
     m_blockID = start.ReadNtohU64 ();
+    m_share = start.ReadNtohU16 ();
+    m_nShares = start.ReadNtohU16 ();
+    m_wordCount = start.ReadNtohU16 ();
+    m_chunkBits.clear();
+    for (int i = 0; i < m_wordCount; ++i) {
+        m_chunkBits.push_back(start.ReadNtohU64());
+    }
 
     return MINCAST_REQUEST_SIZE; // the number of bytes consumed.
 }
@@ -559,17 +588,17 @@ MincastReqHeader::Deserialize (ns3::Buffer::Iterator start)
 void 
 MincastReqHeader::Print (std::ostream &os) const
 {
-    os << "senderID=" << m_senderID << " blockID=" << m_blockID;
+    os << "senderID=" << m_senderID << " blockID=" << m_blockID << " share=" << m_share << "/" << m_nShares << " words=" << m_wordCount;
 }
 
 void 
-MincastReqHeader::SetSenderId (uint64_t senderID)
+MincastReqHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 MincastReqHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -590,6 +619,43 @@ MincastReqHeader::GetBlockId (void) const
     return m_blockID;
 }
 
+void 
+MincastReqHeader::SetShare (uint16_t share, uint16_t nShares)
+{
+    NS_LOG_FUNCTION(this);
+    m_share = share;
+    m_nShares = nShares;
+}
+
+uint16_t 
+MincastReqHeader::GetShare (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_share;
+}
+
+uint16_t 
+MincastReqHeader::GetNShares (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nShares;
+}
+
+void 
+MincastReqHeader::SetChunkBits (const std::vector<uint64_t> &chunkBits)
+{
+    NS_LOG_FUNCTION(this);
+    m_chunkBits = chunkBits;
+    m_wordCount = chunkBits.size();
+}
+
+std::vector<uint64_t> 
+MincastReqHeader::GetChunkBits (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_chunkBits;
+}
+
 ns3::TypeId
 MincastInformHeader::GetTypeId (void)
 {
@@ -621,8 +687,10 @@ MincastInformHeader::Serialize (ns3::Buffer::Iterator start) const
 {
     NS_LOG_FUNCTION(this);
     // The data.
-    start.WriteHtonU64 (m_senderID);
-    start.WriteHtonU64 (m_blockID);
+    m_senderID.Serialize(start);
+    start.WriteHtonU16 (m_count);
+    for (uint64_t obj : m_inventory)
+        start.WriteHtonU64 (obj);
 }
 
 
@@ -630,8 +698,11 @@ uint32_t
 MincastInformHeader::Deserialize (ns3::Buffer::Iterator start)
 {
     NS_LOG_FUNCTION(this);
-    m_senderID = start.ReadNtohU64 ();
-    m_blockID = start.ReadNtohU64 ();
+    m_senderID.Deserialize(start);
+    m_count = start.ReadNtohU16 ();
+    m_inventory.clear();
+    for (uint16_t i = 0; i < m_count; i++)
+        m_inventory.push_back(start.ReadNtohU64 ());
 
     return MINCAST_INFORM_SIZE; // the number of bytes consumed.
 }
@@ -640,17 +711,17 @@ MincastInformHeader::Deserialize (ns3::Buffer::Iterator start)
 void 
 MincastInformHeader::Print (std::ostream &os) const
 {
-    os << "senderID=" << m_senderID << " blockID=" << m_blockID;
+    os << "senderID=" << m_senderID << " count=" << m_count;
 }
 
 void 
-MincastInformHeader::SetSenderId (uint64_t senderID)
+MincastInformHeader::SetSenderId (const nodeid_t &senderID)
 {
     NS_LOG_FUNCTION(this);
     m_senderID = senderID;
 }
 
-uint64_t 
+nodeid_t 
 MincastInformHeader::GetSenderId (void) const
 {
     NS_LOG_FUNCTION(this);
@@ -658,16 +729,240 @@ MincastInformHeader::GetSenderId (void) const
 }
 
 void 
-MincastInformHeader::SetBlockId (uint64_t blockID)
+MincastInformHeader::SetInventory (const std::vector<uint64_t> &inventory)
+{
+    NS_LOG_FUNCTION(this);
+    m_inventory = inventory;
+    m_count = inventory.size();
+}
+
+std::vector<uint64_t> 
+MincastInformHeader::GetInventory (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_inventory;
+}
+
+ns3::TypeId
+MincastReportHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("MincastReportHeader")
+	.SetParent<Header> ()
+	.AddConstructor<MincastReportHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+MincastReportHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+MincastReportHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return MINCAST_REPORT_SIZE;
+}
+
+
+void 
+MincastReportHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    m_senderID.Serialize(start);
+
+    start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU16 (m_nReceived);
+    start.WriteHtonU16 (m_nSent);
+    start.WriteHtonU32 (m_goodput);
+}
+
+
+uint32_t 
+MincastReportHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_senderID.Deserialize(start);
+
+    m_blockID = start.ReadNtohU64 ();
+    m_nReceived = start.ReadNtohU16 ();
+    m_nSent = start.ReadNtohU16 ();
+    m_goodput = start.ReadNtohU32 ();
+    return MINCAST_REPORT_SIZE; // the number of bytes consumed.
+}
+
+
+void 
+MincastReportHeader::Print (std::ostream &os) const
+{
+    os << "senderID=" << m_senderID << " blockID=" << m_blockID << " nReceived=" << m_nReceived << " nSent=" << m_nSent << " goodput=" << m_goodput;
+}
+
+void 
+MincastReportHeader::SetSenderId (const nodeid_t &senderID)
+{
+    NS_LOG_FUNCTION(this);
+    m_senderID = senderID;
+}
+
+nodeid_t 
+MincastReportHeader::GetSenderId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_senderID;
+}
+
+void 
+MincastReportHeader::SetBlockId (uint64_t blockID)
 {
     NS_LOG_FUNCTION(this);
     m_blockID = blockID;
 }
 
 uint64_t 
-MincastInformHeader::GetBlockId (void) const
+MincastReportHeader::GetBlockId (void) const
 {
     NS_LOG_FUNCTION(this);
     return m_blockID;
 }
+
+void 
+MincastReportHeader::SetReceived (uint16_t nReceived, uint16_t nSent)
+{
+    NS_LOG_FUNCTION(this);
+    m_nReceived = nReceived;
+    m_nSent = nSent;
+}
+
+uint16_t 
+MincastReportHeader::GetNReceived (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nReceived;
+}
+
+uint16_t 
+MincastReportHeader::GetNSent (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nSent;
+}
+
+void 
+MincastReportHeader::SetGoodput (uint32_t goodput)
+{
+    NS_LOG_FUNCTION(this);
+    m_goodput = goodput;
+}
+
+uint32_t 
+MincastReportHeader::GetGoodput (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_goodput;
+}
+
+ns3::TypeId
+MincastTxHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("MincastTxHeader")
+	.SetParent<Header> ()
+	.AddConstructor<MincastTxHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+MincastTxHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+MincastTxHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return MINCAST_TX_SIZE;
+}
+
+
+void 
+MincastTxHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    m_senderID.Serialize(start);
+
+    start.WriteHtonU64 (m_txID);
+    start.WriteHtonU16 (m_height);
+}
+
+
+uint32_t 
+MincastTxHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_senderID.Deserialize(start);
+
+    m_txID = start.ReadNtohU64 ();
+    m_height = start.ReadNtohU16 ();
+    return MINCAST_TX_SIZE; // the number of bytes consumed.
+}
+
+
+void 
+MincastTxHeader::Print (std::ostream &os) const
+{
+    os << "senderID=" << m_senderID << " txID=" << m_txID << " height=" << m_height;
+}
+
+void 
+MincastTxHeader::SetSenderId (const nodeid_t &senderID)
+{
+    NS_LOG_FUNCTION(this);
+    m_senderID = senderID;
+}
+
+nodeid_t 
+MincastTxHeader::GetSenderId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_senderID;
+}
+
+void 
+MincastTxHeader::SetTxId (uint64_t txID)
+{
+    NS_LOG_FUNCTION(this);
+    m_txID = txID;
+}
+
+uint64_t 
+MincastTxHeader::GetTxId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_txID;
+}
+
+void 
+MincastTxHeader::SetHeight (uint16_t height)
+{
+    NS_LOG_FUNCTION(this);
+    m_height = height;
+}
+
+uint16_t 
+MincastTxHeader::GetHeight (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_height;
+}
+
 }
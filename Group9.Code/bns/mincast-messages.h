@@ -10,16 +10,20 @@
 #include "ns3/boolean.h"
 #include "ns3/log.h"
 #include "ns3/random-variable-stream.h"
+#include "node-id.h"
 
 // define field sizes for the headers
 #define LEN_SIZE 4																						 // length
 #define TYPE_SIZE 1																						 // type
-#define MINCAST_PING_SIZE 8																		 // senderID
-#define MINCAST_FINDNODE_SIZE 8 + 8														 // senderID + targetID
-#define MINCAST_NODES_SIZE 8 + 8 + 2 + (m_nodeCount * (8 + 4)) // senderID + targetID + nodeCount + 12 byte per node
-#define MINCAST_BROADCAST_SIZE 8 + 8 + 2 + 8 + 4 + 2 + 2			 // senderID+blockID+chunkID+prevID+blockSize+nChunks+height
-#define MINCAST_REQUEST_SIZE 8 + 8														 // senderID+blockID
-#define MINCAST_INFORM_SIZE 8 + 8															 // senderID+blockID
+#define MINCAST_ID_SIZE (BNS_ID_LEN / 8)										 // node ID
+#define MINCAST_PING_SIZE MINCAST_ID_SIZE																		 // senderID
+#define MINCAST_FINDNODE_SIZE MINCAST_ID_SIZE + MINCAST_ID_SIZE														 // senderID + targetID
+#define MINCAST_NODES_SIZE MINCAST_ID_SIZE + MINCAST_ID_SIZE + 2 + (m_nodeCount * (MINCAST_ID_SIZE + 4)) // senderID + targetID + nodeCount + ID and address per node
+#define MINCAST_BROADCAST_SIZE MINCAST_ID_SIZE + 8 + 2 + 8 + 4 + 2 + 2 + 2		 // senderID+blockID+chunkID+prevID+blockSize+nChunks+nSent+height
+#define MINCAST_REQUEST_SIZE MINCAST_ID_SIZE + 8 + 2 + 2 + 2 + (m_wordCount * 8)						 // senderID+blockID+share+nShares+wordCount+8 byte per bitmap word
+#define MINCAST_INFORM_SIZE MINCAST_ID_SIZE + 2 + (m_count * 8)												 // senderID+count+8 byte per blockID
+#define MINCAST_REPORT_SIZE MINCAST_ID_SIZE + 8 + 2 + 2 + 4												 // senderID+blockID+nReceived+nSent+goodput
+#define MINCAST_TX_SIZE MINCAST_ID_SIZE + 8 + 2																 // senderID+txID+height, the transaction follows as payload
 namespace bns
 {
 
@@ -32,6 +36,8 @@ enum class MincastMsgType
 	BROADCAST, //4
 	REQUEST,	 //5
 	INFORM,		 //6
+	REPORT,		 //7
+	TX,				 //8
 };
 
 class MincastTypeHeader : public ns3::Header
@@ -61,11 +67,11 @@ public:
 	virtual uint32_t Deserialize(ns3::Buffer::Iterator start);
 	virtual void Print(std::ostream &os) const;
 
-	void SetSenderId(uint64_t senderID);
-	uint64_t GetSenderId(void) const;
+	void SetSenderId(const nodeid_t &senderID);
+	nodeid_t GetSenderId(void) const;
 
 private:
-	uint64_t m_senderID;
+	nodeid_t m_senderID;
 };
 
 class MincastFindNodeHeader : public ns3::Header
@@ -78,15 +84,15 @@ public:
 	virtual uint32_t Deserialize(ns3::Buffer::Iterator start);
 	virtual void Print(std::ostream &os) const;
 
-	void SetSenderId(uint64_t senderID);
-	uint64_t GetSenderId(void) const;
+	void SetSenderId(const nodeid_t &senderID);
+	nodeid_t GetSenderId(void) const;
 
-	void SetTargetId(uint64_t targetID);
-	uint64_t GetTargetId(void) const;
+	void SetTargetId(const nodeid_t &targetID);
+	nodeid_t GetTargetId(void) const;
 
 private:
-	uint64_t m_senderID;
-	uint64_t m_targetID;
+	nodeid_t m_senderID;
+	nodeid_t m_targetID;
 };
 
 class MincastNodesHeader : public ns3::Header
@@ -99,20 +105,20 @@ public:
 	virtual uint32_t Deserialize(ns3::Buffer::Iterator start);
 	virtual void Print(std::ostream &os) const;
 
-	void SetSenderId(uint64_t senderID);
-	uint64_t GetSenderId(void) const;
+	void SetSenderId(const nodeid_t &senderID);
+	nodeid_t GetSenderId(void) const;
 
-	void SetTargetId(uint64_t targetID);
-	uint64_t GetTargetId(void) const;
+	void SetTargetId(const nodeid_t &targetID);
+	nodeid_t GetTargetId(void) const;
 
-	void SetNodes(std::unordered_map<uint64_t, ns3::Ipv4Address> nodes);
-	std::unordered_map<uint64_t, ns3::Ipv4Address> GetNodes(void) const;
+	void SetNodes(std::unordered_map<nodeid_t, ns3::Ipv4Address> nodes);
+	std::unordered_map<nodeid_t, ns3::Ipv4Address> GetNodes(void) const;
 
 private:
-	uint64_t m_senderID;
-	uint64_t m_targetID;
+	nodeid_t m_senderID;
+	nodeid_t m_targetID;
 	uint16_t m_nodeCount;
-	std::unordered_map<uint64_t, ns3::Ipv4Address> m_nodes;
+	std::unordered_map<nodeid_t, ns3::Ipv4Address> m_nodes;
 };
 
 class MincastChunkHeader : public ns3::Header
@@ -125,8 +131,8 @@ public:
 	virtual uint32_t Deserialize(ns3::Buffer::Iterator start);
 	virtual void Print(std::ostream &os) const;
 
-	void SetSenderId(uint64_t senderID);
-	uint64_t GetSenderId(void) const;
+	void SetSenderId(const nodeid_t &senderID);
+	nodeid_t GetSenderId(void) const;
 
 	void SetBlockId(uint64_t blockID);
 	uint64_t GetBlockId(void) const;
@@ -143,17 +149,24 @@ public:
 	void SetNChunks(uint16_t nChunks);
 	uint16_t GetNChunks(void) const;
 
+	/**
+	 * \brief Chunks of the block the sender transmits to this receiver
+	 */
+	void SetNSent(uint16_t nSent);
+	uint16_t GetNSent(void) const;
+
 	void SetHeight(uint16_t nonce);
 	uint16_t GetHeight(void) const;
 
 private:
-	uint64_t m_senderID;
+	nodeid_t m_senderID;
 
 	uint64_t m_blockID;
 	uint16_t m_chunkID;
 	uint64_t m_prevID;
 	uint32_t m_blockSize;
 	uint16_t m_nChunks;
+	uint16_t m_nSent;
 
 	uint16_t m_height;
 };
@@ -168,16 +181,33 @@ public:
 	virtual uint32_t Deserialize(ns3::Buffer::Iterator start);
 	virtual void Print(std::ostream &os) const;
 
-	void SetSenderId(uint64_t senderID);
-	uint64_t GetSenderId(void) const;
+	void SetSenderId(const nodeid_t &senderID);
+	nodeid_t GetSenderId(void) const;
 
 	void SetBlockId(uint64_t blockID);
 	uint64_t GetBlockId(void) const;
 
+	/**
+	 * \brief Which of nShares disjoint stripes of the missing chunks the receiver should send
+	 */
+	void SetShare(uint16_t share, uint16_t nShares);
+	uint16_t GetShare(void) const;
+	uint16_t GetNShares(void) const;
+
+	/**
+	 * \brief Bitmap of the chunks the requester already has
+	 */
+	void SetChunkBits(const std::vector<uint64_t> &chunkBits);
+	std::vector<uint64_t> GetChunkBits(void) const;
+
 private:
-	uint64_t m_senderID;
+	nodeid_t m_senderID;
 
 	uint64_t m_blockID;
+	uint16_t m_share;
+	uint16_t m_nShares;
+	uint16_t m_wordCount;
+	std::vector<uint64_t> m_chunkBits;
 };
 
 class MincastInformHeader : public ns3::Header
@@ -190,16 +220,81 @@ public:
 	virtual uint32_t Deserialize(ns3::Buffer::Iterator start);
 	virtual void Print(std::ostream &os) const;
 
-	void SetSenderId(uint64_t senderID);
-	uint64_t GetSenderId(void) const;
+	void SetSenderId(const nodeid_t &senderID);
+	nodeid_t GetSenderId(void) const;
+
+	void SetInventory(const std::vector<uint64_t> &inventory);
+	std::vector<uint64_t> GetInventory(void) const;
+
+private:
+	nodeid_t m_senderID;
+
+	uint16_t m_count;
+	std::vector<uint64_t> m_inventory;
+};
+
+class MincastReportHeader : public ns3::Header
+{
+public:
+	static ns3::TypeId GetTypeId(void);
+	virtual ns3::TypeId GetInstanceTypeId(void) const;
+	virtual uint32_t GetSerializedSize(void) const;
+	virtual void Serialize(ns3::Buffer::Iterator start) const;
+	virtual uint32_t Deserialize(ns3::Buffer::Iterator start);
+	virtual void Print(std::ostream &os) const;
+
+	void SetSenderId(const nodeid_t &senderID);
+	nodeid_t GetSenderId(void) const;
 
 	void SetBlockId(uint64_t blockID);
 	uint64_t GetBlockId(void) const;
 
+	/**
+	 * \brief How many of the nSent chunks the addressed node sent us have arrived
+	 */
+	void SetReceived(uint16_t nReceived, uint16_t nSent);
+	uint16_t GetNReceived(void) const;
+	uint16_t GetNSent(void) const;
+
+	/**
+	 * \brief Bytes per second the chunks arrived with, 0 if unknown
+	 */
+	void SetGoodput(uint32_t goodput);
+	uint32_t GetGoodput(void) const;
+
 private:
-	uint64_t m_senderID;
+	nodeid_t m_senderID;
 
 	uint64_t m_blockID;
+	uint16_t m_nReceived;
+	uint16_t m_nSent;
+	uint32_t m_goodput;
+};
+
+class MincastTxHeader : public ns3::Header
+{
+public:
+	static ns3::TypeId GetTypeId(void);
+	virtual ns3::TypeId GetInstanceTypeId(void) const;
+	virtual uint32_t GetSerializedSize(void) const;
+	virtual void Serialize(ns3::Buffer::Iterator start) const;
+	virtual uint32_t Deserialize(ns3::Buffer::Iterator start);
+	virtual void Print(std::ostream &os) const;
+
+	void SetSenderId(const nodeid_t &senderID);
+	nodeid_t GetSenderId(void) const;
+
+	void SetTxId(uint64_t txID);
+	uint64_t GetTxId(void) const;
+
+	void SetHeight(uint16_t height);
+	uint16_t GetHeight(void) const;
+
+private:
+	nodeid_t m_senderID;
+
+	uint64_t m_txID;
+	uint16_t m_height;
 };
 } // namespace bns
 #endif
@@ -32,15 +32,31 @@ uint16_t MincastNode::kadBeta = 5;
 
 double MincastNode::kadFecOverhead = 0.25;
 
+uint32_t MincastNode::kadStateDepth = 6;
+
+double MincastNode::kadRefreshInterval = MINCAST_BUCKET_REFRESH_TIMEOUT;
+
+bool MincastNode::kadFecAdaptive = false;
+
+ChunkOrder MincastNode::kadChunkOrder = ChunkOrder::SERIAL;
+
+double MincastNode::kadFecMin = 0.05;
+
+double MincastNode::kadFecMax = 0.5;
+
 bool MincastNode::mincastUseScores = false;
 
+double MincastNode::announceDelay = 0.0;
+
+uint16_t MincastNode::announceBatch = 16;
+
 //int MincastNode::mincastScores = -1;
 
-MincastNode::MincastNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : BitcoinNode(address, isMiner, hashRate), m_sending(false)
+MincastNode::MincastNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : BitcoinNode(address, isMiner, hashRate), m_fecOverheadSum(0), m_nFecChoices(0), m_nPushed(0), m_nInformed(0), m_sending(false)
 {
     NS_LOG_FUNCTION(this);
     m_nodeID = GenerateNodeID();
-    m_doneBlocks[0] = true;
+    m_blockStates.Get(0).done = true;
 }
 
 MincastNode::~MincastNode(void)
@@ -61,7 +77,7 @@ void MincastNode::DoDispose(void)
 // Application Methods
 void MincastNode::StartApplication() // Called at time specified by Start
 {
-    NS_LOG_INFO("Starting node " << GetNode()->GetId() << ": " << m_address << " / " << EncodeID(m_nodeID) << " / mincastUseScores: " << std::boolalpha << mincastUseScores);
+    NS_LOG_INFO("Starting node " << GetNode()->GetId() << ": " << m_address << " / " << m_nodeID << " / mincastUseScores: " << std::boolalpha << mincastUseScores);
     m_isRunning = true;
     if (!m_socket)
     {
@@ -118,7 +134,7 @@ void MincastNode::StartApplication() // Called at time specified by Start
     {
         refreshTime = ns3::Seconds(x->GetValue());
     }
-    // ns3::Simulator::Schedule(refreshTime, &MincastNode::PeriodicRefresh, this);
+    m_nextRefresh = ns3::Simulator::Schedule(refreshTime, &MincastNode::PeriodicRefresh, this);
 
     if (m_isMiner)
     {
@@ -139,29 +155,43 @@ void MincastNode::StopApplication() // Called at time specified by Stop
         ns3::Simulator::Remove(event);
     }
     m_pendingRefreshes.clear();
+    ns3::Simulator::Cancel(m_nextRefresh);
+
+    // running lookups are lost, they are not recorded
+    for (auto &l : m_nodeLookups)
+    {
+        l.second.Finish(false);
+    }
+    m_nodeLookups.clear();
+
+    ns3::Simulator::Cancel(m_nextSend);
+    m_sendQueue.clear();
+    m_chunkReports.clear();
+    m_pendingPings.clear();
+    m_pendingInforms.clear();
+    m_pulls.clear();
+    m_informBatches.Clear();
+
     m_socket->Close();
+    m_socket = 0;
 }
 
 nodeid_t
 MincastNode::GenerateNodeID()
 {
     NS_LOG_FUNCTION(this);
-    return RandomIDInInterval(pow2(0), pow2(MINCAST_ID_LEN));
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    return nodeid_t::Random(x);
 }
 
 nodeid_t
-MincastNode::RandomIDInInterval(uint64_t min, uint64_t max)
+MincastNode::RandomIDInBucket(uint16_t i)
 {
     NS_LOG_FUNCTION(this);
-    double dmin = static_cast<double>(min);
-    double dmax = static_cast<double>(max);
-
     ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
 
-    // GetValue returns a value in [min, max)
-    uint64_t encoded_id = x->GetValue(dmin, dmax);
-
-    return DecodeID(encoded_id);
+    // the distance to our own ID falls in [2^i, 2^(i+1))
+    return m_nodeID ^ nodeid_t::RandomWithTopBit(x, i);
 }
 
 ns3::Ipv4Address
@@ -182,30 +212,18 @@ MincastNode::RandomAddressFromBucket(short i)
     return it->first;
 }
 
-uint64_t
-MincastNode::Distance(nodeid_t node1, nodeid_t node2)
+nodeid_t
+MincastNode::Distance(const nodeid_t &node1, const nodeid_t &node2)
 {
-    NS_LOG_FUNCTION(this);
-    std::bitset<MINCAST_ID_LEN> bs = node1 ^= node2;
-    return bs.to_ulong();
+    return node1 ^ node2;
 }
 
 uint16_t
 MincastNode::BucketIndexFromID(nodeid_t node)
 {
     NS_LOG_FUNCTION(this);
-    // take distance from local node
-    uint64_t d = Distance(m_nodeID, node);
-
-    // iterate all possible intervals
-    for (short i = 0; i < MINCAST_ID_LEN; ++i)
-    {
-        if (d >= pow2(i) && d < pow2(i + 1))
-        {
-            return i;
-        }
-    }
-    return 0;
+    // highest set bit of the distance from the local node
+    return nodeid_t::BucketIndex(m_nodeID, node);
 }
 
 void MincastNode::UpdateBucket(ns3::Ipv4Address addr, nodeid_t nodeID)
@@ -214,10 +232,13 @@ void MincastNode::UpdateBucket(ns3::Ipv4Address addr, nodeid_t nodeID)
     if (nodeID == m_nodeID)
         return;
 
-    // delete pending refreshes.
+    m_lastSeen[nodeID] = ns3::Simulator::Now();
+
+    // the node is alive, delete pending refreshes.
     auto rit = FindInRefreshes(nodeID);
     if (rit != std::end(m_pendingRefreshes))
     {
+        ns3::Simulator::Cancel(std::get<0>(rit->second));
         m_pendingRefreshes.erase(rit);
     }
 
@@ -247,12 +268,10 @@ void MincastNode::UpdateBucket(ns3::Ipv4Address addr, nodeid_t nodeID)
         }
         else
         {
-            // 2.2. else ping least recently seen node
-            //auto old = bucket.front();
-            bucket.erase(bucket.begin());
-            bucket.push_back(std::make_pair(addr, nodeID));
+            // 2.2. else ping least recently seen node, it is replaced if it does not answer
+            auto old = bucket.front();
             //     if (GetNode()->GetId() == 52) NS_LOG_INFO("Checking least recently seen " << i);
-            //RefreshNode(old.first, old.second, addr, nodeID);
+            RefreshNode(old.first, old.second, addr, nodeID);
         }
     }
 
@@ -269,14 +288,18 @@ void MincastNode::InitBroadcast(Block &b)
 {
     uint16_t startHeight = MINCAST_ID_LEN;
 
-    m_doneBlocks[b.blockID] = true;
+    BlockState &state = m_blockStates.Get(b.blockID);
+    state.done = true;
 
     //NS_LOG_INFO ("Initializing Broadcast " << b.blockID);
-    if (m_maxSeenHeight.find(b.blockID) == std::end(m_maxSeenHeight))
+    if (!state.heightSet)
     {
-        m_maxSeenHeight[b.blockID] = startHeight;
+        state.maxSeenHeight = startHeight;
+        state.heightSet = true;
     }
     BroadcastBlock(b);
+
+    CollectBlockStates();
 }
 
 void MincastNode::BroadcastBlock(Block &b)
@@ -290,85 +313,163 @@ void MincastNode::BroadcastBlock(Block &b)
     //}
     //NS_LOG_INFO ("nNodes total: " << nNodes);
     //}
-    uint16_t height = m_maxSeenHeight[b.blockID];
-    m_maxSeenHeight.erase(b.blockID);
+    BlockState &state = m_blockStates.Get(b.blockID);
+    uint16_t height = state.maxSeenHeight;
+    state.maxSeenHeight = 0;
+    state.heightSet = false;
 
     if (height == 0)
         return;
     //NS_LOG_INFO ("Initializing Broadcast for block " << b.blockID << ". Height: " << height);
 
+    std::vector<std::pair<ns3::Ipv4Address, uint16_t>> dests;
     for (uint16_t bIndex = height - 1; bIndex >= 0 && bIndex < MINCAST_ID_LEN; --bIndex)
     {
         //if (m_buckets[i].size() == 0) NS_LOG_INFO("Bucket " << i << ": empty! (height: " << height << ")");
         if (m_buckets[bIndex].size() == 0)
             continue;
 
-        std::vector<ns3::Ipv4Address> nodeAddresses;
-        // Pick MincastNode::kadBeta nodes
-        uint16_t toQuery = MincastNode::kadBeta < m_buckets[bIndex].size() ? MincastNode::kadBeta : m_buckets[bIndex].size();
-        //if (GetNode()->GetId() == 52) NS_LOG_INFO("Bucket " << i << ": Will query " << toQuery << "/" << m_buckets[i].size() << " nodes.");
-        while (toQuery > 0)
-        {
-            ns3::Ipv4Address nodeAddr = RandomAddressFromBucket(bIndex);
-            if (nodeAddr == m_address)
-                continue;
-            auto it = std::find(std::begin(nodeAddresses), std::end(nodeAddresses), nodeAddr);
-            if (it == std::end(nodeAddresses))
-            {
-                nodeAddresses.push_back(nodeAddr);
-                toQuery--;
-            }
-        }
-        std::random_shuffle(nodeAddresses.begin(), nodeAddresses.end());
+        std::vector<ns3::Ipv4Address> nodeAddresses = SampleBucket(bIndex);
         NS_LOG_INFO("will broadcast to " << nodeAddresses.size() << " nodes");
 
         if (mincastUseScores)
         {
-            //NS_LOG_INFO("Use Scores System");
-            //NS_LOG_INFO(m_address);
-            int ct = nodeAddresses.size() == kadBeta ? kadBeta == 3 ? 1 : 2 : 0;
+            // push where an INFORM would delay peers needing the block by more than
+            // the upload pushing it wastes on peers getting it elsewhere
+            std::vector<std::pair<double, ns3::Ipv4Address>> gains;
             for (auto nAddr : nodeAddresses)
-            {
+                gains.push_back(std::make_pair(m_peerEstimates.GetPushGain(nAddr, b.blockSize), nAddr));
+            std::stable_sort(gains.begin(), gains.end(), [](const std::pair<double, ns3::Ipv4Address> &l, const std::pair<double, ns3::Ipv4Address> &r) { return l.first > r.first; });
 
-                //int subnetLatency = std::abs(int(m_address.Get()) - int(nAddr.Get())); // Use IP subnet changes to calculate latency
-
-                if (std::abs(int(m_address.Get()) - int(nAddr.Get())) >= 65535 || ct == 0) // 2^16 consider subnets changes after the 1st 8bits field here
-                {
-                    SendBlock(nAddr, b, bIndex);
-                }
-                else
-                {
-                    SendInformMessage(nAddr, b.blockID);
-                    ct--;
-                }
-            }
+            // the best peer of a bucket always gets the block pushed
+            for (uint16_t j = 0; j < gains.size(); j++)
+                PushOrInform(gains[j].second, b, bIndex, j == 0 || gains[j].first >= 0, dests);
         }
         else
         {
-            //NS_LOG_INFO("Use Percentage System");
-            //NS_LOG_INFO(m_address);
-
-            int nodeAddrLimit = nodeAddresses.size() == kadBeta ? kadBeta == 5 ? nodeAddresses.size() - 3 : nodeAddresses.size() - 2 : nodeAddresses.size() - 1, ct = 0;
+            // inform a fixed share of a full bucket sample, push to the rest
+            uint16_t nInform = nodeAddresses.size() == kadBeta ? kadBeta * MINCAST_INFORM_SHARE : 0;
+            for (uint16_t j = 0; j < nodeAddresses.size(); j++)
+                PushOrInform(nodeAddresses[j], b, bIndex, j < nodeAddresses.size() - nInform, dests);
+        }
+    }
 
-            for (auto nAddr : nodeAddresses)
-            {
+    SendBlock(dests, b);
+    return;
+}
 
-                if (ct <= nodeAddrLimit)
-                    SendBlock(nAddr, b, bIndex);
-                else
-                    SendInformMessage(nAddr, b.blockID);
-                ct++;
-            }
+std::vector<ns3::Ipv4Address>
+MincastNode::SampleBucket(uint16_t bIndex)
+{
+    std::vector<ns3::Ipv4Address> nodeAddresses;
+    // Pick MincastNode::kadBeta nodes
+    uint16_t toQuery = MincastNode::kadBeta < m_buckets[bIndex].size() ? MincastNode::kadBeta : m_buckets[bIndex].size();
+    //if (GetNode()->GetId() == 52) NS_LOG_INFO("Bucket " << i << ": Will query " << toQuery << "/" << m_buckets[i].size() << " nodes.");
+    while (toQuery > 0)
+    {
+        ns3::Ipv4Address nodeAddr = RandomAddressFromBucket(bIndex);
+        if (nodeAddr == m_address)
+            continue;
+        auto it = std::find(std::begin(nodeAddresses), std::end(nodeAddresses), nodeAddr);
+        if (it == std::end(nodeAddresses))
+        {
+            nodeAddresses.push_back(nodeAddr);
+            toQuery--;
         }
     }
+    std::random_shuffle(nodeAddresses.begin(), nodeAddresses.end());
+    return nodeAddresses;
+}
 
-    return;
+void MincastNode::InitTxBroadcast(Tx &tx)
+{
+    BroadcastTx(tx, MINCAST_ID_LEN);
+}
+
+void MincastNode::BroadcastTx(Tx &tx, uint16_t height)
+{
+    for (uint16_t bIndex = height - 1; bIndex >= 0 && bIndex < MINCAST_ID_LEN; --bIndex)
+    {
+        if (m_buckets[bIndex].size() == 0)
+            continue;
+        for (auto nAddr : SampleBucket(bIndex))
+            SendTxMessage(nAddr, tx, bIndex);
+    }
+}
+
+void MincastNode::PushOrInform(ns3::Ipv4Address addr, Block &b, uint16_t bIndex, bool push, std::vector<std::pair<ns3::Ipv4Address, uint16_t>> &dests)
+{
+    if (!push)
+    {
+        QueueInform(addr, b.blockID);
+        m_nInformed++;
+        return;
+    }
+
+    // blocks go out after all informs when their chunks are interleaved
+    if (MincastNode::kadChunkOrder == ChunkOrder::SERIAL)
+        SendBlock(addr, b, bIndex);
+    else
+        dests.push_back(std::make_pair(addr, bIndex));
+    m_nPushed++;
 }
 
 void MincastNode::SendBlock(ns3::Ipv4Address &outgoingAddress, Block &b, uint16_t height)
 {
     NS_LOG_INFO("Sending BLOCK: " << b.blockID << " to: " << outgoingAddress);
-    std::map<uint16_t, MinChunk> chunkMap = Chunkify(b);
+    for (auto &c : PrepareChunks(outgoingAddress, b))
+    {
+        SendChunkMessage(outgoingAddress, c, height);
+    }
+}
+
+void MincastNode::SendBlock(std::vector<std::pair<ns3::Ipv4Address, uint16_t>> &dests, Block &b)
+{
+    if (MincastNode::kadChunkOrder == ChunkOrder::SERIAL)
+    {
+        for (auto &d : dests)
+        {
+            SendBlock(d.first, b, d.second);
+        }
+        return;
+    }
+
+    // interleave, so every subtree gets its first chunks early.
+    // Weighted: destinations in higher buckets cover larger subtrees and get a larger share.
+    std::vector<std::vector<MinChunk>> chunkLists;
+    std::vector<uint16_t> counts;
+    std::vector<uint32_t> weights;
+    for (auto &d : dests)
+    {
+        chunkLists.push_back(PrepareChunks(d.first, b));
+        counts.push_back(chunkLists.back().size());
+        weights.push_back(MincastNode::kadChunkOrder == ChunkOrder::WEIGHTED ? d.second + 1 : 1);
+    }
+
+    std::vector<uint16_t> next(dests.size(), 0);
+    for (uint16_t i : InterleaveChunks(counts, weights))
+    {
+        if (next[i] == 0)
+            NS_LOG_INFO("Sending BLOCK: " << b.blockID << " to: " << dests[i].first);
+        SendChunkMessage(dests[i].first, chunkLists[i][next[i]++], dests[i].second);
+    }
+}
+
+std::vector<MinChunk>
+MincastNode::PrepareChunks(ns3::Ipv4Address &outgoingAddress, Block &b)
+{
+    // choose the redundancy by the losses the destination reported
+    double fecOverhead = MincastNode::kadFecOverhead;
+    if (MincastNode::kadFecAdaptive)
+        fecOverhead = m_lossEstimates.GetFecOverhead(outgoingAddress, MincastNode::kadFecOverhead, MincastNode::kadFecMin, MincastNode::kadFecMax);
+    m_fecOverheadSum += fecOverhead;
+    m_nFecChoices++;
+
+    std::map<uint16_t, MinChunk> chunkMap = Chunkify(b, fecOverhead);
+    for (auto &e : chunkMap)
+    {
+        e.second.nSent = chunkMap.size();
+    }
 
     std::vector<uint16_t> chunksToSend;
     for (uint16_t chunkID = 0; chunkID < chunkMap.size(); chunkID++)
@@ -376,6 +477,7 @@ void MincastNode::SendBlock(ns3::Ipv4Address &outgoingAddress, Block &b, uint16_
         chunksToSend.push_back(chunkID);
     }
 
+    std::vector<MinChunk> chunks;
     while (!chunksToSend.empty())
     {
         ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
@@ -385,11 +487,11 @@ void MincastNode::SendBlock(ns3::Ipv4Address &outgoingAddress, Block &b, uint16_
         auto it = std::begin(chunksToSend);
         std::advance(it, steps);
 
-        SendChunkMessage(outgoingAddress, chunkMap[*it], height);
+        chunks.push_back(chunkMap[*it]);
 
-        m_seenBroadcasts[b.blockID][*it] = true;
         chunksToSend.erase(it);
     }
+    return chunks;
 }
 
 std::unordered_map<uint16_t, std::vector<bentry_t>>::iterator
@@ -453,14 +555,13 @@ void MincastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             MincastPingHeader ph;
             packet->RemoveHeader(ph);
 
-            uint64_t eSenderID = ph.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = ph.GetSenderId();
 
             // Do not act on messages from self
             if (senderID == m_nodeID)
                 continue;
 
-            //NS_LOG_INFO("Got PING from node: " << eSenderID << " / " << senderAddr);
+            //NS_LOG_INFO("Got PING from node: " << senderID << " / " << senderAddr);
 
             HandlePingMessage(senderAddr, senderID);
             break;
@@ -470,14 +571,13 @@ void MincastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             MincastPingHeader ph;
             packet->RemoveHeader(ph);
 
-            uint64_t eSenderID = ph.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = ph.GetSenderId();
 
             // Do not act on messages from self
             if (senderID == m_nodeID)
                 continue;
 
-            //if (GetNode()->GetId() == 52) NS_LOG_INFO("Got PONG from node: " << eSenderID << " / " << senderAddr);
+            //if (GetNode()->GetId() == 52) NS_LOG_INFO("Got PONG from node: " << senderID << " / " << senderAddr);
             HandlePongMessage(senderAddr, senderID);
 
             break;
@@ -487,17 +587,15 @@ void MincastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             MincastFindNodeHeader fh;
             packet->RemoveHeader(fh);
 
-            uint64_t eSenderID = fh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = fh.GetSenderId();
 
-            uint64_t eTargetID = fh.GetTargetId();
-            nodeid_t targetID = DecodeID(eTargetID);
+            nodeid_t targetID = fh.GetTargetId();
 
             // Do not act on messages from self
             if (senderID == m_nodeID)
                 continue;
 
-            //NS_LOG_INFO("Got FIND_NODE from node " << eSenderID << " / " << senderAddr << ": " << eTargetID);
+            //NS_LOG_INFO("Got FIND_NODE from node " << senderID << " / " << senderAddr << ": " << targetID);
             HandleFindNodeMessage(senderAddr, senderID, targetID);
             break;
         }
@@ -506,19 +604,17 @@ void MincastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             MincastNodesHeader nh;
             packet->RemoveHeader(nh);
 
-            uint64_t eSenderID = nh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = nh.GetSenderId();
 
-            uint64_t eTargetID = nh.GetTargetId();
-            nodeid_t targetID = DecodeID(eTargetID);
+            nodeid_t targetID = nh.GetTargetId();
 
             // Do not act on messages from self
             if (senderID == m_nodeID)
                 continue;
 
-            //NS_LOG_INFO("Got NODES from node: " << eSenderID << " / " << senderAddr);
+            //NS_LOG_INFO("Got NODES from node: " << senderID << " / " << senderAddr);
 
-            std::unordered_map<uint64_t, ns3::Ipv4Address> nodeMap = nh.GetNodes();
+            std::unordered_map<nodeid_t, ns3::Ipv4Address> nodeMap = nh.GetNodes();
             std::vector<bentry_t> nodes;
 
             nodeid_t nID;
@@ -526,7 +622,7 @@ void MincastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
 
             for (auto it : nodeMap)
             {
-                nID = DecodeID(it.first);
+                nID = it.first;
                 nAddr = it.second;
                 nodes.push_back(std::make_pair(nAddr, nID));
             }
@@ -540,10 +636,9 @@ void MincastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             MincastChunkHeader bh;
             packet->RemoveHeader(bh);
 
-            uint64_t eSenderID = bh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = bh.GetSenderId();
 
-            //NS_LOG_INFO("Got BROADCAST from node: " << eSenderID << " / " << senderAddr);
+            //NS_LOG_INFO("Got BROADCAST from node: " << senderID << " / " << senderAddr);
 
             MinChunk c;
             c.blockID = bh.GetBlockId();
@@ -552,6 +647,7 @@ void MincastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             c.blockSize = bh.GetBlockSize();
             c.chunkSize = packet->GetSize();
             c.nChunks = bh.GetNChunks();
+            c.nSent = bh.GetNSent();
 
             uint16_t height = bh.GetHeight();
 
@@ -563,29 +659,51 @@ void MincastNode::HandleRead(ns3::Ptr<ns3::Socket> socket)
             MincastReqHeader rh;
             packet->RemoveHeader(rh);
 
-            uint64_t eSenderID = rh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = rh.GetSenderId();
 
-            //NS_LOG_INFO("Got REQUEST from node: " << eSenderID << " / " << senderAddr);
+            //NS_LOG_INFO("Got REQUEST from node: " << senderID << " / " << senderAddr);
 
             uint64_t blockID = rh.GetBlockId();
+            std::vector<uint64_t> chunkBits = rh.GetChunkBits();
 
-            HandleRequestMessage(senderAddr, senderID, blockID);
+            HandleRequestMessage(senderAddr, senderID, blockID, rh.GetShare(), rh.GetNShares(), chunkBits);
             break;
         }
         case MincastMsgType::INFORM:
         {
-            MincastReqHeader rh;
+            MincastInformHeader rh;
             packet->RemoveHeader(rh);
 
-            uint64_t eSenderID = rh.GetSenderId();
-            nodeid_t senderID = DecodeID(eSenderID);
+            nodeid_t senderID = rh.GetSenderId();
 
-            //NS_LOG_INFO("Got INFORM from node: " << eSenderID << " / " << senderAddr);
+            //NS_LOG_INFO("Got INFORM from node: " << senderID << " / " << senderAddr);
 
-            uint64_t blockID = rh.GetBlockId();
+            for (uint64_t blockID : rh.GetInventory())
+                HandleInformMessage(senderAddr, senderID, blockID);
+            break;
+        }
+        case MincastMsgType::REPORT:
+        {
+            MincastReportHeader rh;
+            packet->RemoveHeader(rh);
+
+            nodeid_t senderID = rh.GetSenderId();
+
+            HandleReportMessage(senderAddr, senderID, rh.GetBlockId(), rh.GetNReceived(), rh.GetNSent(), rh.GetGoodput());
+            break;
+        }
+        case MincastMsgType::TX:
+        {
+            MincastTxHeader txh;
+            packet->RemoveHeader(txh);
+
+            Tx tx;
+            tx.txID = txh.GetTxId();
+            tx.txSize = packet->GetSize();
 
-            HandleInformMessage(senderAddr, senderID, blockID);
+            // a node passes a transaction on in the subtree it got it for, only the first time
+            if (AcceptTx(tx))
+                BroadcastTx(tx, txh.GetHeight());
             break;
         }
         default:
@@ -605,8 +723,11 @@ void MincastNode::HandleSent(ns3::Ptr<ns3::Socket> socketPtr, uint32_t availByte
 
 void MincastNode::SendAvailable()
 {
-    if (!m_socket)
+    if (!m_isRunning || !m_socket)
+    {
+        m_sendQueue.clear(); // we are offline, drop everything
         return;
+    }
     if (m_sendQueue.empty())
         return;
     if (m_sending)
@@ -661,6 +782,13 @@ void MincastNode::HandlePongMessage(ns3::Ipv4Address &senderAddr, nodeid_t &send
 {
     NS_LOG_FUNCTION(this);
     UpdateBucket(senderAddr, senderID);
+
+    auto pit = m_pendingPings.find(senderAddr);
+    if (pit != std::end(m_pendingPings))
+    {
+        m_peerEstimates.AddRttSample(senderAddr, ns3::Simulator::Now() - pit->second);
+        m_pendingPings.erase(pit);
+    }
     return;
 }
 
@@ -669,7 +797,7 @@ void MincastNode::HandleFindNodeMessage(ns3::Ipv4Address &senderAddr, nodeid_t &
     NS_LOG_FUNCTION(this);
     UpdateBucket(senderAddr, senderID);
 
-    std::map<uint64_t, bentry_t> kClosest = FindKClosestNodes(targetID);
+    std::map<nodeid_t, bentry_t> kClosest = FindKClosestNodes(targetID);
 
     std::vector<bentry_t> nodeList;
     for (auto e : kClosest)
@@ -684,11 +812,14 @@ void MincastNode::HandleFindNodeMessage(ns3::Ipv4Address &senderAddr, nodeid_t &
 void MincastNode::HandleNodesMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, nodeid_t &targetID, std::vector<bentry_t> &nodes)
 {
     NS_LOG_FUNCTION(this);
-    if (m_nodeLookups.count(targetID) == 0)
+    auto lit = m_nodeLookups.find(targetID);
+    if (lit == std::end(m_nodeLookups))
         return; // we aren't actually looking for this id
-    std::map<uint64_t, std::tuple<ns3::Ipv4Address, nodeid_t, bool>> queryMap = m_nodeLookups[targetID];
+    NodeLookup &lookup = lit->second;
+
+    uint16_t hop = lookup.HandleReply(Distance(senderID, targetID));
 
-    bool queryAll = true; // query all formerly unqueried nodes, if we do not make progress
+    bool progress = false;
     for (bentry_t e : nodes)
     {
         ns3::Ipv4Address nodeAddr = e.first;
@@ -696,36 +827,24 @@ void MincastNode::HandleNodesMessage(ns3::Ipv4Address &senderAddr, nodeid_t &sen
 
         UpdateBucket(nodeAddr, nodeID);
 
+        if (nodeID == m_nodeID)
+            continue;
+
         if (nodeID == targetID)
         {
-            NS_LOG_INFO("Found node ID: " << EncodeID(targetID));
-            m_nodeLookups.erase(targetID);
+            NS_LOG_INFO("Found node ID: " << targetID);
+            TerminateLookup(targetID, true, hop + 1);
             return;
         }
 
         // 5. Upon receiving NODES msg: if there are closest nodes, update kClosest nodes structure
-
-        uint64_t dist = Distance(nodeID, targetID);
-        if (queryMap.count(dist) == 1)
-            continue; // we actually already know this node
-
-        std::tuple<ns3::Ipv4Address, nodeid_t, bool> nodeEntry(nodeAddr, nodeID, false);
-        queryMap[dist] = nodeEntry;
-
-        if (queryMap.size() > MincastNode::kadK)
-        {
-            if (queryMap.find(dist) == std::prev(std::end(queryMap)))
-            {
-                // we didn't add to the end => will not be directly removed => progress happened
-                queryAll = false;
-            }
-            // if there are too many entries, remove entries on the end of the map (aka largest entries)
-            queryMap.erase(std::prev(std::end(queryMap)));
-        }
+        nodeid_t dist = Distance(nodeID, targetID);
+        if (lookup.AddCandidate(e, dist, hop + 1))
+            progress = true;
     }
-    m_nodeLookups[targetID] = queryMap;
+    lookup.SetProgress(progress);
 
-    LookupNode(targetID, queryAll);
+    LookupNode(targetID);
 }
 
 void MincastNode::HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, MinChunk c, uint16_t height)
@@ -736,39 +855,54 @@ void MincastNode::HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &sen
     m_receivedFirstPartBlock = true;
     SetTTFB(c.blockID, ns3::Simulator::Now());
 
-    if (!m_doneBlocks[c.prevID] && !m_blockchain->HasBlock(c.prevID))
+    if (c.nSent > 0)
+        CountReportedChunk(senderAddr, c);
+
+    auto pit = m_pulls.find(c.blockID);
+    if (pit != std::end(m_pulls))
     {
-        if (!m_requestedBlocks[c.prevID])
+        PullStripe &stripe = pit->second.stripes[senderAddr.Get()];
+        stripe.nSent = std::max(stripe.nSent, c.nSent);
+        stripe.nReceived++;
+    }
+
+    BlockState *prevState = m_blockStates.Find(c.prevID);
+    if (!(prevState && prevState->done) && !m_blockchain->HasBlock(c.prevID))
+    {
+        BlockState &missing = m_blockStates.Get(c.prevID);
+        if (!missing.requested)
         {
+            missing.requested = true;
             RequestMissingBlock(senderAddr, c.prevID);
-            m_requestedBlocks[c.prevID] = true;
         }
     }
 
-    if (m_seenBroadcasts[c.blockID][c.chunkID])
+    // late chunks of blocks whose state was already collected
+    if (m_blockchain->HasBlock(c.blockID))
         return;
-    m_seenBroadcasts[c.blockID][c.chunkID] = true;
 
-    if (m_doneBlocks[c.blockID])
+    BlockState &state = m_blockStates.Get(c.blockID);
+    if (state.done)
         return;
 
-    m_maxSeenHeight[c.blockID] = std::max(height, m_maxSeenHeight[c.blockID]);
+    // only count chunks once
+    if (!state.MarkChunk(c.chunkID))
+        return;
 
-    std::map<uint16_t, MinChunk> &chunkMap = m_receivedChunks[c.blockID];
-    if (chunkMap.count(c.chunkID) == 0)
-    {
-        // only insert chunks once
-        chunkMap[c.chunkID] = c;
-    }
+    state.maxSeenHeight = std::max(height, state.maxSeenHeight);
+    state.heightSet = true;
+    state.prevID = c.prevID;
+    state.blockSize = c.blockSize;
+    state.nChunks = c.nChunks;
 
-    if (chunkMap.size() >= c.nChunks && !m_doneBlocks[c.blockID])
+    if (state.nReceived >= state.nChunks)
     {
-        m_doneBlocks[c.blockID] = true;
-
-        m_requestedBlocks.erase(c.blockID);
+        state.done = true;
+        state.requested = false;
+        state.ClearChunks();
 
         // we have all chunks
-        Block b = Dechunkify(chunkMap);
+        Block b = Dechunkify(state);
 
         NS_LOG_INFO("Got all Chunks (ID: " << b.blockID << ", prevID: " << b.prevID << ", size: " << b.blockSize << ").");
 
@@ -780,8 +914,8 @@ void MincastNode::HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &sen
             delay = GetValidationDelay(b);
         }
         ns3::Simulator::Schedule(delay, &MincastNode::NotifyNewBlock, this, b, false);
-        chunkMap.clear();
-        m_receivedChunks.erase(c.blockID);
+
+        CollectBlockStates();
     }
     else
     {
@@ -791,34 +925,98 @@ void MincastNode::HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &sen
     return;
 }
 
-void MincastNode::HandleRequestMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID)
+void MincastNode::HandleRequestMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID, uint16_t share, uint16_t nShares, std::vector<uint64_t> &chunkBits)
 {
+    auto iit = m_pendingInforms.find(std::make_pair(blockID, senderAddr.Get()));
+    if (iit != std::end(m_pendingInforms))
+    {
+        // the peer needed the block, and the INFORM/REQUEST exchange took one round trip
+        m_peerEstimates.AddInformOutcome(senderAddr, true);
+        m_peerEstimates.AddRttSample(senderAddr, ns3::Simulator::Now() - iit->second);
+        m_pendingInforms.erase(iit);
+    }
+
     if (!m_blockchain->HasBlock(blockID))
     {
         NS_LOG_INFO("Requested block I do not have. This should never happen!");
         return;
     }
     Block b = m_blockchain->GetBlockById(blockID);
-    NS_LOG_INFO("Found block:" << b.blockID << " to send to " << senderAddr);
-    SendBlock(senderAddr, b, 0);
+    if (nShares <= 1 && chunkBits.empty())
+    {
+        NS_LOG_INFO("Found block:" << b.blockID << " to send to " << senderAddr);
+        SendBlock(senderAddr, b, 0);
+        return;
+    }
+    if (share >= nShares)
+        return;
+
+    double fecOverhead = MincastNode::kadFecOverhead;
+    if (MincastNode::kadFecAdaptive)
+        fecOverhead = m_lossEstimates.GetFecOverhead(senderAddr, MincastNode::kadFecOverhead, MincastNode::kadFecMin, MincastNode::kadFecMax);
+    std::map<uint16_t, MinChunk> chunkMap = Chunkify(b, fecOverhead);
+    if (chunkMap.empty())
+        return;
+
+    BlockState held = BlockState();
+    held.chunkBits = chunkBits;
+    uint16_t nHeld = 0;
+    for (auto &e : chunkMap)
+    {
+        if (held.HasChunk(e.first))
+            nHeld++;
+    }
+
+    // our stripe of what is still needed, with the same redundancy a push would carry
+    uint16_t nChunks = chunkMap.begin()->second.nChunks;
+    uint16_t needed = nChunks > nHeld ? nChunks - nHeld : 0;
+    uint16_t toSend = std::ceil(needed * (1 + fecOverhead) / nShares);
+
+    std::vector<MinChunk> stripe;
+    for (auto &e : chunkMap)
+    {
+        if (stripe.size() == toSend)
+            break;
+        if (e.first % nShares != share || held.HasChunk(e.first))
+            continue;
+        stripe.push_back(e.second);
+    }
+
+    NS_LOG_INFO("Sending stripe " << share << "/" << nShares << " of block " << blockID << " to " << senderAddr << ": " << stripe.size() << " of " << needed << " missing chunks.");
+    for (auto &c : stripe)
+    {
+        c.nSent = stripe.size();
+        SendChunkMessage(senderAddr, c, 0);
+    }
 
     return;
 }
 
 void MincastNode::HandleInformMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID)
 {
-    if (m_seenBroadcasts[blockID].size() > 0)
+    BlockState *state = m_blockStates.Find(blockID);
+    if ((state && state->done) || m_blockchain->HasBlock(blockID))
     {
-        NS_LOG_INFO("Already started download of block");
+        NS_LOG_INFO("Already have block " << blockID);
         return;
     }
-    int r = 0;
-    ns3::Time delay = ns3::Seconds(r);
-    while (delay < 0)
+
+    auto pit = m_pulls.find(blockID);
+    if (pit != std::end(m_pulls))
     {
-        delay = ns3::Seconds(r);
+        // another source to stripe over
+        std::vector<ns3::Ipv4Address> &informers = pit->second.informers;
+        if (std::find(std::begin(informers), std::end(informers), senderAddr) == std::end(informers))
+            informers.push_back(senderAddr);
+        return;
     }
-    ns3::Simulator::Schedule(delay, &MincastNode::RequestInformedBlock, this, senderAddr, blockID, 10);
+
+    PullState &pull = m_pulls[blockID];
+    pull.informers.push_back(senderAddr);
+    pull.nRounds = 0;
+
+    // collect the informers arriving right after the first one
+    ns3::Simulator::Schedule(ns3::Seconds(MINCAST_PULL_WAIT), &MincastNode::StartPull, this, blockID);
     return;
 }
 
@@ -831,12 +1029,15 @@ void MincastNode::SendPingMessage(ns3::Ipv4Address &outgoingAddress)
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
 
     MincastPingHeader ph;
-    ph.SetSenderId(eSenderID);
+    ph.SetSenderId(m_nodeID);
     packet->AddHeader(ph);
 
+    // only the oldest unanswered ping gives an RTT sample
+    if (m_pendingPings.count(outgoingAddress) == 0)
+        m_pendingPings[outgoingAddress] = ns3::Simulator::Now();
+
     MincastTypeHeader th;
     th.SetType(static_cast<uint8_t>(MincastMsgType::PING));
     packet->AddHeader(th);
@@ -856,10 +1057,9 @@ void MincastNode::SendPongMessage(ns3::Ipv4Address &outgoingAddress)
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
 
     MincastPingHeader ph;
-    ph.SetSenderId(eSenderID);
+    ph.SetSenderId(m_nodeID);
     packet->AddHeader(ph);
 
     MincastTypeHeader th;
@@ -881,12 +1081,10 @@ void MincastNode::SendFindNodeMessage(ns3::Ipv4Address &outgoingAddress, nodeid_
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-    uint64_t eTargetID = EncodeID(targetID);
 
     MincastFindNodeHeader fn_header;
-    fn_header.SetSenderId(eSenderID);
-    fn_header.SetTargetId(eTargetID);
+    fn_header.SetSenderId(m_nodeID);
+    fn_header.SetTargetId(targetID);
     packet->AddHeader(fn_header);
 
     MincastTypeHeader th;
@@ -908,19 +1106,16 @@ void MincastNode::SendNodesMessage(ns3::Ipv4Address &outgoingAddress, nodeid_t &
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    std::unordered_map<uint64_t, ns3::Ipv4Address> nodeMap;
+    std::unordered_map<nodeid_t, ns3::Ipv4Address> nodeMap;
     for (auto e : nodes)
     {
-        uint64_t eNodeID = EncodeID(e.second);
-        nodeMap[eNodeID] = e.first;
+        nodeMap[e.second] = e.first;
     }
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-    uint64_t eTargetID = EncodeID(targetID);
 
     MincastNodesHeader nh;
-    nh.SetSenderId(eSenderID);
-    nh.SetTargetId(eTargetID);
+    nh.SetSenderId(m_nodeID);
+    nh.SetTargetId(targetID);
     nh.SetNodes(nodeMap);
     packet->AddHeader(nh);
 
@@ -943,15 +1138,15 @@ void MincastNode::SendChunkMessage(ns3::Ipv4Address &outgoingAddress, MinChunk c
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(c.chunkSize);
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
 
     MincastChunkHeader ch;
-    ch.SetSenderId(eSenderID);
+    ch.SetSenderId(m_nodeID);
     ch.SetBlockId(c.blockID);
     ch.SetChunkId(c.chunkID);
     ch.SetPrevId(c.prevID);
     ch.SetBlockSize(c.blockSize);
     ch.SetNChunks(c.nChunks);
+    ch.SetNSent(c.nSent);
     ch.SetHeight(height);
     packet->AddHeader(ch);
 
@@ -966,7 +1161,7 @@ void MincastNode::SendChunkMessage(ns3::Ipv4Address &outgoingAddress, MinChunk c
     SendAvailable();
 }
 
-void MincastNode::SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID)
+void MincastNode::SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID, uint16_t share, uint16_t nShares, const std::vector<uint64_t> &chunkBits)
 {
     NS_LOG_FUNCTION(this);
 
@@ -975,12 +1170,13 @@ void MincastNode::SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-    //NS_LOG_INFO("Send REQUEST to node " << eSenderID << " / " << outgoingAddress);
+    //NS_LOG_INFO("Send REQUEST to node " << senderID << " / " << outgoingAddress);
 
     MincastReqHeader rh;
-    rh.SetSenderId(eSenderID);
+    rh.SetSenderId(m_nodeID);
     rh.SetBlockId(blockID);
+    rh.SetShare(share, nShares);
+    rh.SetChunkBits(chunkBits);
     packet->AddHeader(rh);
 
     MincastTypeHeader th;
@@ -991,7 +1187,15 @@ void MincastNode::SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t
     SendAvailable();
 }
 
-void MincastNode::SendInformMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID)
+void MincastNode::HandleReportMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID, uint16_t nReceived, uint16_t nSent, uint32_t goodput)
+{
+    NS_LOG_FUNCTION(this);
+    m_lossEstimates.AddSample(senderAddr, nSent, nReceived);
+    m_peerEstimates.AddGoodputSample(senderAddr, goodput);
+    NS_LOG_INFO("Got REPORT from " << senderAddr << " on block " << blockID << ": " << nReceived << "/" << nSent << " chunks, loss estimate " << m_lossEstimates.GetLoss(senderAddr) << ", goodput estimate " << m_peerEstimates.GetGoodput(senderAddr));
+}
+
+void MincastNode::SendReportMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID, uint16_t nReceived, uint16_t nSent, uint32_t goodput)
 {
     NS_LOG_FUNCTION(this);
 
@@ -1000,18 +1204,91 @@ void MincastNode::SendInformMessage(ns3::Ipv4Address &outgoingAddress, uint64_t
 
     ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
 
-    uint64_t eSenderID = EncodeID(m_nodeID);
-    //NS_LOG_INFO("Send INFORM to node " << eSenderID << " / " << outgoingAddress);
 
-    MincastReqHeader rh;
-    rh.SetSenderId(eSenderID);
+    MincastReportHeader rh;
+    rh.SetSenderId(m_nodeID);
     rh.SetBlockId(blockID);
+    rh.SetReceived(nReceived, nSent);
+    rh.SetGoodput(goodput);
     packet->AddHeader(rh);
 
+    MincastTypeHeader th;
+    th.SetType(static_cast<uint8_t>(MincastMsgType::REPORT));
+    packet->AddHeader(th);
+
+    m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
+    SendAvailable();
+}
+
+void MincastNode::SendTxMessage(ns3::Ipv4Address &outgoingAddress, Tx &tx, uint16_t height)
+{
+    if (outgoingAddress == m_address)
+        return; // do not send to self
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(tx.txSize);
+
+    MincastTxHeader txh;
+    txh.SetSenderId(m_nodeID);
+    txh.SetTxId(tx.txID);
+    txh.SetHeight(height);
+    packet->AddHeader(txh);
+
+    MincastTypeHeader th;
+    th.SetType(static_cast<uint8_t>(MincastMsgType::TX));
+    packet->AddHeader(th);
+
+    m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
+    SendAvailable();
+}
+
+void MincastNode::QueueInform(ns3::Ipv4Address addr, uint64_t blockID)
+{
+    if (addr == m_address)
+        return; // do not send to self
+
+    bool opened = m_informBatches.Add(addr, blockID);
+    if (MincastNode::announceDelay <= 0 || m_informBatches.GetSize(addr) >= MincastNode::announceBatch)
+    {
+        FlushInforms(addr);
+        return;
+    }
+    if (opened)
+        m_informBatches.SetFlushEvent(addr, ns3::Simulator::Schedule(ns3::Seconds(MincastNode::announceDelay), &MincastNode::FlushInforms, this, addr));
+}
+
+void MincastNode::FlushInforms(ns3::Ipv4Address addr)
+{
+    std::vector<uint64_t> inventory = m_informBatches.Take(addr);
+    if (!inventory.empty())
+        SendInformMessage(addr, inventory);
+}
+
+void MincastNode::SendInformMessage(ns3::Ipv4Address &outgoingAddress, const std::vector<uint64_t> &inventory)
+{
+    NS_LOG_FUNCTION(this);
+
+    if (outgoingAddress == m_address)
+        return; // do not send to self
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+
+    //NS_LOG_INFO("Send INFORM to node " << senderID << " / " << outgoingAddress);
+
+    MincastInformHeader ih;
+    ih.SetSenderId(m_nodeID);
+    ih.SetInventory(inventory);
+    packet->AddHeader(ih);
+
     MincastTypeHeader th;
     th.SetType(static_cast<uint8_t>(MincastMsgType::INFORM));
     packet->AddHeader(th);
 
+    for (uint64_t blockID : inventory)
+    {
+        m_pendingInforms[std::make_pair(blockID, outgoingAddress.Get())] = ns3::Simulator::Now();
+        ns3::Simulator::Schedule(ns3::Seconds(MINCAST_INFORM_TIMEOUT), &MincastNode::ExpireInform, this, outgoingAddress, blockID);
+    }
+
     m_sendQueue.push_back(std::make_pair(outgoingAddress, packet));
     SendAvailable();
 }
@@ -1019,82 +1296,78 @@ void MincastNode::SendInformMessage(ns3::Ipv4Address &outgoingAddress, uint64_t
 void MincastNode::InitLookupNode(nodeid_t &targetID)
 {
     NS_LOG_FUNCTION(this);
-    //NS_LOG_INFO("Initializing node lookup: " << EncodeID(targetID));
+    //NS_LOG_INFO("Initializing node lookup: " << targetID);
 
     // 1. Create LookupNode data structure
-    // if already looking up, skip
-    if (m_nodeLookups.count(targetID) == 1)
+    // if offline or already looking up, skip
+    if (!m_isRunning || m_nodeLookups.count(targetID) == 1)
         return;
 
     // 2. Retrieve kClosest nodes, add to data structure with distance
-    std::map<uint64_t, bentry_t> kClosest = FindKClosestNodes(targetID);
-    std::map<uint64_t, std::tuple<ns3::Ipv4Address, nodeid_t, bool>> queryMap;
+    std::map<nodeid_t, bentry_t> kClosest = FindKClosestNodes(targetID);
+    NodeLookup &lookup = m_nodeLookups.emplace(targetID, NodeLookup(targetID, MincastNode::kadK, MincastNode::kadAlpha)).first->second;
     for (auto e : kClosest)
     {
-        ns3::Ipv4Address &nodeAddr = e.second.first;
-        nodeid_t &nodeID = e.second.second;
-        std::tuple<ns3::Ipv4Address, nodeid_t, bool> p(nodeAddr, nodeID, false);
-        queryMap[e.first] = p;
+        lookup.AddCandidate(e.second, e.first, 1);
     }
-    m_nodeLookups[targetID] = queryMap;
 
     LookupNode(targetID);
 }
 
-void MincastNode::LookupNode(nodeid_t &targetID, bool queryAll)
+void MincastNode::LookupNode(nodeid_t &targetID)
 {
     NS_LOG_FUNCTION(this);
-    if (targetID == m_nodeID)
-        return;
-    if (m_nodeLookups.count(targetID) == 0)
+    auto lit = m_nodeLookups.find(targetID);
+    if (lit == std::end(m_nodeLookups))
         return; // Make sure we do not acidentally create new entries
+    NodeLookup &lookup = lit->second;
 
     // 3. Check in local buckets
-    auto bucket_index = BucketIndexFromID(targetID);
-    std::vector<bentry_t> &bucket = m_buckets[bucket_index];
-
-    for (auto e : bucket)
+    if (targetID != m_nodeID)
     {
-        if (e.second == targetID)
+        auto bucket_index = BucketIndexFromID(targetID);
+        std::vector<bentry_t> &bucket = m_buckets[bucket_index];
+
+        for (auto e : bucket)
         {
-            NS_LOG_INFO("Found node ID in local bucket: " << EncodeID(targetID));
-            TerminateLookup(targetID);
-            return;
+            if (e.second == targetID)
+            {
+                NS_LOG_INFO("Found node ID in local bucket: " << targetID);
+                TerminateLookup(targetID, true, 0);
+                return;
+            }
         }
     }
 
-    std::map<uint64_t, std::tuple<ns3::Ipv4Address, nodeid_t, bool>> queryMap = m_nodeLookups[targetID];
-
-    // 4. Query alpha not-yet-queried closest nodes
-    unsigned int toQuery = MincastNode::kadAlpha;
-    unsigned int nQueried = 0;
-
-    for (auto e : queryMap)
+    // 4. Query alpha not-yet-queried closest nodes, each with its own timeout
+    for (const nodeid_t &dist : lookup.NextQueries())
     {
-        if (!queryAll && toQuery == 0)
-            break;
-        ns3::Ipv4Address nodeAddr;
-        nodeid_t nodeID;
-        bool queried;
-        std::tie(nodeAddr, nodeID, queried) = e.second;
-
-        if (queried)
-        {
-            nQueried++;
-            continue;
-        }
+        LookupCandidate *c = lookup.GetCandidate(dist);
+        SendFindNodeMessage(c->addr, targetID);
+        c->timeout = ns3::Simulator::Schedule(ns3::Seconds(MINCAST_LOOKUP_TIMEOUT), &MincastNode::LookupTimeoutExpired, this, targetID, dist);
+    }
 
-        SendFindNodeMessage(nodeAddr, targetID);
-        MarkQueried(targetID, nodeID);
-        nQueried++;
-        toQuery--;
+    if (lookup.IsConverged())
+    {
+        //NS_LOG_INFO ("Terminating node lookup!");
+        TerminateLookup(targetID);
     }
+}
 
-    if (nQueried < MincastNode::kadK)
+void MincastNode::LookupTimeoutExpired(nodeid_t &targetID, nodeid_t dist)
+{
+    NS_LOG_FUNCTION(this);
+    auto lit = m_nodeLookups.find(targetID);
+    if (lit == std::end(m_nodeLookups))
         return;
-    //NS_LOG_INFO ("Terminating node lookup!");
-    // terminate after timeout
-    ns3::Simulator::Schedule(ns3::Seconds(10), &MincastNode::TerminateLookup, this, targetID);
+
+    // the node did not answer, check if it is still alive
+    LookupCandidate *c = lit->second.GetCandidate(dist);
+    if (c && c->state == RpcState::INFLIGHT)
+        CheckNode(c->addr, c->nodeID);
+
+    lit->second.HandleTimeout(dist);
+    LookupNode(targetID);
 }
 
 void MincastNode::PeriodicRefresh()
@@ -1104,62 +1377,152 @@ void MincastNode::PeriodicRefresh()
     NS_LOG_INFO("Conducting periodic refresh!");
 
     RefreshBuckets();
+    CheckBuckets();
 
     ns3::Ptr<ns3::NormalRandomVariable> x = ns3::CreateObject<ns3::NormalRandomVariable>();
-    x->SetAttribute("Mean", ns3::DoubleValue(MINCAST_BUCKET_REFRESH_TIMEOUT));
+    x->SetAttribute("Mean", ns3::DoubleValue(MincastNode::kadRefreshInterval));
     x->SetAttribute("Variance", ns3::DoubleValue(100));
     ns3::Time refreshTime = ns3::Seconds(x->GetValue());
     while (refreshTime < 0)
     {
         refreshTime = ns3::Seconds(x->GetValue());
     }
-    ns3::Simulator::Schedule(refreshTime, &MincastNode::PeriodicRefresh, this);
+    m_nextRefresh = ns3::Simulator::Schedule(refreshTime, &MincastNode::PeriodicRefresh, this);
 }
 
-void MincastNode::RequestInformedBlock(ns3::Ipv4Address &senderAddr, uint64_t blockID, int ct)
+void MincastNode::StartPull(uint64_t blockID)
 {
-    if (m_doneBlocks[blockID] || m_blockchain->HasBlock(blockID))
+    auto pit = m_pulls.find(blockID);
+    if (pit == std::end(m_pulls))
+        return; // dropped while offline
+
+    BlockState *state = m_blockStates.Find(blockID);
+    if ((state && state->done) || m_blockchain->HasBlock(blockID))
     {
-        NS_LOG_INFO("Caught up to block: " << blockID);
+        m_pulls.erase(pit);
         return;
     }
-    if (m_seenBroadcasts[blockID].size() > 0)
-    {
+
+    // a push is already arriving, only pull if it stalls
+    if (state && state->nReceived > 0)
         NS_LOG_INFO("Already started download of block");
+    else
+        RequestStripes(blockID, pit->second);
+
+    ns3::Simulator::Schedule(ns3::Seconds(MINCAST_PULL_CHECK), &MincastNode::CheckPull, this, blockID);
+}
+
+void MincastNode::RequestStripes(uint64_t blockID, PullState &pull)
+{
+    // fastest informers first
+    std::vector<ns3::Ipv4Address> candidates = pull.informers;
+    std::stable_sort(candidates.begin(), candidates.end(), [this](const ns3::Ipv4Address &l, const ns3::Ipv4Address &r) { return m_peerEstimates.GetGoodput(l) > m_peerEstimates.GetGoodput(r); });
+    uint16_t nSources = std::min<size_t>(candidates.size(), MINCAST_PULL_SOURCES);
+    pull.sources.assign(candidates.begin(), candidates.begin() + nSources);
+
+    std::vector<uint64_t> chunkBits;
+    BlockState *state = m_blockStates.Find(blockID);
+    if (state)
+        chunkBits = state->chunkBits;
+
+    for (uint16_t i = 0; i < nSources; i++)
+        SendRequestMessage(pull.sources[i], blockID, i, nSources, chunkBits);
+
+    pull.stripes.clear();
+    pull.nRounds++;
+    NS_LOG_INFO("Pulling block " << blockID << " from " << nSources << " of " << pull.informers.size() << " informers (round " << pull.nRounds << ").");
+}
+
+void MincastNode::CheckPull(uint64_t blockID)
+{
+    auto pit = m_pulls.find(blockID);
+    if (pit == std::end(m_pulls))
+        return;
+    PullState &pull = pit->second;
+
+    BlockState *state = m_blockStates.Find(blockID);
+    if ((state && state->done) || m_blockchain->HasBlock(blockID))
+    {
+        m_pulls.erase(pit);
         return;
     }
 
-    SendRequestMessage(senderAddr, blockID);
+    if (pull.nRounds >= MINCAST_PULL_ROUNDS)
+    {
+        NS_LOG_INFO("Giving up pull of block " << blockID << " after " << pull.nRounds << " rounds.");
+        m_pulls.erase(pit);
+        return;
+    }
 
-    ns3::Ptr<ns3::NormalRandomVariable> x = ns3::CreateObject<ns3::NormalRandomVariable>();
-    x->SetAttribute("Mean", ns3::DoubleValue(7));
-    x->SetAttribute("Variance", ns3::DoubleValue(1));
+    uint32_t total = 0;
+    for (auto &p : pull.stripes)
+        total += p.second.nReceived - p.second.nChecked;
 
-    ns3::Time nextRequestTime = ns3::Seconds(x->GetValue());
-    while (nextRequestTime < 0)
+    // share of its stripe a source delivered, 0 before its first chunk
+    auto completion = [](const PullStripe &stripe) {
+        return stripe.nSent == 0 ? 0.0 : std::min(1.0, static_cast<double>(stripe.nReceived) / stripe.nSent);
+    };
+
+    bool restripe = false;
+    if (pull.sources.empty())
     {
-        nextRequestTime = ns3::Seconds(x->GetValue());
+        // waiting on a push, pull once it stalls
+        restripe = total == 0;
+    }
+    else
+    {
+        double mean = 0;
+        for (auto &src : pull.sources)
+            mean += completion(pull.stripes[src.Get()]);
+        mean /= pull.sources.size();
+
+        // replace the slow sources by the other informers, if there are any
+        std::vector<ns3::Ipv4Address> kept;
+        for (auto &addr : pull.informers)
+        {
+            bool slow = false;
+            if (std::find(std::begin(pull.sources), std::end(pull.sources), addr) != std::end(pull.sources))
+            {
+                PullStripe &stripe = pull.stripes[addr.Get()];
+                bool complete = stripe.nSent > 0 && stripe.nReceived >= stripe.nSent;
+                bool stalled = stripe.nReceived == stripe.nChecked;
+                slow = !complete && (stalled || completion(stripe) < MINCAST_PULL_SLOW * mean);
+            }
+            if (slow)
+                restripe = true;
+            else
+                kept.push_back(addr);
+        }
+        if (restripe && !kept.empty())
+            pull.informers = kept;
     }
-    if (ct > 0)
-        ns3::Simulator::Schedule(nextRequestTime, &MincastNode::RequestInformedBlock, this, senderAddr, blockID, ct - 1);
 
-    NS_LOG_INFO("Requesting informed block " << blockID << " from " << senderAddr << " Next: +" << nextRequestTime << "s");
+    if (restripe)
+        RequestStripes(blockID, pull);
+    else
+    {
+        for (auto &p : pull.stripes)
+            p.second.nChecked = p.second.nReceived;
+    }
+
+    ns3::Simulator::Schedule(ns3::Seconds(MINCAST_PULL_CHECK), &MincastNode::CheckPull, this, blockID);
 }
 
 void MincastNode::RequestMissingBlock(ns3::Ipv4Address &senderAddr, uint64_t blockID)
 {
-    if (m_doneBlocks[blockID] || m_blockchain->HasBlock(blockID))
+    BlockState *state = m_blockStates.Find(blockID);
+    if ((state && state->done) || m_blockchain->HasBlock(blockID))
     {
         NS_LOG_INFO("Caught up to block: " << blockID);
         return;
     }
-    if (m_seenBroadcasts[blockID].size() > 0)
+    if (state && state->nReceived > 0)
     {
         NS_LOG_INFO("Already started download of block");
         return;
     }
 
-    SendRequestMessage(senderAddr, blockID);
+    SendRequestMessage(senderAddr, blockID, 0, 1, std::vector<uint64_t>());
 
     ns3::Ptr<ns3::NormalRandomVariable> x = ns3::CreateObject<ns3::NormalRandomVariable>();
     x->SetAttribute("Mean", ns3::DoubleValue(5000));
@@ -1175,6 +1538,58 @@ void MincastNode::RequestMissingBlock(ns3::Ipv4Address &senderAddr, uint64_t blo
     NS_LOG_INFO("Requesting missing block " << blockID << " from " << senderAddr << ". Next: " << nextRequestTime);
 }
 
+void MincastNode::CountReportedChunk(ns3::Ipv4Address &senderAddr, MinChunk &c)
+{
+    auto key = std::make_pair(c.blockID, senderAddr.Get());
+    auto rit = m_chunkReports.find(key);
+    if (rit != std::end(m_chunkReports))
+    {
+        rit->second.nReceived++;
+        rit->second.last = ns3::Simulator::Now();
+        rit->second.nBytes += c.chunkSize;
+        return;
+    }
+
+    ChunkReport report = {1, c.nSent, ns3::Simulator::Now(), ns3::Simulator::Now(), 0};
+    m_chunkReports[key] = report;
+    ns3::Simulator::Schedule(ns3::Seconds(MINCAST_REPORT_DELAY), &MincastNode::ReportLoss, this, senderAddr, c.blockID, 1);
+}
+
+void MincastNode::ReportLoss(ns3::Ipv4Address addr, uint64_t blockID, uint16_t lastReceived)
+{
+    auto rit = m_chunkReports.find(std::make_pair(blockID, addr.Get()));
+    if (rit == std::end(m_chunkReports))
+        return; // dropped while offline
+
+    ChunkReport &report = rit->second;
+    uint16_t nReceived = report.nReceived;
+    if (nReceived > lastReceived)
+    {
+        // the sender is still transmitting
+        ns3::Simulator::Schedule(ns3::Seconds(MINCAST_REPORT_DELAY), &MincastNode::ReportLoss, this, addr, blockID, nReceived);
+        return;
+    }
+
+    // goodput over the chunks after the first one
+    uint32_t goodput = 0;
+    ns3::Time span = report.last - report.first;
+    if (span > ns3::Seconds(0))
+        goodput = report.nBytes / span.GetSeconds();
+
+    SendReportMessage(addr, blockID, nReceived, report.nSent, goodput);
+    m_chunkReports.erase(rit);
+}
+
+void MincastNode::ExpireInform(ns3::Ipv4Address addr, uint64_t blockID)
+{
+    auto iit = m_pendingInforms.find(std::make_pair(blockID, addr.Get()));
+    if (iit == std::end(m_pendingInforms))
+        return; // answered, or dropped while offline
+
+    m_peerEstimates.AddInformOutcome(addr, false);
+    m_pendingInforms.erase(iit);
+}
+
 void MincastNode::RefreshBuckets()
 {
     NS_LOG_FUNCTION(this);
@@ -1183,10 +1598,8 @@ void MincastNode::RefreshBuckets()
         auto it = m_activeBuckets.find(i);
         if (it != std::end(m_activeBuckets))
             continue;
-        uint64_t min = pow2(i);
-        uint64_t max = pow2(i + 1);
-        nodeid_t random_id = RandomIDInInterval(min, max);
-        //NS_LOG_INFO("Looking up random node in [" << min << "," << max << "): " << EncodeID(random_id));
+        nodeid_t random_id = RandomIDInBucket(i);
+        //NS_LOG_INFO("Looking up random node in bucket " << i << ": " << random_id);
         InitLookupNode(random_id);
     }
     m_activeBuckets.clear();
@@ -1204,8 +1617,7 @@ void MincastNode::RefreshNode(ns3::Ipv4Address &oldAddress, nodeid_t oldID, ns3:
 
     SendPingMessage(oldAddress);
 
-    if (newID == m_nodeID)
-        return;
+    // newID == m_nodeID means there is no replacement, the node is just evicted on timeout
     if (ns3::Seconds(MINCAST_PING_TIMEOUT) <= 0)
     {
         NS_LOG_INFO("Shit");
@@ -1215,6 +1627,27 @@ void MincastNode::RefreshNode(ns3::Ipv4Address &oldAddress, nodeid_t oldID, ns3:
     m_pendingRefreshes[oldID] = eventTuple;
 }
 
+void MincastNode::CheckNode(ns3::Ipv4Address addr, nodeid_t nodeID)
+{
+    NS_LOG_FUNCTION(this);
+    RefreshNode(addr, nodeID, m_address, m_nodeID);
+}
+
+void MincastNode::CheckBuckets()
+{
+    NS_LOG_FUNCTION(this);
+    ns3::Time lastRefresh = ns3::Simulator::Now() - ns3::Seconds(MincastNode::kadRefreshInterval);
+    for (auto &b : m_buckets)
+    {
+        for (auto e : b.second)
+        {
+            auto sit = m_lastSeen.find(e.second);
+            if (sit == std::end(m_lastSeen) || sit->second < lastRefresh)
+                CheckNode(e.first, e.second);
+        }
+    }
+}
+
 void MincastNode::RefreshTimeoutExpired(ns3::Ipv4Address &addr, nodeid_t nodeID)
 {
     NS_LOG_FUNCTION(this);
@@ -1229,15 +1662,16 @@ void MincastNode::RefreshTimeoutExpired(ns3::Ipv4Address &addr, nodeid_t nodeID)
     {
         bucket.erase(nit);
     }
+    m_lastSeen.erase(nodeID);
 
-    // Retrieve & push new peer
+    // Retrieve & push new peer, if there is room
     auto rit = FindInRefreshes(nodeID);
     if (rit != std::end(m_pendingRefreshes))
     {
         std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t> t = rit->second;
         ns3::Ipv4Address newAddr = std::get<1>(t);
         nodeid_t newID = std::get<2>(t);
-        if (newID != m_nodeID)
+        if (newID != m_nodeID && bucket.size() < MincastNode::kadK && FindInBucket(newAddr, bucket) == std::end(bucket))
             bucket.push_back(std::make_pair(newAddr, newID));
         m_pendingRefreshes.erase(rit);
     }
@@ -1245,25 +1679,12 @@ void MincastNode::RefreshTimeoutExpired(ns3::Ipv4Address &addr, nodeid_t nodeID)
     m_buckets[i] = bucket;
 }
 
-uint64_t
-MincastNode::EncodeID(std::bitset<MINCAST_ID_LEN> &bs)
-{
-    return bs.to_ullong();
-}
-
-std::bitset<MINCAST_ID_LEN>
-MincastNode::DecodeID(uint64_t encoded)
-{
-    std::bitset<MINCAST_ID_LEN> bs(encoded);
-    return bs;
-}
-
-std::map<uint64_t, bentry_t>
+std::map<nodeid_t, bentry_t>
 MincastNode::FindKClosestNodes(nodeid_t targetID)
 {
-    std::map<uint64_t, bentry_t> closestNodes;
+    std::map<nodeid_t, bentry_t> closestNodes;
 
-    uint64_t dist;
+    nodeid_t dist;
 
     // Get nodes from the target's bucket
     uint16_t bucket_index = BucketIndexFromID(targetID);
@@ -1289,7 +1710,7 @@ MincastNode::FindKClosestNodes(nodeid_t targetID)
                 if (closestNodes.count(dist) == 0)
                 {
                     // if we did not already add the entry, calculate distance and insert to map
-                    uint64_t dist = Distance(targetID, e.second);
+                    nodeid_t dist = Distance(targetID, e.second);
                     closestNodes[dist] = e;
                     if (closestNodes.size() > MincastNode::kadK)
                     {
@@ -1303,30 +1724,6 @@ MincastNode::FindKClosestNodes(nodeid_t targetID)
     return closestNodes;
 }
 
-void MincastNode::MarkQueried(nodeid_t &targetID, nodeid_t &nodeID)
-{
-    if (m_nodeLookups.count(targetID) == 0)
-        return; // Make sure we do not acidentally create new entries
-
-    uint64_t dist = Distance(nodeID, targetID);
-    if (m_nodeLookups[targetID].count(dist) == 0)
-        return; // Make sure we do not acidentally add to the k closest nodes
-
-    std::get<2>(m_nodeLookups[targetID][dist]) = true;
-}
-
-bool MincastNode::IsQueried(nodeid_t &targetID, nodeid_t &nodeID)
-{
-    if (m_nodeLookups.count(targetID) == 0)
-        return false; // Make sure we do not acidentally create new entries
-
-    uint64_t dist = Distance(nodeID, targetID);
-    if (m_nodeLookups[targetID].count(dist) == 0)
-        return false; // Make sure we do not acidentally add to the k closest nodes
-
-    return std::get<2>(m_nodeLookups[targetID][dist]);
-}
-
 void MincastNode::PrintBuckets()
 {
     for (uint16_t i = 0; i < MINCAST_ID_LEN; ++i)
@@ -1340,7 +1737,7 @@ void MincastNode::PrintBuckets()
 }
 
 std::map<uint16_t, MinChunk>
-MincastNode::Chunkify(Block b)
+MincastNode::Chunkify(Block b, double fecOverhead)
 {
     MincastTypeHeader th;
     MincastChunkHeader ch;
@@ -1366,6 +1763,7 @@ MincastNode::Chunkify(Block b)
         assert(c.chunkSize <= packetSize);
 
         c.nChunks = nChunks;
+        c.nSent = 0;
 
         chunks[i] = c;
         toProcess -= c.chunkSize;
@@ -1382,7 +1780,7 @@ MincastNode::Chunkify(Block b)
     assert(blockSize == b.blockSize);
 
     // add additional chunks to model FEC
-    uint16_t nAdditional = (nChunks * MincastNode::kadFecOverhead);
+    uint16_t nAdditional = (nChunks * fecOverhead);
     for (unsigned int i = nChunks; i < nChunks + nAdditional; i++)
     {
         MinChunk c;
@@ -1395,33 +1793,83 @@ MincastNode::Chunkify(Block b)
         assert(c.chunkSize <= packetSize);
 
         c.nChunks = nChunks;
+        c.nSent = 0;
 
         chunks[i] = c;
     }
     return chunks;
 }
 
-Block MincastNode::Dechunkify(std::map<uint16_t, MinChunk> chunks)
+Block MincastNode::Dechunkify(const BlockState &state)
 {
-    assert(chunks.size() > 0);
+    assert(state.blockID != 0);
+    assert(state.nChunks > 0 && state.nChunks <= state.nReceived);
 
-    MinChunk firstChunk = std::begin(chunks)->second;
-
-    assert(firstChunk.blockID != 0);
-    assert(firstChunk.nChunks <= chunks.size());
-
-    uint64_t newBlockID = firstChunk.blockID;
-    uint64_t newPrevID = firstChunk.prevID;
-    uint32_t newBlockSize = firstChunk.blockSize;
-    Block newBlock = Blockchain::GetNewBlock(newBlockID, newPrevID, newBlockSize);
+    Block newBlock = Blockchain::GetNewBlock(state.blockID, state.prevID, state.blockSize);
 
     return newBlock;
 }
 
-void MincastNode::TerminateLookup(nodeid_t &targetID)
+void MincastNode::CollectBlockStates()
+{
+    uint32_t topHeight = m_blockchain->GetTopBlockHeight();
+    if (MincastNode::kadStateDepth == 0 || topHeight <= MincastNode::kadStateDepth)
+        return;
+    uint32_t maxHeight = topHeight - MincastNode::kadStateDepth;
+
+    Blockchain *chain = m_blockchain;
+    auto isBuried = [chain, maxHeight](const BlockState &s) {
+        uint32_t h = 0;
+        if (chain->HasBlock(s.blockID))
+            h = chain->GetBlockById(s.blockID).blockHeight;
+        else if (s.nChunks > 0 && chain->HasBlock(s.prevID))
+            h = chain->GetBlockById(s.prevID).blockHeight + 1; // stale partial download
+        return h > 0 && h <= maxHeight;
+    };
+    uint32_t nDropped = m_blockStates.EraseIf(isBuried);
+
+    if (nDropped > 0)
+        NS_LOG_INFO("Dropped state of " << nDropped << " blocks below height " << maxHeight << ", " << m_blockStates.Size() << " left.");
+}
+
+void MincastNode::TerminateLookup(nodeid_t &targetID, bool found, uint16_t foundHop)
 {
-    if (m_nodeLookups.count(targetID) == 0)
+    auto lit = m_nodeLookups.find(targetID);
+    if (lit == std::end(m_nodeLookups))
         return;
-    m_nodeLookups.erase(targetID);
+
+    LookupStats stats = lit->second.Finish(found, foundHop);
+    NS_LOG_INFO("Lookup of " << targetID << " done after " << stats.duration.GetMilliSeconds() << " ms, " << stats.hops << " hops, " << stats.nMessages << " messages, " << stats.nTimeouts << " timeouts (found: " << stats.found << ").");
+
+    m_lookupStats.push_back(stats);
+    m_nodeLookups.erase(lit);
+}
+
+std::vector<LookupStats>
+MincastNode::GetLookupStats()
+{
+    return m_lookupStats;
+}
+
+double
+MincastNode::GetMeanFecOverhead()
+{
+    if (m_nFecChoices == 0)
+        return 0.0;
+    return m_fecOverheadSum / m_nFecChoices;
+}
+
+double
+MincastNode::GetPushShare()
+{
+    if (m_nPushed + m_nInformed == 0)
+        return 0.0;
+    return m_nPushed / (double)(m_nPushed + m_nInformed);
+}
+
+const AnnounceBatcher &
+MincastNode::GetAnnounces()
+{
+    return m_informBatches;
 }
 } // namespace bns
@@ -6,7 +6,6 @@
 #define MINCAST_NODE_H
 
 #include <algorithm>
-#include <bitset>
 #include <set>
 #include <unordered_map>
 #include <deque>
@@ -20,15 +19,30 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/socket.h"
 
+#include "announce-batcher.h"
 #include "bitcoin-node.h"
+#include "block-state.h"
+#include "chunk-order.h"
+#include "loss-estimator.h"
 #include "mincast-messages.h"
+#include "node-lookup.h"
+#include "peer-estimator.h"
 #include "util.h"
 
-#define MINCAST_ID_LEN 64 // FIXME: Using node ID length of 64 bits for now, since it fits a uint64_t distance variable.
+#define MINCAST_ID_LEN BNS_ID_LEN
 #define MINCAST_PING_TIMEOUT 10.0
+#define MINCAST_LOOKUP_TIMEOUT 2.0
 #define MINCAST_BUCKET_REFRESH_TIMEOUT 300
 #define MINCAST_PORT 8334
 #define MINCAST_PACKET_SIZE 1433
+#define MINCAST_REPORT_DELAY 1.0 // Seconds without new chunks from a sender before we report its losses
+#define MINCAST_INFORM_TIMEOUT 2.0 // Seconds after which an unanswered INFORM counts as not needed
+#define MINCAST_INFORM_SHARE 0.4 // Share of a full bucket sample informed instead of pushed without scores
+#define MINCAST_PULL_WAIT 0.05 // Seconds to collect further informers before pulling a block
+#define MINCAST_PULL_CHECK 1.0 // Seconds between progress checks of a pull
+#define MINCAST_PULL_SOURCES 4 // Informers a block is pulled from in parallel
+#define MINCAST_PULL_ROUNDS 10 // Request rounds before a pull is given up
+#define MINCAST_PULL_SLOW 0.25 // Sources below this share of the mean stripe completion are replaced
 
 namespace bns
 {
@@ -37,9 +51,6 @@ class Address;
 class Socket;
 class Packet;
 
-typedef std::bitset<64> nodeid_t;
-typedef std::pair<ns3::Ipv4Address, nodeid_t> bentry_t;
-
 struct MinChunk
 {
     uint16_t chunkID;
@@ -49,6 +60,41 @@ struct MinChunk
     uint16_t chunkSize;
     uint32_t blockHeight;
     uint16_t nChunks;
+    uint16_t nSent; //!< Chunks of the block sent to the receiver
+};
+
+/**
+ * \brief Chunks of a pulled block received from one sender since the stripes were requested
+ */
+struct PullStripe
+{
+    uint16_t nSent;     //!< Chunks the sender serves for its stripe, 0 until its first chunk
+    uint16_t nReceived; //!< Chunks received from the sender
+    uint16_t nChecked;  //!< nReceived at the last check
+};
+
+/**
+ * \brief Striped pull of an informed block.
+ * Source i of n serves the chunks whose ID is i modulo n.
+ */
+struct PullState
+{
+    std::vector<ns3::Ipv4Address> informers;          //!< Peers that informed us, in arrival order
+    std::vector<ns3::Ipv4Address> sources;            //!< Peers currently serving a stripe
+    std::unordered_map<uint32_t, PullStripe> stripes; //!< Stripe progress per sender
+    uint16_t nRounds;                                 //!< Request rounds so far
+};
+
+/**
+ * \brief Chunks of one block received from one sender, for the loss and goodput report
+ */
+struct ChunkReport
+{
+    uint16_t nReceived;
+    uint16_t nSent;
+    ns3::Time first;    //!< Arrival of the first chunk
+    ns3::Time last;     //!< Arrival of the latest chunk
+    uint32_t nBytes;    //!< Bytes of the chunks after the first one
 };
 
 class MincastNode : public BitcoinNode
@@ -67,7 +113,35 @@ public:
     static uint16_t kadAlpha;
     static uint16_t kadBeta;
     static double kadFecOverhead;
+    static uint32_t kadStateDepth;
+    static double kadRefreshInterval;
+    static bool kadFecAdaptive;
+    static ChunkOrder kadChunkOrder;
+    static double kadFecMin;
+    static double kadFecMax;
     static bool mincastUseScores;
+    static double announceDelay;
+    static uint16_t announceBatch;
+
+    /**
+         * \brief Metrics of all finished node lookups
+         */
+    std::vector<LookupStats> GetLookupStats();
+
+    /**
+         * \brief Mean FEC overhead chosen for the blocks we sent
+         */
+    double GetMeanFecOverhead();
+
+    /**
+         * \brief Share of the broadcast destinations we pushed the block to instead of informing
+         */
+    double GetPushShare();
+
+    /**
+         * \brief Batched INFORMs sent, with their mean size and the mean time a block ID waited
+         */
+    const AnnounceBatcher &GetAnnounces();
 
 protected:
     virtual void DoDispose(void); // inherited from Application base class.
@@ -81,9 +155,9 @@ protected:
     nodeid_t GenerateNodeID();
 
     /**
-         * \brief Generate a random ID in given interval.
+         * \brief Generate a random ID in the i-th bucket of this node
          */
-    nodeid_t RandomIDInInterval(uint64_t min, uint64_t max);
+    nodeid_t RandomIDInBucket(uint16_t i);
 
     /**
          * \brief Returns a random address from a bucket.
@@ -93,7 +167,7 @@ protected:
     /**
          * \brief Calculate the distance between two IDs
          */
-    uint64_t Distance(nodeid_t node1, nodeid_t node2);
+    nodeid_t Distance(const nodeid_t &node1, const nodeid_t &node2);
 
     /**
          * \brief Calculate the appropriate bucket index for a nodeid_t
@@ -139,15 +213,20 @@ protected:
     void HandleChunkMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, MinChunk c, uint16_t height);
 
     /**
-         * \brief Handle a received block request message.
+         * \brief Handle a received block request, for the whole block or one stripe of the missing chunks.
          */
-    void HandleRequestMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID);
+    void HandleRequestMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID, uint16_t share, uint16_t nShares, std::vector<uint64_t> &chunkBits);
 
     /**
          * \brief Handle a inform block request message.
          */
     void HandleInformMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID);
 
+    /**
+         * \brief Handle a received loss report on the chunks we sent.
+         */
+    void HandleReportMessage(ns3::Ipv4Address &senderAddr, nodeid_t &senderID, uint64_t blockID, uint16_t nReceived, uint16_t nSent, uint32_t goodput);
+
     /** 
          * \brief Send a ping message to a node
          */
@@ -176,12 +255,27 @@ protected:
     /**
          * \brief Send a block request message
          */
-    void SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID);
+    void SendRequestMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID, uint16_t share, uint16_t nShares, const std::vector<uint64_t> &chunkBits);
+
+    /**
+         * \brief Send one inform message for all block IDs of the inventory
+         */
+    void SendInformMessage(ns3::Ipv4Address &outgoingAddress, const std::vector<uint64_t> &inventory);
+
+    /**
+         * \brief Inform addr about a block, batched with the other blocks announced within announceDelay
+         */
+    void QueueInform(ns3::Ipv4Address addr, uint64_t blockID);
 
     /**
-         * \brief Send a block inform message
+         * \brief Send the batched informs of addr
          */
-    void SendInformMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID);
+    void FlushInforms(ns3::Ipv4Address addr);
+
+    /**
+         * \brief Send a report on how many of the nSent chunks of a block arrived from a node, and how fast
+         */
+    void SendReportMessage(ns3::Ipv4Address &outgoingAddress, uint64_t blockID, uint16_t nReceived, uint16_t nSent, uint32_t goodput);
 
     /**
          * \brief Initializ a node lookup
@@ -191,7 +285,12 @@ protected:
     /**
          * \brief Lookup a node based on the current state of m_nodeLookups map
          */
-    void LookupNode(nodeid_t &targetID, bool queryAll = false);
+    void LookupNode(nodeid_t &targetID);
+
+    /**
+         * \brief Is called when a find_node RPC of a lookup is expired.
+         */
+    void LookupTimeoutExpired(nodeid_t &targetID, nodeid_t dist);
 
     /**
          * \brief Initialize a broadcast operation
@@ -203,11 +302,38 @@ protected:
          */
     void BroadcastBlock(Block &b);
 
+    /**
+         * \brief Pick up to kadBeta random nodes of a bucket
+         */
+    std::vector<ns3::Ipv4Address> SampleBucket(uint16_t bIndex);
+
+    virtual void InitTxBroadcast(Tx &tx);
+
+    /**
+         * \brief Push a transaction into the subtree of height, it is too small to be worth an INFORM
+         */
+    void BroadcastTx(Tx &tx, uint16_t height);
+
+    /**
+         * \brief Send a transaction through the send queue shared with the blocks
+         */
+    void SendTxMessage(ns3::Ipv4Address &outgoingAddress, Tx &tx, uint16_t height);
+
     /**
          * \brief Actually chunkify and send a block
          */
     void SendBlock(ns3::Ipv4Address &outgoingAddress, Block &b, uint16_t height);
 
+    /**
+         * \brief Send a block to several (address, height) destinations, interleaving their chunks by kadChunkOrder
+         */
+    void SendBlock(std::vector<std::pair<ns3::Ipv4Address, uint16_t>> &dests, Block &b);
+
+    /**
+         * \brief Chunkify a block with the FEC overhead of a destination, in random transmission order
+         */
+    std::vector<MinChunk> PrepareChunks(ns3::Ipv4Address &outgoingAddress, Block &b);
+
     /**
          * \brief Refresh a known node
          */
@@ -219,94 +345,135 @@ protected:
     void RefreshTimeoutExpired(ns3::Ipv4Address &addr, nodeid_t node);
 
     /**
-         * \brief Periodically refresh buckets (every KAD_BUCKET_REFRESH_TIMEOUT seconds)
+         * \brief Periodically refresh buckets (every kadRefreshInterval seconds)
          */
     void PeriodicRefresh();
 
+    /**
+         * \brief Ping a node and evict it from its bucket if it does not answer
+         */
+    void CheckNode(ns3::Ipv4Address addr, nodeid_t nodeID);
+
+    /**
+         * \brief Check the liveness of all nodes not seen since the last refresh
+         */
+    void CheckBuckets();
+
     void RequestMissingBlock(ns3::Ipv4Address &senderAddr, uint64_t blockID);
 
-    void RequestInformedBlock(ns3::Ipv4Address &senderAddr, uint64_t blockID, int ct);
     /**
-         * \brief Refresh all buckets
+         * \brief Pull an informed block from the informers collected so far
          */
-    void RefreshBuckets();
+    void StartPull(uint64_t blockID);
 
     /**
-         * \brief Creates a fresh bucket or returns the existing one.
+         * \brief Request one stripe of the missing chunks from each of the fastest informers
          */
-    std::unordered_map<uint16_t, std::vector<bentry_t>>::iterator InitBucket(uint16_t i, std::unordered_map<uint16_t, std::vector<bentry_t>> &bm);
+    void RequestStripes(uint64_t blockID, PullState &pull);
 
     /**
-         * \brief Find a node in a bucket
+         * \brief Re-stripe a pull over the remaining informers if sources are slow.
+         * A source is slow if its stripe is not complete and it sent nothing
+         * since the last check or completed far less of it than the others.
          */
-    std::vector<bentry_t>::iterator FindInBucket(ns3::Ipv4Address &addr, std::vector<bentry_t> &bucket);
+    void CheckPull(uint64_t blockID);
 
     /**
-         * \brief Find pending node refresh data
+         * \brief Count a received chunk towards the loss report for its sender
          */
-    std::unordered_map<nodeid_t, std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t>>::iterator FindInRefreshes(nodeid_t nodeID);
+    void CountReportedChunk(ns3::Ipv4Address &senderAddr, MinChunk &c);
 
     /**
-         * \brief Encode a node id for transmission.
+         * \brief Report the losses of a sender, unless more of its chunks arrived since lastReceived
          */
-    uint64_t EncodeID(std::bitset<MINCAST_ID_LEN> &bs);
+    void ReportLoss(ns3::Ipv4Address addr, uint64_t blockID, uint16_t lastReceived);
 
     /**
-         * \brief Decode a trasmitted node ID.
+         * \brief Count an INFORM the peer did not answer with a REQUEST as not needed
          */
-    std::bitset<MINCAST_ID_LEN> DecodeID(uint64_t encoded);
+    void ExpireInform(ns3::Ipv4Address addr, uint64_t blockID);
 
     /**
-         * \brief Find the K closest nodes to a given node id
+         * \brief Push the block to addr (now or interleaved via dests) or inform it
+         */
+    void PushOrInform(ns3::Ipv4Address addr, Block &b, uint16_t bIndex, bool push, std::vector<std::pair<ns3::Ipv4Address, uint16_t>> &dests);
+
+    /**
+         * \brief Drop the reception state of blocks buried kadStateDepth blocks deep
+         */
+    void CollectBlockStates();
+    /**
+         * \brief Refresh all buckets
+         */
+    void RefreshBuckets();
+
+    /**
+         * \brief Creates a fresh bucket or returns the existing one.
          */
-    std::map<uint64_t, bentry_t> FindKClosestNodes(nodeid_t targetID);
+    std::unordered_map<uint16_t, std::vector<bentry_t>>::iterator InitBucket(uint16_t i, std::unordered_map<uint16_t, std::vector<bentry_t>> &bm);
+
+    /**
+         * \brief Find a node in a bucket
+         */
+    std::vector<bentry_t>::iterator FindInBucket(ns3::Ipv4Address &addr, std::vector<bentry_t> &bucket);
 
     /**
-         * \brief Mark that a node has already been queried for a specified find_node targetID
+         * \brief Find pending node refresh data
          */
-    void MarkQueried(nodeid_t &targetID, nodeid_t &nodeID);
+    std::unordered_map<nodeid_t, std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t>>::iterator FindInRefreshes(nodeid_t nodeID);
 
     /**
-         * \brief Check if a node has already been queried for a targetID
+         * \brief Find the K closest nodes to a given node id
          */
-    bool IsQueried(nodeid_t &targetID, nodeid_t &nodeID);
+    std::map<nodeid_t, bentry_t> FindKClosestNodes(nodeid_t targetID);
 
     /**
-         * \brief Terminate lookup
+         * \brief Terminate lookup and record its metrics
          */
-    void TerminateLookup(nodeid_t &targetID);
+    void TerminateLookup(nodeid_t &targetID, bool found = false, uint16_t foundHop = 0);
 
     void PrintBuckets();
 
     /**
          * \brief Create chunks out of blocks.
          */
-    std::map<uint16_t, MinChunk> Chunkify(Block b);
+    std::map<uint16_t, MinChunk> Chunkify(Block b, double fecOverhead);
 
     /**
-         * \brief Create blocks from chunks.
+         * \brief Create blocks from the reception state of its chunks.
          */
-    Block Dechunkify(std::map<uint16_t, MinChunk> chunks);
+    Block Dechunkify(const BlockState &state);
 
     nodeid_t m_nodeID;                                                                                            //!< The Kademlia node id of the Mincast peer.
     std::unordered_map<uint16_t, std::vector<bentry_t>> m_buckets;                                                //!< The k-buckets (one for every 0 =< i =< MINCAST_ID_LEN)
     std::unordered_map<nodeid_t, std::tuple<ns3::EventId, ns3::Ipv4Address, nodeid_t>> m_pendingRefreshes;        //!< Pending refreshed nodes.
-    std::unordered_map<nodeid_t, std::map<uint64_t, std::tuple<ns3::Ipv4Address, nodeid_t, bool>>> m_nodeLookups; //!< Lists all running node lookups, currently known k closest nodes by distance, and if they were queried
+    std::unordered_map<nodeid_t, NodeLookup> m_nodeLookups;                                                       //!< All running node lookups by target
+    std::vector<LookupStats> m_lookupStats;                                                                        //!< Metrics of finished lookups
+    std::unordered_map<nodeid_t, ns3::Time> m_lastSeen;                                                            //!< Last time we heard of a node
 
-    std::unordered_map<uint64_t, std::map<uint32_t, bool>> m_seenBroadcasts;
-    std::unordered_map<uint64_t, std::map<uint16_t, MinChunk>> m_receivedChunks;
-    std::unordered_map<uint64_t, uint16_t> m_maxSeenHeight;
-    std::unordered_map<uint64_t, bool> m_doneBlocks;
-
-    std::unordered_map<uint64_t, bool> m_requestedBlocks;
+    BlockStateTable m_blockStates; //!< Per-block chunk bitmap, seen height and done/requested flags
 
     std::deque<std::pair<ns3::Ipv4Address, ns3::Ptr<ns3::Packet>>> m_sendQueue;
 
+    LossEstimator m_lossEstimates;                                                          //!< Chunk loss towards the nodes we sent blocks to
+    std::map<std::pair<uint64_t, uint32_t>, ChunkReport> m_chunkReports;                   //!< Chunks received and sent, by block and sender
+    double m_fecOverheadSum;
+    uint32_t m_nFecChoices;
+
+    PeerEstimator m_peerEstimates;                                                          //!< RTT, goodput and block need per peer
+    std::unordered_map<ns3::Ipv4Address, ns3::Time, ns3::Ipv4AddressHash> m_pendingPings;  //!< Send time of unanswered pings
+    std::map<std::pair<uint64_t, uint32_t>, ns3::Time> m_pendingInforms;                   //!< Send time of unanswered informs, by block and peer
+    std::unordered_map<uint64_t, PullState> m_pulls;                                        //!< Running pulls by block
+    AnnounceBatcher m_informBatches;                                                        //!< Informs waiting to be sent, per peer
+    uint32_t m_nPushed;
+    uint32_t m_nInformed;
+
     std::set<uint16_t> m_activeBuckets;
 
     bool m_sending;
     int mincastScores = 0;
     ns3::EventId m_nextSend;
+    ns3::EventId m_nextRefresh;
 };
 
 } // namespace bns
@@ -0,0 +1,166 @@
+#include "miner-relay-messages.h"
+NS_LOG_COMPONENT_DEFINE ("BNSMinerRelayMessages");
+
+namespace bns {
+
+ns3::TypeId
+RelayChunkHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("RelayChunkHeader")
+	.SetParent<Header> ()
+	.AddConstructor<RelayChunkHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+RelayChunkHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+RelayChunkHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return RELAY_CHUNK_SIZE;
+}
+
+
+void 
+RelayChunkHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU64 (m_prevID);
+    start.WriteHtonU32 (m_blockSize);
+    start.WriteHtonU16 (m_chunkID);
+    start.WriteHtonU16 (m_nChunks);
+    start.WriteHtonU32 (m_origin);
+    start.WriteU8 (m_forward);
+}
+
+
+uint32_t 
+RelayChunkHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = start.ReadNtohU64 ();
+    m_prevID = start.ReadNtohU64 ();
+    m_blockSize = start.ReadNtohU32 ();
+    m_chunkID = start.ReadNtohU16 ();
+    m_nChunks = start.ReadNtohU16 ();
+    m_origin = start.ReadNtohU32 ();
+    m_forward = start.ReadU8 ();
+    return RELAY_CHUNK_SIZE;
+}
+
+
+void 
+RelayChunkHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "blockID=" << m_blockID << " chunkID=" << m_chunkID << "/" << m_nChunks << " forward=" << (uint32_t)m_forward;
+}
+
+void 
+RelayChunkHeader::SetBlockId (uint64_t blockID)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = blockID;
+}
+
+uint64_t 
+RelayChunkHeader::GetBlockId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockID;
+}
+
+void 
+RelayChunkHeader::SetPrevId (uint64_t prevID)
+{
+    NS_LOG_FUNCTION(this);
+    m_prevID = prevID;
+}
+
+uint64_t 
+RelayChunkHeader::GetPrevId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_prevID;
+}
+
+void 
+RelayChunkHeader::SetBlockSize (uint32_t blockSize)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockSize = blockSize;
+}
+
+uint32_t 
+RelayChunkHeader::GetBlockSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockSize;
+}
+
+void 
+RelayChunkHeader::SetChunkId (uint16_t chunkID)
+{
+    NS_LOG_FUNCTION(this);
+    m_chunkID = chunkID;
+}
+
+uint16_t 
+RelayChunkHeader::GetChunkId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_chunkID;
+}
+
+void 
+RelayChunkHeader::SetNChunks (uint16_t nChunks)
+{
+    NS_LOG_FUNCTION(this);
+    m_nChunks = nChunks;
+}
+
+uint16_t 
+RelayChunkHeader::GetNChunks (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_nChunks;
+}
+
+void 
+RelayChunkHeader::SetOrigin (uint32_t origin)
+{
+    NS_LOG_FUNCTION(this);
+    m_origin = origin;
+}
+
+uint32_t 
+RelayChunkHeader::GetOrigin (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_origin;
+}
+
+void 
+RelayChunkHeader::SetForward (uint8_t forward)
+{
+    NS_LOG_FUNCTION(this);
+    m_forward = forward;
+}
+
+uint8_t 
+RelayChunkHeader::GetForward (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_forward;
+}
+}
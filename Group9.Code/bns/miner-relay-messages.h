@@ -0,0 +1,58 @@
+#ifndef MINER_RELAY_MESSAGES_H
+#define MINER_RELAY_MESSAGES_H
+
+#include "ns3/header.h"
+#include "ns3/log.h"
+
+// define field sizes for the headers
+#define RELAY_CHUNK_SIZE 8 + 8 + 4 + 2 + 2 + 4 + 1 // blockID + prevID + blockSize + chunkID + nChunks + origin + forward
+
+namespace bns {
+
+/**
+ * \brief One FEC chunk of a block on the miner relay.
+ * nChunks is the number of data chunks, any nChunks distinct chunks rebuild
+ * the block. forward tells the receiver to pass the chunk on to the other miners.
+ */
+class RelayChunkHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetBlockId (uint64_t blockID);
+		uint64_t GetBlockId (void) const;
+
+		void SetPrevId (uint64_t prevID);
+		uint64_t GetPrevId (void) const;
+
+		void SetBlockSize (uint32_t blockSize);
+		uint32_t GetBlockSize (void) const;
+
+		void SetChunkId (uint16_t chunkID);
+		uint16_t GetChunkId (void) const;
+
+		void SetNChunks (uint16_t nChunks);
+		uint16_t GetNChunks (void) const;
+
+		void SetOrigin (uint32_t origin);
+		uint32_t GetOrigin (void) const;
+
+		void SetForward (uint8_t forward);
+		uint8_t GetForward (void) const;
+
+	private:
+		uint64_t m_blockID;
+		uint64_t m_prevID;
+		uint32_t m_blockSize;
+		uint16_t m_chunkID;
+		uint16_t m_nChunks;
+		uint32_t m_origin;
+		uint8_t m_forward;
+};
+}
+#endif
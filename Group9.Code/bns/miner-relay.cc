@@ -0,0 +1,240 @@
+#include <cmath>
+#include "ns3/data-rate.h"
+#include "ns3/drop-tail-queue.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/simulator.h"
+#include "ns3/udp-socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include "bitcoin-miner.h"
+#include "bitcoin-node.h"
+#include "miner-relay.h"
+#include "util.h"
+
+NS_LOG_COMPONENT_DEFINE("BNSMinerRelay");
+
+namespace bns
+{
+
+double MinerRelay::relayFecOverhead = 0.2;
+
+MinerRelay::MinerRelay(BitcoinNode *node, ns3::Ipv4Address address) : m_node(node), m_address(address), m_socket(0), m_nRelayedBlocks(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+MinerRelay::~MinerRelay(void)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void MinerRelay::DoDispose(void)
+{
+    NS_LOG_FUNCTION(this);
+    m_socket = 0;
+    m_node = nullptr;
+    Application::DoDispose();
+}
+
+void MinerRelay::StartApplication(void)
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_socket)
+    {
+        m_socket = ns3::Socket::CreateSocket(GetNode(), ns3::UdpSocketFactory::GetTypeId());
+        m_socket->Bind(ns3::InetSocketAddress(m_address, RELAY_PORT));
+
+        ns3::Ptr<ns3::UdpSocket> sock = ns3::DynamicCast<ns3::UdpSocket>(m_socket);
+        uint32_t bufSize = 5 * 1024 * 1024 * BitcoinMiner::blockSizeFactor;
+        sock->SetAttribute("RcvBufSize", ns3::UintegerValue(bufSize));
+
+        m_socket->SetRecvCallback(ns3::MakeCallback(&MinerRelay::HandleRead, this));
+    }
+    m_expire = ns3::Simulator::Schedule(ns3::Seconds(RELAY_STATE_TIMEOUT), &MinerRelay::ExpireStates, this);
+}
+
+void MinerRelay::StopApplication(void)
+{
+    NS_LOG_FUNCTION(this);
+    if (m_socket)
+    {
+        m_socket->Close();
+        m_socket = 0;
+    }
+    m_sendQueue.clear();
+    ns3::Simulator::Cancel(m_nextSend);
+    ns3::Simulator::Cancel(m_expire);
+}
+
+void MinerRelay::SetMiners(const std::vector<ns3::Ipv4Address> &miners)
+{
+    m_miners.clear();
+    for (auto &addr : miners)
+    {
+        if (addr != m_address)
+            m_miners.push_back(addr);
+    }
+}
+
+void MinerRelay::Relay(const Block &b)
+{
+    RelayState &state = m_states[b.blockID];
+    if (state.done)
+        return; // rebuilt from the relay or sent already
+    state.done = true;
+    state.doneAt = ns3::Simulator::Now();
+    state.chunks.clear();
+
+    if (m_miners.empty() || !m_socket)
+        return;
+
+    uint16_t payload = RELAY_PACKET_SIZE - RelayChunkHeader().GetSerializedSize();
+    uint16_t nChunks = std::max<uint32_t>(1, (b.blockSize + payload - 1) / payload);
+    uint16_t nSent = std::ceil(nChunks * (1 + MinerRelay::relayFecOverhead));
+    NS_LOG_INFO("Relaying block " << b.blockID << " to " << m_miners.size() << " miners in " << nSent << " chunks (" << nChunks << " needed)");
+
+    RelayChunkHeader ch;
+    ch.SetBlockId(b.blockID);
+    ch.SetPrevId(b.prevID);
+    ch.SetBlockSize(b.blockSize);
+    ch.SetNChunks(nChunks);
+    ch.SetOrigin(m_address.Get());
+    ch.SetForward(1);
+
+    // every miner gets a stripe directly and forwards it to the others
+    for (uint16_t i = 0; i < nSent; i++)
+    {
+        ch.SetChunkId(i);
+        SendChunk(m_miners[i % m_miners.size()], ch, payload);
+    }
+}
+
+uint32_t
+MinerRelay::GetNRelayedBlocks()
+{
+    return m_nRelayedBlocks;
+}
+
+void MinerRelay::SendChunk(ns3::Ipv4Address addr, const RelayChunkHeader &ch, uint32_t chunkSize)
+{
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(chunkSize);
+    packet->AddHeader(ch);
+    m_sendQueue.push_back({addr, packet});
+    SendAvailable();
+}
+
+void MinerRelay::SendAvailable(void)
+{
+    if (!m_socket)
+    {
+        m_sendQueue.clear();
+        return;
+    }
+    if (m_sendQueue.empty())
+        return;
+
+    ns3::Ptr<ns3::PointToPointNetDevice> dev = ns3::DynamicCast<ns3::PointToPointNetDevice>(GetNode()->GetDevice(0));
+    ns3::Ptr<ns3::DropTailQueue<ns3::Packet>> queue = ns3::DynamicCast<ns3::DropTailQueue<ns3::Packet>>(dev->GetQueue());
+
+    // only keep a small backlog in the device queue, the public stack shares the link
+    uint32_t backlog = queue->GetNBytes();
+    while (backlog < RELAY_SEND_BACKLOG && !m_sendQueue.empty())
+    {
+        ns3::Ipv4Address nextAddr = m_sendQueue.front().first;
+        ns3::Ptr<ns3::Packet> nextPacket = m_sendQueue.front().second;
+        m_sendQueue.pop_front();
+
+        int sent = m_socket->SendTo(nextPacket, 0, ns3::InetSocketAddress(nextAddr, RELAY_PORT));
+        if (sent == -1)
+            NS_LOG_WARN("Error sending packet: " << show_errno(m_socket->GetErrno()));
+        backlog = queue->GetNBytes();
+    }
+
+    // come back when half of the backlog is on the wire
+    ns3::Simulator::Cancel(m_nextSend);
+    if (!m_sendQueue.empty())
+    {
+        ns3::DataRateValue rate;
+        dev->GetAttribute("DataRate", rate);
+        ns3::Time sendTime = std::max(rate.Get().CalculateBytesTxTime(backlog / 2), ns3::MicroSeconds(100));
+        m_nextSend = ns3::Simulator::Schedule(sendTime, &MinerRelay::SendAvailable, this);
+    }
+}
+
+void MinerRelay::HandleRead(ns3::Ptr<ns3::Socket> socketPtr)
+{
+    NS_LOG_FUNCTION(this << socketPtr);
+    ns3::Ptr<ns3::Packet> packet;
+    ns3::Address from;
+    while ((packet = socketPtr->RecvFrom(from)))
+    {
+        RelayChunkHeader ch;
+        packet->RemoveHeader(ch);
+        HandleChunk(ch, packet->GetSize());
+    }
+}
+
+void MinerRelay::HandleChunk(RelayChunkHeader &ch, uint32_t chunkSize)
+{
+    // cut-through: pass our stripe on before looking at the block
+    if (ch.GetForward() == 1)
+    {
+        ns3::Ipv4Address origin(ch.GetOrigin());
+        ch.SetForward(0);
+        for (auto &addr : m_miners)
+        {
+            if (addr != origin)
+                SendChunk(addr, ch, chunkSize);
+        }
+    }
+
+    uint64_t blockID = ch.GetBlockId();
+    if (m_states.count(blockID) == 0 && m_node->GetBlockchain()->HasBlock(blockID))
+        return; // a late chunk of a block whose state expired
+    RelayState &state = m_states[blockID];
+    if (state.done)
+        return;
+
+    if (state.chunks.empty())
+    {
+        state.firstChunk = ns3::Simulator::Now();
+        m_node->SetTTFB(blockID, ns3::Simulator::Now());
+    }
+    state.chunks.insert(ch.GetChunkId());
+    if (state.chunks.size() < ch.GetNChunks())
+        return;
+
+    state.done = true;
+    state.doneAt = ns3::Simulator::Now();
+    state.chunks.clear();
+    if (m_node->GetBlockchain()->HasBlock(blockID))
+        return;
+
+    NS_LOG_INFO("Rebuilt relayed block " << blockID);
+    m_nRelayedBlocks++;
+    Block b = Blockchain::GetNewBlock(blockID, ch.GetPrevId(), ch.GetBlockSize());
+    m_node->SetTTLB(blockID, ns3::Simulator::Now());
+    ns3::Time delay = m_node->GetValidationDelay(b);
+    ns3::Simulator::Schedule(delay, &BitcoinNode::NotifyNewBlock, m_node, b, false);
+}
+
+void MinerRelay::ExpireStates(void)
+{
+    ns3::Time now = ns3::Simulator::Now();
+    for (auto it = std::begin(m_states); it != std::end(m_states);)
+    {
+        RelayState &state = it->second;
+        if (now - (state.done ? state.doneAt : state.firstChunk) > ns3::Seconds(RELAY_STATE_TIMEOUT))
+            it = m_states.erase(it);
+        else
+            ++it;
+    }
+    m_expire = ns3::Simulator::Schedule(ns3::Seconds(RELAY_STATE_TIMEOUT), &MinerRelay::ExpireStates, this);
+}
+
+} // namespace bns
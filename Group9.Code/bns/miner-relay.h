@@ -0,0 +1,109 @@
+/**
+ * This file declares the MinerRelay class, a FIBRE-style block relay among
+ * the miners that runs next to the public network stack.
+ */
+
+#ifndef MINER_RELAY_H
+#define MINER_RELAY_H
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ptr.h"
+#include "ns3/socket.h"
+
+#include "blockchain.h"
+#include "miner-relay-messages.h"
+
+#define RELAY_PORT 8336
+#define RELAY_PACKET_SIZE 1152                      // Bytes per UDP packet, as in FIBRE
+#define RELAY_SEND_BACKLOG (32 * RELAY_PACKET_SIZE) // Bytes we let pile up in the device queue
+#define RELAY_STATE_TIMEOUT 600                     // Seconds the chunks of an undecoded block, or the state of a done one, are kept
+
+namespace bns
+{
+
+class BitcoinNode;
+
+/**
+ * \brief UDP relay of blocks between all miners, with FEC and cut-through forwarding.
+ * The origin cuts a block into chunks plus relayFecOverhead redundant ones
+ * and sends them round robin to the other miners, every receiver forwards
+ * the chunks it got from the origin to all other miners at once, before it
+ * has the whole block. A miner rebuilds the block from any nChunks distinct
+ * chunks and hands it to its node, which validates it and passes it on
+ * through the public network stack. Blocks a miner gets from the public
+ * network enter the relay the same way once they are valid.
+ */
+class MinerRelay : public ns3::Application
+{
+public:
+    MinerRelay(BitcoinNode *node, ns3::Ipv4Address address);
+
+    virtual ~MinerRelay(void);
+
+    static double relayFecOverhead;
+
+    /**
+     * \brief Set the addresses of the other miners
+     */
+    void SetMiners(const std::vector<ns3::Ipv4Address> &miners);
+
+    /**
+     * \brief Send a block to the other miners, unless it came over the relay
+     */
+    void Relay(const Block &b);
+
+    /**
+     * \brief Blocks rebuilt from relayed chunks before the node had them
+     */
+    uint32_t GetNRelayedBlocks();
+
+protected:
+    virtual void DoDispose(void);
+
+    virtual void StartApplication(void);
+    virtual void StopApplication(void);
+
+    void SendChunk(ns3::Ipv4Address addr, const RelayChunkHeader &ch, uint32_t chunkSize);
+
+    /**
+     * \brief Move queued chunks to the device while its queue is short
+     */
+    void SendAvailable(void);
+
+    void HandleRead(ns3::Ptr<ns3::Socket> socketPtr);
+
+    void HandleChunk(RelayChunkHeader &ch, uint32_t chunkSize);
+
+    /**
+     * \brief Forget blocks that could not be rebuilt in time, and blocks done long ago
+     */
+    void ExpireStates(void);
+
+private:
+    struct RelayState
+    {
+        std::set<uint16_t> chunks;
+        ns3::Time firstChunk;
+        ns3::Time doneAt; //!< When the block was rebuilt or sent
+        bool done = false;
+    };
+
+    BitcoinNode *m_node;
+    ns3::Ipv4Address m_address;
+    ns3::Ptr<ns3::Socket> m_socket;
+    std::vector<ns3::Ipv4Address> m_miners;
+    std::unordered_map<uint64_t, RelayState> m_states;
+    std::deque<std::pair<ns3::Ipv4Address, ns3::Ptr<ns3::Packet>>> m_sendQueue;
+    ns3::EventId m_nextSend;
+    ns3::EventId m_expire;
+    uint32_t m_nRelayedBlocks;
+};
+
+} // namespace bns
+#endif /* MINER_RELAY_H */
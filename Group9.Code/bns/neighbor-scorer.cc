@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <limits>
+#include "ns3/simulator.h"
+#include "neighbor-scorer.h"
+
+namespace bns
+{
+
+NeighborScorer::NeighborScorer()
+{
+}
+
+void NeighborScorer::AddPeer(ns3::Ipv4Address addr)
+{
+    m_connected[addr] = ns3::Simulator::Now();
+}
+
+void NeighborScorer::RemovePeer(ns3::Ipv4Address addr)
+{
+    m_connected.erase(addr);
+}
+
+void NeighborScorer::Observe(uint64_t blockID, ns3::Ipv4Address addr)
+{
+    ns3::Time now = ns3::Simulator::Now();
+    auto it = m_blocks.find(blockID);
+    if (it == std::end(m_blocks))
+        it = m_blocks.insert({blockID, {now, {}}}).first;
+
+    // only the first announcement of every peer counts
+    BlockObservation &o = it->second;
+    if (o.delays.count(addr) == 0)
+        o.delays[addr] = now - o.firstSeen;
+}
+
+uint32_t
+NeighborScorer::GetNBlocks() const
+{
+    return m_blocks.size();
+}
+
+double
+NeighborScorer::GetScore(ns3::Ipv4Address addr, double p) const
+{
+    auto cIt = m_connected.find(addr);
+    if (cIt == std::end(m_connected))
+        return 0;
+
+    std::vector<double> delays;
+    for (auto &b : m_blocks)
+    {
+        if (b.second.firstSeen < cIt->second)
+            continue;
+        auto dIt = b.second.delays.find(addr);
+        if (dIt == std::end(b.second.delays))
+            delays.push_back(std::numeric_limits<double>::infinity());
+        else
+            delays.push_back(dIt->second.GetSeconds());
+    }
+    if (delays.empty())
+        return 0;
+
+    uint32_t k = std::min((uint32_t)(p * delays.size()), (uint32_t)delays.size() - 1);
+    std::nth_element(std::begin(delays), std::begin(delays) + k, std::end(delays));
+    return delays[k];
+}
+
+bool NeighborScorer::FindWorst(const std::vector<ns3::Ipv4Address> &candidates, double p, ns3::Ipv4Address &worst) const
+{
+    bool found = false;
+    double worstScore = -1;
+    for (auto &addr : candidates)
+    {
+        auto cIt = m_connected.find(addr);
+        if (cIt == std::end(m_connected))
+            continue;
+        // peers that connected after the last block of the round have nothing to be judged on
+        bool judged = std::any_of(std::begin(m_blocks), std::end(m_blocks), [&cIt](const std::pair<const uint64_t, BlockObservation> &b) { return b.second.firstSeen >= cIt->second; });
+        if (!judged)
+            continue;
+
+        double score = GetScore(addr, p);
+        if (score > worstScore)
+        {
+            worstScore = score;
+            worst = addr;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void NeighborScorer::Reset()
+{
+    m_blocks.clear();
+}
+
+void NeighborScorer::Clear()
+{
+    m_blocks.clear();
+    m_connected.clear();
+}
+
+} // namespace bns
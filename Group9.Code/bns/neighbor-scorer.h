@@ -0,0 +1,76 @@
+/**
+ * This file declares the Perigee-style scoring of outgoing peers by how early
+ * they announce new blocks.
+ */
+
+#ifndef NEIGHBOR_SCORER_H
+#define NEIGHBOR_SCORER_H
+
+#include <unordered_map>
+#include <vector>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+namespace bns
+{
+
+/**
+ * \brief Delay of every peer's first announcement of a block behind the earliest one, per round.
+ * A round covers the blocks first seen since the last Reset. A peer scores
+ * the given percentile of its delays over the blocks of the round that were
+ * first seen after it connected; blocks it did not announce count as
+ * infinitely late. The highest score marks the peer to replace.
+ */
+class NeighborScorer
+{
+public:
+    NeighborScorer();
+
+    /**
+     * \brief Remember when addr connected, only later blocks count for it
+     */
+    void AddPeer(ns3::Ipv4Address addr);
+
+    void RemovePeer(ns3::Ipv4Address addr);
+
+    /**
+     * \brief addr announced or sent blockID now
+     */
+    void Observe(uint64_t blockID, ns3::Ipv4Address addr);
+
+    /**
+     * \brief Number of blocks first seen in this round
+     */
+    uint32_t GetNBlocks() const;
+
+    /**
+     * \brief Score of addr in seconds, the percentile p of its delays
+     */
+    double GetScore(ns3::Ipv4Address addr, double p) const;
+
+    /**
+     * \brief The peer among candidates with the highest score
+     * \return false if no candidate was connected for any block of the round
+     */
+    bool FindWorst(const std::vector<ns3::Ipv4Address> &candidates, double p, ns3::Ipv4Address &worst) const;
+
+    /**
+     * \brief Start a new round
+     */
+    void Reset();
+
+    void Clear();
+
+private:
+    struct BlockObservation
+    {
+        ns3::Time firstSeen;
+        std::unordered_map<ns3::Ipv4Address, ns3::Time, ns3::Ipv4AddressHash> delays;
+    };
+
+    std::unordered_map<uint64_t, BlockObservation> m_blocks;
+    std::unordered_map<ns3::Ipv4Address, ns3::Time, ns3::Ipv4AddressHash> m_connected;
+};
+
+} // namespace bns
+#endif /* NEIGHBOR_SCORER_H */
@@ -0,0 +1,137 @@
+#include <bitset>
+#include <chrono>
+#include <map>
+#include <vector>
+#include "ns3/log.h"
+#include "node-id.h"
+#include "node-id-bench.h"
+#include "util.h"
+
+NS_LOG_COMPONENT_DEFINE("BNSNodeIdBench");
+
+namespace bns
+{
+
+struct BenchResult
+{
+    double bucketNs;  //!< Nanoseconds per bucket index
+    double closestNs; //!< Nanoseconds per k-closest selection
+    uint64_t sink;    //!< Keeps the compiler from dropping the work
+};
+
+static double
+ElapsedNs(std::chrono::steady_clock::time_point start, uint64_t nOps)
+{
+    std::chrono::duration<double, std::nano> d = std::chrono::steady_clock::now() - start;
+    return d.count() / nOps;
+}
+
+/**
+ * \brief The 64 bit path before multi-word IDs
+ */
+static BenchResult
+BenchLegacy(const std::vector<NodeId<64>> &table, const std::vector<NodeId<64>> &targets, uint16_t k)
+{
+    std::vector<std::bitset<64>> ids;
+    for (auto &id : table)
+        ids.push_back(std::bitset<64>(id.GetLow()));
+
+    BenchResult res = {0, 0, 0};
+    auto start = std::chrono::steady_clock::now();
+    for (auto &t : targets)
+    {
+        std::bitset<64> self(t.GetLow());
+        for (auto &id : ids)
+        {
+            uint64_t d = (self ^ id).to_ulong();
+            for (short i = 0; i < 64; ++i)
+            {
+                if (d >= pow2(i) && d < pow2(i + 1))
+                {
+                    res.sink += i;
+                    break;
+                }
+            }
+        }
+    }
+    res.bucketNs = ElapsedNs(start, (uint64_t)targets.size() * ids.size());
+
+    start = std::chrono::steady_clock::now();
+    for (auto &t : targets)
+    {
+        std::bitset<64> target(t.GetLow());
+        std::map<uint64_t, uint32_t> closest;
+        for (uint32_t i = 0; i < ids.size(); i++)
+        {
+            closest[(target ^ ids[i]).to_ulong()] = i;
+            if (closest.size() > k)
+                closest.erase(std::prev(std::end(closest)));
+        }
+        res.sink += std::begin(closest)->second;
+    }
+    res.closestNs = ElapsedNs(start, targets.size());
+    return res;
+}
+
+template <uint16_t BITS>
+static BenchResult
+BenchWidth(uint32_t nIds, uint16_t k, uint32_t nRounds, ns3::Ptr<ns3::UniformRandomVariable> x)
+{
+    std::vector<NodeId<BITS>> ids;
+    std::vector<NodeId<BITS>> targets;
+    for (uint32_t i = 0; i < nIds; i++)
+        ids.push_back(NodeId<BITS>::Random(x));
+    for (uint32_t i = 0; i < nRounds; i++)
+        targets.push_back(NodeId<BITS>::Random(x));
+
+    BenchResult res = {0, 0, 0};
+    auto start = std::chrono::steady_clock::now();
+    for (auto &t : targets)
+    {
+        for (auto &id : ids)
+            res.sink += NodeId<BITS>::BucketIndex(t, id);
+    }
+    res.bucketNs = ElapsedNs(start, (uint64_t)nRounds * nIds);
+
+    // same selection as FindKClosestNodes
+    start = std::chrono::steady_clock::now();
+    for (auto &t : targets)
+    {
+        std::map<NodeId<BITS>, uint32_t> closest;
+        for (uint32_t i = 0; i < ids.size(); i++)
+        {
+            closest[t ^ ids[i]] = i;
+            if (closest.size() > k)
+                closest.erase(std::prev(std::end(closest)));
+        }
+        res.sink += std::begin(closest)->second;
+    }
+    res.closestNs = ElapsedNs(start, nRounds);
+    return res;
+}
+
+void BenchmarkNodeIds(uint32_t nIds, uint16_t k, uint32_t nRounds)
+{
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+
+    std::vector<NodeId<64>> table;
+    std::vector<NodeId<64>> targets;
+    for (uint32_t i = 0; i < nIds; i++)
+        table.push_back(NodeId<64>::Random(x));
+    for (uint32_t i = 0; i < nRounds; i++)
+        targets.push_back(NodeId<64>::Random(x));
+
+    BenchResult legacy = BenchLegacy(table, targets, k);
+    BenchResult r64 = BenchWidth<64>(nIds, k, nRounds, x);
+    BenchResult r160 = BenchWidth<160>(nIds, k, nRounds, x);
+    BenchResult r256 = BenchWidth<256>(nIds, k, nRounds, x);
+
+    NS_LOG_INFO("Node ID benchmark: " << nIds << " IDs, k = " << k << ", " << nRounds << " targets (checksum " << (legacy.sink ^ r64.sink ^ r160.sink ^ r256.sink) << ")");
+    NS_LOG_INFO("width,bucketNs,closestNs,bucketFactor,closestFactor");
+    NS_LOG_INFO("bitset64," << legacy.bucketNs << "," << legacy.closestNs << "," << legacy.bucketNs / r64.bucketNs << "," << legacy.closestNs / r64.closestNs);
+    NS_LOG_INFO("64," << r64.bucketNs << "," << r64.closestNs << ",1,1");
+    NS_LOG_INFO("160," << r160.bucketNs << "," << r160.closestNs << "," << r160.bucketNs / r64.bucketNs << "," << r160.closestNs / r64.closestNs);
+    NS_LOG_INFO("256," << r256.bucketNs << "," << r256.closestNs << "," << r256.bucketNs / r64.bucketNs << "," << r256.closestNs / r64.closestNs);
+}
+
+} // namespace bns
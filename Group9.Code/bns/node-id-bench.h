@@ -0,0 +1,25 @@
+/**
+ * This file declares the microbenchmark of the node ID distance kernels.
+ */
+
+#ifndef NODE_ID_BENCH_H
+#define NODE_ID_BENCH_H
+
+#include <stdint.h>
+
+namespace bns
+{
+
+/**
+ * \brief Time bucket index and k-closest selection for 64, 160 and 256 bit IDs.
+ * Compares the multi-word NodeId kernels against the former bitset<64> path
+ * (to_ulong distance, power of two search for the bucket) and logs the cost
+ * per operation and relative to the 64 bit kernel.
+ * \param nIds size of the simulated routing table
+ * \param k number of closest nodes to select
+ * \param nRounds number of targets to look up
+ */
+void BenchmarkNodeIds(uint32_t nIds, uint16_t k, uint32_t nRounds);
+
+} // namespace bns
+#endif /* NODE_ID_BENCH_H */
@@ -0,0 +1,250 @@
+/**
+ * This file declares the node IDs of the Kadcast and Mincast overlays.
+ */
+
+#ifndef NODE_ID_H
+#define NODE_ID_H
+
+#include <assert.h>
+#include <functional>
+#include <ostream>
+#include <stdint.h>
+#include "ns3/buffer.h"
+#include "ns3/ptr.h"
+#include "ns3/random-variable-stream.h"
+
+#ifndef BNS_ID_LEN
+#define BNS_ID_LEN 64 // ID width of the overlays in bits, a multiple of 32 (e.g. 160 or 256 for real Kademlia deployments)
+#endif
+
+namespace bns
+{
+
+/**
+ * \brief Fixed-width Kademlia ID of BITS bits, stored as 64 bit words.
+ * Word 0 is the most significant one and only holds the top BITS % 64 bits
+ * if BITS is not a multiple of 64, all unused bits stay zero. XOR and
+ * comparisons are word loops of fixed length the compiler unrolls and
+ * vectorizes, the bucket index is a leading zero count on the first
+ * differing word.
+ */
+template <uint16_t BITS>
+class NodeId
+{
+    static_assert(BITS > 0 && BITS % 32 == 0, "ID width must be a multiple of 32 bits");
+
+public:
+    static constexpr uint16_t WORDS = (BITS + 63) / 64;
+    static constexpr uint32_t SIZE = BITS / 8;                         //!< Bytes on the wire
+    static constexpr uint16_t TOP_BITS = BITS - (WORDS - 1) * 64;      //!< Used bits of word 0
+    static constexpr uint64_t TOP_MASK = TOP_BITS == 64 ? ~0ULL : (1ULL << TOP_BITS) - 1;
+
+    NodeId()
+    {
+        for (uint16_t i = 0; i < WORDS; i++)
+            m_words[i] = 0;
+    }
+
+    /**
+     * \brief ID with the given value in its lowest 64 bits
+     */
+    explicit NodeId(uint64_t low) : NodeId()
+    {
+        m_words[WORDS - 1] = low & (WORDS == 1 ? TOP_MASK : ~0ULL);
+    }
+
+    /**
+     * \brief Uniformly random ID
+     */
+    static NodeId Random(ns3::Ptr<ns3::UniformRandomVariable> x)
+    {
+        NodeId id;
+        for (uint16_t i = 0; i < WORDS; i++)
+        {
+            uint64_t hi = x->GetInteger(0, UINT32_MAX);
+            uint64_t lo = x->GetInteger(0, UINT32_MAX);
+            id.m_words[i] = (hi << 32) | lo;
+        }
+        id.m_words[0] &= TOP_MASK;
+        return id;
+    }
+
+    /**
+     * \brief Random distance whose highest set bit is bit, i.e. in [2^bit, 2^(bit+1))
+     */
+    static NodeId RandomWithTopBit(ns3::Ptr<ns3::UniformRandomVariable> x, uint16_t bit)
+    {
+        NodeId id = Random(x);
+        uint16_t w = WordOf(bit);
+        uint16_t b = bit % 64;
+        for (uint16_t i = 0; i < w; i++)
+            id.m_words[i] = 0;
+        id.m_words[w] &= b == 63 ? ~0ULL : (1ULL << (b + 1)) - 1;
+        id.m_words[w] |= 1ULL << b;
+        return id;
+    }
+
+    /**
+     * \brief Overwrite the highest nBits bits with prefix (nBits <= TOP_BITS)
+     */
+    void SetPrefix(uint64_t prefix, uint16_t nBits)
+    {
+        assert(nBits > 0 && nBits <= TOP_BITS);
+        uint16_t shift = TOP_BITS - nBits;
+        uint64_t mask = (nBits == 64 ? ~0ULL : (1ULL << nBits) - 1) << shift;
+        m_words[0] = (m_words[0] & ~mask) | ((prefix << shift) & mask);
+    }
+
+    NodeId operator^(const NodeId &o) const
+    {
+        NodeId r;
+        for (uint16_t i = 0; i < WORDS; i++)
+            r.m_words[i] = m_words[i] ^ o.m_words[i];
+        return r;
+    }
+
+    bool operator==(const NodeId &o) const
+    {
+        uint64_t diff = 0;
+        for (uint16_t i = 0; i < WORDS; i++)
+            diff |= m_words[i] ^ o.m_words[i];
+        return diff == 0;
+    }
+
+    bool operator!=(const NodeId &o) const
+    {
+        return !(*this == o);
+    }
+
+    bool operator<(const NodeId &o) const
+    {
+        for (uint16_t i = 0; i < WORDS; i++)
+        {
+            if (m_words[i] != o.m_words[i])
+                return m_words[i] < o.m_words[i];
+        }
+        return false;
+    }
+
+    bool operator>(const NodeId &o) const
+    {
+        return o < *this;
+    }
+
+    bool IsZero() const
+    {
+        return *this == NodeId();
+    }
+
+    /**
+     * \brief Number of leading zero bits, BITS for the zero ID
+     */
+    uint16_t LeadingZeros() const
+    {
+        for (uint16_t i = 0; i < WORDS; i++)
+        {
+            if (m_words[i] != 0)
+                return i * 64 - (64 - TOP_BITS) + __builtin_clzll(m_words[i]);
+        }
+        return BITS;
+    }
+
+    /**
+     * \brief Index of the highest set bit, i.e. the k-bucket of a distance (0 for the zero ID)
+     */
+    uint16_t BucketIndex() const
+    {
+        uint16_t lz = LeadingZeros();
+        return lz >= BITS ? 0 : BITS - 1 - lz;
+    }
+
+    /**
+     * \brief Bucket index of the distance between a and b, without building the distance
+     */
+    static uint16_t BucketIndex(const NodeId &a, const NodeId &b)
+    {
+        for (uint16_t i = 0; i < WORDS; i++)
+        {
+            uint64_t d = a.m_words[i] ^ b.m_words[i];
+            if (d != 0)
+                return BITS - 1 - (i * 64 - (64 - TOP_BITS) + __builtin_clzll(d));
+        }
+        return 0;
+    }
+
+    uint64_t GetWord(uint16_t i) const
+    {
+        return m_words[i];
+    }
+
+    /**
+     * \brief Lowest 64 bits, e.g. for hashing
+     */
+    uint64_t GetLow() const
+    {
+        return m_words[WORDS - 1];
+    }
+
+    void Serialize(ns3::Buffer::Iterator &start) const
+    {
+        if (TOP_BITS == 32)
+            start.WriteHtonU32(m_words[0]);
+        else
+            start.WriteHtonU64(m_words[0]);
+        for (uint16_t i = 1; i < WORDS; i++)
+            start.WriteHtonU64(m_words[i]);
+    }
+
+    void Deserialize(ns3::Buffer::Iterator &start)
+    {
+        if (TOP_BITS == 32)
+            m_words[0] = start.ReadNtohU32();
+        else
+            m_words[0] = start.ReadNtohU64();
+        for (uint16_t i = 1; i < WORDS; i++)
+            m_words[i] = start.ReadNtohU64();
+    }
+
+private:
+    static uint16_t WordOf(uint16_t bit)
+    {
+        return WORDS - 1 - bit / 64;
+    }
+
+    uint64_t m_words[WORDS];
+};
+
+template <uint16_t BITS>
+std::ostream &operator<<(std::ostream &os, const NodeId<BITS> &id)
+{
+    std::ios::fmtflags flags = os.flags();
+    char fill = os.fill('0');
+    os << std::hex;
+    for (uint16_t i = 0; i < NodeId<BITS>::WORDS; i++)
+    {
+        os.width(i == 0 ? NodeId<BITS>::TOP_BITS / 4 : 16);
+        os << id.GetWord(i);
+    }
+    os.fill(fill);
+    os.flags(flags);
+    return os;
+}
+
+typedef NodeId<BNS_ID_LEN> nodeid_t;
+
+} // namespace bns
+
+namespace std
+{
+template <uint16_t BITS>
+struct hash<bns::NodeId<BITS>>
+{
+    size_t operator()(const bns::NodeId<BITS> &id) const
+    {
+        // IDs are uniformly random, the lowest word is a good hash
+        return std::hash<uint64_t>()(id.GetLow());
+    }
+};
+} // namespace std
+
+#endif /* NODE_ID_H */
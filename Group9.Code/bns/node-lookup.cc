@@ -0,0 +1,147 @@
+#include "ns3/simulator.h"
+#include "node-lookup.h"
+
+namespace bns
+{
+
+NodeLookup::NodeLookup(nodeid_t targetID, uint16_t k, uint16_t alpha) : m_targetID(targetID), m_k(k), m_alpha(alpha), m_nInFlight(0), m_progress(true), m_startTime(ns3::Simulator::Now()), m_nMessages(0), m_nReplies(0), m_nTimeouts(0)
+{
+}
+
+bool NodeLookup::AddCandidate(const bentry_t &e, const nodeid_t &dist, uint16_t hop)
+{
+    if (m_candidates.count(dist) == 1 || m_failed.count(dist) == 1)
+        return false; // we actually already know this node
+
+    if (m_candidates.size() >= m_k && dist > std::prev(std::end(m_candidates))->first)
+        return false; // not among the k closest
+
+    LookupCandidate c;
+    c.addr = e.first;
+    c.nodeID = e.second;
+    c.state = RpcState::FRESH;
+    c.hop = hop;
+    m_candidates[dist] = c;
+
+    // if there are too many entries, remove entries on the end of the map (aka largest entries)
+    while (m_candidates.size() > m_k)
+    {
+        Evict(std::prev(std::end(m_candidates)));
+    }
+    return true;
+}
+
+std::vector<nodeid_t>
+NodeLookup::NextQueries()
+{
+    std::vector<nodeid_t> toQuery;
+
+    // query all formerly unqueried nodes, if we do not make progress
+    uint16_t parallelism = m_progress ? m_alpha : m_k;
+
+    for (auto &e : m_candidates)
+    {
+        if (m_nInFlight >= parallelism)
+            break;
+        if (e.second.state != RpcState::FRESH)
+            continue;
+
+        e.second.state = RpcState::INFLIGHT;
+        m_nInFlight++;
+        m_nMessages++;
+        toQuery.push_back(e.first);
+    }
+    return toQuery;
+}
+
+LookupCandidate *
+NodeLookup::GetCandidate(const nodeid_t &dist)
+{
+    auto it = m_candidates.find(dist);
+    if (it == std::end(m_candidates))
+        return nullptr;
+    return &it->second;
+}
+
+uint16_t
+NodeLookup::HandleReply(const nodeid_t &dist)
+{
+    m_nReplies++;
+
+    auto it = m_candidates.find(dist);
+    if (it == std::end(m_candidates) || it->second.state != RpcState::INFLIGHT)
+        return 0; // late or unsolicited reply, still useful for its nodes
+
+    ns3::Simulator::Cancel(it->second.timeout);
+    it->second.state = RpcState::RESPONDED;
+    m_nInFlight--;
+    return it->second.hop;
+}
+
+void NodeLookup::HandleTimeout(const nodeid_t &dist)
+{
+    auto it = m_candidates.find(dist);
+    if (it == std::end(m_candidates) || it->second.state != RpcState::INFLIGHT)
+        return;
+
+    m_nTimeouts++;
+    m_failed.insert(dist);
+    Evict(it);
+}
+
+void NodeLookup::SetProgress(bool progress)
+{
+    m_progress = progress;
+}
+
+bool NodeLookup::IsConverged() const
+{
+    if (m_nInFlight > 0)
+        return false;
+    for (auto &e : m_candidates)
+    {
+        if (e.second.state != RpcState::RESPONDED)
+            return false;
+    }
+    return true;
+}
+
+LookupStats
+NodeLookup::Finish(bool found, uint16_t foundHop)
+{
+    LookupStats s;
+    s.duration = ns3::Simulator::Now() - m_startTime;
+    s.nMessages = m_nMessages;
+    s.nReplies = m_nReplies;
+    s.nTimeouts = m_nTimeouts;
+    s.found = found;
+    s.hops = foundHop;
+
+    for (auto &e : m_candidates)
+    {
+        if (!found && s.hops == 0 && e.second.state == RpcState::RESPONDED)
+            s.hops = e.second.hop; // the closest responding node
+        ns3::Simulator::Cancel(e.second.timeout);
+    }
+    m_candidates.clear();
+    m_nInFlight = 0;
+    return s;
+}
+
+nodeid_t
+NodeLookup::GetTargetId() const
+{
+    return m_targetID;
+}
+
+void NodeLookup::Evict(std::map<nodeid_t, LookupCandidate>::iterator it)
+{
+    if (it->second.state == RpcState::INFLIGHT)
+    {
+        ns3::Simulator::Cancel(it->second.timeout);
+        m_nInFlight--;
+    }
+    m_candidates.erase(it);
+}
+
+} // namespace bns
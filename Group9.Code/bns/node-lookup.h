@@ -0,0 +1,128 @@
+/**
+ * This file declares the iterative node lookup used by the Kadcast and
+ * Mincast nodes.
+ */
+
+#ifndef NODE_LOOKUP_H
+#define NODE_LOOKUP_H
+
+#include <map>
+#include <set>
+#include <vector>
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+#include "node-id.h"
+
+namespace bns
+{
+
+typedef std::pair<ns3::Ipv4Address, nodeid_t> bentry_t;
+
+/**
+ * \brief State of the FIND_NODE RPC to a lookup candidate.
+ */
+enum class RpcState
+{
+    FRESH,     //0
+    INFLIGHT,  //1
+    RESPONDED, //2
+};
+
+struct LookupCandidate
+{
+    ns3::Ipv4Address addr;
+    nodeid_t nodeID;
+    RpcState state;
+    uint16_t hop;         //!< Number of FIND_NODE hops it took to learn about the node
+    ns3::EventId timeout; //!< Pending RPC timeout
+};
+
+/**
+ * \brief Metrics of a finished lookup.
+ */
+struct LookupStats
+{
+    ns3::Time duration; //!< Time until the lookup converged or found the target
+    uint16_t hops;      //!< Hops to the closest responding node (or to the one returning the target)
+    uint32_t nMessages; //!< FIND_NODE messages sent
+    uint32_t nReplies;  //!< NODES messages received
+    uint32_t nTimeouts; //!< RPCs that timed out
+    bool found;         //!< Target ID was found
+};
+
+/**
+ * \brief State machine of a single iterative lookup.
+ * Keeps the k closest known candidates ordered by distance, at most alpha
+ * (or k, if the last round made no progress) RPCs in flight, and converges
+ * once all of the k closest candidates have responded.
+ */
+class NodeLookup
+{
+public:
+    NodeLookup(nodeid_t targetID, uint16_t k, uint16_t alpha);
+
+    /**
+     * \brief Add a candidate learned at the given hop.
+     * \return true if the candidate entered the k closest known nodes
+     */
+    bool AddCandidate(const bentry_t &e, const nodeid_t &dist, uint16_t hop);
+
+    /**
+     * \brief Select the next candidates to query and mark them in flight.
+     * \return distances of the selected candidates
+     */
+    std::vector<nodeid_t> NextQueries();
+
+    /**
+     * \brief Returns a candidate by distance or nullptr.
+     */
+    LookupCandidate *GetCandidate(const nodeid_t &dist);
+
+    /**
+     * \brief Process a reply of the candidate at dist.
+     * \return hop of the responder, 0 if it is no longer tracked
+     */
+    uint16_t HandleReply(const nodeid_t &dist);
+
+    /**
+     * \brief Drop a candidate whose RPC timed out, freeing its slot.
+     */
+    void HandleTimeout(const nodeid_t &dist);
+
+    /**
+     * \brief Record if the last reply moved the lookup closer to the target.
+     */
+    void SetProgress(bool progress);
+
+    /**
+     * \brief All of the k closest known candidates have responded.
+     */
+    bool IsConverged() const;
+
+    /**
+     * \brief Cancel pending timeouts and return the lookup metrics.
+     */
+    LookupStats Finish(bool found, uint16_t foundHop = 0);
+
+    nodeid_t GetTargetId() const;
+
+private:
+    void Evict(std::map<nodeid_t, LookupCandidate>::iterator it);
+
+    nodeid_t m_targetID;
+    uint16_t m_k;
+    uint16_t m_alpha;
+    std::map<nodeid_t, LookupCandidate> m_candidates; //!< k closest known nodes by distance
+    std::set<nodeid_t> m_failed;                     //!< Candidates that timed out, never re-added
+    uint16_t m_nInFlight;
+    bool m_progress;
+
+    ns3::Time m_startTime;
+    uint32_t m_nMessages;
+    uint32_t m_nReplies;
+    uint32_t m_nTimeouts;
+};
+
+} // namespace bns
+#endif /* NODE_LOOKUP_H */
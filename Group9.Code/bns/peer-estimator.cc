@@ -0,0 +1,81 @@
+#include <algorithm>
+#include "peer-estimator.h"
+
+namespace bns
+{
+
+PeerEstimator::PeerEstimator()
+{
+}
+
+void PeerEstimator::Update(estimates_t &estimates, ns3::Ipv4Address addr, double sample, double weight)
+{
+    auto it = estimates.find(addr);
+    if (it == std::end(estimates))
+        estimates[addr] = sample;
+    else
+        it->second = (1.0 - weight) * it->second + weight * sample;
+}
+
+double
+PeerEstimator::Get(const estimates_t &estimates, ns3::Ipv4Address addr, double def)
+{
+    auto it = estimates.find(addr);
+    if (it != std::end(estimates))
+        return it->second;
+    if (estimates.empty())
+        return def;
+
+    double sum = 0;
+    for (auto &e : estimates)
+        sum += e.second;
+    return sum / estimates.size();
+}
+
+void PeerEstimator::AddRttSample(ns3::Ipv4Address addr, ns3::Time rtt)
+{
+    Update(m_rtt, addr, rtt.GetSeconds(), PEER_RTT_EWMA_WEIGHT);
+}
+
+void PeerEstimator::AddGoodputSample(ns3::Ipv4Address addr, double goodput)
+{
+    if (goodput <= 0)
+        return;
+    Update(m_goodput, addr, goodput, PEER_GOODPUT_EWMA_WEIGHT);
+}
+
+void PeerEstimator::AddInformOutcome(ns3::Ipv4Address addr, bool requested)
+{
+    Update(m_need, addr, requested ? 1.0 : 0.0, PEER_NEED_EWMA_WEIGHT);
+}
+
+ns3::Time
+PeerEstimator::GetRtt(ns3::Ipv4Address addr) const
+{
+    return ns3::Seconds(Get(m_rtt, addr, PEER_DEFAULT_RTT));
+}
+
+double
+PeerEstimator::GetGoodput(ns3::Ipv4Address addr) const
+{
+    return Get(m_goodput, addr, PEER_DEFAULT_GOODPUT);
+}
+
+double
+PeerEstimator::GetNeed(ns3::Ipv4Address addr) const
+{
+    return Get(m_need, addr, PEER_DEFAULT_NEED);
+}
+
+double
+PeerEstimator::GetPushGain(ns3::Ipv4Address addr, uint32_t nBytes) const
+{
+    // pushed:   delivery after rtt/2 + transfer
+    // informed: delivery after 3 * rtt/2 + transfer, but only if the peer needs it
+    double rtt = GetRtt(addr).GetSeconds();
+    double transfer = nBytes / GetGoodput(addr);
+    double need = GetNeed(addr);
+    return need * rtt - (1.0 - need) * transfer;
+}
+
+} // namespace bns
@@ -0,0 +1,70 @@
+/**
+ * This file declares the per-peer RTT, goodput and redundancy estimates the
+ * Mincast nodes use to choose between pushing a block and sending an INFORM.
+ */
+
+#ifndef PEER_ESTIMATOR_H
+#define PEER_ESTIMATOR_H
+
+#include <unordered_map>
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+#define PEER_RTT_EWMA_WEIGHT 0.125    // Weight of a new RTT sample
+#define PEER_GOODPUT_EWMA_WEIGHT 0.25 // Weight of a new goodput sample
+#define PEER_NEED_EWMA_WEIGHT 0.25    // Weight of a new INFORM outcome
+#define PEER_DEFAULT_RTT 0.1          // Seconds, if no peer was measured yet
+#define PEER_DEFAULT_GOODPUT 1000000  // Bytes per second, if no peer was measured yet
+#define PEER_DEFAULT_NEED 0.5         // Chance an unknown peer requests an informed block
+
+namespace bns
+{
+
+/**
+ * \brief Smoothed RTT, goodput and block need per peer.
+ * RTTs come from PING/PONG and INFORM/REQUEST round trips, goodput from the
+ * chunk arrival span the receivers report, and the need from the share of
+ * our INFORMs a peer answered with a REQUEST. Unmeasured peers get the mean
+ * of the measured ones.
+ */
+class PeerEstimator
+{
+public:
+    PeerEstimator();
+
+    void AddRttSample(ns3::Ipv4Address addr, ns3::Time rtt);
+
+    /**
+     * \brief Add the goodput (bytes per second) addr received our chunks with.
+     */
+    void AddGoodputSample(ns3::Ipv4Address addr, double goodput);
+
+    /**
+     * \brief Add whether addr requested a block we informed it about.
+     */
+    void AddInformOutcome(ns3::Ipv4Address addr, bool requested);
+
+    ns3::Time GetRtt(ns3::Ipv4Address addr) const;
+    double GetGoodput(ns3::Ipv4Address addr) const;
+    double GetNeed(ns3::Ipv4Address addr) const;
+
+    /**
+     * \brief Expected gain in seconds of pushing nBytes to addr instead of informing it.
+     * Informing costs peers that need the block one more round trip, pushing
+     * wastes the transfer time on peers that get the block elsewhere.
+     */
+    double GetPushGain(ns3::Ipv4Address addr, uint32_t nBytes) const;
+
+private:
+    typedef std::unordered_map<ns3::Ipv4Address, double, ns3::Ipv4AddressHash> estimates_t;
+
+    static void Update(estimates_t &estimates, ns3::Ipv4Address addr, double sample, double weight);
+    static double Get(const estimates_t &estimates, ns3::Ipv4Address addr, double def);
+
+    estimates_t m_rtt;     //!< Smoothed RTT in seconds
+    estimates_t m_goodput; //!< Smoothed goodput in bytes per second
+    estimates_t m_need;    //!< Smoothed share of INFORMs answered with a REQUEST
+};
+
+} // namespace bns
+#endif /* PEER_ESTIMATOR_H */
@@ -0,0 +1,94 @@
+#include <algorithm>
+#include <cmath>
+#include "ns3/random-variable-stream.h"
+#include "rolling-bloom-filter.h"
+
+namespace bns
+{
+
+RollingBloomFilter::RollingBloomFilter(uint32_t nElements, double fpRate)
+{
+    double logFpRate = std::log(fpRate);
+    m_nHashFuncs = std::max(1, std::min((int)std::round(logFpRate / std::log(0.5)), 50));
+    m_entriesPerGeneration = (nElements + 1) / 2;
+    uint32_t nMaxElements = m_entriesPerGeneration * 3;
+
+    // bits for nMaxElements at the given rate, two words per 64 bits
+    uint32_t nFilterBits = (uint32_t)std::ceil(-1.0 * m_nHashFuncs * nMaxElements / std::log(1.0 - std::exp(logFpRate / m_nHashFuncs)));
+    m_data.resize(((nFilterBits + 63) / 64) << 1);
+
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    m_tweak = ((uint64_t)x->GetInteger(0, UINT32_MAX) << 32) | x->GetInteger(0, UINT32_MAX);
+    Reset();
+}
+
+uint32_t
+RollingBloomFilter::Hash(uint32_t n, uint64_t key) const
+{
+    // splitmix64 finalizer over the key, seeded per hash function
+    uint64_t z = key ^ (m_tweak + (n + 1) * 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (uint32_t)(z ^ (z >> 31));
+}
+
+void RollingBloomFilter::Insert(uint64_t key)
+{
+    if (m_entriesThisGeneration == m_entriesPerGeneration)
+    {
+        m_entriesThisGeneration = 0;
+        m_generation++;
+        if (m_generation == 4)
+            m_generation = 1;
+
+        // wipe the bits of the generation we reuse
+        uint64_t mask1 = -(uint64_t)(m_generation & 1);
+        uint64_t mask2 = -(uint64_t)(m_generation >> 1);
+        for (uint32_t p = 0; p < m_data.size(); p += 2)
+        {
+            uint64_t p1 = m_data[p], p2 = m_data[p + 1];
+            uint64_t mask = (p1 ^ mask1) | (p2 ^ mask2);
+            m_data[p] = p1 & mask;
+            m_data[p + 1] = p2 & mask;
+        }
+    }
+    m_entriesThisGeneration++;
+
+    for (uint32_t n = 0; n < m_nHashFuncs; n++)
+    {
+        uint32_t h = Hash(n, key);
+        int bit = h & 0x3F;
+        uint32_t pos = ((uint64_t)h * m_data.size()) >> 32; // range reduction without a division
+        m_data[pos & ~1U] = (m_data[pos & ~1U] & ~(1ULL << bit)) | ((uint64_t)(m_generation & 1)) << bit;
+        m_data[pos | 1] = (m_data[pos | 1] & ~(1ULL << bit)) | ((uint64_t)(m_generation >> 1)) << bit;
+    }
+}
+
+bool RollingBloomFilter::Contains(uint64_t key) const
+{
+    for (uint32_t n = 0; n < m_nHashFuncs; n++)
+    {
+        uint32_t h = Hash(n, key);
+        int bit = h & 0x3F;
+        uint32_t pos = ((uint64_t)h * m_data.size()) >> 32;
+        // a bit is set if any generation owns it
+        if (!(((m_data[pos & ~1U] | m_data[pos | 1]) >> bit) & 1))
+            return false;
+    }
+    return true;
+}
+
+void RollingBloomFilter::Reset()
+{
+    m_entriesThisGeneration = 0;
+    m_generation = 1;
+    std::fill(std::begin(m_data), std::end(m_data), 0);
+}
+
+uint32_t
+RollingBloomFilter::GetMemory() const
+{
+    return m_data.size() * sizeof(uint64_t);
+}
+
+} // namespace bns
@@ -0,0 +1,50 @@
+/**
+ * This file declares the rolling bloom filter the Vanilla node uses to track
+ * the blocks each peer knows.
+ */
+
+#ifndef ROLLING_BLOOM_FILTER_H
+#define ROLLING_BLOOM_FILTER_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace bns
+{
+
+/**
+ * \brief Bloom filter remembering about the last nElements inserted keys.
+ * Modeled after CRollingBloomFilter of Bitcoin Core: every bit is stored as
+ * a 2 bit generation number spread over two words. Each generation holds
+ * nElements / 2 keys, starting a new one clears the oldest of three, so
+ * between nElements and 1.5 * nElements of the latest keys are kept, with
+ * the given false positive rate. Memory is fixed at construction, insert
+ * and lookup cost one hash per hash function.
+ */
+class RollingBloomFilter
+{
+public:
+    RollingBloomFilter(uint32_t nElements, double fpRate);
+
+    void Insert(uint64_t key);
+    bool Contains(uint64_t key) const;
+    void Reset();
+
+    /**
+     * \brief Bytes used by the filter
+     */
+    uint32_t GetMemory() const;
+
+private:
+    uint32_t Hash(uint32_t n, uint64_t key) const;
+
+    uint32_t m_entriesPerGeneration;
+    uint32_t m_entriesThisGeneration;
+    uint32_t m_generation; //!< 1, 2 or 3
+    uint32_t m_nHashFuncs;
+    uint64_t m_tweak;
+    std::vector<uint64_t> m_data;
+};
+
+} // namespace bns
+#endif /* ROLLING_BLOOM_FILTER_H */
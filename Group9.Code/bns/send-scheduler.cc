@@ -0,0 +1,140 @@
+#include "ns3/simulator.h"
+#include "send-scheduler.h"
+
+namespace bns
+{
+
+SendScheduler::SendScheduler() : m_nSinceRepair(0), m_txLowPriority(false), m_size(0), m_delaySum{0, 0, 0, 0}, m_nServed{0, 0, 0, 0}, m_bytes{0, 0, 0, 0}
+{
+}
+
+void SendScheduler::Enqueue(TrafficClass cls, ns3::Ipv4Address addr, ns3::Ptr<ns3::Packet> packet, uint64_t blockID)
+{
+    Entry e;
+    e.addr = addr;
+    e.packet = packet;
+    e.enqueued = ns3::Simulator::Now();
+
+    switch (cls)
+    {
+    case TrafficClass::CONTROL:
+        m_control.push_back(e);
+        break;
+    case TrafficClass::BLOCK:
+    {
+        std::deque<Entry> &queue = m_blocks[blockID];
+        if (queue.empty())
+            m_activeBlocks.push_back(blockID);
+        queue.push_back(e);
+        break;
+    }
+    case TrafficClass::REPAIR:
+        m_repair.push_back(e);
+        break;
+    case TrafficClass::TX:
+        m_txs.push_back(e);
+        break;
+    }
+    m_size++;
+}
+
+bool SendScheduler::Dequeue(ns3::Ipv4Address &addr, ns3::Ptr<ns3::Packet> &packet)
+{
+    if (!m_control.empty())
+        return Take(m_control, TrafficClass::CONTROL, addr, packet);
+
+    if (!m_repair.empty() && (m_activeBlocks.empty() || m_nSinceRepair >= SCHED_REPAIR_SHARE))
+    {
+        m_nSinceRepair = 0;
+        return Take(m_repair, TrafficClass::REPAIR, addr, packet);
+    }
+
+    if (m_activeBlocks.empty())
+    {
+        if (m_txs.empty())
+            return false;
+        return Take(m_txs, TrafficClass::TX, addr, packet);
+    }
+
+    // a transaction queued before the next chunk goes first, like on a shared TCP connection
+    uint64_t blockID = m_activeBlocks.front();
+    auto bit = m_blocks.find(blockID);
+    if (!m_txLowPriority && !m_txs.empty() && m_txs.front().enqueued < bit->second.front().enqueued)
+    {
+        if (!m_repair.empty())
+            m_nSinceRepair++;
+        return Take(m_txs, TrafficClass::TX, addr, packet);
+    }
+
+    // serve the block at the head, then move it to the back if it has more chunks
+    m_activeBlocks.pop_front();
+    Take(bit->second, TrafficClass::BLOCK, addr, packet);
+    if (bit->second.empty())
+        m_blocks.erase(bit);
+    else
+        m_activeBlocks.push_back(blockID);
+
+    if (!m_repair.empty())
+        m_nSinceRepair++;
+    return true;
+}
+
+bool SendScheduler::Take(std::deque<Entry> &queue, TrafficClass cls, ns3::Ipv4Address &addr, ns3::Ptr<ns3::Packet> &packet)
+{
+    Entry &e = queue.front();
+    addr = e.addr;
+    packet = e.packet;
+
+    uint8_t i = static_cast<uint8_t>(cls);
+    m_delaySum[i] += (ns3::Simulator::Now() - e.enqueued).GetSeconds();
+    m_nServed[i]++;
+    m_bytes[i] += packet->GetSize();
+
+    queue.pop_front();
+    m_size--;
+    return true;
+}
+
+void SendScheduler::SetTxLowPriority(bool low)
+{
+    m_txLowPriority = low;
+}
+
+bool SendScheduler::IsEmpty() const
+{
+    return m_size == 0;
+}
+
+uint32_t
+SendScheduler::GetSize() const
+{
+    return m_size;
+}
+
+void SendScheduler::Clear()
+{
+    m_control.clear();
+    m_repair.clear();
+    m_txs.clear();
+    m_blocks.clear();
+    m_activeBlocks.clear();
+    m_nSinceRepair = 0;
+    m_size = 0;
+}
+
+ns3::Time
+SendScheduler::GetMeanDelay(TrafficClass cls) const
+{
+    uint8_t i = static_cast<uint8_t>(cls);
+    if (m_nServed[i] == 0)
+        return ns3::Seconds(0);
+    return ns3::Seconds(m_delaySum[i] / m_nServed[i]);
+}
+
+uint64_t
+SendScheduler::GetBytes(TrafficClass cls) const
+{
+    return m_bytes[static_cast<uint8_t>(cls)];
+}
+
+} // namespace bns
@@ -0,0 +1,100 @@
+/**
+ * This file declares the send scheduler of the Kadcast node.
+ */
+
+#ifndef SEND_SCHEDULER_H
+#define SEND_SCHEDULER_H
+
+#include <deque>
+#include <unordered_map>
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+#include "ns3/ipv4-address.h"
+
+#define SCHED_REPAIR_SHARE 8 // Serve a waiting repair packet at least after this many block chunks
+
+namespace bns
+{
+
+/**
+ * \brief Traffic classes, in order of priority.
+ */
+enum class TrafficClass
+{
+    CONTROL, //0: ping, pong, find_node, nodes, request
+    BLOCK,   //1: chunks of blocks being broadcast
+    REPAIR,  //2: chunks of blocks sent on request
+    TX,      //3: transactions of the background workload
+};
+
+/**
+ * \brief Priority scheduler for outgoing packets.
+ * Control packets are always served first. Block chunks are kept in one
+ * queue per block and served round-robin, so competing blocks progress at
+ * the same pace. Repair chunks get the remaining capacity, but are never
+ * starved for longer than SCHED_REPAIR_SHARE block chunks. Transactions
+ * go out in arrival order with the block chunks, or only while no block or
+ * repair chunk is waiting if they have low priority.
+ */
+class SendScheduler
+{
+public:
+    SendScheduler();
+
+    /**
+     * \brief Queue a packet, blockID is only used for the BLOCK class.
+     */
+    void Enqueue(TrafficClass cls, ns3::Ipv4Address addr, ns3::Ptr<ns3::Packet> packet, uint64_t blockID = 0);
+
+    /**
+     * \brief Take the next packet to send.
+     * \return false if there is none
+     */
+    bool Dequeue(ns3::Ipv4Address &addr, ns3::Ptr<ns3::Packet> &packet);
+
+    /**
+     * \brief Only send transactions while no block or repair chunk is waiting
+     */
+    void SetTxLowPriority(bool low);
+
+    bool IsEmpty() const;
+    uint32_t GetSize() const;
+    void Clear();
+
+    /**
+     * \brief Mean time the packets of a class waited in the scheduler
+     */
+    ns3::Time GetMeanDelay(TrafficClass cls) const;
+
+    /**
+     * \brief Bytes handed out for transmission, per class
+     */
+    uint64_t GetBytes(TrafficClass cls) const;
+
+private:
+    struct Entry
+    {
+        ns3::Ipv4Address addr;
+        ns3::Ptr<ns3::Packet> packet;
+        ns3::Time enqueued;
+    };
+
+    bool Take(std::deque<Entry> &queue, TrafficClass cls, ns3::Ipv4Address &addr, ns3::Ptr<ns3::Packet> &packet);
+
+    std::deque<Entry> m_control;
+    std::deque<Entry> m_repair;
+    std::deque<Entry> m_txs;
+    std::unordered_map<uint64_t, std::deque<Entry>> m_blocks; //!< Chunk queues by block
+    std::deque<uint64_t> m_activeBlocks;                      //!< Round-robin order of the blocks with queued chunks
+    uint32_t m_nSinceRepair;                                  //!< Block chunks and transactions served while repair traffic was waiting
+    bool m_txLowPriority;
+    uint32_t m_size;
+
+    double m_delaySum[4];  //!< Accumulated waiting time in seconds, per class
+    uint64_t m_nServed[4]; //!< Served packets, per class
+    uint64_t m_bytes[4];   //!< Served bytes, per class
+};
+
+} // namespace bns
+#endif /* SEND_SCHEDULER_H */
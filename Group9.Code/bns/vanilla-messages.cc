@@ -605,4 +605,425 @@ VanBlockHeader::GetPrevId (void) const
     return m_prevID;
 }
 
+ns3::TypeId
+VanSendCmpctHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("VanSendCmpctHeader")
+	.SetParent<Header> ()
+	.AddConstructor<VanSendCmpctHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+VanSendCmpctHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+VanSendCmpctHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return VAN_SENDCMPCT_SIZE;
+}
+
+
+void 
+VanSendCmpctHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    start.WriteU8 (m_announce);
+    start.WriteHtonU64 (m_version);
+}
+
+
+uint32_t 
+VanSendCmpctHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_announce = start.ReadU8 ();
+    m_version = start.ReadNtohU64 ();
+    return VAN_SENDCMPCT_SIZE;
+}
+
+
+void 
+VanSendCmpctHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "announce=" << (uint32_t)m_announce;
+}
+
+void 
+VanSendCmpctHeader::SetAnnounce (uint8_t announce)
+{
+    NS_LOG_FUNCTION(this);
+    m_announce = announce;
+}
+
+uint8_t 
+VanSendCmpctHeader::GetAnnounce (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_announce;
+}
+
+void 
+VanSendCmpctHeader::SetVersion (uint64_t version)
+{
+    NS_LOG_FUNCTION(this);
+    m_version = version;
+}
+
+uint64_t 
+VanSendCmpctHeader::GetVersion (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_version;
+}
+
+ns3::TypeId
+VanCmpctBlockHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("VanCmpctBlockHeader")
+	.SetParent<Header> ()
+	.AddConstructor<VanCmpctBlockHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+VanCmpctBlockHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+VanCmpctBlockHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return VAN_CMPCTBLOCK_SIZE;
+}
+
+
+void 
+VanCmpctBlockHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU64 (m_prevID);
+    start.WriteHtonU32 (m_blockSize);
+    start.WriteHtonU32 (m_txCount);
+}
+
+
+uint32_t 
+VanCmpctBlockHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = start.ReadNtohU64 ();
+    m_prevID = start.ReadNtohU64 ();
+    m_blockSize = start.ReadNtohU32 ();
+    m_txCount = start.ReadNtohU32 ();
+    return VAN_CMPCTBLOCK_SIZE;
+}
+
+
+void 
+VanCmpctBlockHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "blockID=" << m_blockID;
+}
+
+void 
+VanCmpctBlockHeader::SetBlockId (uint64_t blockID)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = blockID;
+}
+
+uint64_t 
+VanCmpctBlockHeader::GetBlockId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockID;
+}
+
+void 
+VanCmpctBlockHeader::SetPrevId (uint64_t prevID)
+{
+    NS_LOG_FUNCTION(this);
+    m_prevID = prevID;
+}
+
+uint64_t 
+VanCmpctBlockHeader::GetPrevId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_prevID;
+}
+
+void 
+VanCmpctBlockHeader::SetBlockSize (uint32_t blockSize)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockSize = blockSize;
+}
+
+uint32_t 
+VanCmpctBlockHeader::GetBlockSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockSize;
+}
+
+void 
+VanCmpctBlockHeader::SetTxCount (uint32_t txCount)
+{
+    NS_LOG_FUNCTION(this);
+    m_txCount = txCount;
+}
+
+uint32_t 
+VanCmpctBlockHeader::GetTxCount (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_txCount;
+}
+
+ns3::TypeId
+VanGetBlockTxnHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("VanGetBlockTxnHeader")
+	.SetParent<Header> ()
+	.AddConstructor<VanGetBlockTxnHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+VanGetBlockTxnHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+VanGetBlockTxnHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return VAN_GETBLOCKTXN_SIZE;
+}
+
+
+void 
+VanGetBlockTxnHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU32 (m_count);
+}
+
+
+uint32_t 
+VanGetBlockTxnHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = start.ReadNtohU64 ();
+    m_count = start.ReadNtohU32 ();
+    return VAN_GETBLOCKTXN_SIZE;
+}
+
+
+void 
+VanGetBlockTxnHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "blockID=" << m_blockID;
+}
+
+void 
+VanGetBlockTxnHeader::SetBlockId (uint64_t blockID)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = blockID;
+}
+
+uint64_t 
+VanGetBlockTxnHeader::GetBlockId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockID;
+}
+
+void 
+VanGetBlockTxnHeader::SetCount (uint32_t count)
+{
+    NS_LOG_FUNCTION(this);
+    m_count = count;
+}
+
+uint32_t 
+VanGetBlockTxnHeader::GetCount (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_count;
+}
+
+ns3::TypeId
+VanBlockTxnHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("VanBlockTxnHeader")
+	.SetParent<Header> ()
+	.AddConstructor<VanBlockTxnHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+VanBlockTxnHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+VanBlockTxnHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return VAN_BLOCKTXN_SIZE;
+}
+
+
+void 
+VanBlockTxnHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    start.WriteHtonU64 (m_blockID);
+    start.WriteHtonU32 (m_count);
+}
+
+
+uint32_t 
+VanBlockTxnHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = start.ReadNtohU64 ();
+    m_count = start.ReadNtohU32 ();
+    return VAN_BLOCKTXN_SIZE;
+}
+
+
+void 
+VanBlockTxnHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "blockID=" << m_blockID;
+}
+
+void 
+VanBlockTxnHeader::SetBlockId (uint64_t blockID)
+{
+    NS_LOG_FUNCTION(this);
+    m_blockID = blockID;
+}
+
+uint64_t 
+VanBlockTxnHeader::GetBlockId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_blockID;
+}
+
+void 
+VanBlockTxnHeader::SetCount (uint32_t count)
+{
+    NS_LOG_FUNCTION(this);
+    m_count = count;
+}
+
+uint32_t 
+VanBlockTxnHeader::GetCount (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_count;
+}
+
+ns3::TypeId
+VanTxHeader::GetTypeId (void)
+{
+    static ns3::TypeId tid = ns3::TypeId ("VanTxHeader")
+	.SetParent<Header> ()
+	.AddConstructor<VanTxHeader> ();
+    return tid;
+}
+
+
+ns3::TypeId
+VanTxHeader::GetInstanceTypeId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return GetTypeId ();
+}
+
+
+uint32_t 
+VanTxHeader::GetSerializedSize (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return VAN_TX_SIZE;
+}
+
+
+void 
+VanTxHeader::Serialize (ns3::Buffer::Iterator start) const
+{
+    NS_LOG_FUNCTION(this);
+    // The data.
+    start.WriteHtonU64 (m_txID);
+}
+
+
+uint32_t 
+VanTxHeader::Deserialize (ns3::Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION(this);
+    m_txID = start.ReadNtohU64 ();
+    return VAN_TX_SIZE;
+}
+
+
+void 
+VanTxHeader::Print (std::ostream &os) const
+{
+    NS_LOG_FUNCTION(this);
+    os << "txID=" << m_txID;
+}
+
+void 
+VanTxHeader::SetTxId (uint64_t txID)
+{
+    NS_LOG_FUNCTION(this);
+    m_txID = txID;
+}
+
+uint64_t 
+VanTxHeader::GetTxId (void) const
+{
+    NS_LOG_FUNCTION(this);
+    return m_txID;
+}
+
 }
@@ -20,6 +20,11 @@
 #define VAN_HEADERS_SIZE 4+(m_count*8) // count + 8 bytes per entry
 #define VAN_GETBLOCKS_SIZE 8+8 // startID + stopID
 #define VAN_BLOCK_SIZE 8+8// blockID + prevID + blockSize
+#define VAN_SENDCMPCT_SIZE 1+8 // announce + version
+#define VAN_CMPCTBLOCK_SIZE 8+8+4+4 // blockID + prevID + blockSize + txCount, short IDs follow as payload
+#define VAN_GETBLOCKTXN_SIZE 8+4 // blockID + count, indexes follow as payload
+#define VAN_BLOCKTXN_SIZE 8+4 // blockID + count, transactions follow as payload
+#define VAN_TX_SIZE 8 // txID, the transaction follows as payload
 
 /*
  * Real sizes:
@@ -38,6 +43,13 @@ enum class VanMsgType
   HEADERS,          //3
   GETBLOCKS,       //4
   BLOCK,            //5
+  SENDCMPCT,        //6
+  CMPCTBLOCK,       //7
+  GETBLOCKTXN,      //8
+  BLOCKTXN,         //9
+  TXINV,            //10: same layout as INV
+  GETTX,            //11: same layout as GETDATA
+  TX,               //12
 };
 
 class VanLengthHeader : public ns3::Header
@@ -185,5 +197,114 @@ class VanBlockHeader : public ns3::Header
 		uint64_t m_blockID;
         uint64_t m_prevID;
 };
+
+class VanSendCmpctHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetAnnounce (uint8_t announce);
+		uint8_t GetAnnounce (void) const;
+
+		void SetVersion (uint64_t version);
+		uint64_t GetVersion (void) const;
+
+	private:
+		uint8_t m_announce;
+		uint64_t m_version;
+};
+
+class VanCmpctBlockHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetBlockId (uint64_t blockID);
+		uint64_t GetBlockId (void) const;
+
+		void SetPrevId (uint64_t prevID);
+		uint64_t GetPrevId (void) const;
+
+		void SetBlockSize (uint32_t blockSize);
+		uint32_t GetBlockSize (void) const;
+
+		void SetTxCount (uint32_t txCount);
+		uint32_t GetTxCount (void) const;
+
+	private:
+		uint64_t m_blockID;
+		uint64_t m_prevID;
+		uint32_t m_blockSize;
+		uint32_t m_txCount;
+};
+
+class VanGetBlockTxnHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetBlockId (uint64_t blockID);
+		uint64_t GetBlockId (void) const;
+
+		void SetCount (uint32_t count);
+		uint32_t GetCount (void) const;
+
+	private:
+		uint64_t m_blockID;
+		uint32_t m_count;
+};
+
+class VanBlockTxnHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetBlockId (uint64_t blockID);
+		uint64_t GetBlockId (void) const;
+
+		void SetCount (uint32_t count);
+		uint32_t GetCount (void) const;
+
+	private:
+		uint64_t m_blockID;
+		uint32_t m_count;
+};
+
+class VanTxHeader : public ns3::Header
+{
+	public:
+		static ns3::TypeId GetTypeId (void);
+		virtual ns3::TypeId GetInstanceTypeId (void) const;
+		virtual uint32_t GetSerializedSize (void) const;
+		virtual void Serialize (ns3::Buffer::Iterator start) const;
+		virtual uint32_t Deserialize (ns3::Buffer::Iterator start);
+		virtual void Print (std::ostream &os) const;
+
+		void SetTxId (uint64_t txID);
+		uint64_t GetTxId (void) const;
+
+	private:
+		uint64_t m_txID;
+};
 }
 #endif
@@ -17,6 +17,8 @@
 #include "ns3/tcp-socket-factory.h"
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/queue.h"
 
 #include "bitcoin-node.h"
 #include "vanilla-node.h"
@@ -30,7 +32,19 @@ namespace bns
 
 BroadcastType VanillaNode::vanBroadcastType = BroadcastType::SENDHEADERS;
 
-VanillaNode::VanillaNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : BitcoinNode(address, isMiner, hashRate), m_nInPeers(0), m_nOutPeers(0)
+double VanillaNode::announceDelay = 0.0;
+
+uint16_t VanillaNode::announceBatch = 16;
+
+double VanillaNode::mempoolOverlap = 0.95;
+
+uint16_t VanillaNode::perigeeRound = 0;
+
+double VanillaNode::trickleOutbound = 0.0;
+
+double VanillaNode::trickleInbound = 0.0;
+
+VanillaNode::VanillaNode(ns3::Ipv4Address address, bool isMiner, double hashRate) : BitcoinNode(address, isMiner, hashRate), m_nInPeers(0), m_nOutPeers(0), m_uplinkBacklogSum(0), m_nUplinkSamples(0), m_mempoolOverlap(VanillaNode::mempoolOverlap), m_nCompactBlocks(0), m_nBlockTxnRoundTrips(0), m_sync(VAN_IBD_WINDOW, VAN_IBD_PER_PEER), m_stallTimeout(VAN_IBD_STALL_TIMEOUT), m_nStalls(0), m_nRotations(0)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -75,6 +89,7 @@ void VanillaNode::StopApplication() // Called at time specified by Stop
 
     // accept no incoming connections anymore
     m_socket->Close();
+    m_socket = 0;
 
     // close outgoing connections
     for (auto pEntry : m_peers)
@@ -83,6 +98,26 @@ void VanillaNode::StopApplication() // Called at time specified by Stop
         socketPtr->Close();
     }
     m_peers.clear();
+    m_nInPeers = 0;
+    m_nOutPeers = 0;
+
+    // forget connection state, so we start over when rejoining
+    m_recvQueues.clear();
+    m_sendQueues.clear();
+    m_requestedBlocks.clear();
+    m_announces.Clear();
+    for (auto &e : m_pendingCompact)
+        e.second.timeout.Cancel();
+    m_pendingCompact.clear();
+    m_hbPeers.clear();
+    m_sync.Clear();
+    m_syncCheck.Cancel();
+    m_scorer.Clear();
+    m_rotation.Cancel();
+    m_txPool.clear();
+    m_txOrder.clear();
+    m_requestedTxs.clear();
+    m_txAnnounces.Clear();
 }
 
 void VanillaNode::InitListenSocket(void)
@@ -105,7 +140,7 @@ void VanillaNode::InitOutgoingConnection(void)
     NS_LOG_FUNCTION(this);
     uint32_t size = m_knownAddresses.size();
 
-    if (size == 0)
+    if (size == 0 || !m_isRunning)
         return;
 
     if (m_nOutPeers < VAN_MAXCONN_OUT)
@@ -131,6 +166,13 @@ void VanillaNode::InitOutgoingConnection(void)
     }
 }
 
+void VanillaNode::ReplaceOutgoingPeer(void)
+{
+    // the connection loop stops once all outgoing slots are taken, restart it
+    if (m_nOutPeers == VAN_MAXCONN_OUT - 1)
+        ns3::Simulator::ScheduleNow(&VanillaNode::InitOutgoingConnection, this);
+}
+
 void VanillaNode::InitBroadcast(Block &b)
 {
     NS_LOG_FUNCTION(this);
@@ -138,33 +180,184 @@ void VanillaNode::InitBroadcast(Block &b)
     NS_LOG_FUNCTION("InitBroadcast");
 
     //NS_LOG_INFO ("Broadcasting BLOCK " << b.blockID << ", prevID: " << b.prevID << ", size: " << b.blockSize << ").");
-    for (auto p : m_peers)
+    for (auto &p : m_peers)
     {
         ns3::Ipv4Address peerAddr = p.first;
         Peer &peer = p.second;
 
-        if (!PeerKnowsBlock(peerAddr, b.blockID))
+        if (!peer.knownBlocks.Contains(b.blockID))
         {
-            std::vector<uint64_t> inventory;
-            inventory.push_back(b.blockID);
-            switch (VanillaNode::vanBroadcastType)
-            {
-            case BroadcastType::UNSOLICITED:
+            if (VanillaNode::vanBroadcastType == BroadcastType::UNSOLICITED)
                 SendBlockMessage(peer.socket, b);
-                break;
-            case BroadcastType::SENDHEADERS:
-                SendHeadersMessage(peer.socket, inventory);
-                break;
-            case BroadcastType::INV:
-                SendInvMessage(peer.socket, inventory);
-                break;
-            }
-            SetBlockKnown(peerAddr, b.blockID);
+            else if (VanillaNode::vanBroadcastType == BroadcastType::COMPACT && peer.highBandwidth)
+                SendCmpctBlockMessage(peer.socket, b);
+            else
+                QueueAnnounce(peerAddr, b.blockID);
+            peer.knownBlocks.Insert(b.blockID);
         }
     }
     return;
 }
 
+void VanillaNode::QueueAnnounce(ns3::Ipv4Address peerAddr, uint64_t blockID)
+{
+    bool opened = m_announces.Add(peerAddr, blockID);
+    if (m_announces.GetSize(peerAddr) >= VanillaNode::announceBatch)
+    {
+        FlushAnnounces(peerAddr);
+        return;
+    }
+    if (!opened)
+        return;
+
+    ns3::Time delay = GetAnnounceDelay(peerAddr);
+    if (delay <= ns3::Seconds(0))
+        FlushAnnounces(peerAddr);
+    else
+        m_announces.SetFlushEvent(peerAddr, ns3::Simulator::Schedule(delay, &VanillaNode::FlushAnnounces, this, peerAddr));
+}
+
+ns3::Time
+VanillaNode::GetAnnounceDelay(ns3::Ipv4Address peerAddr)
+{
+    auto it = m_peers.find(peerAddr);
+    if (it == std::end(m_peers))
+        return ns3::Seconds(0);
+
+    bool outbound = it->second.type == PeerType::OUT;
+    double mean = outbound ? VanillaNode::trickleOutbound : VanillaNode::trickleInbound;
+    if (mean <= 0)
+        return ns3::Seconds(VanillaNode::announceDelay);
+
+    // the timer is memoryless, so a tick that passed unused is as good as a new one
+    ns3::Time now = ns3::Simulator::Now();
+    ns3::Time &next = outbound ? it->second.nextAnnounce : m_nextInboundAnnounce;
+    if (next <= now)
+    {
+        ns3::Ptr<ns3::ExponentialRandomVariable> x = ns3::CreateObject<ns3::ExponentialRandomVariable>();
+        x->SetAttribute("Mean", ns3::DoubleValue(mean));
+        next = now + ns3::Seconds(x->GetValue());
+    }
+    return next - now;
+}
+
+void VanillaNode::FlushAnnounces(ns3::Ipv4Address peerAddr)
+{
+    std::vector<uint64_t> inventory = m_announces.Take(peerAddr);
+    auto it = m_peers.find(peerAddr);
+    if (inventory.empty() || it == std::end(m_peers))
+        return; // the peer disconnected meanwhile
+
+    // how much is already waiting on the uplink when the announcement goes out
+    ns3::Ptr<ns3::PointToPointNetDevice> dev = ns3::DynamicCast<ns3::PointToPointNetDevice>(GetNode()->GetDevice(0));
+    if (dev)
+    {
+        ns3::Ptr<ns3::Queue<ns3::Packet>> queue = dev->GetQueue();
+        m_uplinkBacklogSum += queue->GetNBytes();
+        m_nUplinkSamples++;
+    }
+
+    // compact relay announces to low-bandwidth peers with HEADERS
+    if (VanillaNode::vanBroadcastType == BroadcastType::INV)
+        SendInvMessage(it->second.socket, inventory);
+    else
+        SendHeadersMessage(it->second.socket, inventory);
+}
+
+const AnnounceBatcher &
+VanillaNode::GetAnnounces()
+{
+    return m_announces;
+}
+
+void VanillaNode::InitTxBroadcast(Tx &tx)
+{
+    RelayTx(tx, m_address);
+}
+
+void VanillaNode::RelayTx(Tx &tx, ns3::Ipv4Address from)
+{
+    m_txPool[tx.txID] = tx;
+    m_txOrder.push_back(tx.txID);
+    while (m_txOrder.size() > BitcoinNode::nKnownTxs)
+    {
+        m_txPool.erase(m_txOrder.front());
+        m_txOrder.pop_front();
+    }
+
+    for (auto &pEntry : m_peers)
+    {
+        if (pEntry.first != from)
+            QueueTxAnnounce(pEntry.first, tx.txID);
+    }
+}
+
+void VanillaNode::QueueTxAnnounce(ns3::Ipv4Address peerAddr, uint64_t txID)
+{
+    bool opened = m_txAnnounces.Add(peerAddr, txID);
+    if (m_txAnnounces.GetSize(peerAddr) >= VAN_TX_INV_MAX)
+    {
+        FlushTxAnnounces(peerAddr);
+        return;
+    }
+    if (!opened)
+        return;
+
+    ns3::Time delay = GetAnnounceDelay(peerAddr);
+    if (delay <= ns3::Seconds(0))
+        FlushTxAnnounces(peerAddr);
+    else
+        m_txAnnounces.SetFlushEvent(peerAddr, ns3::Simulator::Schedule(delay, &VanillaNode::FlushTxAnnounces, this, peerAddr));
+}
+
+void VanillaNode::FlushTxAnnounces(ns3::Ipv4Address peerAddr)
+{
+    std::vector<uint64_t> inventory = m_txAnnounces.Take(peerAddr);
+    auto it = m_peers.find(peerAddr);
+    if (inventory.empty() || it == std::end(m_peers))
+        return; // the peer disconnected meanwhile
+
+    SendTxInvMessage(it->second.socket, inventory);
+}
+
+void VanillaNode::SetMempoolOverlap(double overlap)
+{
+    assert(overlap >= 0 && overlap <= 1);
+    m_mempoolOverlap = overlap;
+}
+
+uint32_t
+VanillaNode::GetNCompactBlocks()
+{
+    return m_nCompactBlocks;
+}
+
+uint32_t
+VanillaNode::GetNBlockTxnRoundTrips()
+{
+    return m_nBlockTxnRoundTrips;
+}
+
+uint32_t
+VanillaNode::GetNStalls()
+{
+    return m_nStalls;
+}
+
+uint32_t
+VanillaNode::GetNRotations()
+{
+    return m_nRotations;
+}
+
+double
+VanillaNode::GetMeanUplinkBacklog()
+{
+    if (m_nUplinkSamples == 0)
+        return 0;
+    return m_uplinkBacklogSum / m_nUplinkSamples;
+}
+
 ns3::Ipv4Address const
 VanillaNode::RandomKnownAddress()
 {
@@ -265,6 +458,18 @@ void VanillaNode::HandleConnect(ns3::Ptr<ns3::Socket> socketPtr)
     m_nOutPeers++;
 
     assert(m_peers.size() == m_nInPeers + m_nOutPeers);
+
+    // start with the first outgoing peers, the fastest ones take over later
+    if (VanillaNode::vanBroadcastType == BroadcastType::COMPACT && m_hbPeers.size() < VAN_HB_PEERS)
+    {
+        m_hbPeers.push_back(peerAddr);
+        SendSendCmpctMessage(socketPtr, true);
+    }
+
+    m_scorer.AddPeer(peerAddr);
+
+    // headers-first sync, everything after our top block
+    SendGetHeadersMessage(socketPtr, m_blockchain->GetTopBlockID(), 0);
 }
 
 void VanillaNode::SendPacket(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
@@ -419,6 +624,367 @@ void VanillaNode::SendBlockMessage(ns3::Ptr<ns3::Socket> socketPtr, Block b)
     SendPacket(socketPtr, packet);
 }
 
+void VanillaNode::SendSendCmpctMessage(ns3::Ptr<ns3::Socket> socketPtr, bool announce)
+{
+    VanSendCmpctHeader sch;
+    sch.SetAnnounce(announce ? 1 : 0);
+    sch.SetVersion(1);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+    packet->AddHeader(sch);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(VanMsgType::SENDCMPCT));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(socketPtr, packet);
+}
+
+void VanillaNode::SendCmpctBlockMessage(ns3::Ptr<ns3::Socket> socketPtr, Block b)
+{
+    ns3::Ipv4Address peerAddr = GetSocketAddress (socketPtr);
+    NS_LOG_INFO("Sending compact block: " << b.blockID << " to: " << peerAddr);
+
+    uint32_t nTx = std::max<uint32_t>(1, b.blockSize / VAN_AVG_TX_SIZE);
+
+    VanCmpctBlockHeader cbh;
+    cbh.SetBlockId(b.blockID);
+    cbh.SetPrevId(b.prevID);
+    cbh.SetBlockSize(b.blockSize);
+    cbh.SetTxCount(nTx);
+
+    // nonce, a short ID per transaction but the coinbase, and the prefilled coinbase
+    uint32_t payload = VAN_CMPCT_NONCE_SIZE + (nTx - 1) * VAN_SHORTID_SIZE + VAN_CMPCT_PREFILLED;
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(payload);
+    packet->AddHeader(cbh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(VanMsgType::CMPCTBLOCK));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(socketPtr, packet);
+}
+
+void VanillaNode::SendGetBlockTxnMessage(ns3::Ptr<ns3::Socket> socketPtr, uint64_t blockID, uint32_t count)
+{
+    VanGetBlockTxnHeader gbth;
+    gbth.SetBlockId(blockID);
+    gbth.SetCount(count);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(count * VAN_CMPCT_INDEX_SIZE);
+    packet->AddHeader(gbth);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(VanMsgType::GETBLOCKTXN));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(socketPtr, packet);
+}
+
+void VanillaNode::SendBlockTxnMessage(ns3::Ptr<ns3::Socket> socketPtr, uint64_t blockID, uint32_t count)
+{
+    VanBlockTxnHeader bth;
+    bth.SetBlockId(blockID);
+    bth.SetCount(count);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(count * VAN_AVG_TX_SIZE);
+    packet->AddHeader(bth);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(VanMsgType::BLOCKTXN));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(socketPtr, packet);
+}
+
+void VanillaNode::SendTxInvMessage(ns3::Ptr<ns3::Socket> socketPtr, std::vector<uint64_t> inventory)
+{
+    if (inventory.empty())
+        return;
+
+    VanInvHeader ih;
+    ih.SetInventory(inventory);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+    packet->AddHeader(ih);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(VanMsgType::TXINV));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(socketPtr, packet);
+}
+
+void VanillaNode::SendGetTxMessage(ns3::Ptr<ns3::Socket> socketPtr, std::vector<uint64_t> inventory)
+{
+    if (inventory.empty())
+        return;
+
+    VanGetDataHeader gdh;
+    gdh.SetInventory(inventory);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>();
+    packet->AddHeader(gdh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(VanMsgType::GETTX));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(socketPtr, packet);
+}
+
+void VanillaNode::SendTxMessage(ns3::Ptr<ns3::Socket> socketPtr, Tx tx)
+{
+    VanTxHeader txh;
+    txh.SetTxId(tx.txID);
+
+    ns3::Ptr<ns3::Packet> packet = ns3::Create<ns3::Packet>(tx.txSize);
+    packet->AddHeader(txh);
+
+    VanTypeHeader th;
+    th.SetType(static_cast<uint8_t>(VanMsgType::TX));
+    packet->AddHeader(th);
+
+    VanLengthHeader lh;
+    lh.SetLength(packet->GetSize());
+    packet->AddHeader(lh);
+
+    SendPacket(socketPtr, packet);
+}
+
+uint32_t
+VanillaNode::GetMissingTxCount(const Block &b)
+{
+    if (m_mempoolOverlap >= 1)
+        return 0;
+
+    // every transaction but the prefilled coinbase is in our mempool with probability m_mempoolOverlap
+    uint32_t nTx = std::max<uint32_t>(1, b.blockSize / VAN_AVG_TX_SIZE);
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3::CreateObject<ns3::UniformRandomVariable>();
+    uint32_t missing = 0;
+    for (uint32_t i = 1; i < nTx; i++)
+    {
+        if (x->GetValue() >= m_mempoolOverlap)
+            missing++;
+    }
+    return missing;
+}
+
+void VanillaNode::UpdateHighBandwidthPeers(ns3::Ipv4Address peerAddr)
+{
+    if (VanillaNode::vanBroadcastType != BroadcastType::COMPACT)
+        return;
+    auto pIt = m_peers.find(peerAddr);
+    if (pIt == std::end(m_peers))
+        return;
+
+    auto it = std::find(std::begin(m_hbPeers), std::end(m_hbPeers), peerAddr);
+    if (it != std::end(m_hbPeers))
+    {
+        // already high-bandwidth, just mark it as the most recent one
+        m_hbPeers.erase(it);
+        m_hbPeers.push_back(peerAddr);
+        return;
+    }
+
+    m_hbPeers.push_back(peerAddr);
+    SendSendCmpctMessage(pIt->second.socket, true);
+
+    if (m_hbPeers.size() > VAN_HB_PEERS)
+    {
+        ns3::Ipv4Address oldest = m_hbPeers.front();
+        m_hbPeers.pop_front();
+        auto oIt = m_peers.find(oldest);
+        if (oIt != std::end(m_peers))
+            SendSendCmpctMessage(oIt->second.socket, false);
+    }
+}
+
+void VanillaNode::RequestBlocks(void)
+{
+    if (m_sync.GetSize() == 0)
+        return;
+
+    for (auto &p : m_peers)
+    {
+        if (p.second.type != PeerType::OUT)
+            continue;
+        std::vector<uint64_t> inventory = m_sync.Assign(p.first);
+        if (inventory.empty())
+            continue;
+        SendGetDataMessage(p.second.socket, inventory);
+        m_requestedBlocks.insert(std::begin(inventory), std::end(inventory));
+    }
+
+    if (!m_syncCheck.IsRunning())
+        m_syncCheck = ns3::Simulator::Schedule(ns3::Seconds(VAN_IBD_CHECK_INTERVAL), &VanillaNode::CheckStalls, this);
+}
+
+void VanillaNode::CheckStalls(void)
+{
+    if (!m_isRunning || m_sync.GetSize() == 0)
+        return;
+
+    ns3::Ipv4Address staller;
+    if (m_sync.FindStaller(ns3::Seconds(m_stallTimeout), staller))
+    {
+        NS_LOG_INFO("Disconnecting peer stalling the block download: " << staller << " (timeout: " << m_stallTimeout << " s)");
+        m_nStalls++;
+        m_stallTimeout = std::min(2 * m_stallTimeout, (double)VAN_IBD_STALL_TIMEOUT_MAX);
+        DisconnectPeer(staller);
+    }
+
+    RequestBlocks();
+    if (!m_syncCheck.IsRunning())
+        m_syncCheck = ns3::Simulator::Schedule(ns3::Seconds(VAN_IBD_CHECK_INTERVAL), &VanillaNode::CheckStalls, this);
+}
+
+void VanillaNode::DisconnectPeer(ns3::Ipv4Address peerAddr)
+{
+    auto it = m_peers.find(peerAddr);
+    if (it == std::end(m_peers))
+        return;
+
+    ns3::Ptr<ns3::Socket> socketPtr = it->second.socket;
+    socketPtr->SetCloseCallbacks(
+        ns3::MakeNullCallback<void, ns3::Ptr<ns3::Socket>>(),
+        ns3::MakeNullCallback<void, ns3::Ptr<ns3::Socket>>());
+    socketPtr->SetRecvCallback(ns3::MakeNullCallback<void, ns3::Ptr<ns3::Socket>>());
+    socketPtr->Close();
+
+    if (it->second.type == PeerType::OUT)
+    {
+        m_nOutPeers--;
+        ReplaceOutgoingPeer();
+    }
+    else
+    {
+        m_nInPeers--;
+    }
+    m_peers.erase(it);
+    m_hbPeers.erase(std::remove(std::begin(m_hbPeers), std::end(m_hbPeers), peerAddr), std::end(m_hbPeers));
+    m_recvQueues.erase(peerAddr);
+    m_sendQueues.erase(peerAddr);
+    m_sync.Release(peerAddr);
+    m_scorer.RemovePeer(peerAddr);
+    ForgetPeerRequests(peerAddr);
+    assert(m_peers.size() == m_nInPeers + m_nOutPeers);
+}
+
+void VanillaNode::ForgetPeerRequests(ns3::Ipv4Address peerAddr)
+{
+    std::vector<uint64_t> stranded;
+    for (auto &e : m_pendingCompact)
+    {
+        if (e.second.peer == peerAddr)
+            stranded.push_back(e.first);
+    }
+    for (uint64_t blockID : stranded)
+        FetchCompactFallback(blockID);
+
+    // the next announcement of these transactions fetches them from another peer
+    for (auto it = std::begin(m_requestedTxs); it != std::end(m_requestedTxs);)
+    {
+        if (it->second.first == peerAddr)
+            it = m_requestedTxs.erase(it);
+        else
+            ++it;
+    }
+}
+
+void VanillaNode::FetchCompactFallback(uint64_t blockID)
+{
+    auto it = m_pendingCompact.find(blockID);
+    if (!m_isRunning || it == std::end(m_pendingCompact))
+        return;
+    ns3::Ipv4Address from = it->second.peer;
+    it->second.timeout.Cancel();
+    m_pendingCompact.erase(it);
+    if (m_blockchain->HasBlock(blockID) || m_requestedBlocks.count(blockID) == 1)
+        return;
+
+    // prefer a peer that has the block, any other one may get it meanwhile
+    ns3::Ptr<ns3::Socket> socketPtr = 0;
+    for (auto &p : m_peers)
+    {
+        if (p.first == from)
+            continue;
+        if (PeerKnowsBlock(p.first, blockID))
+        {
+            socketPtr = p.second.socket;
+            break;
+        }
+        if (!socketPtr)
+            socketPtr = p.second.socket;
+    }
+    if (!socketPtr)
+    {
+        NS_LOG_WARN("No peer to fetch block " << blockID << " from after its BLOCKTXN from " << from << " failed");
+        return;
+    }
+
+    NS_LOG_INFO("No BLOCKTXN for compact block " << blockID << " from " << from << ", requesting the full block from: " << GetSocketAddress(socketPtr));
+    SendGetDataMessage(socketPtr, {blockID});
+    m_requestedBlocks.insert(blockID);
+}
+
+void VanillaNode::ObserveAnnouncement(ns3::Ipv4Address peerAddr, uint64_t blockID)
+{
+    if (VanillaNode::perigeeRound == 0)
+        return;
+
+    m_scorer.Observe(blockID, peerAddr);
+    if (m_scorer.GetNBlocks() >= VanillaNode::perigeeRound && !m_rotation.IsRunning())
+        m_rotation = ns3::Simulator::Schedule(ns3::Seconds(VAN_PERIGEE_SETTLE), &VanillaNode::RotatePeers, this);
+}
+
+void VanillaNode::RotatePeers(void)
+{
+    if (!m_isRunning)
+        return;
+
+    std::vector<ns3::Ipv4Address> candidates;
+    for (auto &p : m_peers)
+    {
+        if (p.second.type == PeerType::OUT)
+            candidates.push_back(p.first);
+    }
+
+    // only replace peers when all slots are taken, so there is a full set to compare
+    ns3::Ipv4Address worst;
+    if (m_nOutPeers == VAN_MAXCONN_OUT && m_scorer.FindWorst(candidates, VAN_PERIGEE_PERCENTILE, worst))
+    {
+        NS_LOG_INFO("Replacing outgoing peer " << worst << " (score: " << m_scorer.GetScore(worst, VAN_PERIGEE_PERCENTILE) << " s over " << m_scorer.GetNBlocks() << " blocks)");
+        m_nRotations++;
+        DisconnectPeer(worst);
+    }
+    m_scorer.Reset();
+}
+
 void VanillaNode::HandleSent(ns3::Ptr<ns3::Socket> socketPtr, uint32_t availBytes)
 {
     NS_LOG_FUNCTION(this << socketPtr << availBytes);
@@ -435,15 +1001,20 @@ void VanillaNode::HandleRead(ns3::Ptr<ns3::Socket> socketPtr)
 
     ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
 
-    ns3::Ptr<ns3::Packet> p = socketPtr->Recv();
-    if (m_recvQueues.count(peerAddr) == 0)
-        m_recvQueues[peerAddr] = ns3::Create<ns3::Packet>();
+    FrameReassembler &recvQueue = m_recvQueues[peerAddr];
 
+    ns3::Ptr<ns3::Packet> p = socketPtr->Recv();
     while (p != 0)
     {
-        m_recvQueues[peerAddr]->AddAtEnd(p);
+        recvQueue.Push(p);
 
-        ProcessPacket(socketPtr);
+        // handle every message completed by this segment
+        ns3::Ptr<ns3::Packet> msg = recvQueue.Pop();
+        while (msg != 0)
+        {
+            HandlePacket(socketPtr, msg);
+            msg = recvQueue.Pop();
+        }
 
         p = socketPtr->Recv();
     }
@@ -461,6 +1032,7 @@ void VanillaNode::HandlePeerClose(ns3::Ptr<ns3::Socket> socketPtr)
     {
         NS_LOG_INFO("Outgoing connection CLOSED: " << peerAddr);
         m_nOutPeers--;
+        ReplaceOutgoingPeer();
     }
     else
     {
@@ -468,6 +1040,11 @@ void VanillaNode::HandlePeerClose(ns3::Ptr<ns3::Socket> socketPtr)
         m_nInPeers--;
     }
     m_peers.erase(peerAddr);
+    m_hbPeers.erase(std::remove(std::begin(m_hbPeers), std::end(m_hbPeers), peerAddr), std::end(m_hbPeers));
+    m_sync.Release(peerAddr);
+    m_scorer.RemovePeer(peerAddr);
+    ForgetPeerRequests(peerAddr);
+    RequestBlocks();
     assert(m_peers.size() == m_nInPeers + m_nOutPeers);
 }
 
@@ -484,6 +1061,7 @@ void VanillaNode::HandlePeerError(ns3::Ptr<ns3::Socket> socketPtr)
         NS_LOG_WARN("Outgoing connection ERROR: " << peerAddr);
         NS_LOG_WARN("Error: " << show_errno(socketPtr->GetErrno()));
         m_nOutPeers--;
+        ReplaceOutgoingPeer();
     }
     else
     {
@@ -492,6 +1070,11 @@ void VanillaNode::HandlePeerError(ns3::Ptr<ns3::Socket> socketPtr)
         m_nInPeers--;
     }
     m_peers.erase(peerAddr);
+    m_hbPeers.erase(std::remove(std::begin(m_hbPeers), std::end(m_hbPeers), peerAddr), std::end(m_hbPeers));
+    m_sync.Release(peerAddr);
+    m_scorer.RemovePeer(peerAddr);
+    ForgetPeerRequests(peerAddr);
+    RequestBlocks();
     assert(m_peers.size() == m_nInPeers + m_nOutPeers);
 }
 
@@ -522,48 +1105,32 @@ void VanillaNode::HandlePacket(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Pa
     case VanMsgType::BLOCK:
         HandleBlockMessage(socketPtr, packet);
         break;
+    case VanMsgType::SENDCMPCT:
+        HandleSendCmpctMessage(socketPtr, packet);
+        break;
+    case VanMsgType::CMPCTBLOCK:
+        HandleCmpctBlockMessage(socketPtr, packet);
+        break;
+    case VanMsgType::GETBLOCKTXN:
+        HandleGetBlockTxnMessage(socketPtr, packet);
+        break;
+    case VanMsgType::BLOCKTXN:
+        HandleBlockTxnMessage(socketPtr, packet);
+        break;
+    case VanMsgType::TXINV:
+        HandleTxInvMessage(socketPtr, packet);
+        break;
+    case VanMsgType::GETTX:
+        HandleGetTxMessage(socketPtr, packet);
+        break;
+    case VanMsgType::TX:
+        HandleTxMessage(socketPtr, packet);
+        break;
     default:
         NS_LOG_DEBUG("Got unknown message: " << packet);
     }
 }
 
-void VanillaNode::ProcessPacket(ns3::Ptr<ns3::Socket> socketPtr)
-{
-    NS_LOG_FUNCTION(this);
-
-    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
-    //NS_LOG_INFO("Processing from: " << peerAddr);
-
-    ns3::Ptr<ns3::Packet> curPacket = m_recvQueues[peerAddr];
-    VanLengthHeader lh;
-    if (curPacket->GetSize() < lh.GetSerializedSize())
-        return; // we can't go on further, not enough to read length header
-
-    curPacket->PeekHeader(lh);
-    uint32_t length = lh.GetLength();
-    //NS_LOG_INFO("length is: " << length << " packet size: " << curPacket->GetSize() << " my addr: " << m_address);
-    //
-    VanTypeHeader th;
-    if (curPacket->GetSize() >= lh.GetSerializedSize() + th.GetSerializedSize())
-    {
-        ns3::Ptr<ns3::Packet> p = curPacket->CreateFragment(lh.GetSerializedSize(), th.GetSerializedSize());
-        p->RemoveHeader(th);
-    }
-    if (curPacket->GetSize() < lh.GetSerializedSize() + length)
-        return; // we can't go on further, not enough for the whole package
-
-    curPacket->RemoveHeader(lh);
-
-    // we have enough data process next packet
-    ns3::Ptr<ns3::Packet> p = curPacket->CreateFragment(0, length);
-    curPacket->RemoveAtStart(length);
-
-    HandlePacket(socketPtr, p);
-
-    if (curPacket->GetSize() > 0)
-        ProcessPacket(socketPtr); // repeat for next packet
-}
-
 void VanillaNode::HandleInvMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
 {
     ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
@@ -575,6 +1142,7 @@ void VanillaNode::HandleInvMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3
     for (uint64_t blockID : inventory)
     {
         SetBlockKnown(peerAddr, blockID);
+        ObserveAnnouncement(peerAddr, blockID);
     }
 
     // remove all entries we already have
@@ -583,19 +1151,26 @@ void VanillaNode::HandleInvMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3
     // remove all entries we already have requested
     inventory.erase(std::remove_if(std::begin(inventory), std::end(inventory), [this](uint64_t id) { return this->m_requestedBlocks.count(id) == 1; }), std::end(inventory));
 
+    if (inventory.empty())
+        return;
+
+    // catching up: fetch the headers, the window then spreads the blocks over all peers
+    if (inventory.size() > VAN_IBD_DIRECT_FETCH)
+    {
+        SendGetHeadersMessage(socketPtr, m_blockchain->GetTopBlockID(), 0);
+        return;
+    }
+
     std::sort(std::begin(inventory), std::end(inventory));
 
     // send getheaders for blocks
     SendGetHeadersMessage(socketPtr, inventory.front(), inventory.back());
 
     // send getdata for blocks
-    if (!inventory.empty())
+    SendGetDataMessage(socketPtr, inventory);
+    for (auto id : inventory)
     {
-        SendGetDataMessage(socketPtr, inventory);
-        for (auto id : inventory)
-        {
-            m_requestedBlocks.insert(id);
-        }
+        m_requestedBlocks.insert(id);
     }
 }
 
@@ -611,7 +1186,11 @@ void VanillaNode::HandleGetDataMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr
         if (m_blockchain->HasBlock(blockID))
         {
             Block b = m_blockchain->GetBlockById(blockID);
-            SendBlockMessage(socketPtr, b);
+            // peers catching up on old blocks do not have their transactions
+            if (VanillaNode::vanBroadcastType == BroadcastType::COMPACT && b.blockHeight + VAN_CMPCT_DEPTH >= m_blockchain->GetTopBlockHeight())
+                SendCmpctBlockMessage(socketPtr, b);
+            else
+                SendBlockMessage(socketPtr, b);
             SetBlockKnown(peerAddr, blockID);
         }
         else
@@ -632,8 +1211,8 @@ void VanillaNode::HandleGetHeadersMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::
         startID = 0;
 
     uint64_t stopID = ghh.GetStopId();
-    // find stopID. if not, assume topBlock.
-    if (!m_blockchain->HasBlock(stopID))
+    // find stopID. if not (or 0), assume topBlock.
+    if (stopID == 0 || !m_blockchain->HasBlock(stopID))
         stopID = m_blockchain->GetTopBlockID();
     if (stopID == startID)
         return; // do not send anything, if we do not know anything newer
@@ -659,11 +1238,22 @@ void VanillaNode::HandleHeadersMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr
     for (uint64_t blockID : inventory)
     {
         SetBlockKnown(peerAddr, blockID);
+        ObserveAnnouncement(peerAddr, blockID);
     }
 
     // remove all entries we already have
     inventory.erase(std::remove_if(std::begin(inventory), std::end(inventory), [this](uint64_t id) { return this->m_blockchain->HasBlock(id); }), std::end(inventory));
 
+    // catching up: headers come newest first, download them oldest first from all peers that sent them
+    if (inventory.size() > VAN_IBD_DIRECT_FETCH)
+    {
+        NS_LOG_INFO("Syncing " << inventory.size() << " blocks, headers from: " << peerAddr);
+        std::reverse(std::begin(inventory), std::end(inventory));
+        m_sync.Add(inventory, peerAddr);
+        RequestBlocks();
+        return;
+    }
+
     // remove all entries we already have requested
     inventory.erase(std::remove_if(std::begin(inventory), std::end(inventory), [this](uint64_t id) { return this->m_requestedBlocks.count(id) == 1; }), std::end(inventory));
 
@@ -707,7 +1297,7 @@ void VanillaNode::HandleGetBlocksMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::P
 
 void VanillaNode::HandleBlockMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
 {
-    //ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
 
     VanBlockHeader bh;
     packet->RemoveHeader(bh);
@@ -717,32 +1307,193 @@ void VanillaNode::HandleBlockMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<n
     uint32_t newBlockSize = packet->GetSize();
     Block newBlock = Blockchain::GetNewBlock(newBlockID, newPrevID, newBlockSize);
 
+    SetBlockKnown(peerAddr, newBlockID);
+    ObserveAnnouncement(peerAddr, newBlockID);
+    auto pit = m_pendingCompact.find(newBlockID);
+    if (!m_blockchain->HasBlock(newBlockID) && pit == std::end(m_pendingCompact))
+        UpdateHighBandwidthPeers(peerAddr);
+    if (pit != std::end(m_pendingCompact))
+    {
+        pit->second.timeout.Cancel();
+        m_pendingCompact.erase(pit);
+    }
 
         SetTTFB(newBlockID, ns3::Simulator::Now());
         SetTTLB(newBlockID, ns3::Simulator::Now());
 
-    // Remove from requested blocks
-    m_requestedBlocks.erase(newBlockID);
+    AcceptBlock(newBlock);
+}
 
-    ns3::Time delay = GetValidationDelay(newBlock);
-    ns3::Simulator::Schedule(delay, &VanillaNode::NotifyNewBlock, this, newBlock, false);
+void VanillaNode::HandleSendCmpctMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
+{
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    VanSendCmpctHeader sch;
+    packet->RemoveHeader(sch);
+
+    auto it = m_peers.find(peerAddr);
+    if (it != std::end(m_peers))
+        it->second.highBandwidth = sch.GetAnnounce() == 1;
 }
 
-void VanillaNode::SetBlockKnown(ns3::Ipv4Address peerAddr, uint64_t blockID)
+void VanillaNode::HandleCmpctBlockMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
 {
-    std::vector<ns3::Ipv4Address> &alreadyKnown = m_knownBlocks[blockID];
-    auto it = std::find(std::begin(alreadyKnown), std::end(alreadyKnown), peerAddr);
-    if (it == std::end(alreadyKnown))
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    VanCmpctBlockHeader cbh;
+    packet->RemoveHeader(cbh);
+
+    uint64_t newBlockID = cbh.GetBlockId();
+    SetBlockKnown(peerAddr, newBlockID);
+    ObserveAnnouncement(peerAddr, newBlockID);
+
+    // high-bandwidth peers push the same block concurrently
+    if (m_blockchain->HasBlock(newBlockID) || m_pendingCompact.count(newBlockID) == 1)
+        return;
+
+    Block newBlock = Blockchain::GetNewBlock(newBlockID, cbh.GetPrevId(), cbh.GetBlockSize());
+    UpdateHighBandwidthPeers(peerAddr);
+    m_nCompactBlocks++;
+
+    SetTTFB(newBlockID, ns3::Simulator::Now());
+
+    uint32_t missing = GetMissingTxCount(newBlock);
+    if (missing == 0)
     {
-        alreadyKnown.push_back(peerAddr);
+        SetTTLB(newBlockID, ns3::Simulator::Now());
+        AcceptBlock(newBlock);
+        return;
     }
+
+    NS_LOG_INFO("Compact block " << newBlockID << " misses " << missing << " transactions, requesting from: " << peerAddr);
+    PendingCompact &pending = m_pendingCompact[newBlockID];
+    pending.block = newBlock;
+    pending.peer = peerAddr;
+    pending.timeout = ns3::Simulator::Schedule(ns3::Seconds(VAN_CMPCT_TIMEOUT), &VanillaNode::FetchCompactFallback, this, newBlockID);
+    m_nBlockTxnRoundTrips++;
+    SendGetBlockTxnMessage(socketPtr, newBlockID, missing);
+}
+
+void VanillaNode::HandleGetBlockTxnMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
+{
+    VanGetBlockTxnHeader gbth;
+    packet->RemoveHeader(gbth);
+
+    if (!m_blockchain->HasBlock(gbth.GetBlockId()))
+    {
+        NS_LOG_INFO("Could not find block of requested transactions!!");
+        return;
+    }
+    SendBlockTxnMessage(socketPtr, gbth.GetBlockId(), gbth.GetCount());
+}
+
+void VanillaNode::HandleBlockTxnMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
+{
+    VanBlockTxnHeader bth;
+    packet->RemoveHeader(bth);
+
+    auto it = m_pendingCompact.find(bth.GetBlockId());
+    if (it == std::end(m_pendingCompact))
+        return; // got the full block meanwhile
+
+    Block newBlock = it->second.block;
+    it->second.timeout.Cancel();
+    m_pendingCompact.erase(it);
+
+    SetTTLB(newBlock.blockID, ns3::Simulator::Now());
+    AcceptBlock(newBlock);
+}
+
+void VanillaNode::HandleTxInvMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
+{
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+    VanInvHeader ih;
+    packet->RemoveHeader(ih);
+
+    // forget the requests nobody answered once the table is full
+    ns3::Time now = ns3::Simulator::Now();
+    if (m_requestedTxs.size() >= BitcoinNode::nKnownTxs)
+    {
+        for (auto it = std::begin(m_requestedTxs); it != std::end(m_requestedTxs);)
+        {
+            if (now - it->second.second >= ns3::Seconds(VAN_TX_REQUEST_TIMEOUT))
+                it = m_requestedTxs.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // fetch what we neither have nor asked another peer for recently
+    std::vector<uint64_t> inventory;
+    for (uint64_t txID : ih.GetInventory())
+    {
+        if (m_knownTxs.Contains(txID))
+            continue;
+        auto it = m_requestedTxs.find(txID);
+        if (it != std::end(m_requestedTxs) && now - it->second.second < ns3::Seconds(VAN_TX_REQUEST_TIMEOUT))
+            continue;
+        if (it == std::end(m_requestedTxs) && m_requestedTxs.size() >= BitcoinNode::nKnownTxs)
+            break; // a later announcement brings the rest
+        m_requestedTxs[txID] = std::make_pair(peerAddr, now);
+        inventory.push_back(txID);
+    }
+    SendGetTxMessage(socketPtr, inventory);
+}
+
+void VanillaNode::HandleGetTxMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
+{
+    VanGetDataHeader gdh;
+    packet->RemoveHeader(gdh);
+
+    for (uint64_t txID : gdh.GetInventory())
+    {
+        auto it = m_txPool.find(txID);
+        if (it != std::end(m_txPool))
+            SendTxMessage(socketPtr, it->second);
+    }
+}
+
+void VanillaNode::HandleTxMessage(ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet)
+{
+    ns3::Ipv4Address peerAddr = GetSocketAddress(socketPtr);
+
+    VanTxHeader txh;
+    packet->RemoveHeader(txh);
+
+    Tx tx;
+    tx.txID = txh.GetTxId();
+    tx.txSize = packet->GetSize();
+
+    m_requestedTxs.erase(tx.txID);
+    if (AcceptTx(tx))
+        RelayTx(tx, peerAddr);
+}
+
+void VanillaNode::AcceptBlock(Block b)
+{
+    // Remove from requested blocks
+    m_requestedBlocks.erase(b.blockID);
+
+    // the window moved, relax the stall timeout again and refill the free slots
+    if (m_sync.Received(b.blockID))
+    {
+        m_stallTimeout = std::max(0.85 * m_stallTimeout, (double)VAN_IBD_STALL_TIMEOUT);
+        RequestBlocks();
+    }
+
+    ns3::Time delay = GetValidationDelay(b);
+    ns3::Simulator::Schedule(delay, &VanillaNode::NotifyNewBlock, this, b, false);
+}
+
+void VanillaNode::SetBlockKnown(ns3::Ipv4Address peerAddr, uint64_t blockID)
+{
+    auto it = m_peers.find(peerAddr);
+    if (it != std::end(m_peers))
+        it->second.knownBlocks.Insert(blockID);
 }
 
 bool VanillaNode::PeerKnowsBlock(ns3::Ipv4Address peerAddr, uint64_t blockID)
 {
-    std::vector<ns3::Ipv4Address> &alreadyKnown = m_knownBlocks[blockID];
-    auto it = std::find(std::begin(alreadyKnown), std::end(alreadyKnown), peerAddr);
-    return (it != std::end(alreadyKnown));
+    auto it = m_peers.find(peerAddr);
+    return it != std::end(m_peers) && it->second.knownBlocks.Contains(blockID);
 }
 
 ns3::Ipv4Address
@@ -13,12 +13,37 @@
 #include "ns3/boolean.h"
 #include "ns3/random-variable-stream.h"
 
+#include "announce-batcher.h"
 #include "bitcoin-node.h"
+#include "download-window.h"
+#include "frame-reassembler.h"
+#include "neighbor-scorer.h"
+#include "rolling-bloom-filter.h"
 #include "vanilla-messages.h"
 
 #define VAN_PORT 8334
 #define VAN_MAXCONN_OUT 8
 #define VAN_MAXCONN_IN 117
+#define VAN_KNOWN_BLOCKS 500      // Latest block IDs remembered per peer
+#define VAN_KNOWN_FP_RATE 0.000001 // False positive rate of the per peer inventory filter
+#define VAN_HB_PEERS 3            // Peers asked to push compact blocks without announcing them first
+#define VAN_AVG_TX_SIZE 500       // Bytes per transaction, block size / this = transactions per block
+#define VAN_SHORTID_SIZE 6        // Bytes per short transaction ID in a CMPCTBLOCK
+#define VAN_CMPCT_NONCE_SIZE 8    // Bytes of the short ID salt nonce
+#define VAN_CMPCT_PREFILLED 250   // Bytes of prefilled transactions (the coinbase)
+#define VAN_CMPCT_INDEX_SIZE 2    // Bytes per differentially encoded index in a GETBLOCKTXN
+#define VAN_CMPCT_DEPTH 5         // Older blocks are always sent in full
+#define VAN_CMPCT_TIMEOUT 10      // Seconds to wait for a BLOCKTXN before the full block is fetched from another peer
+#define VAN_IBD_WINDOW 1024       // Blocks ahead of the first missing one that may be requested
+#define VAN_IBD_PER_PEER 16       // Blocks in flight per peer during sync
+#define VAN_IBD_DIRECT_FETCH 16   // Fewer new blocks are fetched from the announcing peer directly
+#define VAN_IBD_STALL_TIMEOUT 2   // Seconds the window may wait for its first block, doubled on every stall
+#define VAN_IBD_STALL_TIMEOUT_MAX 64
+#define VAN_IBD_CHECK_INTERVAL 1  // Seconds between stall checks
+#define VAN_PERIGEE_PERCENTILE 0.9 // Percentile of the announcement delays a peer is scored by
+#define VAN_PERIGEE_SETTLE 10     // Seconds the last block of a round may still be announced by slower peers
+#define VAN_TX_INV_MAX 1000       // Transaction IDs per TXINV, a fuller batch is sent at once
+#define VAN_TX_REQUEST_TIMEOUT 60 // Seconds before a transaction requested from one peer is asked from another
 
 namespace std {
 template <>
@@ -39,13 +64,28 @@ class Packet;
 
 
 enum class PeerType { IN, OUT };
-enum class BroadcastType { UNSOLICITED, SENDHEADERS, INV };
+enum class BroadcastType { UNSOLICITED, SENDHEADERS, INV, COMPACT };
 
 struct Peer
 {
+    Peer () : highBandwidth(false), knownBlocks(VAN_KNOWN_BLOCKS, VAN_KNOWN_FP_RATE) {}
+
     ns3::Ipv4Address address;
     ns3::Ptr<ns3::Socket> socket;
     PeerType type;
+    bool highBandwidth;             //!< The peer asked for compact blocks without announcement (SENDCMPCT 1)
+    ns3::Time nextAnnounce;         //!< Next tick of the announcement timer of an outgoing peer
+    RollingBloomFilter knownBlocks; //!< Blocks the peer announced, sent or got from us
+};
+
+/**
+ * \brief A compact block waiting for the BLOCKTXN with its missing transactions
+ */
+struct PendingCompact
+{
+    Block block;
+    ns3::Ipv4Address peer; //!< Peer we sent the GETBLOCKTXN to
+    ns3::EventId timeout;
 };
 
 class VanillaNode : public BitcoinNode
@@ -56,6 +96,43 @@ class VanillaNode : public BitcoinNode
         virtual ~VanillaNode (void);
 
         static BroadcastType vanBroadcastType;
+        static double announceDelay;
+        static uint16_t announceBatch;
+        static double mempoolOverlap;
+        static uint16_t perigeeRound;
+        static double trickleOutbound;
+        static double trickleInbound;
+
+        /**
+         * \brief Batched INV and HEADERS messages sent, with their mean size and the mean time a block ID waited
+         */
+        const AnnounceBatcher &GetAnnounces ();
+
+        /**
+         * \brief Share of the transactions of a relayed block this node has in its mempool
+         */
+        void SetMempoolOverlap (double overlap);
+
+        /**
+         * \brief Blocks received as CMPCTBLOCK, and how many of them needed a GETBLOCKTXN round trip
+         */
+        uint32_t GetNCompactBlocks ();
+        uint32_t GetNBlockTxnRoundTrips ();
+
+        /**
+         * \brief Peers disconnected for stalling the block download window
+         */
+        uint32_t GetNStalls ();
+
+        /**
+         * \brief Outgoing peers replaced for announcing blocks late
+         */
+        uint32_t GetNRotations ();
+
+        /**
+         * \brief Mean bytes in the device queue when a batch of announcements was sent
+         */
+        double GetMeanUplinkBacklog ();
     protected:
         virtual void DoDispose (void);           // inherited from Application base class.
 
@@ -72,11 +149,51 @@ class VanillaNode : public BitcoinNode
 		 */
 		void InitOutgoingConnection(void);
 
+		/**
+		 * \brief Look for a new outgoing peer after one was lost.
+		 */
+		void ReplaceOutgoingPeer(void);
+
         /**
          * \brief Initialize a broadcast operation
          */
         void InitBroadcast (Block& b);
 
+        /**
+         * \brief Announce a block to a peer, batched with the other blocks announced within announceDelay
+         */
+        void QueueAnnounce (ns3::Ipv4Address peerAddr, uint64_t blockID);
+
+        /**
+         * \brief Send the batched announcements of a peer as one INV or HEADERS message
+         */
+        void FlushAnnounces (ns3::Ipv4Address peerAddr);
+
+        virtual void InitTxBroadcast (Tx &tx);
+
+        /**
+         * \brief Keep a transaction for GETTX and announce it to all peers but the one it came from
+         */
+        void RelayTx (Tx &tx, ns3::Ipv4Address from);
+
+        /**
+         * \brief Queue a transaction announcement, sent on the same timers as the block announcements
+         */
+        void QueueTxAnnounce (ns3::Ipv4Address peerAddr, uint64_t txID);
+
+        /**
+         * \brief Send the transaction IDs waiting for a peer in one TXINV message
+         */
+        void FlushTxAnnounces (ns3::Ipv4Address peerAddr);
+
+        /**
+         * \brief Time until the batch opened for a peer is sent.
+         * announceDelay, or the next tick of a Poisson timer if trickling is on:
+         * one per outgoing peer with mean trickleOutbound, one shared by all
+         * incoming peers with mean trickleInbound.
+         */
+        ns3::Time GetAnnounceDelay (ns3::Ipv4Address peerAddr);
+
 		/**
 		 * \brief Returns a random known address
 		 */
@@ -119,6 +236,87 @@ class VanillaNode : public BitcoinNode
          */
         void SendBlockMessage (ns3::Ptr<ns3::Socket> socketPtr, Block b);
 
+        /** 
+         * \brief Send a SENDCMPCT message, announce asks the peer to push new blocks as CMPCTBLOCK
+         */
+        void SendSendCmpctMessage (ns3::Ptr<ns3::Socket> socketPtr, bool announce);
+
+        /** 
+         * \brief Send a CMPCTBLOCK message, the header and short IDs of a block
+         */
+        void SendCmpctBlockMessage (ns3::Ptr<ns3::Socket> socketPtr, Block b);
+
+        /** 
+         * \brief Send a GETBLOCKTXN message for the transactions missing to rebuild a block
+         */
+        void SendGetBlockTxnMessage (ns3::Ptr<ns3::Socket> socketPtr, uint64_t blockID, uint32_t count);
+
+        /** 
+         * \brief Send a BLOCKTXN message carrying the requested transactions
+         */
+        void SendBlockTxnMessage (ns3::Ptr<ns3::Socket> socketPtr, uint64_t blockID, uint32_t count);
+
+        /** 
+         * \brief Send a TXINV message
+         */
+        void SendTxInvMessage (ns3::Ptr<ns3::Socket> socketPtr, std::vector<uint64_t> inventory);
+
+        /** 
+         * \brief Send a GETTX message
+         */
+        void SendGetTxMessage (ns3::Ptr<ns3::Socket> socketPtr, std::vector<uint64_t> inventory);
+
+        /** 
+         * \brief Send a TX message
+         */
+        void SendTxMessage (ns3::Ptr<ns3::Socket> socketPtr, Tx tx);
+
+        /**
+         * \brief Number of transactions of a block missing from our mempool
+         */
+        uint32_t GetMissingTxCount (const Block &b);
+
+        /**
+         * \brief Ask a peer that delivered a new block first for high-bandwidth relay.
+         * Keeps the VAN_HB_PEERS most recent ones, the oldest is asked to stop.
+         */
+        void UpdateHighBandwidthPeers (ns3::Ipv4Address peerAddr);
+
+        /**
+         * \brief Fill the free download slots of all outgoing peers from the window
+         */
+        void RequestBlocks (void);
+
+        /**
+         * \brief Disconnect the peer holding back the window and hand its blocks to the others
+         */
+        void CheckStalls (void);
+
+        /**
+         * \brief Close the connection to a peer and forget its state
+         */
+        void DisconnectPeer (ns3::Ipv4Address peerAddr);
+
+        /**
+         * \brief Stop waiting for the blocks and transactions a lost peer owes us
+         */
+        void ForgetPeerRequests (ns3::Ipv4Address peerAddr);
+
+        /**
+         * \brief Give up the BLOCKTXN of a compact block and fetch the full block from another peer
+         */
+        void FetchCompactFallback (uint64_t blockID);
+
+        /**
+         * \brief Score the announcement of a block by a peer, and end the round after perigeeRound blocks
+         */
+        void ObserveAnnouncement (ns3::Ipv4Address peerAddr, uint64_t blockID);
+
+        /**
+         * \brief Replace the outgoing peer with the latest announcements of the round by a random one
+         */
+        void RotatePeers (void);
+
 
 		/**
 		 * \brief Handle an incoming connection
@@ -164,11 +362,6 @@ class VanillaNode : public BitcoinNode
          */
         void HandlePacket (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
 
-        /** 
-         * \brief Process a received packet
-         */
-        void ProcessPacket (ns3::Ptr<ns3::Socket> socketPtr);
-
         /**
          * \brief Handle an INV message
          */
@@ -199,6 +392,46 @@ class VanillaNode : public BitcoinNode
          */
         void HandleBlockMessage (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
 
+        /**
+         * \brief Handle a SENDCMPCT message
+         */
+        void HandleSendCmpctMessage (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
+
+        /**
+         * \brief Handle a CMPCTBLOCK message
+         */
+        void HandleCmpctBlockMessage (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
+
+        /**
+         * \brief Handle a GETBLOCKTXN message
+         */
+        void HandleGetBlockTxnMessage (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
+
+        /**
+         * \brief Handle a BLOCKTXN message
+         */
+        void HandleBlockTxnMessage (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
+
+        /**
+         * \brief Handle a TXINV message
+         */
+        void HandleTxInvMessage (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
+
+        /**
+         * \brief Handle a GETTX message
+         */
+        void HandleGetTxMessage (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
+
+        /**
+         * \brief Handle a TX message
+         */
+        void HandleTxMessage (ns3::Ptr<ns3::Socket> socketPtr, ns3::Ptr<ns3::Packet> packet);
+
+        /**
+         * \brief Add a received block to the chain after its validation delay
+         */
+        void AcceptBlock (Block b);
+
         /**
          * \brief Set if a peer already knows a block
          */
@@ -213,13 +446,36 @@ class VanillaNode : public BitcoinNode
         uint32_t m_nInPeers;
         uint32_t m_nOutPeers;
         
-        std::unordered_map<ns3::Ipv4Address, ns3::Ptr<ns3::Packet>>	m_recvQueues;
+        std::unordered_map<ns3::Ipv4Address, FrameReassembler>	m_recvQueues;
 
         std::unordered_map<ns3::Ipv4Address, std::deque<ns3::Ptr<ns3::Packet>>> m_sendQueues;
 
-        std::unordered_map<uint64_t, std::vector<ns3::Ipv4Address>> m_knownBlocks;
-
         std::set<uint64_t> m_requestedBlocks;
+
+        AnnounceBatcher m_announces;
+        ns3::Time m_nextInboundAnnounce; //!< Next tick of the announcement timer of all incoming peers
+        double m_uplinkBacklogSum;
+        uint32_t m_nUplinkSamples;
+
+        double m_mempoolOverlap;
+        std::unordered_map<uint64_t, PendingCompact> m_pendingCompact; //!< Compact blocks waiting for their BLOCKTXN
+        std::deque<ns3::Ipv4Address> m_hbPeers;                        //!< Peers we asked for high-bandwidth relay, oldest first
+        uint32_t m_nCompactBlocks;
+        uint32_t m_nBlockTxnRoundTrips;
+
+        DownloadWindow m_sync;
+        ns3::EventId m_syncCheck;
+        double m_stallTimeout;   //!< Seconds, adapted to the observed download speed
+        uint32_t m_nStalls;
+
+        NeighborScorer m_scorer;
+        ns3::EventId m_rotation;
+        uint32_t m_nRotations;
+
+        std::unordered_map<uint64_t, Tx> m_txPool;               //!< Transactions we can serve, at most nKnownTxs
+        std::deque<uint64_t> m_txOrder;                          //!< IDs of m_txPool, oldest first
+        std::unordered_map<uint64_t, std::pair<ns3::Ipv4Address, ns3::Time>> m_requestedTxs; //!< Transactions requested with GETTX, by peer and request time, at most nKnownTxs
+        AnnounceBatcher m_txAnnounces;
 };
 
 